@@ -39,7 +39,7 @@ Abstract:
 // Utility version information
 //
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 1
+#define UTILITY_MINOR_VERSION 2
 
 EFI_GUID  mEfiFirmwareFileSystem2Guid = EFI_FIRMWARE_FILE_SYSTEM2_GUID;
 
@@ -148,6 +148,10 @@ Returns:
                         HeadSize is required by Capsule Image.\n");                        
   fprintf (stdout, "  -c, --capsule         Create Capsule Image.\n");
   fprintf (stdout, "  -p, --dump            Dump Capsule Image header.\n");
+  fprintf (stdout, "  --batch BatchFile     Each line of BatchFile holds the options of one\n\
+                        GenFv run. The images are built in order by this\n\
+                        process and the first failure stops the batch.\n\
+                        Must be the only option given.\n");
   fprintf (stdout, "  -v, --verbose         Turn on verbose output with informational messages.\n");
   fprintf (stdout, "  -q, --quiet           Disable all messages except key message and fatal error\n");
   fprintf (stdout, "  -d, --debug level     Enable debug messages, at input debug level.\n");
@@ -158,8 +162,9 @@ Returns:
 UINT32 mFvTotalSize;
 UINT32 mFvTakenSize;
 
+STATIC
 int
-main (
+GenFvMain (
   IN int   argc,
   IN char  **argv
   )
@@ -168,6 +173,8 @@ main (
 Routine Description:
 
   This utility uses GenFvImage.Lib to build a firmware volume image.
+  It handles one command line, whether given to the process or read
+  from a batch file.
 
 Arguments:
 
@@ -218,6 +225,7 @@ Returns:
   mFvTotalSize  = 0;
   mFvTakenSize  = 0;
   Status        = EFI_SUCCESS;
+  mFvBaseAddressNumber = 0;
 
   SetUtilityName (UTILITY_NAME);
   
@@ -681,3 +689,157 @@ Returns:
 
   return GetUtilityStatus ();
 }
+
+STATIC
+int
+ProcessBatchFile (
+  IN CHAR8  *BatchFileName
+  )
+/*++
+
+Routine Description:
+
+  Runs GenFvMain once for every non-empty line of a batch file, so that
+  several images are built without starting a process for each one.
+  Options on a line are separated by white space; double quotes group
+  a value that contains spaces.  Lines starting with '#' are comments.
+
+  The batch is meant for scripts that build independent images, such as
+  post-build steps that package several FVs.  GenFds does not use it: it
+  copies each FV into its FD region or parent FV image as soon as GenFv
+  returns, reads the FV alignment from the new header, and may run GenFv
+  a second time once the FFS files are rebased to the child FV addresses
+  GenFv reported.  Each GenFv run there depends on the one before, so
+  GenFds still starts one process per FV and skips the FVs that are up
+  to date.
+
+Arguments:
+
+  BatchFileName      The name of the batch file.
+
+Returns:
+
+  The status of the first failing line, or STATUS_SUCCESS.
+
+--*/
+{
+  EFI_STATUS            Status;
+  CHAR8                 *BatchImage;
+  UINT32                BatchSize;
+  CHAR8                 *Line;
+  CHAR8                 *LineEnd;
+  CHAR8                 *End;
+  CHAR8                 *Source;
+  CHAR8                 *Dest;
+  CHAR8                 **Argv;
+  int                   Argc;
+  int                   Result;
+  BOOLEAN               InQuote;
+  UINT32                LineNumber;
+
+  SetUtilityName (UTILITY_NAME);
+
+  Status = GetFileImage (BatchFileName, &BatchImage, &BatchSize);
+  if (EFI_ERROR (Status)) {
+    return STATUS_ERROR;
+  }
+
+  //
+  // Leave room to terminate an argument that ends the file, and for one
+  // argument pointer per two characters, the shortest option and separator.
+  //
+  Line = realloc (BatchImage, BatchSize + 1);
+  Argv = malloc ((BatchSize / 2 + 2) * sizeof (CHAR8 *));
+  if (Line == NULL || Argv == NULL) {
+    free (Line == NULL ? BatchImage : Line);
+    free (Argv);
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    return STATUS_ERROR;
+  }
+
+  BatchImage = Line;
+  Result     = STATUS_SUCCESS;
+  End        = BatchImage + BatchSize;
+  LineNumber = 0;
+  for (Line = BatchImage; Line < End && Result == STATUS_SUCCESS; Line = LineEnd + 1) {
+    LineNumber++;
+    for (LineEnd = Line; LineEnd < End && *LineEnd != '\n'; LineEnd++) {
+      ;
+    }
+
+    //
+    // Split the line into arguments in place.
+    //
+    Argv[0] = UTILITY_NAME;
+    Argc    = 1;
+    Source  = Line;
+    while (Source < LineEnd) {
+      if (*Source == ' ' || *Source == '\t' || *Source == '\r') {
+        Source++;
+        continue;
+      }
+
+      if (Argc == 1 && *Source == '#') {
+        break;
+      }
+
+      Argv[Argc++] = Source;
+      Dest         = Source;
+      InQuote      = FALSE;
+      while (Source < LineEnd && (InQuote || (*Source != ' ' && *Source != '\t' && *Source != '\r'))) {
+        if (*Source == '"') {
+          InQuote = (BOOLEAN) !InQuote;
+        } else {
+          *Dest++ = *Source;
+        }
+        Source++;
+      }
+
+      Source++;
+      *Dest = '\0';
+    }
+
+    if (Argc == 1) {
+      continue;
+    }
+
+    Argv[Argc] = NULL;
+    Result     = GenFvMain (Argc, Argv);
+    if (Result != STATUS_SUCCESS) {
+      Error (BatchFileName, LineNumber, 3000, "Batch failed", "the image on this line could not be built");
+    }
+  }
+
+  free (Argv);
+  free (BatchImage);
+  return Result;
+}
+
+int
+main (
+  IN int   argc,
+  IN char  **argv
+  )
+/*++
+
+Routine Description:
+
+  Builds one image from the command line, or a batch of images listed
+  in the file given with --batch.
+
+Arguments:
+
+  argc, argv         The command line.
+
+Returns:
+
+  STATUS_SUCCESS, or the status of the failing image.
+
+--*/
+{
+  if (argc == 3 && stricmp (argv[1], "--batch") == 0) {
+    return ProcessBatchFile (argv[2]);
+  }
+
+  return GenFvMain (argc, argv);
+}
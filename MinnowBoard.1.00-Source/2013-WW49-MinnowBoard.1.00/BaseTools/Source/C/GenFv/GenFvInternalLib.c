@@ -25,12 +25,17 @@ Abstract:
 #ifdef __GNUC__
 #include <uuid/uuid.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 #include <string.h>
 #ifndef __GNUC__
 #include <io.h>
 #endif
 #include <assert.h>
+#include <time.h>
 
 #include "GenFvInternalLib.h"
 #include "FvLib.h"
@@ -39,6 +44,7 @@ Abstract:
 
 BOOLEAN mArm = FALSE;
 STATIC UINT32   MaxFfsAlignment = 0;
+STATIC UINT64   mReadFileTime = 0;
 
 EFI_GUID  mEfiFirmwareVolumeTopFileGuid = EFI_FFS_VOLUME_TOP_FILE_GUID;
 EFI_GUID  mFileGuidArray [MAX_NUMBER_OF_FILES_IN_FV];
@@ -909,6 +915,176 @@ Returns:
   return EFI_SUCCESS;
 }
 
+STATIC
+UINT64
+GetTimeInMicroseconds (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Read a monotonic-enough wall clock for the phase timing report.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The current time in microseconds.
+
+--*/
+{
+#ifdef __GNUC__
+  struct timeval  Time;
+
+  gettimeofday (&Time, NULL);
+  return (UINT64) Time.tv_sec * 1000000 + Time.tv_usec;
+#else
+  return (UINT64) clock () * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+STATIC
+EFI_STATUS
+ReadInputFile (
+  IN  CHAR8    *FileName,
+  OUT UINT8    **FileBuffer,
+  OUT UINTN    *FileSize,
+  OUT BOOLEAN  *FileMapped
+  )
+/*++
+
+Routine Description:
+
+  This function brings an input file into memory.  With GCC the file is
+  mapped copy-on-write, so the in-place FFS state update and rebase stay
+  private to this process and untouched pages are never copied.  If the
+  file cannot be mapped it is read into an allocated buffer.
+
+Arguments:
+
+  FileName      The name of the file to read.
+  FileBuffer    Receives the file contents.
+  FileSize      Receives the size of the file.
+  FileMapped    Receives TRUE if FileBuffer is a mapping of the file.
+
+Returns:
+
+  EFI_SUCCESS              The file is in memory.
+  EFI_ABORTED              The file could not be opened or read.
+  EFI_OUT_OF_RESOURCES     Insufficient resources exist to read the file.
+
+--*/
+{
+  FILE                  *NewFile;
+  UINTN                 NumBytesRead;
+  UINT64                StartTime;
+#ifdef __GNUC__
+  int                   FileDescriptor;
+  struct stat           FileStat;
+  VOID                  *Mapping;
+#endif
+
+  StartTime   = GetTimeInMicroseconds ();
+  *FileMapped = FALSE;
+
+#ifdef __GNUC__
+  FileDescriptor = open (FileName, O_RDONLY);
+  if (FileDescriptor >= 0) {
+    Mapping = MAP_FAILED;
+    if (fstat (FileDescriptor, &FileStat) == 0 && FileStat.st_size > 0) {
+      Mapping = mmap (NULL, (size_t) FileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, FileDescriptor, 0);
+    }
+    close (FileDescriptor);
+
+    if (Mapping != MAP_FAILED) {
+      *FileBuffer     = Mapping;
+      *FileSize       = (UINTN) FileStat.st_size;
+      *FileMapped     = TRUE;
+      mReadFileTime  += GetTimeInMicroseconds () - StartTime;
+      return EFI_SUCCESS;
+    }
+  }
+#endif
+
+  NewFile = fopen (FileName, "rb");
+
+  if (NewFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", FileName);
+    return EFI_ABORTED;
+  }
+
+  //
+  // Get the file size
+  //
+  *FileSize = _filelength (fileno (NewFile));
+
+  //
+  // Read the file into a buffer
+  //
+  *FileBuffer = malloc (*FileSize);
+  if (*FileBuffer == NULL) {
+    fclose (NewFile);
+    Error (NULL, 0, 4001, "Resouce", "memory cannot be allocated!");
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NumBytesRead = fread (*FileBuffer, sizeof (UINT8), *FileSize, NewFile);
+
+  //
+  // Done with the file, from this point on we will just use the buffer read.
+  //
+  fclose (NewFile);
+
+  //
+  // Verify read successful
+  //
+  if (NumBytesRead != sizeof (UINT8) * *FileSize) {
+    free (*FileBuffer);
+    Error (NULL, 0, 0004, "Error reading file", FileName);
+    return EFI_ABORTED;
+  }
+
+  mReadFileTime += GetTimeInMicroseconds () - StartTime;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeInputFile (
+  IN UINT8    *FileBuffer,
+  IN UINTN    FileSize,
+  IN BOOLEAN  FileMapped
+  )
+/*++
+
+Routine Description:
+
+  This function releases a file brought into memory by ReadInputFile.
+
+Arguments:
+
+  FileBuffer    The file contents.
+  FileSize      The size of the file.
+  FileMapped    TRUE if FileBuffer is a mapping of the file.
+
+Returns:
+
+  None
+
+--*/
+{
+#ifdef __GNUC__
+  if (FileMapped) {
+    munmap (FileBuffer, FileSize);
+    return;
+  }
+#endif
+  free (FileBuffer);
+}
+
 EFI_STATUS
 AddFile (
   IN OUT MEMORY_FILE          *FvImage,
@@ -945,10 +1121,9 @@ Returns:
 
 --*/
 {
-  FILE                  *NewFile;
   UINTN                 FileSize;
   UINT8                 *FileBuffer;
-  UINTN                 NumBytesRead;
+  BOOLEAN               FileMapped;
   UINT32                CurrentFileAlignment;
   EFI_STATUS            Status;
   UINTN                 Index1;
@@ -965,41 +1140,9 @@ Returns:
   //
   // Read the file to add
   //
-  NewFile = fopen (FvInfo->FvFiles[Index], "rb");
-
-  if (NewFile == NULL) {
-    Error (NULL, 0, 0001, "Error opening file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
-  }
-
-  //
-  // Get the file size
-  //
-  FileSize = _filelength (fileno (NewFile));
-
-  //
-  // Read the file into a buffer
-  //
-  FileBuffer = malloc (FileSize);
-  if (FileBuffer == NULL) {
-    Error (NULL, 0, 4001, "Resouce", "memory cannot be allocated!");
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  NumBytesRead = fread (FileBuffer, sizeof (UINT8), FileSize, NewFile);
-
-  //
-  // Done with the file, from this point on we will just use the buffer read.
-  //
-  fclose (NewFile);
-  
-  //
-  // Verify read successful
-  //
-  if (NumBytesRead != sizeof (UINT8) * FileSize) {
-    free  (FileBuffer);
-    Error (NULL, 0, 0004, "Error reading file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
+  Status = ReadInputFile (FvInfo->FvFiles[Index], &FileBuffer, &FileSize, &FileMapped);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
   
   //
@@ -1020,7 +1163,7 @@ Returns:
   //
   Status = VerifyFfsFile ((EFI_FFS_FILE_HEADER *)FileBuffer);
   if (EFI_ERROR (Status)) {
-    free (FileBuffer);
+    FreeInputFile (FileBuffer, FileSize, FileMapped);
     Error (NULL, 0, 3000, "Invalid", "%s is not a valid FFS file.", FvInfo->FvFiles[Index]);
     return EFI_INVALID_PARAMETER;
   }
@@ -1029,7 +1172,7 @@ Returns:
   // Verify space exists to add the file
   //
   if (FileSize > (UINTN) ((UINTN) *VtfFileImage - (UINTN) FvImage->CurrentFilePointer)) {
-    free (FileBuffer);
+    FreeInputFile (FileBuffer, FileSize, FileMapped);
     Error (NULL, 0, 4002, "Resource", "FV space is full, not enough room to add file %s.", FvInfo->FvFiles[Index]);
     return EFI_OUT_OF_RESOURCES;
   }
@@ -1079,7 +1222,7 @@ Returns:
       //
       if (((UINTN) *VtfFileImage + sizeof (EFI_FFS_FILE_HEADER) - (UINTN) FvImage->FileImage) % (1 << CurrentFileAlignment)) {
         Error (NULL, 0, 3000, "Invalid", "VTF file cannot be aligned on a %u-byte boundary.", (unsigned) (1 << CurrentFileAlignment));
-        free (FileBuffer);
+        FreeInputFile (FileBuffer, FileSize, FileMapped);
         return EFI_ABORTED;
       }
       //
@@ -1099,7 +1242,7 @@ Returns:
       PrintGuidToBuffer ((EFI_GUID *) FileBuffer, FileGuidString, sizeof (FileGuidString), TRUE); 
       fprintf (FvReportFile, "0x%08X %s\n", (unsigned)(UINTN) (((UINT8 *)*VtfFileImage) - (UINTN)FvImage->FileImage), FileGuidString);
 
-      free (FileBuffer);
+      FreeInputFile (FileBuffer, FileSize, FileMapped);
       DebugMsg (NULL, 0, 9, "Add VTF FFS file in FV image", NULL);
       return EFI_SUCCESS;
     } else {
@@ -1107,7 +1250,7 @@ Returns:
       // Already found a VTF file.
       //
       Error (NULL, 0, 3000, "Invalid", "multiple VTF files are not permitted within a single FV.");
-      free (FileBuffer);
+      FreeInputFile (FileBuffer, FileSize, FileMapped);
       return EFI_ABORTED;
     }
   }
@@ -1118,7 +1261,7 @@ Returns:
   Status = AddPadFile (FvImage, 1 << CurrentFileAlignment, *VtfFileImage, NULL);
   if (EFI_ERROR (Status)) {
     Error (NULL, 0, 4002, "Resource", "FV space is full, could not add pad file for data alignment property.");
-    free (FileBuffer);
+    FreeInputFile (FileBuffer, FileSize, FileMapped);
     return EFI_ABORTED;
   }
   //
@@ -1143,7 +1286,7 @@ Returns:
     FvImage->CurrentFilePointer += FileSize;
   } else {
     Error (NULL, 0, 4002, "Resource", "FV space is full, cannot add file %s.", FvInfo->FvFiles[Index]);
-    free (FileBuffer);
+    FreeInputFile (FileBuffer, FileSize, FileMapped);
     return EFI_ABORTED;
   }
   //
@@ -1157,7 +1300,7 @@ Done:
   //
   // Free allocated memory.
   //
-  free (FileBuffer);
+  FreeInputFile (FileBuffer, FileSize, FileMapped);
 
   return EFI_SUCCESS;
 }
@@ -2003,11 +2146,29 @@ Returns:
   UINTN                           FileSize;
   CHAR8                           FvReportName[_MAX_PATH];
   FILE                            *FvReportFile;
+  UINT64                          PhaseStart;
+  UINT64                          ParseTime;
+  UINT64                          SizeTime;
+  UINT64                          AddTime;
+  UINT64                          WriteTime;
 
   FvBufferHeader = NULL;
   FvFile         = NULL;
   FvMapFile      = NULL;
   FvReportFile   = NULL;
+  PhaseStart     = GetTimeInMicroseconds ();
+  ParseTime      = 0;
+  SizeTime       = 0;
+  AddTime        = 0;
+  WriteTime      = 0;
+
+  //
+  // GenFv may build several FVs in one process, so reset the state
+  // gathered from the files of the previous one.
+  //
+  mArm            = FALSE;
+  MaxFfsAlignment = 0;
+  mReadFileTime   = 0;
 
   if (InfFileImage != NULL) {
     //
@@ -2026,6 +2187,8 @@ Returns:
       return Status;
     }
   }
+  ParseTime   = GetTimeInMicroseconds () - PhaseStart;
+  PhaseStart += ParseTime;
 
   //
   // Update the file name return values
@@ -2161,6 +2324,8 @@ Returns:
     return Status;    
   }
   VerboseMsg ("the generated FV image size is %u bytes", (unsigned) mFvDataInfo.Size);
+  SizeTime    = GetTimeInMicroseconds () - PhaseStart;
+  PhaseStart += SizeTime;
   
   //
   // support fv image and empty fv image
@@ -2387,6 +2552,8 @@ Returns:
     FvHeader->Checksum      = 0;
     FvHeader->Checksum      = CalculateChecksum16 ((UINT16 *) FvHeader, FvHeader->HeaderLength / sizeof (UINT16));
   }
+  AddTime     = GetTimeInMicroseconds () - PhaseStart;
+  PhaseStart += AddTime;
 
 WriteFile: 
   //
@@ -2404,6 +2571,19 @@ WriteFile:
     Status = EFI_ABORTED;
     goto Finish;
   }
+  WriteTime = GetTimeInMicroseconds () - PhaseStart;
+
+  //
+  // Report where the time went; reading the FFS files is part of adding them.
+  //
+  VerboseMsg (
+    "FV phase times in us: parse %llu, size %llu, add files %llu (read %llu), write %llu",
+    (unsigned long long) ParseTime,
+    (unsigned long long) SizeTime,
+    (unsigned long long) AddTime,
+    (unsigned long long) mReadFileTime,
+    (unsigned long long) WriteTime
+    );
 
 Finish:
   if (FvBufferHeader != NULL) {
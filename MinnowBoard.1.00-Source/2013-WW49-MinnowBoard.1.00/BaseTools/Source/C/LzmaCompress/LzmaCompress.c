@@ -21,6 +21,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
 
 #include "Sdk/C/Alloc.h"
 #include "Sdk/C/7zFile.h"
@@ -48,11 +51,13 @@ static void SzFree(void *p, void *address) { p = p; MyFree(address); }
 static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 
 static Bool mQuietMode = False;
+static Bool mVerboseMode = False;
 static CONVERTER_TYPE mConType = NoConverter;
+static int mNumThreads = 1;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 2
+#define UTILITY_MINOR_VERSION 3
 #define INTEL_COPYRIGHT \
   "Copyright (c) 2009-2012, Intel Corporation. All rights reserved."
 void PrintHelp(char *buffer)
@@ -65,7 +70,9 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
-             "  -v, --verbose: increase output messages\n"
+             "  --threads N: use N threads to encode; any N greater than 1 runs\n"
+             "               the match finder in its own threads (default 1)\n"
+             "  -v, --verbose: increase output messages, including timing\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
              "  --version: display the program version and exit\n"
@@ -97,6 +104,20 @@ void PrintVersion(char *buffer)
   sprintf (buffer, "%s Version %d.%d %s ", UTILITY_NAME, UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION, __BUILD_VERSION);
 }
 
+/**
+  Return a wall clock time stamp in milliseconds, used to time the operations.
+**/
+static UInt64 GetTimeStamp(void)
+{
+#ifdef _WIN32
+  return GetTickCount();
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (UInt64)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
 static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -108,6 +129,10 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
   CLzmaEncProps props;
 
   LzmaEncProps_Init(&props);
+  //
+  // The match finder of this SDK runs in at most two threads besides the encoder.
+  //
+  props.numThreads = (mNumThreads > 1) ? 2 : 1;
   LzmaEncProps_Normalize(&props);
 
   if (inSize != 0) {
@@ -256,6 +281,7 @@ int main2(int numArgs, const char *args[], char *rs)
   const char *outputFile = "file.tmp";
   int param;
   UInt64 fileSize;
+  UInt64 startTime;
 
   FileSeqInStream_CreateVTable(&inStream);
   File_Construct(&inStream.file);
@@ -281,6 +307,14 @@ int main2(int numArgs, const char *args[], char *rs)
         return PrintUserError(rs);
       }
       outputFile = args[++param];
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mNumThreads = atoi(args[++param]);
+      if (mNumThreads < 1) {
+        return PrintUserError(rs);
+      }
     } else if (strcmp(args[param], "--debug") == 0) {
       if (numArgs < (param + 2)) {
         return PrintUserError(rs);
@@ -300,10 +334,7 @@ int main2(int numArgs, const char *args[], char *rs)
                 strcmp(args[param], "-v") == 0 ||
                 strcmp(args[param], "--verbose") == 0
               ) {
-      //
-      // For now we silently ignore this parameter to achieve command line
-      // parameter compatibility with other build tools.
-      //
+      mVerboseMode = True;
     } else if (
                 strcmp(args[param], "-q") == 0 ||
                 strcmp(args[param], "--quiet") == 0
@@ -338,6 +369,7 @@ int main2(int numArgs, const char *args[], char *rs)
 
   File_GetLength(&inStream.file, &fileSize);
 
+  startTime = GetTimeStamp();
   if (encodeMode)
   {
     if (!mQuietMode) {
@@ -353,6 +385,16 @@ int main2(int numArgs, const char *args[], char *rs)
     res = Decode(&outStream.s, &inStream.s, fileSize);
   }
 
+  if (mVerboseMode && !mQuietMode && res == SZ_OK) {
+    UInt64 outSize = 0;
+    File_GetLength(&outStream.file, &outSize);
+    printf("%s %llu bytes to %llu bytes in %llu ms\n",
+           encodeMode ? "Encoded" : "Decoded",
+           (unsigned long long)fileSize,
+           (unsigned long long)outSize,
+           (unsigned long long)(GetTimeStamp() - startTime));
+  }
+
   File_Close(&outStream.file);
   File_Close(&inStream.file);
 
@@ -52,6 +52,19 @@ static BOOLEAN QuietMode = FALSE;
 #define CRCPOLY       0xA001
 #define UPDATE_CRC(c) mCrc = mCrcTable[(mCrc ^ (c)) & 0xFF] ^ (mCrc >> UINT8_BIT)
 
+//
+// Hash-chain match finder.  Chains link earlier positions with the same
+// 3-byte hash; HC_NICE_MATCH bounds the work the optimal parser spends
+// inside long repeats and OPT_CHUNK is the span it optimizes at once.
+//
+#define HC_HASH_BITS          16
+#define HC_NIL                0xFFFFFFFFU
+#define HC_HASH(p)            (((((UINT32) mHcText[p] << 16) | ((UINT32) mHcText[(p) + 1] << 8) | mHcText[(p) + 2]) * 2654435761U) >> (32 - HC_HASH_BITS))
+#define HC_DEFAULT_DEPTH      256
+#define HC_NICE_MATCH         128
+#define OPT_CHUNK             (1U << 12)
+#define OPT_INFINITY          0xFFFFFFFFU
+
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
 //
@@ -84,6 +97,14 @@ STATIC UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC -
 
 STATIC NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext = NULL;
 
+STATIC UINT32 mChainDepth = 0;
+STATIC BOOLEAN mOptimalParse = FALSE;
+STATIC UINT8  *mHcText;
+STATIC UINT32 mHcSize, *mHcHead, *mHcPrev;
+STATIC UINT32 *mOptCost, *mOptDist;
+STATIC UINT16 *mOptLen;
+STATIC UINT32 mCPrice[NC], mPPrice[NP];
+
 static  UINT64     DebugLevel;
 static  BOOLEAN    DebugMode;
 //
@@ -136,6 +157,11 @@ Returns:
   mParent         = NULL;
   mPrev           = NULL;
   mNext           = NULL;
+  mHcHead         = NULL;
+  mHcPrev         = NULL;
+  mOptCost        = NULL;
+  mOptLen         = NULL;
+  mOptDist        = NULL;
 
 
   mSrc            = SrcBuffer;
@@ -246,17 +272,34 @@ Returns:
 {
   UINT32  Index;
 
-  mText = malloc (WNDSIZ * 2 + MAXMATCH);
-  for (Index = 0; Index < WNDSIZ * 2 + MAXMATCH; Index++) {
-    mText[Index] = 0;
-  }
+  if (mChainDepth != 0) {
+    mHcHead = malloc ((1U << HC_HASH_BITS) * sizeof (*mHcHead));
+    mHcPrev = malloc (WNDSIZ * sizeof (*mHcPrev));
+    if (mHcHead == NULL || mHcPrev == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
 
-  mLevel      = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mLevel));
-  mChildCount = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mChildCount));
-  mPosition   = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mPosition));
-  mParent     = malloc (WNDSIZ * 2 * sizeof (*mParent));
-  mPrev       = malloc (WNDSIZ * 2 * sizeof (*mPrev));
-  mNext       = malloc ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+    if (mOptimalParse) {
+      mOptCost  = malloc ((OPT_CHUNK + 1) * sizeof (*mOptCost));
+      mOptLen   = malloc ((OPT_CHUNK + 1) * sizeof (*mOptLen));
+      mOptDist  = malloc ((OPT_CHUNK + 1) * sizeof (*mOptDist));
+      if (mOptCost == NULL || mOptLen == NULL || mOptDist == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+  } else {
+    mText = malloc (WNDSIZ * 2 + MAXMATCH);
+    for (Index = 0; Index < WNDSIZ * 2 + MAXMATCH; Index++) {
+      mText[Index] = 0;
+    }
+
+    mLevel      = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mLevel));
+    mChildCount = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mChildCount));
+    mPosition   = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mPosition));
+    mParent     = malloc (WNDSIZ * 2 * sizeof (*mParent));
+    mPrev       = malloc (WNDSIZ * 2 * sizeof (*mPrev));
+    mNext       = malloc ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+  }
 
   mBufSiz     = BLKSIZ;
   mBuf        = malloc (mBufSiz);
@@ -322,6 +365,26 @@ Returns: (VOID)
     free (mBuf);
   }
 
+  if (mHcHead != NULL) {
+    free (mHcHead);
+  }
+
+  if (mHcPrev != NULL) {
+    free (mHcPrev);
+  }
+
+  if (mOptCost != NULL) {
+    free (mOptCost);
+  }
+
+  if (mOptLen != NULL) {
+    free (mOptLen);
+  }
+
+  if (mOptDist != NULL) {
+    free (mOptDist);
+  }
+
   return ;
 }
 
@@ -735,6 +798,346 @@ Returns: (VOID)
   InsertNode ();
 }
 
+STATIC
+VOID
+HashChainInsert (
+  IN UINT32 Pos
+  )
+/*++
+
+Routine Description:
+
+  Link a position of the source into the chain of its 3-byte hash.
+
+Arguments:
+
+  Pos     - the position to insert
+
+Returns: (VOID)
+
+--*/
+{
+  UINT32  Hash;
+
+  if (Pos + THRESHOLD > mHcSize) {
+    return ;
+  }
+
+  Hash                          = HC_HASH (Pos);
+  mHcPrev[Pos & (WNDSIZ - 1)]   = mHcHead[Hash];
+  mHcHead[Hash]                 = Pos;
+}
+
+STATIC
+UINT32
+HashChainFindMatch (
+  IN  UINT32  Pos,
+  IN  UINT32  MaxLen,
+  OUT UINT32  *Lengths,
+  OUT UINT32  *Distances,
+  OUT UINT32  *Count
+  )
+/*++
+
+Routine Description:
+
+  Walk the hash chain of the current position, following at most
+  mChainDepth earlier positions within the window.  Every time a longer
+  match is found its length and distance are recorded, so the nearest
+  distance is reported for each length.
+
+Arguments:
+
+  Pos       - the position to find a match for
+  MaxLen    - the longest match allowed
+  Lengths   - receives the increasing match lengths
+  Distances - receives the distance of each recorded length
+  Count     - receives the number of recorded lengths
+
+Returns:
+
+  The longest match length found, or 0 if there is no usable match.
+
+--*/
+{
+  UINT8   *Current;
+  UINT8   *Match;
+  UINT32  Candidate;
+  UINT32  Next;
+  UINT32  Depth;
+  UINT32  Len;
+  UINT32  BestLen;
+
+  *Count = 0;
+  if (MaxLen > MAXMATCH) {
+    MaxLen = MAXMATCH;
+  }
+
+  if (MaxLen > mHcSize - Pos) {
+    MaxLen = mHcSize - Pos;
+  }
+
+  if (MaxLen < THRESHOLD) {
+    return 0;
+  }
+
+  Current   = mHcText + Pos;
+  BestLen   = THRESHOLD - 1;
+  Candidate = mHcHead[HC_HASH (Pos)];
+  for (Depth = mChainDepth; Candidate != HC_NIL && Depth > 0; Depth--) {
+    if (Pos - Candidate >= WNDSIZ) {
+      break;
+    }
+
+    Match = mHcText + Candidate;
+    if (Match[BestLen] == Current[BestLen] && Match[0] == Current[0] && Match[1] == Current[1]) {
+      for (Len = 2; Len < MaxLen && Match[Len] == Current[Len]; Len++) {
+        ;
+      }
+
+      if (Len > BestLen) {
+        BestLen             = Len;
+        Lengths[*Count]     = Len;
+        Distances[*Count]   = Pos - Candidate;
+        (*Count)++;
+        if (Len == MaxLen) {
+          break;
+        }
+      }
+    }
+
+    //
+    // A link that does not point backwards was overwritten by a position
+    // that is more than a window away, so the rest of the chain is stale.
+    //
+    Next = mHcPrev[Candidate & (WNDSIZ - 1)];
+    if (Next >= Candidate) {
+      break;
+    }
+
+    Candidate = Next;
+  }
+
+  return (*Count == 0) ? 0 : BestLen;
+}
+
+STATIC
+VOID
+HashChainParse (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Split the source into Original Characters and Pointers with the
+  hash-chain match finder.  A match is deferred by one position when the
+  next position has a longer one, as the tree-based Encode () does.
+
+Arguments: (VOID)
+
+Returns: (VOID)
+
+--*/
+{
+  UINT32  Lengths[MAXMATCH];
+  UINT32  Distances[MAXMATCH];
+  UINT32  Count;
+  UINT32  Pos;
+  UINT32  Index;
+  UINT32  MatchLen;
+  UINT32  MatchDist;
+  UINT32  LastMatchLen;
+  UINT32  LastMatchDist;
+
+  Pos       = 0;
+  MatchDist = 0;
+  MatchLen  = HashChainFindMatch (Pos, MAXMATCH, Lengths, Distances, &Count);
+  if (MatchLen != 0) {
+    MatchDist = Distances[Count - 1];
+  }
+
+  HashChainInsert (Pos);
+
+  while (Pos < mHcSize) {
+    LastMatchLen  = MatchLen;
+    LastMatchDist = MatchDist;
+
+    MatchLen      = HashChainFindMatch (Pos + 1, MAXMATCH, Lengths, Distances, &Count);
+    if (MatchLen != 0) {
+      MatchDist = Distances[Count - 1];
+    }
+
+    HashChainInsert (Pos + 1);
+
+    if (MatchLen > LastMatchLen || LastMatchLen < THRESHOLD ||
+        (LastMatchLen == THRESHOLD && LastMatchDist - 1 > (1U << 11))) {
+      //
+      // Not enough benefits are gained by outputting a pointer,
+      // so just output the original character
+      //
+      Output (mHcText[Pos], 0);
+      Pos++;
+      continue;
+    }
+
+    Output (LastMatchLen + (UINT8_MAX + 1 - THRESHOLD), LastMatchDist - 1);
+    for (Index = Pos + 2; Index < Pos + LastMatchLen; Index++) {
+      HashChainInsert (Index);
+    }
+
+    Pos += LastMatchLen;
+    MatchLen = HashChainFindMatch (Pos, MAXMATCH, Lengths, Distances, &Count);
+    if (MatchLen != 0) {
+      MatchDist = Distances[Count - 1];
+    }
+
+    HashChainInsert (Pos);
+  }
+}
+
+STATIC
+VOID
+UpdatePrices (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Estimate the bit cost of every Char&Len and Position symbol from the
+  code lengths of the last block sent.  Symbols without a code yet are
+  given a pessimistic default.
+
+Arguments: (VOID)
+
+Returns: (VOID)
+
+--*/
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < NC; Index++) {
+    if (mCLen[Index] != 0) {
+      mCPrice[Index] = mCLen[Index];
+    } else {
+      mCPrice[Index] = (Index <= UINT8_MAX) ? 9 : 11;
+    }
+  }
+
+  for (Index = 0; Index < NP; Index++) {
+    mPPrice[Index] = (mPTLen[Index] != 0) ? mPTLen[Index] : 5;
+    if (Index > 1) {
+      mPPrice[Index] += Index - 1;
+    }
+  }
+}
+
+STATIC
+VOID
+OptimalParse (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Split the source into Original Characters and Pointers choosing, for
+  each chunk of OPT_CHUNK bytes, the sequence with the lowest estimated
+  cost in bits instead of the longest match at each step.
+
+Arguments: (VOID)
+
+Returns: (VOID)
+
+--*/
+{
+  UINT32  Lengths[MAXMATCH];
+  UINT32  Distances[MAXMATCH];
+  UINT32  Count;
+  UINT32  Start;
+  UINT32  End;
+  UINT32  Pos;
+  UINT32  SkipTo;
+  UINT32  Index;
+  UINT32  Len;
+  UINT32  PrevLen;
+  UINT32  Cost;
+  UINT32  Bits;
+  UINT32  Dist;
+
+  for (Start = 0; Start < mHcSize; Start = End) {
+    End = (mHcSize - Start > OPT_CHUNK) ? Start + OPT_CHUNK : mHcSize;
+
+    UpdatePrices ();
+    mOptCost[0] = 0;
+    for (Index = 1; Index <= End - Start; Index++) {
+      mOptCost[Index] = OPT_INFINITY;
+    }
+
+    SkipTo = Start;
+    for (Pos = Start; Pos < End; Pos++) {
+      Index = Pos - Start;
+      Cost  = mOptCost[Index] + mCPrice[mHcText[Pos]];
+      if (Cost < mOptCost[Index + 1]) {
+        mOptCost[Index + 1] = Cost;
+        mOptLen[Index + 1]  = 1;
+      }
+
+      if (Pos >= SkipTo) {
+        HashChainFindMatch (Pos, End - Pos, Lengths, Distances, &Count);
+        PrevLen = THRESHOLD - 1;
+        for (Len = 0; Len < Count; Len++) {
+          Dist = Distances[Len] - 1;
+          for (Bits = 0; (Dist >> Bits) != 0; Bits++) {
+            ;
+          }
+
+          //
+          // A long match is taken whole and the positions it covers are
+          // not searched, which keeps long repeats close to linear time.
+          //
+          if (Lengths[Len] >= HC_NICE_MATCH) {
+            PrevLen = Lengths[Len] - 1;
+            SkipTo  = Pos + Lengths[Len];
+          }
+
+          while (PrevLen < Lengths[Len]) {
+            PrevLen++;
+            Cost = mOptCost[Index] + mCPrice[PrevLen + (UINT8_MAX + 1 - THRESHOLD)] + mPPrice[Bits];
+            if (Cost < mOptCost[Index + PrevLen]) {
+              mOptCost[Index + PrevLen] = Cost;
+              mOptLen[Index + PrevLen]  = (UINT16) PrevLen;
+              mOptDist[Index + PrevLen] = Dist;
+            }
+          }
+        }
+      }
+
+      HashChainInsert (Pos);
+    }
+
+    //
+    // Reverse the chosen path in place so that it can be output in order:
+    // mOptCost[] is reused to hold the start offset of each step.
+    //
+    Count = 0;
+    for (Index = End - Start; Index > 0; Index -= mOptLen[Index]) {
+      mOptCost[Count++] = Index;
+    }
+
+    while (Count > 0) {
+      Index = mOptCost[--Count];
+      Len   = mOptLen[Index];
+      if (Len == 1) {
+        Output (mHcText[Start + Index - 1], 0);
+      } else {
+        Output (Len + (UINT8_MAX + 1 - THRESHOLD), mOptDist[Index]);
+      }
+    }
+  }
+}
+
 STATIC
 EFI_STATUS
 Encode (
@@ -758,6 +1161,7 @@ Returns:
   EFI_STATUS  Status;
   INT32       LastMatchLen;
   NODE        LastMatchPos;
+  UINT32      Index;
 
   Status = AllocateMemory ();
   if (EFI_ERROR (Status)) {
@@ -765,6 +1169,48 @@ Returns:
     return Status;
   }
 
+  if (mChainDepth != 0) {
+    //
+    // The whole source is in memory, so the hash-chain match finder
+    // indexes it directly instead of sliding a copy of the window.
+    //
+    mHcText = mSrc;
+    mHcSize = (UINT32) (mSrcUpperLimit - mSrc);
+    for (Index = 0; Index < mHcSize; Index++) {
+      UPDATE_CRC (mHcText[Index]);
+    }
+
+    mOrigSize = mHcSize;
+    mSrc      = mSrcUpperLimit;
+
+    //
+    // The optimal parser prices symbols from the code lengths of the last
+    // block, so start every run from the same defaults.
+    //
+    for (Index = 0; Index < NC; Index++) {
+      mCLen[Index] = 0;
+    }
+
+    for (Index = 0; Index < NPT; Index++) {
+      mPTLen[Index] = 0;
+    }
+
+    for (Index = 0; Index < (1U << HC_HASH_BITS); Index++) {
+      mHcHead[Index] = HC_NIL;
+    }
+
+    HufEncodeStart ();
+    if (mOptimalParse) {
+      OptimalParse ();
+    } else {
+      HashChainParse ();
+    }
+
+    HufEncodeEnd ();
+    FreeMemory ();
+    return EFI_SUCCESS;
+  }
+
   InitSlide ();
 
   HufEncodeStart ();
@@ -1709,6 +2155,12 @@ Returns:
            Disable all messages except key message and fatal error\n");
   fprintf (stdout, "  --debug [0-9]\n\
            Enable debug messages, at input debug level.\n");
+  fprintf (stdout, "  --chain-depth Depth\n\
+           Find matches with hash chains, following at most Depth\n\
+           earlier positions per match, instead of the tree search.\n");
+  fprintf (stdout, "  --optimal\n\
+           Choose matches by estimated cost rather than length.\n\
+           Implies hash chains of depth %u unless --chain-depth is given.\n", HC_DEFAULT_DEPTH);
   fprintf (stdout, "  --version\n\
            Show program's version number and exit.\n");
   fprintf (stdout, "  -h, --help\n\
@@ -1835,6 +2287,24 @@ Returns:
       continue;
     }
 
+    if (stricmp (argv[0], "--chain-depth") == 0) {
+      if (argv[1] == NULL || atoi (argv[1]) <= 0) {
+        Error (NULL, 0, 1003, "Invalid option value", "--chain-depth requires a positive depth");
+        goto ERROR;
+      }
+      mChainDepth = (UINT32) atoi (argv[1]);
+      argc -= 2;
+      argv += 2;
+      continue;
+    }
+
+    if (stricmp (argv[0], "--optimal") == 0) {
+      mOptimalParse = TRUE;
+      argc--;
+      argv++;
+      continue;
+    }
+
     if ((strcmp(argv[0], "-q") == 0) || (stricmp (argv[0], "--quiet") == 0)) {
       QuietMode = TRUE;
       argc--;
@@ -1869,6 +2339,10 @@ Returns:
     goto ERROR;
   }
 
+  if (mOptimalParse && mChainDepth == 0) {
+    mChainDepth = HC_DEFAULT_DEPTH;
+  }
+
 //
 // All Parameters has been parsed, now set the message print level
 //
@@ -1935,21 +2409,29 @@ Returns:
     
   if (ENCODE) {
   //
-  // First call TianoCompress to get DstSize
+  // Compress into a buffer large enough for all but incompressible input,
+  // and only compress again if TianoCompress reports it is too small.
   //
   if (DebugMode) {
     DebugMsg(UTILITY_NAME, 0, DebugLevel, "Encoding", NULL);
   }
+  DstSize   = InputLength + InputLength / 8 + 64;
+  OutBuffer = (UINT8 *) malloc (DstSize);
+  if (OutBuffer == NULL) {
+    Error (NULL, 0, 4001, "Resource:", "Memory cannot be allocated!");
+    goto ERROR;
+  }
   Status = TianoCompress ((UINT8 *)FileBuffer, InputLength, OutBuffer, &DstSize);
   
   if (Status == EFI_BUFFER_TOO_SMALL) {
+    free (OutBuffer);
     OutBuffer = (UINT8 *) malloc (DstSize);
     if (OutBuffer == NULL) {
       Error (NULL, 0, 4001, "Resource:", "Memory cannot be allocated!");
       goto ERROR;
     }
+    Status = TianoCompress ((UINT8 *)FileBuffer, InputLength, OutBuffer, &DstSize);
   }
-  Status = TianoCompress ((UINT8 *)FileBuffer, InputLength, OutBuffer, &DstSize);
   if (Status != EFI_SUCCESS) {
     Error (NULL, 0, 0007, "Error compressing file", NULL);
     goto ERROR;
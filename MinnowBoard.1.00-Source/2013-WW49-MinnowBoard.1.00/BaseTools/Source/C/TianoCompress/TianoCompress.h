@@ -27,7 +27,7 @@
 //
 #define UTILITY_NAME "TianoCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 1
+#define UTILITY_MINOR_VERSION 2
 
 //
 // Default output file name
@@ -161,6 +161,40 @@ GetNextMatch (
   VOID
   );
 
+STATIC
+VOID
+HashChainInsert (
+  IN UINT32 Pos
+  );
+
+STATIC
+UINT32
+HashChainFindMatch (
+  IN  UINT32  Pos,
+  IN  UINT32  MaxLen,
+  OUT UINT32  *Lengths,
+  OUT UINT32  *Distances,
+  OUT UINT32  *Count
+  );
+
+STATIC
+VOID
+HashChainParse (
+  VOID
+  );
+
+STATIC
+VOID
+UpdatePrices (
+  VOID
+  );
+
+STATIC
+VOID
+OptimalParse (
+  VOID
+  );
+
 STATIC
 EFI_STATUS
 Encode (
@@ -33,13 +33,15 @@ class Tests(TestTools.BaseToolsTest):
         #self.DisplayFile('help')
         self.assertTrue(result == 0)
 
-    def compressionTestCycle(self, data):
+    def compressionTestCycle(self, data, *options):
         path = self.GetTmpFilePath('input')
         self.WriteTmpFile('input', data)
         result = self.RunTool(
             '-e',
-            '-o', self.GetTmpFilePath('output1'),
-            self.GetTmpFilePath('input')
+            *(options + (
+                '-o', self.GetTmpFilePath('output1'),
+                self.GetTmpFilePath('input')
+                ))
             )
         self.assertTrue(result == 0)
         result = self.RunTool(
@@ -65,6 +67,18 @@ class Tests(TestTools.BaseToolsTest):
             self.compressionTestCycle(data)
             self.CleanUpTmpDir()
 
+    def testHashChainCycles(self):
+        for depth in ('1', '16', '256'):
+            data = self.GetRandomString(1024, 2048) * 4
+            self.compressionTestCycle(data, '--chain-depth', depth)
+            self.CleanUpTmpDir()
+
+    def testOptimalParseCycles(self):
+        for i in range(4):
+            data = self.GetRandomString(1024, 2048) * 4
+            self.compressionTestCycle(data, '--optimal')
+            self.CleanUpTmpDir()
+
 TheTestSuite = TestTools.MakeTheTestSuite(locals())
 
 if __name__ == '__main__':
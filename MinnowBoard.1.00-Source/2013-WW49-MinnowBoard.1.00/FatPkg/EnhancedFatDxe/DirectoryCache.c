@@ -56,6 +56,7 @@ Returns:
     FatFreeDirEnt (DirEnt);
   }
 
+  FatFreeHashTable (ODir);
   FreePool (ODir);
 }
 
@@ -90,11 +91,92 @@ Returns:
     ODir->Signature = FAT_ODIR_SIGNATURE;
     InitializeListHead (&ODir->ChildList);
     ODir->CurrentCursor = &ODir->ChildList;
+    if (EFI_ERROR (FatInitializeHashTable (ODir))) {
+      FreePool (ODir);
+      ODir = NULL;
+    }
   }
 
   return ODir;
 }
 
+STATIC
+UINTN
+FatODirSize (
+  IN FAT_ODIR    *ODir
+  )
+/*++
+
+Routine Description:
+
+  Get the memory taken by a directory structure, counted against the
+  volume's directory cache limit.
+
+Arguments:
+
+  ODir                  - The directory.
+
+Returns:
+
+  The size in bytes.
+
+--*/
+{
+  return sizeof (FAT_ODIR) + 2 * ODir->HashTableSize * sizeof (FAT_DIRENT *) + ODir->DirEntSize;
+}
+
+STATIC
+VOID
+FatTrimODirCache (
+  IN FAT_VOLUME  *Volume
+  )
+/*++
+
+Routine Description:
+
+  Free cached directories until the cache is within its count and memory
+  limits. The least recently used small directory goes first; large ones
+  are only freed when no small one is left. The most recently cached
+  directory is always kept.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_ODIR    *ODir;
+  LIST_ENTRY  *Link;
+
+  while (Volume->DirCacheCount > 1 &&
+         (Volume->DirCacheCount > FAT_MAX_DIR_CACHE_COUNT || Volume->DirCacheSize > FAT_MAX_DIR_CACHE_SIZE)) {
+    ODir = NULL;
+    for (Link = Volume->DirCacheList.BackLink;
+         Link != Volume->DirCacheList.ForwardLink;
+         Link = Link->BackLink
+        ) {
+      ODir = ODIR_FROM_DIRCACHELINK (Link);
+      if (ODir->DirEntCount <= FAT_DIR_CACHE_LARGE_COUNT) {
+        break;
+      }
+      ODir = NULL;
+    }
+
+    if (ODir == NULL) {
+      ODir = ODIR_FROM_DIRCACHELINK (Volume->DirCacheList.BackLink);
+    }
+
+    RemoveEntryList (&ODir->DirCacheLink);
+    Volume->DirCacheCount--;
+    Volume->DirCacheSize -= FatODirSize (ODir);
+    FatFreeODir (ODir);
+  }
+}
+
 VOID
 FatDiscardODir (
   IN FAT_OFILE    *OFile
@@ -128,19 +210,13 @@ Returns:
     //
     ODir->DirCacheTag = OFile->FileCluster;
     InsertHeadList (&Volume->DirCacheList, &ODir->DirCacheLink);
-    if (Volume->DirCacheCount == FAT_MAX_DIR_CACHE_COUNT) {
-      //
-      // Replace the least recent used directory
-      //
-      ODir = ODIR_FROM_DIRCACHELINK (Volume->DirCacheList.BackLink);
-      RemoveEntryList (&ODir->DirCacheLink);
-    } else {
-      //
-      // No need to find a replace
-      //
-      Volume->DirCacheCount++;
-      ODir = NULL;
-    }
+    Volume->DirCacheCount++;
+    Volume->DirCacheSize += FatODirSize (ODir);
+    ODir = NULL;
+    //
+    // Make room by releasing least recently used directories
+    //
+    FatTrimODirCache (Volume);
   }
   //
   // Release ODir Structure
@@ -189,6 +265,7 @@ Returns:
     if (CurrentODir->DirCacheTag == DirCacheTag) {
       RemoveEntryList (&CurrentODir->DirCacheLink);
       Volume->DirCacheCount--;
+      Volume->DirCacheSize -= FatODirSize (CurrentODir);
       ODir = CurrentODir;
       break;
     }
@@ -228,6 +305,7 @@ Returns:
   while (Volume->DirCacheCount > 0) {
     ODir = ODIR_FROM_DIRCACHELINK (Volume->DirCacheList.BackLink);
     RemoveEntryList (&ODir->DirCacheLink);
+    Volume->DirCacheSize -= FatODirSize (ODir);
     FatFreeODir (ODir);
     Volume->DirCacheCount--;
   }
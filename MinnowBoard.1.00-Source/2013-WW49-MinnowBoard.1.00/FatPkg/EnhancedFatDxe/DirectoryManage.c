@@ -1386,6 +1386,10 @@ Returns:
     RemoveEntryList (&OFile->ChildLink);
   }
 
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+  }
+
   FreePool (OFile);
   DirEnt->OFile = NULL;
   if (DirEnt->Invalid == TRUE) {
@@ -105,31 +105,38 @@ FatExchangeCachePage (
   IN FAT_VOLUME         *Volume,
   IN CACHE_DATA_TYPE    DataType,
   IN IO_MODE            IoMode,
-  IN CACHE_TAG          *CacheTag
+  IN CACHE_TAG          *CacheTag,
+  IN UINTN              PageCount
   )
 /*++
 
 Routine Description:
 
-  Exchange the cache page with the image on the disk
+  Exchange the cache pages with the image on the disk. The pages must be
+  consecutive both in the cache and on the disk, so that they are moved
+  in one disk access.
 
 Arguments:
 
   Volume                - FAT file system volume.
   DataType              - Indicate the cache type.
-  IoMode                - Indicate whether to load this page from disk or store this page to disk.
-  CacheTag              - The Cache Tag for the current cache page.
+  IoMode                - Indicate whether to load these pages from disk or store these pages to disk.
+  CacheTag              - The Cache Tag for the first cache page.
+  PageCount             - The number of cache pages.
 
 Returns:
 
-  EFI_SUCCESS           - Cache page exchanged successfully.
-  Others                - An error occurred when exchanging cache page.
+  EFI_SUCCESS           - Cache pages exchanged successfully.
+  Others                - An error occurred when exchanging cache pages.
 
 --*/
 {
   EFI_STATUS  Status;
   UINTN       GroupNo;
   UINTN       PageNo;
+  UINTN       PageSize;
+  UINTN       PageOffset;
+  UINTN       Index;
   UINTN       WriteCount;
   UINTN       RealSize;
   UINT64      EntryPos;
@@ -142,16 +149,18 @@ Returns:
   PageNo        = CacheTag->PageNo;
   GroupNo       = PageNo & DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
   PageAddress   = DiskCache->CacheBase + (GroupNo << PageAlignment);
   EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
-  RealSize      = CacheTag->RealSize;
   if (IoMode == READ_DISK) {
-    RealSize  = (UINTN)1 << PageAlignment;
+    RealSize  = PageCount << PageAlignment;
     MaxSize   = DiskCache->LimitAddress - EntryPos;
     if (MaxSize < RealSize) {
       DEBUG ((EFI_D_INFO, "FatDiskIo: Cache Page OutBound occurred! \n"));
       RealSize = (UINTN) MaxSize;
     }
+  } else {
+    RealSize  = ((PageCount - 1) << PageAlignment) + CacheTag[PageCount - 1].RealSize;
   }
 
   WriteCount = 1;
@@ -171,8 +180,133 @@ Returns:
     EntryPos += Volume->FatSize;
   } while (--WriteCount > 0);
 
-  CacheTag->Dirty     = FALSE;
-  CacheTag->RealSize  = RealSize;
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag[Index].Dirty = FALSE;
+    if (IoMode == READ_DISK) {
+      PageOffset                = Index << PageAlignment;
+      CacheTag[Index].RealSize  = 0;
+      if (PageOffset < RealSize) {
+        CacheTag[Index].RealSize = MIN (PageSize, RealSize - PageOffset);
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FatCountCacheHit (
+  IN FAT_VOLUME         *Volume,
+  IN CACHE_TAG          *CacheTag
+  )
+/*++
+
+Routine Description:
+
+  Count a hit in the data cache, and whether the page was read ahead.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  CacheTag              - The Cache Tag of the page hit.
+
+Returns:
+
+  None.
+
+--*/
+{
+  Volume->CacheStatistics.CacheHits++;
+  if (CacheTag->ReadAhead) {
+    Volume->CacheStatistics.ReadAheadHits++;
+    CacheTag->ReadAhead = FALSE;
+  }
+}
+
+STATIC
+EFI_STATUS
+FatReadAlignedPages (
+  IN  FAT_VOLUME         *Volume,
+  IN  UINTN              PageNo,
+  IN  UINTN              PageCount,
+  OUT UINT8              *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Read whole data pages into Buffer. Pages in the data cache are copied
+  from it, and each run of the other pages is read from the disk directly.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  PageNo                - The first page to read.
+  PageCount             - The number of pages to read.
+  Buffer                - The buffer to read into.
+
+Returns:
+
+  EFI_SUCCESS           - The pages were read.
+  Others                - An error occurred when reading from the disk.
+
+--*/
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       GroupNo;
+  UINTN       Index;
+  UINTN       RunCount;
+  UINT8       PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[CACHE_DATA];
+  PageAlignment = DiskCache->PageAlignment;
+
+  Index = 0;
+  while (Index < PageCount) {
+    GroupNo   = (PageNo + Index) & DiskCache->GroupMask;
+    CacheTag  = &DiskCache->CacheTag[GroupNo];
+    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo + Index) {
+      FatCountCacheHit (Volume, CacheTag);
+      CopyMem (
+        Buffer + (Index << PageAlignment),
+        DiskCache->CacheBase + (GroupNo << PageAlignment),
+        (UINTN)1 << PageAlignment
+        );
+      Index++;
+      continue;
+    }
+    //
+    // Read the run of pages missing from the cache in one access
+    //
+    RunCount = 1;
+    while (Index + RunCount < PageCount) {
+      GroupNo   = (PageNo + Index + RunCount) & DiskCache->GroupMask;
+      CacheTag  = &DiskCache->CacheTag[GroupNo];
+      if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo + Index + RunCount) {
+        break;
+      }
+
+      RunCount++;
+    }
+
+    Status = FatDiskIo (
+               Volume,
+               READ_DISK,
+               DiskCache->BaseAddress + LShiftU64 (PageNo + Index, PageAlignment),
+               RunCount << PageAlignment,
+               Buffer + (Index << PageAlignment)
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Volume->CacheStatistics.CacheMisses += RunCount;
+    Index += RunCount;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -212,6 +346,10 @@ Returns:
     //
     // Cache Hit occurred
     //
+    if (CacheDataType == CACHE_DATA) {
+      FatCountCacheHit (Volume, CacheTag);
+    }
+
     return EFI_SUCCESS;
   }
 
@@ -219,16 +357,26 @@ Returns:
   // Write dirty cache page back to disk
   //
   if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
-    Status = FatExchangeCachePage (Volume, CacheDataType, WRITE_DISK, CacheTag);
+    Status = FatExchangeCachePage (Volume, CacheDataType, WRITE_DISK, CacheTag, 1);
     if (EFI_ERROR (Status)) {
       return Status;
     }
+
+    if (CacheDataType == CACHE_DATA) {
+      Volume->CacheStatistics.WriteBehindPages++;
+      Volume->CacheStatistics.WriteBehindRuns++;
+    }
   }
   //
   // Load new data from disk;
   //
-  CacheTag->PageNo  = PageNo;
-  Status            = FatExchangeCachePage (Volume, CacheDataType, READ_DISK, CacheTag);
+  if (CacheDataType == CACHE_DATA) {
+    Volume->CacheStatistics.CacheMisses++;
+  }
+
+  CacheTag->PageNo    = PageNo;
+  CacheTag->ReadAhead = FALSE;
+  Status              = FatExchangeCachePage (Volume, CacheDataType, READ_DISK, CacheTag, 1);
 
   return Status;
 }
@@ -387,17 +535,29 @@ Returns:
     //
     ASSERT (CacheDataType == CACHE_DATA);
 
-    EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
     AlignedSize = AlignedPageCount << PageAlignment;
-    Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer);
-    if (EFI_ERROR (Status)) {
-      return Status;
+    if (IoMode == READ_DISK) {
+      //
+      // Pages already in the cache, such as those read ahead, are copied
+      // from it, which also picks up the dirty ones
+      //
+      Status = FatReadAlignedPages (Volume, PageNo, AlignedPageCount, Buffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    } else {
+      EntryPos  = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
+      Status    = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      //
+      // If these access data over laps the relative cache range, these cache pages need
+      // to be updated.
+      //
+      FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
     }
-    //
-    // If these access data over laps the relative cache range, these cache pages need
-    // to be updated.
-    //
-    FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
+
     Buffer      += AlignedSize;
     BufferSize  -= AlignedSize;
   }
@@ -440,6 +600,8 @@ Returns:
   CACHE_DATA_TYPE CacheDataType;
   UINTN           GroupIndex;
   UINTN           GroupMask;
+  UINTN           PageCount;
+  UINTN           PageSize;
   DISK_CACHE      *DiskCache;
   CACHE_TAG       *CacheTag;
 
@@ -450,16 +612,34 @@ Returns:
       // Data cache or fat cache is dirty, write the dirty data back
       //
       GroupMask = DiskCache->GroupMask;
-      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
-        CacheTag = &DiskCache->CacheTag[GroupIndex];
+      PageSize  = (UINTN)1 << DiskCache->PageAlignment;
+      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex += PageCount) {
+        CacheTag  = &DiskCache->CacheTag[GroupIndex];
+        PageCount = 1;
         if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
+          //
+          // Dirty pages in the next groups that follow this one on the disk
+          // are written back with it in one access
+          //
+          while (GroupIndex + PageCount <= GroupMask &&
+                 CacheTag[PageCount - 1].RealSize == PageSize &&
+                 CacheTag[PageCount].RealSize > 0 &&
+                 CacheTag[PageCount].Dirty &&
+                 CacheTag[PageCount].PageNo == CacheTag->PageNo + PageCount) {
+            PageCount++;
+          }
           //
           // Write back all Dirty Data Cache Page to disk
           //
-          Status = FatExchangeCachePage (Volume, CacheDataType, WRITE_DISK, CacheTag);
+          Status = FatExchangeCachePage (Volume, CacheDataType, WRITE_DISK, CacheTag, PageCount);
           if (EFI_ERROR (Status)) {
             return Status;
           }
+
+          if (CacheDataType == CACHE_DATA) {
+            Volume->CacheStatistics.WriteBehindPages += PageCount;
+            Volume->CacheStatistics.WriteBehindRuns++;
+          }
         }
       }
 
@@ -473,6 +653,105 @@ Returns:
   return Status;
 }
 
+EFI_STATUS
+FatReadAheadCache (
+  IN FAT_VOLUME         *Volume,
+  IN UINT64             Offset,
+  IN UINTN              Length
+  )
+/*++
+
+Routine Description:
+
+  Load the data pages covering Length bytes from the disk position Offset
+  into the data cache, ahead of a sequential reader. Pages that are cached
+  already are left alone, and each run of the others that is consecutive
+  in the cache is read in one disk access.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Offset                - The starting byte offset on the disk.
+  Length                - The number of bytes to read ahead.
+
+Returns:
+
+  EFI_SUCCESS           - The data was read into the cache.
+  Others                - An error occurred when accessing the disk.
+
+--*/
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       PageNo;
+  UINTN       EndPageNo;
+  UINTN       GroupNo;
+  UINTN       PageCount;
+  UINTN       Index;
+  UINT64      EntryPos;
+  UINT8       PageAlignment;
+
+  if (Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DiskCache     = &Volume->DiskCache[CACHE_DATA];
+  PageAlignment = DiskCache->PageAlignment;
+  EntryPos      = Offset - DiskCache->BaseAddress;
+  PageNo        = (UINTN) RShiftU64 (EntryPos, PageAlignment);
+  EndPageNo     = (UINTN) RShiftU64 (EntryPos + Length - 1, PageAlignment) + 1;
+
+  while (PageNo < EndPageNo) {
+    GroupNo   = PageNo & DiskCache->GroupMask;
+    CacheTag  = &DiskCache->CacheTag[GroupNo];
+    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
+      PageNo++;
+      continue;
+    }
+    //
+    // Gather the run of missing pages, up to the end of the cache buffer
+    //
+    PageCount = 1;
+    while (PageNo + PageCount < EndPageNo &&
+           GroupNo + PageCount <= DiskCache->GroupMask &&
+           !(CacheTag[PageCount].RealSize > 0 && CacheTag[PageCount].PageNo == PageNo + PageCount)) {
+      PageCount++;
+    }
+    //
+    // Write back the dirty pages being replaced
+    //
+    for (Index = 0; Index < PageCount; Index++) {
+      if (CacheTag[Index].RealSize > 0 && CacheTag[Index].Dirty) {
+        Status = FatExchangeCachePage (Volume, CACHE_DATA, WRITE_DISK, &CacheTag[Index], 1);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        Volume->CacheStatistics.WriteBehindPages++;
+        Volume->CacheStatistics.WriteBehindRuns++;
+      }
+
+      CacheTag[Index].PageNo    = PageNo + Index;
+      CacheTag[Index].ReadAhead = TRUE;
+    }
+
+    Status = FatExchangeCachePage (Volume, CACHE_DATA, READ_DISK, CacheTag, PageCount);
+    if (EFI_ERROR (Status)) {
+      for (Index = 0; Index < PageCount; Index++) {
+        CacheTag[Index].RealSize = 0;
+      }
+
+      return Status;
+    }
+
+    Volume->CacheStatistics.ReadAheadPages += PageCount;
+    PageNo += PageCount;
+  }
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 FatInitializeDiskCache (
   IN FAT_VOLUME         *Volume
@@ -26,6 +26,7 @@ Revision History
 #include <Guid/FileInfo.h>
 #include <Guid/FileSystemInfo.h>
 #include <Guid/FileSystemVolumeLabelInfo.h>
+#include <Guid/FatCacheStatisticsInfo.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/DiskIo.h>
 #include <Protocol/SimpleFileSystem.h>
@@ -93,6 +94,13 @@ Revision History
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// Read-ahead window of sequential readers in data cache pages. The window
+// doubles on each sequential read, up to a quarter of the data cache.
+//
+#define FAT_READ_AHEAD_MIN_PAGES          2
+#define FAT_READ_AHEAD_MAX_PAGES          (FAT_DATACACHE_GROUP_COUNT / 4)
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -113,8 +121,24 @@ Revision History
 #define LC_ISO_639_2_ENTRY_SIZE 3
 #define MAX_LANG_CODE_SIZE      100
 
-#define FAT_MAX_DIR_CACHE_COUNT 8
+//
+// Closed directories are cached per volume, least recently used first out,
+// within both a count and a memory limit. Directories with more entries than
+// FAT_DIR_CACHE_LARGE_COUNT are evicted only when no smaller one is left,
+// as they are the most expensive to scan again.
+//
+#define FAT_MAX_DIR_CACHE_COUNT     64
+#define FAT_MAX_DIR_CACHE_SIZE      0x400000
+#define FAT_DIR_CACHE_LARGE_COUNT   0x400
 #define FAT_MAX_DIRENTRY_COUNT  0xFFFF
+
+//
+// Free cluster bitmap, one bit per cluster, set when the cluster is free
+//
+#define FAT_FREE_MAP_READ_SIZE        0x10000
+#define FAT_FREE_MAP_IS_FREE(Map, Cluster)  (((Map)[(Cluster) >> 3] & (1 << ((Cluster) & 7))) != 0)
+#define FAT_FREE_MAP_SET(Map, Cluster)      ((Map)[(Cluster) >> 3] |= (UINT8) (1 << ((Cluster) & 7)))
+#define FAT_FREE_MAP_CLEAR(Map, Cluster)    ((Map)[(Cluster) >> 3] &= (UINT8) ~(1 << ((Cluster) & 7)))
 typedef CHAR8                   LC_ISO_639_2;
 
 //
@@ -156,6 +180,7 @@ typedef struct {
   UINTN   PageNo;
   UINTN   RealSize;
   BOOLEAN Dirty;
+  BOOLEAN ReadAhead;  // Read ahead and not yet used
 } CACHE_TAG;
 
 typedef struct {
@@ -169,10 +194,12 @@ typedef struct {
 } DISK_CACHE;
 
 //
-// Hash table size
+// Hash table size. A directory starts with the minimum and its tables grow
+// four times whenever they hold more entries than buckets.
 //
-#define HASH_TABLE_SIZE  0x400
-#define HASH_TABLE_MASK  (HASH_TABLE_SIZE - 1)
+#define HASH_TABLE_MIN_SIZE   0x40
+#define HASH_TABLE_MAX_SIZE   0x10000
+#define HASH_TABLE_GROWTH     4
 
 //
 // The directory entry for opened directory
@@ -199,8 +226,11 @@ typedef struct _FAT_ODIR {
   BOOLEAN             EndOfDir;               // Indicate whether we have reached the end of the directory
   LIST_ENTRY          DirCacheLink;           // Linked in Volume->DirCacheList when discarded
   UINTN               DirCacheTag;            // The identification of the directory when in directory cache
-  FAT_DIRENT          *LongNameHashTable[HASH_TABLE_SIZE];
-  FAT_DIRENT          *ShortNameHashTable[HASH_TABLE_SIZE];
+  UINTN               HashTableSize;          // The number of buckets in each hash table, a power of 2
+  UINTN               DirEntCount;            // The number of directory entries in the hash tables
+  UINTN               DirEntSize;             // The memory taken by those directory entries and their names
+  FAT_DIRENT          **LongNameHashTable;
+  FAT_DIRENT          **ShortNameHashTable;
 } FAT_ODIR;
 
 typedef struct {
@@ -212,6 +242,17 @@ typedef struct {
   LIST_ENTRY          Link;
 } FAT_IFILE;
 
+//
+// A run of clusters that are consecutive both in the file and on the disk
+//
+typedef struct {
+  UINT32              FileCluster;            // Index of the first cluster of the run within the file
+  UINT32              DiskCluster;            // The first cluster of the run on the disk
+  UINT32              Length;                 // The number of clusters in the run
+} FAT_EXTENT;
+
+#define FAT_EXTENT_MAP_INITIAL_COUNT  16
+
 //
 // FAT_OFILE - Each opened file
 //
@@ -255,6 +296,23 @@ typedef struct _FAT_OFILE {
   UINT64              PosDisk;  // on the disk
   UINTN               PosRem;   // remaining in this disk run
   //
+  // Extent map of the cluster chain, built lazily as positions are
+  // resolved. It covers the first ExtentClusters clusters of the file.
+  //
+  FAT_EXTENT          *Extents;
+  UINTN               ExtentCount;
+  UINTN               ExtentCapacity;
+  UINTN               ExtentClusters;
+  UINTN               ExtentHint;
+  //
+  // Sequential read detection. ReadAheadNext is where the next read of a
+  // sequential reader starts, and the data up to ReadAheadLimit has been
+  // read into the data cache already.
+  //
+  UINTN               ReadAheadNext;
+  UINTN               ReadAheadLimit;
+  UINTN               ReadAheadPages;
+  //
   // The opened parent, full path length and currently opened child files
   //
   struct _FAT_OFILE   *Parent;
@@ -317,6 +375,7 @@ typedef struct _FAT_VOLUME {
   FAT_INFO_SECTOR                 FatInfoSector;  // Free cluster info
   UINTN                           FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                         FreeInfoValid;  // If free cluster info is valid
+  UINT8                           *FreeMap;       // Free cluster bitmap, NULL if not built
   //
   // Unpacked Fat BPB info
   //
@@ -351,12 +410,14 @@ typedef struct _FAT_VOLUME {
   //
   LIST_ENTRY                      DirCacheList;
   UINTN                           DirCacheCount;
+  UINTN                           DirCacheSize;
 
   //
   // Disk Cache for this volume
   //
   VOID                            *CacheBuffer;
   DISK_CACHE                      DiskCache[CACHE_MAX_TYPE];
+  FAT_CACHE_STATISTICS_INFO       CacheStatistics;
 } FAT_VOLUME;
 
 //
@@ -661,6 +722,13 @@ FatVolumeFlushCache (
   IN FAT_VOLUME              *Volume
   );
 
+EFI_STATUS
+FatReadAheadCache (
+  IN FAT_VOLUME              *Volume,
+  IN UINT64                  Offset,
+  IN UINTN                   Length
+  );
+
 //
 // Flush.c
 //
@@ -730,6 +798,11 @@ FatComputeFreeInfo (
   IN FAT_VOLUME         *Volume
   );
 
+EFI_STATUS
+FatInitializeFreeMap (
+  IN FAT_VOLUME         *Volume
+  );
+
 //
 // Init.c
 //
@@ -854,6 +927,11 @@ FatStriCmp (
   IN CHAR16             *Str2
   );
 
+UINT32
+FatStriHash (
+  IN CHAR16             *Str
+  );
+
 //
 // Open.c
 //
@@ -1009,6 +1087,16 @@ FatSetVolumeEntry (
 //
 // Hash.c
 //
+EFI_STATUS
+FatInitializeHashTable (
+  IN FAT_ODIR           *ODir
+  );
+
+VOID
+FatFreeHashTable (
+  IN FAT_ODIR           *ODir
+  );
+
 FAT_DIRENT **
 FatLongNameHashSearch (
   IN FAT_ODIR           *ODir,
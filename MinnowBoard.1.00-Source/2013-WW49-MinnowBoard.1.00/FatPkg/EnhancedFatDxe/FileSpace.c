@@ -193,6 +193,16 @@ Returns:
     }
   }
   //
+  // Keep the free cluster bitmap in step with the FAT
+  //
+  if (Volume->FreeMap != NULL && Index <= Volume->MaxCluster + 1) {
+    if (Value == FAT_CLUSTER_FREE) {
+      FAT_FREE_MAP_SET (Volume->FreeMap, Index);
+    } else {
+      FAT_FREE_MAP_CLEAR (Volume->FreeMap, Index);
+    }
+  }
+  //
   // Make sure the entry is in memory
   //
   Pos = FatLoadFatEntry (Volume, Index);
@@ -348,6 +358,174 @@ Returns:
   return Cluster;
 }
 
+STATIC
+UINTN
+FatFindFreeRun (
+  IN  FAT_VOLUME          *Volume,
+  IN  UINTN               Start,
+  IN  UINTN               End,
+  IN  UINTN               Wanted,
+  OUT UINTN               *Length
+  )
+/*++
+
+Routine Description:
+
+  Search the free cluster bitmap between Start and End for the first run of
+  Wanted free clusters, or failing that for the longest run there is.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Start                 - The first cluster to search.
+  End                   - The cluster after the last one to search.
+  Wanted                - The number of clusters wanted.
+  Length                - The number of free clusters found, at most Wanted.
+
+Returns:
+
+  The first cluster of the run found.
+
+--*/
+{
+  UINT8 *FreeMap;
+  UINTN Cluster;
+  UINTN RunStart;
+  UINTN BestStart;
+  UINTN BestLength;
+
+  FreeMap     = Volume->FreeMap;
+  BestStart   = FAT_CLUSTER_FREE;
+  BestLength  = 0;
+  Cluster     = Start;
+
+  while (Cluster < End) {
+    if (!FAT_FREE_MAP_IS_FREE (FreeMap, Cluster)) {
+      //
+      // Skip whole bytes of allocated clusters at a time
+      //
+      if ((Cluster & 7) == 0 && FreeMap[Cluster >> 3] == 0) {
+        Cluster += 8;
+      } else {
+        Cluster += 1;
+      }
+
+      continue;
+    }
+
+    RunStart = Cluster;
+    while (Cluster < End && Cluster - RunStart < Wanted && FAT_FREE_MAP_IS_FREE (FreeMap, Cluster)) {
+      Cluster++;
+    }
+
+    if (Cluster - RunStart > BestLength) {
+      BestStart   = RunStart;
+      BestLength  = Cluster - RunStart;
+      if (BestLength == Wanted) {
+        break;
+      }
+    }
+  }
+
+  *Length = BestLength;
+  return BestStart;
+}
+
+STATIC
+UINTN
+FatAllocateClusterRun (
+  IN  FAT_VOLUME          *Volume,
+  IN  UINTN               LastCluster,
+  IN  UINTN               Wanted,
+  OUT UINTN               *Length
+  )
+/*++
+
+Routine Description:
+
+  Allocate a run of consecutive free clusters for a file. The clusters right
+  after the file's last cluster are preferred, then the first run that is
+  long enough, then the longest run on the volume. Without a free cluster
+  bitmap a single cluster is allocated.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  LastCluster           - The last cluster of the file, FAT_CLUSTER_FREE if it has none.
+  Wanted                - The number of clusters wanted, at least 1.
+  Length                - The number of clusters allocated.
+
+Returns:
+
+  The first cluster of the run, or FAT_CLUSTER_LAST if the volume is full.
+
+--*/
+{
+  UINT8 *FreeMap;
+  UINTN End;
+  UINTN NextCluster;
+  UINTN Cluster;
+  UINTN RunLength;
+  UINTN WrapCluster;
+  UINTN WrapLength;
+  UINTN Index;
+
+  FreeMap = Volume->FreeMap;
+  if (FreeMap == NULL || Volume->DiskError) {
+    *Length = 1;
+    return FatAllocateCluster (Volume);
+  }
+
+  End         = Volume->MaxCluster + 2;
+  NextCluster = Volume->FatInfoSector.FreeInfo.NextCluster;
+  if (NextCluster < FAT_MIN_CLUSTER || NextCluster > End) {
+    NextCluster = FAT_MIN_CLUSTER;
+  }
+  //
+  // Continue the file in place if the space after it is free
+  //
+  Cluster = FAT_CLUSTER_FREE;
+  if (LastCluster != FAT_CLUSTER_FREE && LastCluster + 1 < End) {
+    Cluster = FatFindFreeRun (Volume, LastCluster + 1, LastCluster + 2, 1, &RunLength);
+  }
+
+  if (Cluster != FAT_CLUSTER_FREE) {
+    RunLength = 0;
+    while (Cluster + RunLength < End && RunLength < Wanted && FAT_FREE_MAP_IS_FREE (FreeMap, Cluster + RunLength)) {
+      RunLength++;
+    }
+  } else {
+    //
+    // Search from the allocation hint to the end of the volume, and wrap
+    // around to the start if that did not find a run that is long enough
+    //
+    Cluster = FatFindFreeRun (Volume, NextCluster, End, Wanted, &RunLength);
+    if (RunLength < Wanted && NextCluster > FAT_MIN_CLUSTER) {
+      WrapCluster = FatFindFreeRun (Volume, FAT_MIN_CLUSTER, NextCluster, Wanted, &WrapLength);
+      if (WrapLength > RunLength) {
+        Cluster   = WrapCluster;
+        RunLength = WrapLength;
+      }
+    }
+
+    if (RunLength == 0) {
+      *Length = 0;
+      return (UINTN) FAT_CLUSTER_LAST;
+    }
+  }
+  //
+  // The clusters are taken off the bitmap now, and their FAT entries are
+  // set as the caller links them into the file
+  //
+  for (Index = 0; Index < RunLength; Index++) {
+    FAT_FREE_MAP_CLEAR (FreeMap, Cluster + Index);
+  }
+
+  Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) (Cluster + RunLength);
+  *Length = RunLength;
+  return Cluster;
+}
+
 STATIC
 UINTN
 FatSizeToClusters (
@@ -454,6 +632,12 @@ Returns:
   OFile->FileLastCluster    = LastCluster;
   OFile->Dirty              = TRUE;
   //
+  // The tail of the chain is going away, so the extent map must be rebuilt
+  //
+  OFile->ExtentCount        = 0;
+  OFile->ExtentClusters     = 0;
+  OFile->ExtentHint         = 0;
+  //
   // Free the remaining cluster chain
   //
   return FatFreeClusters (Volume, Cluster);
@@ -492,6 +676,7 @@ Returns:
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  UINTN       RunLength;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -548,7 +733,7 @@ Returns:
     LastCluster = OFile->FileLastCluster;
 
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      NewCluster = FatAllocateClusterRun (Volume, LastCluster, NewSize - CurSize, &RunLength);
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
           FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
@@ -559,15 +744,18 @@ Returns:
         goto Done;
       }
 
-      if (LastCluster != 0) {
-        FatSetFatEntry (Volume, LastCluster, NewCluster);
-      } else {
-        OFile->FileCluster        = NewCluster;
-        OFile->FileCurrentCluster = NewCluster;
-      }
+      for (ClusterCount = 0; ClusterCount < RunLength; ClusterCount++) {
+        if (LastCluster != 0) {
+          FatSetFatEntry (Volume, LastCluster, NewCluster);
+        } else {
+          OFile->FileCluster        = NewCluster;
+          OFile->FileCurrentCluster = NewCluster;
+        }
 
-      LastCluster = NewCluster;
-      CurSize += 1;
+        LastCluster = NewCluster;
+        NewCluster += 1;
+        CurSize    += 1;
+      }
     }
     //
     // Terminate the cluster list
@@ -585,6 +773,97 @@ Done:
   return Status;
 }
 
+STATIC
+EFI_STATUS
+FatExtendExtentMap (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Clusters
+  )
+/*++
+
+Routine Description:
+
+  Follow the cluster chain of the open file from where its extent map ends
+  until the map covers the requested number of clusters or the chain ends.
+  Growing the file only appends to the chain, so the map stays valid then.
+
+Arguments:
+
+  OFile                 - The open file.
+  Clusters              - The number of clusters from the start of the file to map.
+
+Returns:
+
+  EFI_SUCCESS           - The map covers Clusters clusters or the whole chain.
+  EFI_OUT_OF_RESOURCES  - Not enough memory to grow the map.
+  EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *NewExtents;
+  UINTN       NewCapacity;
+  UINTN       Cluster;
+
+  if (OFile->ExtentClusters >= Clusters) {
+    return EFI_SUCCESS;
+  }
+
+  Volume = OFile->Volume;
+  Extent = NULL;
+  if (OFile->ExtentCount == 0) {
+    Cluster = OFile->FileCluster;
+    if (Cluster == FAT_CLUSTER_FREE) {
+      return EFI_SUCCESS;
+    }
+  } else {
+    Extent  = &OFile->Extents[OFile->ExtentCount - 1];
+    Cluster = FatGetFatEntry (Volume, Extent->DiskCluster + Extent->Length - 1);
+  }
+
+  while (OFile->ExtentClusters < Clusters && !FAT_END_OF_FAT_CHAIN (Cluster)) {
+    if (Cluster < FAT_MIN_CLUSTER || Cluster >= FAT_CLUSTER_SPECIAL) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    if (Extent != NULL && Extent->DiskCluster + Extent->Length == Cluster) {
+      Extent->Length++;
+    } else {
+      if (OFile->ExtentCount == OFile->ExtentCapacity) {
+        NewCapacity = OFile->ExtentCapacity * 2;
+        if (NewCapacity == 0) {
+          NewCapacity = FAT_EXTENT_MAP_INITIAL_COUNT;
+        }
+
+        NewExtents = ReallocatePool (
+                       OFile->ExtentCapacity * sizeof (FAT_EXTENT),
+                       NewCapacity * sizeof (FAT_EXTENT),
+                       OFile->Extents
+                       );
+        if (NewExtents == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+
+        OFile->Extents        = NewExtents;
+        OFile->ExtentCapacity = NewCapacity;
+      }
+
+      Extent              = &OFile->Extents[OFile->ExtentCount];
+      Extent->FileCluster = (UINT32) OFile->ExtentClusters;
+      Extent->DiskCluster = (UINT32) Cluster;
+      Extent->Length      = 1;
+      OFile->ExtentCount++;
+    }
+
+    OFile->ExtentClusters++;
+    Cluster = FatGetFatEntry (Volume, Cluster);
+  }
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 FatOFilePosition (
   IN FAT_OFILE            *OFile,
@@ -612,9 +891,16 @@ Returns:
 --*/
 {
   FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  EFI_STATUS  Status;
   UINTN       ClusterSize;
   UINTN       Cluster;
-  UINTN       StartPos;
+  UINTN       ClusterIndex;
+  UINTN       Clusters;
+  UINTN       Offset;
+  UINTN       Index;
+  UINTN       Low;
+  UINTN       High;
   UINTN       Run;
 
   Volume      = OFile->Volume;
@@ -631,54 +917,68 @@ Returns:
     Run             = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // Map the clusters from the position up to PosLimit, so that the
+    // length of the run of consecutive clusters there is known too
     //
-    Cluster     = OFile->FileCurrentCluster;
-    StartPos    = OFile->Position;
-    if (Position < StartPos || OFile->FileCluster == Cluster) {
-      StartPos  = 0;
-      Cluster   = OFile->FileCluster;
+    ClusterIndex  = Position >> Volume->ClusterAlignment;
+    Offset        = Position & (ClusterSize - 1);
+    Clusters      = ClusterIndex + 1;
+    if (PosLimit > ClusterSize - Offset) {
+      Clusters += ((PosLimit - (ClusterSize - Offset) - 1) >> Volume->ClusterAlignment) + 1;
     }
 
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
+    Status = FatExtendExtentMap (OFile, Clusters);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
 
-    if (Cluster < FAT_MIN_CLUSTER) {
+    if (ClusterIndex >= OFile->ExtentClusters) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
       return EFI_VOLUME_CORRUPTED;
     }
 
+    //
+    // Sequential accesses stay in the extent used last, others are
+    // found by a binary search for the last extent starting at or
+    // before the cluster
+    //
+    Index   = OFile->ExtentHint;
+    Extent  = &OFile->Extents[Index];
+    if (Index >= OFile->ExtentCount ||
+        ClusterIndex < Extent->FileCluster ||
+        ClusterIndex >= Extent->FileCluster + Extent->Length) {
+      Low   = 0;
+      High  = OFile->ExtentCount - 1;
+      while (Low < High) {
+        Index = (Low + High + 1) / 2;
+        if (OFile->Extents[Index].FileCluster <= ClusterIndex) {
+          Low = Index;
+        } else {
+          High = Index - 1;
+        }
+      }
+
+      Index             = Low;
+      Extent            = &OFile->Extents[Index];
+      OFile->ExtentHint = Index;
+    }
+
+    Cluster                   = Extent->DiskCluster + (ClusterIndex - Extent->FileCluster);
     OFile->PosDisk            = Volume->FirstClusterPos +
                                 LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
-                                Position - StartPos;
+                                Offset;
     OFile->FileCurrentCluster = Cluster;
-    OFile->Position           = StartPos;
+    OFile->Position           = Position - Offset;
 
     //
     // Compute the number of consecutive clusters in the file
     //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
-      }
+    Clusters = Extent->FileCluster + Extent->Length;
+    if (Clusters > OFile->ExtentClusters) {
+      Clusters = OFile->ExtentClusters;
     }
+
+    Run = ((Clusters - ClusterIndex) << Volume->ClusterAlignment) - Offset;
   }
 
   OFile->PosRem = Run;
@@ -795,14 +1095,25 @@ Returns:
     Volume->FreeInfoValid                        = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount  = 0;
     for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
-      if (Volume->DiskError) {
-        break;
-      }
+      if (Volume->FreeMap != NULL) {
+        //
+        // The bitmap already knows which clusters are free
+        //
+        if (!FAT_FREE_MAP_IS_FREE (Volume->FreeMap, Index)) {
+          continue;
+        }
+      } else {
+        if (Volume->DiskError) {
+          break;
+        }
 
-      if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
-        Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
-        Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
+        if (FatGetFatEntry (Volume, Index) != FAT_CLUSTER_FREE) {
+          continue;
+        }
       }
+
+      Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
     }
 
     Volume->FatInfoSector.Signature          = FAT_INFO_SIGNATURE;
@@ -810,3 +1121,116 @@ Returns:
     Volume->FatInfoSector.InfoEndSignature   = FAT_INFO_END_SIGNATURE;
   }
 }
+
+EFI_STATUS
+FatInitializeFreeMap (
+  IN FAT_VOLUME *Volume
+  )
+/*++
+
+Routine Description:
+
+  Build the free cluster bitmap of the volume from its FAT, and take the
+  free cluster count from it. The FAT is read straight from the disk in
+  large blocks rather than an entry at a time through the FAT cache, whose
+  pages are smaller than a block. This runs while the volume is mounted,
+  before the FAT cache holds any dirty page.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+
+Returns:
+
+  EFI_SUCCESS           - The bitmap is built.
+  EFI_OUT_OF_RESOURCES  - Not enough memory for the bitmap.
+  other                 - An error occurred when reading the FAT.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT8       *FreeMap;
+  UINT8       *Buffer;
+  UINTN       EntrySize;
+  UINTN       Cluster;
+  UINTN       End;
+  UINTN       Count;
+  UINTN       Index;
+  UINTN       Value;
+  UINTN       FreeCount;
+
+  End     = Volume->MaxCluster + 2;
+  FreeMap = AllocateZeroPool ((End + 7) / 8);
+  if (FreeMap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  FreeCount = 0;
+  if (Volume->FatType == FAT12) {
+    //
+    // FAT12 entries straddle bytes, and there are few of them
+    //
+    for (Cluster = FAT_MIN_CLUSTER; Cluster < End; Cluster++) {
+      if (FatGetFatEntry (Volume, Cluster) == FAT_CLUSTER_FREE) {
+        FAT_FREE_MAP_SET (FreeMap, Cluster);
+        FreeCount++;
+      }
+    }
+
+    Status = Volume->DiskError ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+  } else {
+    Buffer = AllocatePool (FAT_FREE_MAP_READ_SIZE);
+    if (Buffer == NULL) {
+      FreePool (FreeMap);
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    EntrySize = (Volume->FatType == FAT16) ? sizeof (UINT16) : sizeof (UINT32);
+    Status    = EFI_SUCCESS;
+    for (Cluster = FAT_MIN_CLUSTER; Cluster < End; Cluster += Count) {
+      Count = FAT_FREE_MAP_READ_SIZE / EntrySize;
+      if (Count > End - Cluster) {
+        Count = End - Cluster;
+      }
+
+      Status = FatDiskIo (
+                 Volume,
+                 READ_DISK,
+                 Volume->FatPos + Cluster * EntrySize,
+                 Count * EntrySize,
+                 Buffer
+                 );
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      for (Index = 0; Index < Count; Index++) {
+        if (EntrySize == sizeof (UINT16)) {
+          Value = ((UINT16 *) Buffer)[Index];
+        } else {
+          Value = ((UINT32 *) Buffer)[Index] & FAT_CLUSTER_MASK_FAT32;
+        }
+
+        if (Value == FAT_CLUSTER_FREE) {
+          FAT_FREE_MAP_SET (FreeMap, Cluster + Index);
+          FreeCount++;
+        }
+      }
+    }
+
+    FreePool (Buffer);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (FreeMap);
+    return Status;
+  }
+
+  Volume->FreeMap                             = FreeMap;
+  Volume->FreeInfoValid                       = TRUE;
+  Volume->FatInfoSector.FreeInfo.ClusterCount = (UINT32) FreeCount;
+  Volume->FatInfoSector.Signature             = FAT_INFO_SIGNATURE;
+  Volume->FatInfoSector.InfoBeginSignature    = FAT_INFO_BEGIN_SIGNATURE;
+  Volume->FatInfoSector.InfoEndSignature      = FAT_INFO_END_SIGNATURE;
+  return EFI_SUCCESS;
+}
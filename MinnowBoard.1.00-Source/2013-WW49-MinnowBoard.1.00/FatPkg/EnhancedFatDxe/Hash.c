@@ -29,7 +29,7 @@ FatHashLongName (
 
 Routine Description:
 
-  Get hash value for long name.
+  Get hash value for long name. The caller masks it to the table size.
 
 Arguments:
 
@@ -41,12 +41,7 @@ Returns:
 
 --*/
 {
-  UINT32  HashValue;
-  CHAR16  UpCasedLongFileName[EFI_PATH_STRING_LENGTH];
-  StrCpy (UpCasedLongFileName, LongNameString);
-  FatStrUpr (UpCasedLongFileName);
-  gBS->CalculateCrc32 (UpCasedLongFileName, StrSize (UpCasedLongFileName), &HashValue);
-  return (HashValue & HASH_TABLE_MASK);
+  return FatStriHash (LongNameString);
 }
 
 STATIC
@@ -58,7 +53,7 @@ FatHashShortName (
 
 Routine Description:
 
-  Get hash value for short name.
+  Get hash value for short name. The caller masks it to the table size.
 
 Arguments:
 
@@ -72,7 +67,140 @@ Returns:
 {
   UINT32  HashValue;
   gBS->CalculateCrc32 (ShortNameString, FAT_NAME_LEN, &HashValue);
-  return (HashValue & HASH_TABLE_MASK);
+  return HashValue;
+}
+
+STATIC
+EFI_STATUS
+FatAllocateHashTable (
+  IN FAT_ODIR       *ODir,
+  IN UINTN          HashTableSize
+  )
+/*++
+
+Routine Description:
+
+  Allocate empty long name and short name hash tables for the directory.
+
+Arguments:
+
+  ODir                  - The directory.
+  HashTableSize         - The number of buckets in each table, a power of 2.
+
+Returns:
+
+  EFI_SUCCESS           - The tables are allocated; the old ones are freed.
+  EFI_OUT_OF_RESOURCES  - Out of resource; the old tables are kept.
+
+--*/
+{
+  FAT_DIRENT  **HashTable;
+
+  //
+  // Both tables share one allocation
+  //
+  HashTable = AllocateZeroPool (2 * HashTableSize * sizeof (FAT_DIRENT *));
+  if (HashTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  FatFreeHashTable (ODir);
+  ODir->HashTableSize       = HashTableSize;
+  ODir->LongNameHashTable   = HashTable;
+  ODir->ShortNameHashTable  = HashTable + HashTableSize;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FatGrowHashTable (
+  IN FAT_ODIR       *ODir
+  )
+/*++
+
+Routine Description:
+
+  Enlarge the hash tables of a directory and rehash all its entries.
+  The tables are left as they are if there is no memory for larger ones.
+
+Arguments:
+
+  ODir                  - The directory.
+
+Returns:
+
+  None.
+
+--*/
+{
+  LIST_ENTRY  *Link;
+  FAT_DIRENT  *DirEnt;
+  UINT32      HashTableIndex;
+
+  if (EFI_ERROR (FatAllocateHashTable (ODir, ODir->HashTableSize * HASH_TABLE_GROWTH))) {
+    return;
+  }
+
+  for (Link = ODir->ChildList.ForwardLink; Link != &ODir->ChildList; Link = Link->ForwardLink) {
+    DirEnt                        = DIRENT_FROM_LINK (Link);
+    HashTableIndex                = FatHashShortName (DirEnt->Entry.FileName) & (ODir->HashTableSize - 1);
+    DirEnt->ShortNameForwardLink  = ODir->ShortNameHashTable[HashTableIndex];
+    ODir->ShortNameHashTable[HashTableIndex] = DirEnt;
+    HashTableIndex                = FatHashLongName (DirEnt->FileString) & (ODir->HashTableSize - 1);
+    DirEnt->LongNameForwardLink   = ODir->LongNameHashTable[HashTableIndex];
+    ODir->LongNameHashTable[HashTableIndex] = DirEnt;
+  }
+}
+
+EFI_STATUS
+FatInitializeHashTable (
+  IN FAT_ODIR       *ODir
+  )
+/*++
+
+Routine Description:
+
+  Allocate the initial, smallest hash tables of a new directory.
+
+Arguments:
+
+  ODir                  - The directory.
+
+Returns:
+
+  EFI_SUCCESS           - The tables are allocated.
+  EFI_OUT_OF_RESOURCES  - Out of resource.
+
+--*/
+{
+  return FatAllocateHashTable (ODir, HASH_TABLE_MIN_SIZE);
+}
+
+VOID
+FatFreeHashTable (
+  IN FAT_ODIR       *ODir
+  )
+/*++
+
+Routine Description:
+
+  Free the hash tables of a directory.
+
+Arguments:
+
+  ODir                  - The directory.
+
+Returns:
+
+  None.
+
+--*/
+{
+  if (ODir->LongNameHashTable != NULL) {
+    FreePool (ODir->LongNameHashTable);
+    ODir->LongNameHashTable   = NULL;
+    ODir->ShortNameHashTable  = NULL;
+  }
 }
 
 FAT_DIRENT **
@@ -98,7 +226,7 @@ Returns:
 --*/
 {
   FAT_DIRENT  **PreviousHashNode;
-  for (PreviousHashNode   = &ODir->LongNameHashTable[FatHashLongName (LongNameString)];
+  for (PreviousHashNode   = &ODir->LongNameHashTable[FatHashLongName (LongNameString) & (ODir->HashTableSize - 1)];
        *PreviousHashNode != NULL;
        PreviousHashNode   = &(*PreviousHashNode)->LongNameForwardLink
       ) {
@@ -133,7 +261,7 @@ Returns:
 --*/
 {
   FAT_DIRENT  **PreviousHashNode;
-  for (PreviousHashNode   = &ODir->ShortNameHashTable[FatHashShortName (ShortNameString)];
+  for (PreviousHashNode   = &ODir->ShortNameHashTable[FatHashShortName (ShortNameString) & (ODir->HashTableSize - 1)];
        *PreviousHashNode != NULL;
        PreviousHashNode   = &(*PreviousHashNode)->ShortNameForwardLink
       ) {
@@ -173,17 +301,26 @@ Returns:
   //
   // Insert hash table index for short name
   //
-  HashTableIndex                = FatHashShortName (DirEnt->Entry.FileName);
+  HashTableIndex                = FatHashShortName (DirEnt->Entry.FileName) & (ODir->HashTableSize - 1);
   HashTable                     = ODir->ShortNameHashTable;
   DirEnt->ShortNameForwardLink  = HashTable[HashTableIndex];
   HashTable[HashTableIndex]     = DirEnt;
   //
   // Insert hash table index for long name
   //
-  HashTableIndex                = FatHashLongName (DirEnt->FileString);
+  HashTableIndex                = FatHashLongName (DirEnt->FileString) & (ODir->HashTableSize - 1);
   HashTable                     = ODir->LongNameHashTable;
   DirEnt->LongNameForwardLink   = HashTable[HashTableIndex];
   HashTable[HashTableIndex]     = DirEnt;
+
+  ODir->DirEntCount++;
+  ODir->DirEntSize += sizeof (FAT_DIRENT) + StrSize (DirEnt->FileString);
+  //
+  // Keep the chains short as the directory grows
+  //
+  if (ODir->DirEntCount > ODir->HashTableSize && ODir->HashTableSize < HASH_TABLE_MAX_SIZE) {
+    FatGrowHashTable (ODir);
+  }
 }
 
 VOID
@@ -210,4 +347,7 @@ Returns:
 {
   *FatShortNameHashSearch (ODir, DirEnt->Entry.FileName) = DirEnt->ShortNameForwardLink;
   *FatLongNameHashSearch (ODir, DirEnt->FileString)      = DirEnt->LongNameForwardLink;
+
+  ODir->DirEntCount--;
+  ODir->DirEntSize -= sizeof (FAT_DIRENT) + StrSize (DirEnt->FileString);
 }
@@ -183,6 +183,43 @@ Returns:
   return Status;
 }
 
+EFI_STATUS
+FatGetCacheStatisticsInfo (
+  IN FAT_VOLUME       *Volume,
+  IN OUT UINTN        *BufferSize,
+  OUT VOID            *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Get the statistics of the volume's data cache into Buffer.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  BufferSize            - Size of Buffer.
+  Buffer                - Buffer containing the cache statistics.
+
+Returns:
+
+  EFI_SUCCESS           - Get the cache statistics successfully.
+  EFI_BUFFER_TOO_SMALL  - The buffer is too small.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  Status = EFI_BUFFER_TOO_SMALL;
+  if (*BufferSize >= sizeof (FAT_CACHE_STATISTICS_INFO)) {
+    CopyMem (Buffer, &Volume->CacheStatistics, sizeof (FAT_CACHE_STATISTICS_INFO));
+    Status = EFI_SUCCESS;
+  }
+
+  *BufferSize = sizeof (FAT_CACHE_STATISTICS_INFO);
+  return Status;
+}
+
 EFI_STATUS
 FatSetVolumeInfo (
   IN FAT_VOLUME       *Volume,
@@ -549,6 +586,10 @@ Returns:
       if (CompareGuid (Type, &gEfiFileSystemVolumeLabelInfoIdGuid)) {
         Status = FatGetVolumeLabelInfo (Volume, BufferSize, Buffer);
       }
+
+      if (CompareGuid (Type, &gFatCacheStatisticsInfoGuid)) {
+        Status = FatGetCacheStatisticsInfo (Volume, BufferSize, Buffer);
+      }
     }
   }
 
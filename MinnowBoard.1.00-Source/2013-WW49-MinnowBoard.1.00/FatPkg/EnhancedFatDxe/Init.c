@@ -89,6 +89,13 @@ Returns:
     goto Done;
   }
   //
+  // Build the free cluster bitmap used for allocation. Without it the
+  // allocator falls back to probing the FAT, so a failure is not fatal.
+  //
+  if (!Volume->ReadOnly) {
+    FatInitializeFreeMap (Volume);
+  }
+  //
   // Install our protocol interfaces on the device's handle
   //
   Status = gBS->InstallMultipleProtocolInterfaces (
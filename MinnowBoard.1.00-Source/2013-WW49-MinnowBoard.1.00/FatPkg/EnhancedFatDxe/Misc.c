@@ -239,6 +239,12 @@ Returns:
     FreePool (Volume->CacheBuffer);
   }
   //
+  // Free the free cluster bitmap
+  //
+  if (Volume->FreeMap != NULL) {
+    FreePool (Volume->FreeMap);
+  }
+  //
   // Free directory cache
   //
   FatCleanupODirCache (Volume);
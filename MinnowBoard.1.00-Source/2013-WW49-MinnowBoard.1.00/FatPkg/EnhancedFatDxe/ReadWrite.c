@@ -401,6 +401,91 @@ Returns:
   return FatIFileAccess (FHand, WRITE_DATA, BufferSize, Buffer);
 }
 
+STATIC
+VOID
+FatReadAheadOFile (
+  IN FAT_OFILE          *OFile,
+  IN UINTN              StartPosition,
+  IN UINTN              EndPosition
+  )
+/*++
+
+Routine Description:
+
+  Track the reads of the open file, and once they are sequential, read the
+  data after them into the data cache so that the following reads hit it.
+  The window read ahead doubles on each sequential read, and a read ahead
+  is only issued when the reader has used up half of the last one. The
+  window is counted in cache pages filled, so that a fragmented file, whose
+  clusters each take a page of their own, cannot evict its own read ahead.
+
+Arguments:
+
+  OFile                 - The open file.
+  StartPosition         - The position where the read started.
+  EndPosition           - The position where the read ended.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  EFI_STATUS  Status;
+  UINTN       Window;
+  UINTN       Position;
+  UINTN       Limit;
+  UINTN       Len;
+  UINTN       Pages;
+  UINT8       PageAlignment;
+
+  Volume = OFile->Volume;
+  if (StartPosition != OFile->ReadAheadNext) {
+    //
+    // Random access, stop reading ahead
+    //
+    OFile->ReadAheadNext  = EndPosition;
+    OFile->ReadAheadLimit = 0;
+    OFile->ReadAheadPages = 0;
+    return;
+  }
+
+  OFile->ReadAheadNext = EndPosition;
+  if (OFile->ReadAheadPages == 0) {
+    OFile->ReadAheadPages = FAT_READ_AHEAD_MIN_PAGES;
+  } else if (OFile->ReadAheadPages < FAT_READ_AHEAD_MAX_PAGES) {
+    OFile->ReadAheadPages *= 2;
+  }
+
+  PageAlignment = Volume->DiskCache[CACHE_DATA].PageAlignment;
+  Window        = OFile->ReadAheadPages << PageAlignment;
+  if (EndPosition + Window / 2 < OFile->ReadAheadLimit) {
+    return;
+  }
+
+  Position  = MAX (EndPosition, OFile->ReadAheadLimit);
+  Limit     = MIN (EndPosition + Window, OFile->FileSize);
+  Pages     = 0;
+  while (Position < Limit && Pages < OFile->ReadAheadPages) {
+    Status = FatOFilePosition (OFile, Position, Limit - Position);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Len     = MIN (OFile->PosRem, Limit - Position);
+    Status  = FatReadAheadCache (Volume, OFile->PosDisk, Len);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Pages    += (UINTN) (RShiftU64 (OFile->PosDisk + Len - 1, PageAlignment) - RShiftU64 (OFile->PosDisk, PageAlignment)) + 1;
+    Position += Len;
+  }
+
+  OFile->ReadAheadLimit = Position;
+}
+
 EFI_STATUS
 FatAccessOFile (
   IN     FAT_OFILE      *OFile,
@@ -435,9 +520,11 @@ Returns:
   UINTN       Len;
   EFI_STATUS  Status;
   UINTN       BufferSize;
+  UINTN       StartPosition;
 
-  BufferSize  = *DataBufferSize;
-  Volume      = OFile->Volume;
+  BufferSize    = *DataBufferSize;
+  StartPosition = Position;
+  Volume        = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
 
   Status = EFI_SUCCESS;
@@ -476,6 +563,10 @@ Returns:
     //
     ASSERT (Position <= OFile->FileSize);
   }
+
+  if (IoMode == READ_DATA && !EFI_ERROR (Status)) {
+    FatReadAheadOFile (OFile, StartPosition, Position);
+  }
   //
   // Update the number of bytes accessed
   //
@@ -13,6 +13,118 @@
 
 EFI_UNICODE_COLLATION_PROTOCOL  *mUnicodeCollationInterface = NULL;
 
+//
+// Case mapping of the selected Unicode Collation protocol for the whole BMP,
+// split in 256 pages of 256 characters. A NULL page maps every character
+// in it to itself, so only the few pages with cased letters take memory.
+//
+#define FAT_CASE_MAP_PAGES  0x100
+#define FAT_CASE_MAP_CHARS  0x100
+
+EFI_UNICODE_COLLATION_PROTOCOL  *mCaseMapInterface = NULL;
+CHAR16                          *mUpperMap[FAT_CASE_MAP_PAGES];
+CHAR16                          *mLowerMap[FAT_CASE_MAP_PAGES];
+
+#define FAT_MAP_CHAR(Map, Char) \
+  ((Map)[(Char) >> 8] == NULL ? (Char) : (Map)[(Char) >> 8][(Char) & 0xFF])
+
+/**
+  Build one case mapping table by passing each page of the BMP through the
+  given conversion of the Unicode Collation protocol.
+
+  @param  Convert              StrUpr or StrLwr of mUnicodeCollationInterface.
+  @param  Map                  The table to fill. Pages that map to themselves
+                               are left NULL.
+
+  @retval EFI_SUCCESS          The table was built.
+  @retval EFI_OUT_OF_RESOURCES A page could not be allocated.
+
+**/
+EFI_STATUS
+FatBuildCaseMap (
+  IN  EFI_UNICODE_COLLATION_STRLWR     Convert,
+  OUT CHAR16                           **Map
+  )
+{
+  CHAR16  Page[FAT_CASE_MAP_CHARS + 1];
+  UINTN   PageIndex;
+  UINTN   Index;
+
+  for (PageIndex = 0; PageIndex < FAT_CASE_MAP_PAGES; PageIndex++) {
+    //
+    // The null character cannot be passed in a string; it maps to itself.
+    //
+    for (Index = 0; Index < FAT_CASE_MAP_CHARS; Index++) {
+      Page[Index] = (CHAR16) ((PageIndex << 8) | Index);
+    }
+    Page[FAT_CASE_MAP_CHARS] = 0;
+    if (PageIndex == 0) {
+      Convert (mUnicodeCollationInterface, &Page[1]);
+    } else {
+      Convert (mUnicodeCollationInterface, Page);
+    }
+
+    for (Index = 0; Index < FAT_CASE_MAP_CHARS; Index++) {
+      if (Page[Index] != (CHAR16) ((PageIndex << 8) | Index)) {
+        break;
+      }
+    }
+    if (Index == FAT_CASE_MAP_CHARS) {
+      continue;
+    }
+
+    Map[PageIndex] = AllocateCopyPool (sizeof (CHAR16) * FAT_CASE_MAP_CHARS, Page);
+    if (Map[PageIndex] == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the case mapping tables for the selected Unicode Collation protocol,
+  unless they were built for it already.
+
+  @retval EFI_SUCCESS          The tables are ready.
+  @retval EFI_OUT_OF_RESOURCES The tables could not be allocated.
+
+**/
+EFI_STATUS
+FatInitializeCaseMaps (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       PageIndex;
+
+  if (mCaseMapInterface == mUnicodeCollationInterface) {
+    return EFI_SUCCESS;
+  }
+
+  for (PageIndex = 0; PageIndex < FAT_CASE_MAP_PAGES; PageIndex++) {
+    if (mUpperMap[PageIndex] != NULL) {
+      FreePool (mUpperMap[PageIndex]);
+      mUpperMap[PageIndex] = NULL;
+    }
+    if (mLowerMap[PageIndex] != NULL) {
+      FreePool (mLowerMap[PageIndex]);
+      mLowerMap[PageIndex] = NULL;
+    }
+  }
+  mCaseMapInterface = NULL;
+
+  Status = FatBuildCaseMap (mUnicodeCollationInterface->StrUpr, mUpperMap);
+  if (!EFI_ERROR (Status)) {
+    Status = FatBuildCaseMap (mUnicodeCollationInterface->StrLwr, mLowerMap);
+  }
+  if (!EFI_ERROR (Status)) {
+    mCaseMapInterface = mUnicodeCollationInterface;
+  }
+
+  return Status;
+}
+
 /**
   Worker function to initialize Unicode Collation support.
 
@@ -149,6 +261,14 @@ InitializeUnicodeCollationSupport (
                );
   }
 
+  //
+  // Name compares and hashes go through tables taken from the protocol
+  // rather than through a protocol call per string.
+  //
+  if (!EFI_ERROR (Status)) {
+    Status = FatInitializeCaseMaps ();
+  }
+
   return Status;
 }
 
@@ -156,6 +276,9 @@ InitializeUnicodeCollationSupport (
 /**
   Performs a case-insensitive comparison of two Null-terminated Unicode strings.
 
+  Characters are compared by their upper case form in the selected Unicode
+  Collation protocol.
+
   @param  S1                   A pointer to a Null-terminated Unicode string.
   @param  S2                   A pointer to a Null-terminated Unicode string.
 
@@ -169,15 +292,53 @@ FatStriCmp (
   IN CHAR16       *S2
   )
 {
+  CHAR16  C1;
+  CHAR16  C2;
+
   ASSERT (StrSize (S1) != 0);
   ASSERT (StrSize (S2) != 0);
-  ASSERT (mUnicodeCollationInterface != NULL);
+  ASSERT (mCaseMapInterface != NULL);
 
-  return mUnicodeCollationInterface->StriColl (
-                                       mUnicodeCollationInterface,
-                                       S1,
-                                       S2
-                                       );
+  do {
+    C1 = FAT_MAP_CHAR (mUpperMap, *S1);
+    C2 = FAT_MAP_CHAR (mUpperMap, *S2);
+    S1++;
+    S2++;
+  } while (C1 == C2 && C1 != 0);
+
+  return (INTN) C1 - (INTN) C2;
+}
+
+
+/**
+  Compute a case-insensitive hash of a Null-terminated Unicode string.
+
+  Strings that FatStriCmp() finds equivalent hash to the same value.
+
+  @param  String               A pointer to a Null-terminated Unicode string.
+
+  @return The hash value.
+
+**/
+UINT32
+FatStriHash (
+  IN CHAR16       *String
+  )
+{
+  UINT32  Hash;
+
+  ASSERT (StrSize (String) != 0);
+  ASSERT (mCaseMapInterface != NULL);
+
+  //
+  // FNV-1a over the upper case characters.
+  //
+  Hash = 0x811C9DC5;
+  for (; *String != 0; String++) {
+    Hash = (Hash ^ FAT_MAP_CHAR (mUpperMap, *String)) * 0x01000193;
+  }
+
+  return Hash;
 }
 
 
@@ -195,9 +356,11 @@ FatStrUpr (
   )
 {
   ASSERT (StrSize (String) != 0);
-  ASSERT (mUnicodeCollationInterface != NULL);
+  ASSERT (mCaseMapInterface != NULL);
 
-  mUnicodeCollationInterface->StrUpr (mUnicodeCollationInterface, String);
+  for (; *String != 0; String++) {
+    *String = FAT_MAP_CHAR (mUpperMap, *String);
+  }
 }
 
 
@@ -215,9 +378,11 @@ FatStrLwr (
   )
 {
   ASSERT (StrSize (String) != 0);
-  ASSERT (mUnicodeCollationInterface != NULL);
+  ASSERT (mCaseMapInterface != NULL);
 
-  mUnicodeCollationInterface->StrLwr (mUnicodeCollationInterface, String);
+  for (; *String != 0; String++) {
+    *String = FAT_MAP_CHAR (mLowerMap, *String);
+  }
 }
 
 
@@ -0,0 +1,841 @@
+/** @file
+  FAT driver benchmark that runs EnhancedFatDxe on a build host.
+
+  The program formats an image file, binds the FAT driver to it through the
+  host Block I/O and Disk I/O of HostDisk.c, and times a set of file
+  operations through EFI_FILE_PROTOCOL. Each operation runs on a freshly
+  mounted volume, so the driver starts with empty caches, and ends with the
+  volume flushed. For every operation the program reports the throughput,
+  the requests that reached the image file and the driver's data cache
+  statistics.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostBench.h"
+#include "FatFileSystem.h"
+
+#include <Library/PrintLib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define BENCH_SECTOR_SIZE         512
+#define BENCH_NAME_LENGTH         64
+#define BENCH_RANDOM_SEED         0x2545F491
+
+typedef struct {
+  CONST CHAR8             *Image;
+  UINT32                  FatBits;
+  UINT32                  SizeMb;
+  UINT32                  ClusterKb;
+  UINT32                  FileMb;
+  UINT32                  ChunkKb;
+  UINT32                  RandomReads;
+  UINT32                  RandomKb;
+  UINT32                  FileCount;
+  UINT32                  TreeDepth;
+  UINT32                  TreeFanout;
+} BENCH_CONFIG;
+
+typedef struct {
+  BENCH_CONFIG            *Config;
+  EFI_HANDLE              Disk;
+  EFI_FILE_PROTOCOL       *Root;
+  UINT8                   *Buffer;
+  UINT64                  Operations;
+  UINT64                  Bytes;
+} BENCH_CONTEXT;
+
+typedef
+EFI_STATUS
+(*BENCH_FUNCTION) (
+  IN OUT BENCH_CONTEXT    *Context
+  );
+
+typedef struct {
+  CONST CHAR8             *Name;
+  BENCH_FUNCTION          Function;
+} BENCHMARK;
+
+UINT64  mBenchRandom = BENCH_RANDOM_SEED;
+
+/**
+  Return the next number of a fixed pseudo random sequence.
+
+**/
+UINT64
+BenchRandom (
+  VOID
+  )
+{
+  mBenchRandom ^= mBenchRandom << 13;
+  mBenchRandom ^= mBenchRandom >> 7;
+  mBenchRandom ^= mBenchRandom << 17;
+  return mBenchRandom;
+}
+
+/**
+  Fill a buffer with the content expected at an offset of the test file.
+
+**/
+VOID
+BenchFillPattern (
+  OUT UINT8               *Buffer,
+  IN  UINT64              Offset,
+  IN  UINTN               Size
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < Size; Index++) {
+    Buffer[Index] = (UINT8) (((Offset + Index) * 0x9E3779B1) >> 13);
+  }
+}
+
+/**
+  Check a buffer against the content expected at an offset of the test file.
+
+**/
+BOOLEAN
+BenchCheckPattern (
+  IN UINT8                *Buffer,
+  IN UINT64               Offset,
+  IN UINTN                Size
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < Size; Index++) {
+    if (Buffer[Index] != (UINT8) (((Offset + Index) * 0x9E3779B1) >> 13)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Return a monotonic time stamp in seconds.
+
+**/
+double
+BenchNow (
+  VOID
+  )
+{
+  struct timespec   Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/**
+  Create and format a FAT16 or FAT32 image file.
+
+  @param  Config                The image parameters.
+
+  @retval EFI_SUCCESS           The image was created.
+  @retval EFI_INVALID_PARAMETER The size and cluster size do not give a
+                                cluster count valid for the FAT type.
+  @retval EFI_DEVICE_ERROR      The image file could not be written.
+
+**/
+EFI_STATUS
+BenchFormatImage (
+  IN BENCH_CONFIG         *Config
+  )
+{
+  FAT_BOOT_SECTOR   BootSector;
+  FAT_INFO_SECTOR   InfoSector;
+  UINT8             Sector[BENCH_SECTOR_SIZE];
+  UINT32            Sectors;
+  UINT32            SectorsPerCluster;
+  UINT32            ReservedSectors;
+  UINT32            RootSectors;
+  UINT32            SectorsPerFat;
+  UINT32            Clusters;
+  UINT32            Fat;
+  UINT32            Entries[3];
+  int               Fd;
+  BOOLEAN           Ok;
+
+  Sectors           = Config->SizeMb * (SIZE_1MB / BENCH_SECTOR_SIZE);
+  SectorsPerCluster = Config->ClusterKb * (SIZE_1KB / BENCH_SECTOR_SIZE);
+  if (Config->FatBits == 32) {
+    ReservedSectors = 32;
+    RootSectors     = 0;
+    SectorsPerFat   = (Sectors - ReservedSectors + (128 * SectorsPerCluster + 1) - 1) / (128 * SectorsPerCluster + 1);
+  } else {
+    ReservedSectors = 1;
+    RootSectors     = 512 * sizeof (FAT_DIRECTORY_ENTRY) / BENCH_SECTOR_SIZE;
+    SectorsPerFat   = (Sectors - ReservedSectors - RootSectors + (256 * SectorsPerCluster + 2) - 1) / (256 * SectorsPerCluster + 2);
+  }
+  Clusters = (Sectors - ReservedSectors - 2 * SectorsPerFat - RootSectors) / SectorsPerCluster;
+  if (Config->FatBits == 32 ? Clusters < FAT_MAX_FAT16_CLUSTER : (Clusters < FAT_MAX_FAT12_CLUSTER || Clusters >= FAT_MAX_FAT16_CLUSTER)) {
+    fprintf (stderr, "%u MB with %u KB clusters gives %u clusters, which is not FAT%u\n",
+      Config->SizeMb, Config->ClusterKb, Clusters, Config->FatBits);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&BootSector, sizeof (BootSector));
+  BootSector.FatBsb.Ia32Jump[0]       = 0xEB;
+  BootSector.FatBsb.Ia32Jump[1]       = 0x58;
+  BootSector.FatBsb.Ia32Jump[2]       = 0x90;
+  CopyMem (BootSector.FatBsb.OemId, "HOSTBNCH", 8);
+  BootSector.FatBsb.SectorSize        = BENCH_SECTOR_SIZE;
+  BootSector.FatBsb.SectorsPerCluster = (UINT8) SectorsPerCluster;
+  BootSector.FatBsb.ReservedSectors   = (UINT16) ReservedSectors;
+  BootSector.FatBsb.NumFats           = 2;
+  BootSector.FatBsb.RootEntries       = (UINT16) (RootSectors * BENCH_SECTOR_SIZE / sizeof (FAT_DIRECTORY_ENTRY));
+  BootSector.FatBsb.Media             = 0xF8;
+  BootSector.FatBsb.SectorsPerTrack   = 63;
+  BootSector.FatBsb.Heads             = 255;
+  BootSector.FatBsb.LargeSectors      = Sectors;
+  if (Config->FatBits == 32) {
+    BootSector.FatBse.Fat32Bse.LargeSectorsPerFat   = SectorsPerFat;
+    BootSector.FatBse.Fat32Bse.RootDirFirstCluster  = FAT_MIN_CLUSTER;
+    BootSector.FatBse.Fat32Bse.FsInfoSector         = 1;
+    BootSector.FatBse.Fat32Bse.BackupBootSector     = 6;
+    BootSector.FatBse.Fat32Bse.PhysicalDriveNumber  = 0x80;
+    BootSector.FatBse.Fat32Bse.Signature            = 0x29;
+    CopyMem (BootSector.FatBse.Fat32Bse.FatLabel, "HOSTBENCH  ", 11);
+    CopyMem (BootSector.FatBse.Fat32Bse.SystemId, "FAT32   ", 8);
+  } else {
+    BootSector.FatBsb.SectorsPerFat                 = (UINT16) SectorsPerFat;
+    BootSector.FatBse.FatBse.PhysicalDriveNumber    = 0x80;
+    BootSector.FatBse.FatBse.Signature              = 0x29;
+    CopyMem (BootSector.FatBse.FatBse.FatLabel, "HOSTBENCH  ", 11);
+    CopyMem (BootSector.FatBse.FatBse.SystemId, "FAT16   ", 8);
+  }
+
+  Fd = open (Config->Image, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (Fd < 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Ok = (BOOLEAN) (ftruncate (Fd, (off_t) Sectors * BENCH_SECTOR_SIZE) == 0);
+
+  ZeroMem (Sector, sizeof (Sector));
+  CopyMem (Sector, &BootSector, sizeof (BootSector));
+  Sector[510] = 0x55;
+  Sector[511] = 0xAA;
+  Ok = (BOOLEAN) (Ok && pwrite (Fd, Sector, sizeof (Sector), 0) == sizeof (Sector));
+
+  if (Config->FatBits == 32) {
+    Ok = (BOOLEAN) (Ok && pwrite (Fd, Sector, sizeof (Sector), 6 * BENCH_SECTOR_SIZE) == sizeof (Sector));
+
+    ZeroMem (&InfoSector, sizeof (InfoSector));
+    InfoSector.Signature              = FAT_INFO_SIGNATURE;
+    InfoSector.InfoBeginSignature     = FAT_INFO_BEGIN_SIGNATURE;
+    InfoSector.FreeInfo.ClusterCount  = Clusters - 1;
+    InfoSector.FreeInfo.NextCluster   = FAT_MIN_CLUSTER + 1;
+    InfoSector.InfoEndSignature       = FAT_INFO_END_SIGNATURE;
+    Ok = (BOOLEAN) (Ok && pwrite (Fd, &InfoSector, sizeof (InfoSector), BENCH_SECTOR_SIZE) == sizeof (InfoSector));
+
+    //
+    // Media and end of chain entries, then the root directory's one cluster
+    //
+    Entries[0] = 0x0FFFFFF8;
+    Entries[1] = 0x0FFFFFFF;
+    Entries[2] = 0x0FFFFFFF;
+    for (Fat = 0; Fat < 2; Fat++) {
+      Ok = (BOOLEAN) (Ok && pwrite (Fd, Entries, 3 * sizeof (UINT32), (off_t) (ReservedSectors + Fat * SectorsPerFat) * BENCH_SECTOR_SIZE) == 3 * sizeof (UINT32));
+    }
+  } else {
+    Entries[0] = 0xFFFFFFF8;
+    for (Fat = 0; Fat < 2; Fat++) {
+      Ok = (BOOLEAN) (Ok && pwrite (Fd, Entries, sizeof (UINT32), (off_t) (ReservedSectors + Fat * SectorsPerFat) * BENCH_SECTOR_SIZE) == sizeof (UINT32));
+    }
+  }
+
+  close (Fd);
+  return Ok ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+}
+
+/**
+  Bind the FAT driver to the disk and open the root directory.
+
+**/
+EFI_STATUS
+BenchMount (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *FileSystem;
+
+  Status = gFatDriverBinding.Supported (&gFatDriverBinding, Context->Disk, NULL);
+  if (!EFI_ERROR (Status)) {
+    Status = gFatDriverBinding.Start (&gFatDriverBinding, Context->Disk, NULL);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = HostHandleProtocol (Context->Disk, &gEfiSimpleFileSystemProtocolGuid, (VOID **) &FileSystem);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = FileSystem->OpenVolume (FileSystem, &Context->Root);
+  }
+  return Status;
+}
+
+/**
+  Close the root directory and unbind the FAT driver, which flushes the volume.
+
+**/
+EFI_STATUS
+BenchUnmount (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  Context->Root->Close (Context->Root);
+  Context->Root = NULL;
+  return gFatDriverBinding.Stop (&gFatDriverBinding, Context->Disk, 0, NULL);
+}
+
+/**
+  Open a file or directory below the root.
+
+**/
+EFI_STATUS
+BenchOpen (
+  IN  BENCH_CONTEXT       *Context,
+  IN  CHAR16              *Name,
+  IN  UINT64              Attributes,
+  IN  BOOLEAN             Create,
+  OUT EFI_FILE_PROTOCOL   **File
+  )
+{
+  UINT64  Mode;
+
+  Mode = EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE;
+  if (Create) {
+    Mode |= EFI_FILE_MODE_CREATE;
+  }
+  return Context->Root->Open (Context->Root, File, Name, Mode, Attributes);
+}
+
+//
+// Benchmarks
+//
+
+EFI_STATUS
+BenchSequentialWrite (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *File;
+  UINT64              Offset;
+  UINT64              FileSize;
+  UINTN               Size;
+
+  Status = BenchOpen (Context, L"\\seq.bin", 0, TRUE, &File);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  FileSize = MultU64x32 (Context->Config->FileMb, SIZE_1MB);
+  for (Offset = 0; Offset < FileSize && !EFI_ERROR (Status); Offset += Size) {
+    Size = (UINTN) MIN (Context->Config->ChunkKb * SIZE_1KB, FileSize - Offset);
+    BenchFillPattern (Context->Buffer, Offset, Size);
+    Status = File->Write (File, &Size, Context->Buffer);
+    Context->Operations++;
+    Context->Bytes += Size;
+  }
+
+  File->Close (File);
+  return Status;
+}
+
+EFI_STATUS
+BenchSequentialRead (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *File;
+  UINT64              Offset;
+  UINTN               Size;
+
+  Status = BenchOpen (Context, L"\\seq.bin", 0, FALSE, &File);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Offset = 0; ; Offset += Size) {
+    Size   = Context->Config->ChunkKb * SIZE_1KB;
+    Status = File->Read (File, &Size, Context->Buffer);
+    if (EFI_ERROR (Status) || Size == 0) {
+      break;
+    }
+    if (!BenchCheckPattern (Context->Buffer, Offset, Size)) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+    Context->Operations++;
+    Context->Bytes += Size;
+  }
+
+  File->Close (File);
+  return Status;
+}
+
+EFI_STATUS
+BenchRandomRead (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *File;
+  UINT64              Blocks;
+  UINT64              Offset;
+  UINT32              Index;
+  UINTN               Size;
+
+  Status = BenchOpen (Context, L"\\seq.bin", 0, FALSE, &File);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Blocks = DivU64x32 (MultU64x32 (Context->Config->FileMb, SIZE_1MB), Context->Config->RandomKb * SIZE_1KB);
+  for (Index = 0; Index < Context->Config->RandomReads && !EFI_ERROR (Status); Index++) {
+    Offset = MultU64x32 (BenchRandom () % Blocks, Context->Config->RandomKb * SIZE_1KB);
+    Size   = Context->Config->RandomKb * SIZE_1KB;
+    Status = File->SetPosition (File, Offset);
+    if (!EFI_ERROR (Status)) {
+      Status = File->Read (File, &Size, Context->Buffer);
+    }
+    if (!EFI_ERROR (Status) && !BenchCheckPattern (Context->Buffer, Offset, Size)) {
+      Status = EFI_VOLUME_CORRUPTED;
+    }
+    Context->Operations++;
+    Context->Bytes += Size;
+  }
+
+  File->Close (File);
+  return Status;
+}
+
+/**
+  Create, open or delete every file of the many-files directory.
+
+**/
+EFI_STATUS
+BenchManyFiles (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     BOOLEAN          Create,
+  IN     BOOLEAN          Delete
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *Dir;
+  EFI_FILE_PROTOCOL   *File;
+  CHAR16              Name[BENCH_NAME_LENGTH];
+  UINT32              Index;
+  UINTN               Size;
+
+  Status = BenchOpen (Context, L"\\many", EFI_FILE_DIRECTORY, Create, &Dir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < Context->Config->FileCount && !EFI_ERROR (Status); Index++) {
+    UnicodeSPrint (Name, sizeof (Name), L"log_file_%06d.txt", Index);
+    Status = Dir->Open (Dir, &File, Name, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | (Create ? EFI_FILE_MODE_CREATE : 0), 0);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    if (Create) {
+      Size   = StrSize (Name);
+      Status = File->Write (File, &Size, Name);
+      Context->Bytes += Size;
+    }
+    if (Delete) {
+      Status = File->Delete (File);
+    } else {
+      File->Close (File);
+    }
+    Context->Operations++;
+  }
+
+  Dir->Close (Dir);
+  return Status;
+}
+
+EFI_STATUS
+BenchCreateFiles (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  return BenchManyFiles (Context, TRUE, FALSE);
+}
+
+EFI_STATUS
+BenchOpenFiles (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  return BenchManyFiles (Context, FALSE, FALSE);
+}
+
+EFI_STATUS
+BenchDeleteFiles (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  return BenchManyFiles (Context, FALSE, TRUE);
+}
+
+EFI_STATUS
+BenchListFiles (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *Dir;
+  UINTN               Size;
+
+  Status = BenchOpen (Context, L"\\many", EFI_FILE_DIRECTORY, FALSE, &Dir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (;;) {
+    Size   = Context->Config->ChunkKb * SIZE_1KB;
+    Status = Dir->Read (Dir, &Size, Context->Buffer);
+    if (EFI_ERROR (Status) || Size == 0) {
+      break;
+    }
+    Context->Operations++;
+  }
+
+  Dir->Close (Dir);
+  return Status;
+}
+
+/**
+  Create a directory tree with one file in each directory, or walk it
+  opening every entry.
+
+**/
+EFI_STATUS
+BenchTree (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     EFI_FILE_PROTOCOL *Dir,
+  IN     UINT32           Depth,
+  IN     BOOLEAN          Create
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *Child;
+  EFI_FILE_INFO       *Info;
+  CHAR16              Name[BENCH_NAME_LENGTH];
+  UINT32              Index;
+  UINTN               Size;
+
+  Status = EFI_SUCCESS;
+  if (Create) {
+    Status = Dir->Open (Dir, &Child, L"data.bin", EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
+    if (!EFI_ERROR (Status)) {
+      Size = SIZE_1KB;
+      BenchFillPattern (Context->Buffer, 0, Size);
+      Status = Child->Write (Child, &Size, Context->Buffer);
+      Child->Close (Child);
+      Context->Operations++;
+    }
+    for (Index = 0; Index < Context->Config->TreeFanout && Depth > 0 && !EFI_ERROR (Status); Index++) {
+      UnicodeSPrint (Name, sizeof (Name), L"directory_level_%d_%d", Depth, Index);
+      Status = Dir->Open (Dir, &Child, Name, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, EFI_FILE_DIRECTORY);
+      if (!EFI_ERROR (Status)) {
+        Context->Operations++;
+        Status = BenchTree (Context, Child, Depth - 1, TRUE);
+        Child->Close (Child);
+      }
+    }
+    return Status;
+  }
+
+  //
+  // Walk: read the directory and open each entry other than . and ..
+  //
+  Info = AllocatePool (SIZE_1KB);
+  if (Info == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (;;) {
+    Size   = SIZE_1KB;
+    Status = Dir->Read (Dir, &Size, Info);
+    if (EFI_ERROR (Status) || Size == 0) {
+      break;
+    }
+    if (StrCmp (Info->FileName, L".") == 0 || StrCmp (Info->FileName, L"..") == 0) {
+      continue;
+    }
+    Status = Dir->Open (Dir, &Child, Info->FileName, EFI_FILE_MODE_READ, 0);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Context->Operations++;
+    if ((Info->Attribute & EFI_FILE_DIRECTORY) != 0) {
+      Status = BenchTree (Context, Child, Depth, FALSE);
+    } else {
+      Size   = SIZE_1KB;
+      Status = Child->Read (Child, &Size, Context->Buffer);
+      Context->Bytes += Size;
+    }
+    Child->Close (Child);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+  FreePool (Info);
+  return Status;
+}
+
+EFI_STATUS
+BenchCreateTree (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *Dir;
+
+  Status = BenchOpen (Context, L"\\tree", EFI_FILE_DIRECTORY, TRUE, &Dir);
+  if (!EFI_ERROR (Status)) {
+    Status = BenchTree (Context, Dir, Context->Config->TreeDepth, TRUE);
+    Dir->Close (Dir);
+  }
+  return Status;
+}
+
+EFI_STATUS
+BenchWalkTree (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS          Status;
+  EFI_FILE_PROTOCOL   *Dir;
+
+  Status = BenchOpen (Context, L"\\tree", EFI_FILE_DIRECTORY, FALSE, &Dir);
+  if (!EFI_ERROR (Status)) {
+    Status = BenchTree (Context, Dir, Context->Config->TreeDepth, FALSE);
+    Dir->Close (Dir);
+  }
+  return Status;
+}
+
+BENCHMARK mBenchmarks[] = {
+  { "seq-write",    BenchSequentialWrite  },
+  { "seq-read",     BenchSequentialRead   },
+  { "random-read",  BenchRandomRead       },
+  { "create",       BenchCreateFiles      },
+  { "open",         BenchOpenFiles        },
+  { "list",         BenchListFiles        },
+  { "delete",       BenchDeleteFiles      },
+  { "tree-create",  BenchCreateTree       },
+  { "tree-walk",    BenchWalkTree         }
+};
+
+/**
+  Run one benchmark on a freshly mounted volume and print its results.
+
+**/
+EFI_STATUS
+BenchRun (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     BENCHMARK        *Benchmark
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_STATUS                  RunStatus;
+  FAT_CACHE_STATISTICS_INFO   Statistics;
+  HOST_DISK_COUNTERS          Counters;
+  UINTN                       Size;
+  double                      Start;
+  double                      Seconds;
+
+  Status = BenchMount (Context);
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "%s: mount failed with status 0x%llx\n", Benchmark->Name, (unsigned long long) Status);
+    return Status;
+  }
+
+  Context->Operations = 0;
+  Context->Bytes      = 0;
+  ZeroMem (&gHostDiskCounters, sizeof (gHostDiskCounters));
+
+  Start     = BenchNow ();
+  RunStatus = Benchmark->Function (Context);
+  Context->Root->Flush (Context->Root);
+
+  ZeroMem (&Statistics, sizeof (Statistics));
+  Size = sizeof (Statistics);
+  Context->Root->GetInfo (Context->Root, &gFatCacheStatisticsInfoGuid, &Size, &Statistics);
+
+  Status  = BenchUnmount (Context);
+  Seconds = BenchNow () - Start;
+  CopyMem (&Counters, &gHostDiskCounters, sizeof (Counters));
+
+  printf (
+    "%-12s %9llu %10.1f %9.3f %10.1f %9.2f %8llu %9.1f %8llu %9.1f %8llu %8llu %8llu\n",
+    Benchmark->Name,
+    (unsigned long long) Context->Operations,
+    Context->Operations / Seconds,
+    Seconds,
+    Context->Bytes / Seconds / SIZE_1MB,
+    (double) Context->Bytes / SIZE_1MB,
+    (unsigned long long) Counters.Reads,
+    (double) Counters.ReadBytes / SIZE_1MB,
+    (unsigned long long) Counters.Writes,
+    (double) Counters.WriteBytes / SIZE_1MB,
+    (unsigned long long) Statistics.CacheHits,
+    (unsigned long long) Statistics.CacheMisses,
+    (unsigned long long) Statistics.ReadAheadPages
+    );
+
+  if (EFI_ERROR (RunStatus)) {
+    fprintf (stderr, "%s failed with status 0x%llx\n", Benchmark->Name, (unsigned long long) RunStatus);
+    return RunStatus;
+  }
+  return Status;
+}
+
+/**
+  Print the command line syntax.
+
+**/
+VOID
+BenchUsage (
+  VOID
+  )
+{
+  fprintf (
+    stderr,
+    "Usage: HostBench [options] Image\n"
+    "Formats Image as a FAT volume and times EnhancedFatDxe on it.\n"
+    "  -t 16|32   FAT type (default 32)\n"
+    "  -s MB      image size (default 512)\n"
+    "  -c KB      cluster size (default 4)\n"
+    "  -m MB      size of the sequential test file (default 64)\n"
+    "  -k KB      read and write size of sequential I/O (default 64)\n"
+    "  -r N       number of random reads (default 4096)\n"
+    "  -R KB      size of each random read (default 4)\n"
+    "  -n N       number of files in the many-files directory (default 5000)\n"
+    "  -d N       depth of the directory tree (default 4)\n"
+    "  -w N       subdirectories per directory in the tree (default 4)\n"
+    "  -b NAME    run only the named benchmark\n"
+    );
+}
+
+int
+main (
+  int       Argc,
+  char      **Argv
+  )
+{
+  EFI_STATUS      Status;
+  BENCH_CONFIG    Config;
+  BENCH_CONTEXT   Context;
+  CONST CHAR8     *Only;
+  UINTN           Index;
+  int             Option;
+  BOOLEAN         Failed;
+
+  Config.Image        = NULL;
+  Config.FatBits      = 32;
+  Config.SizeMb       = 512;
+  Config.ClusterKb    = 4;
+  Config.FileMb       = 64;
+  Config.ChunkKb      = 64;
+  Config.RandomReads  = 4096;
+  Config.RandomKb     = 4;
+  Config.FileCount    = 5000;
+  Config.TreeDepth    = 4;
+  Config.TreeFanout   = 4;
+  Only                = NULL;
+
+  while ((Option = getopt (Argc, Argv, "t:s:c:m:k:r:R:n:d:w:b:h")) != -1) {
+    switch (Option) {
+    case 't': Config.FatBits     = (UINT32) atoi (optarg); break;
+    case 's': Config.SizeMb      = (UINT32) atoi (optarg); break;
+    case 'c': Config.ClusterKb   = (UINT32) atoi (optarg); break;
+    case 'm': Config.FileMb      = (UINT32) atoi (optarg); break;
+    case 'k': Config.ChunkKb     = (UINT32) atoi (optarg); break;
+    case 'r': Config.RandomReads = (UINT32) atoi (optarg); break;
+    case 'R': Config.RandomKb    = (UINT32) atoi (optarg); break;
+    case 'n': Config.FileCount   = (UINT32) atoi (optarg); break;
+    case 'd': Config.TreeDepth   = (UINT32) atoi (optarg); break;
+    case 'w': Config.TreeFanout  = (UINT32) atoi (optarg); break;
+    case 'b': Only               = optarg; break;
+    default:
+      BenchUsage ();
+      return 2;
+    }
+  }
+
+  if (optind != Argc - 1 || (Config.FatBits != 16 && Config.FatBits != 32) ||
+      Config.ClusterKb == 0 || Config.ClusterKb > 64 || (Config.ClusterKb & (Config.ClusterKb - 1)) != 0 ||
+      Config.ChunkKb == 0 || Config.RandomKb == 0 || Config.RandomKb > Config.ChunkKb ||
+      Config.FileMb == 0 || Config.FileMb * SIZE_1KB < Config.RandomKb) {
+    BenchUsage ();
+    return 2;
+  }
+  Config.Image = Argv[optind];
+
+  if (EFI_ERROR (BenchFormatImage (&Config))) {
+    return 1;
+  }
+
+  HostInitializeServices ();
+  InitializeUnicodeCollationEng (NULL, gST);
+  FatEntryPoint (NULL, gST);
+
+  ZeroMem (&Context, sizeof (Context));
+  Context.Config = &Config;
+  Context.Buffer = AllocatePool (Config.ChunkKb * SIZE_1KB);
+  Status = HostOpenDisk (Config.Image, BENCH_SECTOR_SIZE, FALSE, &Context.Disk);
+  if (Context.Buffer == NULL || EFI_ERROR (Status)) {
+    fprintf (stderr, "cannot open %s\n", Config.Image);
+    return 1;
+  }
+
+  printf (
+    "FAT%u, %u MB, %u KB clusters\n"
+    "%-12s %9s %10s %9s %10s %9s %8s %9s %8s %9s %8s %8s %8s\n",
+    Config.FatBits, Config.SizeMb, Config.ClusterKb,
+    "benchmark", "ops", "ops/s", "seconds", "MB/s", "MB", "reads", "read MB", "writes", "write MB", "hits", "misses", "ahead"
+    );
+
+  Failed = FALSE;
+  for (Index = 0; Index < sizeof (mBenchmarks) / sizeof (mBenchmarks[0]); Index++) {
+    if (Only != NULL && strcmp (Only, mBenchmarks[Index].Name) != 0 &&
+        //
+        // Later benchmarks work on what earlier ones created
+        //
+        !(strcmp (Only, "seq-read") == 0 && Index == 0) &&
+        !(strcmp (Only, "random-read") == 0 && Index == 0) &&
+        !((strcmp (Only, "open") == 0 || strcmp (Only, "list") == 0 || strcmp (Only, "delete") == 0) && Index == 3) &&
+        !(strcmp (Only, "tree-walk") == 0 && Index == 7)) {
+      continue;
+    }
+    if (EFI_ERROR (BenchRun (&Context, &mBenchmarks[Index]))) {
+      Failed = TRUE;
+      break;
+    }
+  }
+
+  HostCloseDisk (Context.Disk);
+  FreePool (Context.Buffer);
+  return Failed ? 1 : 0;
+}
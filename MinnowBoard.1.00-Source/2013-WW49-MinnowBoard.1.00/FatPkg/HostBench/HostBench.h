@@ -0,0 +1,47 @@
+/** @file
+  Host environment in which EnhancedFatDxe runs as part of an ordinary
+  program, over the host services of MdeModulePkg/Test/HostSupport.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_BENCH_H_
+#define _HOST_BENCH_H_
+
+#include "HostSupport.h"
+
+#include <Protocol/SimpleFileSystem.h>
+#include <Protocol/DriverBinding.h>
+
+#include <Guid/FileInfo.h>
+#include <Guid/FileSystemInfo.h>
+#include <Guid/FatCacheStatisticsInfo.h>
+
+//
+// Entry points of the modules linked into the program
+//
+extern EFI_DRIVER_BINDING_PROTOCOL  gFatDriverBinding;
+
+EFI_STATUS
+EFIAPI
+FatEntryPoint (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  );
+
+EFI_STATUS
+EFIAPI
+InitializeUnicodeCollationEng (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  );
+
+#endif
@@ -0,0 +1,53 @@
+/** @file
+  Provides a GUID and a data structure that can be used with EFI_FILE_PROTOCOL.GetInfo()
+  on a file of a FAT volume to get the statistics of the volume's data cache.
+
+  Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __FAT_CACHE_STATISTICS_INFO_H__
+#define __FAT_CACHE_STATISTICS_INFO_H__
+
+#define FAT_CACHE_STATISTICS_INFO_GUID \
+  { \
+    0x385f05ae, 0x8055, 0x46c8, {0x9c, 0x85, 0x35, 0x94, 0x9e, 0x20, 0xc2, 0x47 } \
+  }
+
+typedef struct {
+  ///
+  /// The number of data cache pages found in the cache.
+  ///
+  UINT64  CacheHits;
+  ///
+  /// The number of data cache pages read from the disk on demand.
+  ///
+  UINT64  CacheMisses;
+  ///
+  /// The number of data cache pages read ahead of sequential readers.
+  ///
+  UINT64  ReadAheadPages;
+  ///
+  /// The number of pages read ahead that were used before being replaced.
+  ///
+  UINT64  ReadAheadHits;
+  ///
+  /// The number of dirty data cache pages written back to the disk.
+  ///
+  UINT64  WriteBehindPages;
+  ///
+  /// The number of disk writes used to write back the dirty pages.
+  ///
+  UINT64  WriteBehindRuns;
+} FAT_CACHE_STATISTICS_INFO;
+
+extern EFI_GUID gFatCacheStatisticsInfoGuid;
+
+#endif
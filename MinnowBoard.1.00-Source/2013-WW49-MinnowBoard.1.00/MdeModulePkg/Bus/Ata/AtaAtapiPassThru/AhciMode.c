@@ -1888,6 +1888,469 @@ AhciPacketCommandExecute (
   return Status;
 }
 
+/**
+  Get the command slots which queued (FPDMA) commands to a device may use.
+
+  Queued commands are issued only when both the HBA and the device support native
+  command queuing. The command slot number is used as the queue tag, so it has to
+  stay below the queue depth reported by the device. Slot 0 is left to the
+  non-queued commands.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port              The number of port.
+  @param[in]  PortMultiplier    The number of port multiplier.
+
+  @return The queued commands use the slots from 1 to the returned value minus 1.
+          0 means that queued commands are not supported.
+
+**/
+UINT8
+EFIAPI
+AhciNcqSlotLimit (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE    *Instance,
+  IN  UINT16                          Port,
+  IN  UINT16                          PortMultiplier
+  )
+{
+  LIST_ENTRY           *Node;
+  EFI_ATA_DEVICE_INFO  *DeviceInfo;
+  ATA_IDENTIFY_DATA    *IdentifyData;
+  UINT8                SlotLimit;
+
+  if ((Instance->Mode != EfiAtaAhciMode) || (Instance->AhciRegisters.NcqCommandSlotNumber == 0)) {
+    return 0;
+  }
+
+  Node = SearchDeviceInfoList (Instance, Port, PortMultiplier, EfiIdeHarddisk);
+  if (Node == NULL) {
+    return 0;
+  }
+
+  //
+  // Word 76 bit 8 tells whether the device supports native command queuing,
+  // word 75 bits 4:0 hold its queue depth minus 1.
+  //
+  DeviceInfo   = ATA_ATAPI_DEVICE_INFO_FROM_THIS (Node);
+  IdentifyData = &DeviceInfo->IdentifyData->AtaData;
+  if ((IdentifyData->reserved_76_79[0] == 0xFFFF) || ((IdentifyData->reserved_76_79[0] & BIT8) == 0)) {
+    return 0;
+  }
+
+  SlotLimit = (UINT8) ((IdentifyData->queue_depth & 0x1F) + 1);
+  if (SlotLimit > Instance->AhciRegisters.NcqCommandSlotNumber) {
+    SlotLimit = Instance->AhciRegisters.NcqCommandSlotNumber;
+  }
+
+  return (UINT8) ((SlotLimit < 2) ? 0 : SlotLimit);
+}
+
+/**
+  Issue a queued (FPDMA) command in a command slot of specific port.
+
+  The command is added to the queued commands already outstanding on the port,
+  the port is only started for the first one.
+
+  @param[in]       PciIo               The PCI IO protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Slot                The command slot, which is also the queue tag.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of start, uses 100ns as a unit.
+  @param[out]      Map                 The mapping of the data buffer, which is
+                                       unmapped when the command completes.
+
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can not be mapped for the transfer.
+  @retval EFI_TIMEOUT         The port start is time out.
+  @retval EFI_SUCCESS         The queued command is issued.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqStartCommand (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     UINT8                      Slot,
+  IN     BOOLEAN                    Read,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlock,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT32                     DataCount,
+  IN     UINT64                     Timeout,
+  OUT    VOID                       **Map
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PHYSICAL_ADDRESS          PhyAddr;
+  UINTN                         MapLength;
+  EFI_PCI_IO_PROTOCOL_OPERATION Flag;
+  EFI_AHCI_COMMAND_FIS          CFis;
+  EFI_AHCI_COMMAND_LIST         *CmdList;
+  EFI_AHCI_NCQ_COMMAND_TABLE    *CommandTable;
+  UINT32                        PrdtNumber;
+  UINT32                        PrdtIndex;
+  UINTN                         RemainedData;
+  UINT64                        MemAddr;
+  DATA_64                       Data64;
+  UINT32                        Offset;
+  UINT32                        CmdSlotBit;
+
+  if (Read) {
+    Flag = EfiPciIoOperationBusMasterWrite;
+  } else {
+    Flag = EfiPciIoOperationBusMasterRead;
+  }
+
+  PrdtNumber = (DataCount + EFI_AHCI_MAX_DATA_PER_PRDT - 1) / EFI_AHCI_MAX_DATA_PER_PRDT;
+  if ((PrdtNumber == 0) || (PrdtNumber > EFI_AHCI_NCQ_MAX_PRDT_NUMBER)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  MapLength = DataCount;
+  Status = PciIo->Map (
+                    PciIo,
+                    Flag,
+                    MemoryAddr,
+                    &MapLength,
+                    &PhyAddr,
+                    Map
+                    );
+
+  if (EFI_ERROR (Status) || (DataCount != MapLength)) {
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, *Map);
+    }
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  //
+  // READ/WRITE FPDMA QUEUED carry the sector count in the feature field and the
+  // tag in bits 7:3 of the sector count field. Device bit 7 is FUA, leave it clear.
+  //
+  AhciBuildCommandFis (&CFis, AtaCommandBlock);
+  CFis.AhciCFisSecCount = (UINT8) (Slot << 3);
+  CFis.AhciCFisDevHead  = BIT6;
+  CFis.AhciCFisPmNum    = PortMultiplier;
+
+  CommandTable = &AhciRegisters->AhciNcqCommandTable[Slot];
+  ZeroMem (CommandTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+  CopyMem (&CommandTable->CommandFis, &CFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+  RemainedData = (UINTN) DataCount;
+  MemAddr      = PhyAddr;
+  for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+    if (RemainedData < EFI_AHCI_MAX_DATA_PER_PRDT) {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = (UINT32)RemainedData - 1;
+    } else {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = EFI_AHCI_MAX_DATA_PER_PRDT - 1;
+    }
+
+    Data64.Uint64 = MemAddr;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+    RemainedData -= EFI_AHCI_MAX_DATA_PER_PRDT;
+    MemAddr      += EFI_AHCI_MAX_DATA_PER_PRDT;
+  }
+  CommandTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
+
+  CmdList = &AhciRegisters->AhciCmdList[Slot];
+  ZeroMem (CmdList, sizeof (EFI_AHCI_COMMAND_LIST));
+  CmdList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+  CmdList->AhciCmdW     = Read ? 0 : 1;
+  CmdList->AhciCmdPrdtl = PrdtNumber;
+  CmdList->AhciCmdPmp   = PortMultiplier;
+
+  Data64.Uint64 = (UINT64)(UINTN) &AhciRegisters->AhciNcqCommandTablePciAddr[Slot];
+  CmdList->AhciCmdCtba  = Data64.Uint32.Lower32;
+  CmdList->AhciCmdCtbau = Data64.Uint32.Upper32;
+
+  CmdSlotBit = (UINT32) (1 << Slot);
+  if (AhciRegisters->NcqActiveSlots == 0) {
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+    AhciAndReg (PciIo, Offset, (UINT32)~(EFI_AHCI_PORT_CMD_DLAE | EFI_AHCI_PORT_CMD_ATAPI));
+
+    Status = AhciStartCommand (
+               PciIo,
+               Port,
+               Slot,
+               Timeout
+               );
+    if (EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, *Map);
+      return Status;
+    }
+  } else {
+    //
+    // Write the bit of the new slot only. Writing back the bits read from PxSACT
+    // and PxCI would reissue a command which completed in between.
+    //
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWriteReg (PciIo, Offset, CmdSlotBit);
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+    AhciWriteReg (PciIo, Offset, CmdSlotBit);
+  }
+
+  AhciRegisters->NcqActiveSlots |= CmdSlotBit;
+  return EFI_SUCCESS;
+}
+
+/**
+  Check which queued (FPDMA) commands outstanding on specific port have completed.
+
+  A queued command is complete when the HBA has cleared its slot bit in both
+  PxCI and PxSACT. The slots of the completed commands are released.
+
+  @param[in]   PciIo               The PCI IO protocol instance.
+  @param[in]   AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]   Port                The number of port.
+  @param[out]  CompletedSlots      The bit map of the slots whose command completed.
+
+  @retval EFI_DEVICE_ERROR    A queued command failed. The device aborts all the
+                              queued commands outstanding on it then.
+  @retval EFI_SUCCESS         The completed slots are returned.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqCheckCommands (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  OUT    UINT32                     *CompletedSlots
+  )
+{
+  UINT32     Offset;
+  UINT32     PortIs;
+  UINT32     PortTfd;
+  UINT32     ActiveSlots;
+
+  *CompletedSlots = 0;
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+  PortIs = AhciReadReg (PciIo, Offset);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+  PortTfd = AhciReadReg (PciIo, Offset);
+
+  if (((PortIs & (EFI_AHCI_PORT_IS_TFES | EFI_AHCI_PORT_IS_HBFS | EFI_AHCI_PORT_IS_HBDS | EFI_AHCI_PORT_IS_IFS)) != 0) ||
+      ((PortTfd & EFI_AHCI_PORT_TFD_ERR) != 0)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+  ActiveSlots = AhciReadReg (PciIo, Offset);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+  ActiveSlots |= AhciReadReg (PciIo, Offset);
+
+  *CompletedSlots = AhciRegisters->NcqActiveSlots & ~ActiveSlots;
+  AhciRegisters->NcqActiveSlots &= ActiveSlots;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stop specific port once no queued (FPDMA) command is outstanding on it, or
+  abort the outstanding ones after a failure.
+
+  After a queued command failed the device rejects all commands until its NCQ
+  command error log is read, so the log is read here. The port is reset when
+  that does not succeed either.
+
+  @param[in]  PciIo               The PCI IO protocol instance.
+  @param[in]  AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port                The number of port.
+  @param[in]  PortMultiplier      The number of port multiplier.
+  @param[in]  Failed              Whether a queued command failed or timed out.
+  @param[in]  Timeout             The timeout value of stop, uses 100ns as a unit.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopCommands (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT8                     PortMultiplier,
+  IN  BOOLEAN                   Failed,
+  IN  UINT64                    Timeout
+  )
+{
+  EFI_STATUS                Status;
+  EFI_ATA_COMMAND_BLOCK     AtaCommandBlock;
+  EFI_ATA_STATUS_BLOCK      AtaStatusBlock;
+  VOID                      *Buffer;
+
+  AhciStopCommand (
+    PciIo,
+    Port,
+    Timeout
+    );
+
+  AhciDisableFisReceive (
+    PciIo,
+    Port,
+    Timeout
+    );
+
+  AhciRegisters->NcqActiveSlots = 0;
+
+  if (!Failed) {
+    return;
+  }
+
+  Status = EFI_OUT_OF_RESOURCES;
+  Buffer = AllocateZeroPool (0x200);
+  if (Buffer != NULL) {
+    ZeroMem (&AtaCommandBlock, sizeof (EFI_ATA_COMMAND_BLOCK));
+    ZeroMem (&AtaStatusBlock, sizeof (EFI_ATA_STATUS_BLOCK));
+    AtaCommandBlock.AtaCommand      = ATA_CMD_READ_LOG_EXT;
+    AtaCommandBlock.AtaSectorNumber = EFI_AHCI_NCQ_ERROR_LOG_PAGE;
+    AtaCommandBlock.AtaSectorCount  = 1;
+
+    Status = AhciPioTransfer (
+               PciIo,
+               AhciRegisters,
+               Port,
+               PortMultiplier,
+               NULL,
+               0,
+               TRUE,
+               &AtaCommandBlock,
+               &AtaStatusBlock,
+               Buffer,
+               0x200,
+               Timeout,
+               NULL
+               );
+    FreePool (Buffer);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "AHCI port %d NCQ error recovery failed, reset the port\n", Port));
+    AhciPortReset (PciIo, Port, Timeout);
+  }
+}
+
+/**
+  Start a queued (FPDMA) data transfer on specific port and wait for it.
+
+  This is the blocking flavor; non-blocking queued tasks are issued together by
+  AsyncNcqTransferRoutine().
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of data transfer, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR    The queued data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can not be mapped for the transfer.
+  @retval EFI_SUCCESS         The queued data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     BOOLEAN                    Read,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK       *AtaStatusBlock,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT32                     DataCount,
+  IN     UINT64                     Timeout
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PCI_IO_PROTOCOL           *PciIo;
+  EFI_TPL                       OldTpl;
+  VOID                          *Map;
+  UINT32                        CompletedSlots;
+  UINT64                        Delay;
+
+  PciIo = Instance->PciIo;
+
+  //
+  // Before starting the Blocking BlockIO operation, push to finish all non-blocking
+  // BlockIO tasks.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (!IsListEmpty (&Instance->NonBlockingTaskList)) {
+    AsyncNonBlockingTransferRoutine (NULL, Instance);
+    //
+    // Stall for 100us.
+    //
+    MicroSecondDelay (100);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  Status = AhciNcqStartCommand (
+             PciIo,
+             AhciRegisters,
+             Port,
+             PortMultiplier,
+             1,
+             Read,
+             AtaCommandBlock,
+             MemoryAddr,
+             DataCount,
+             Timeout,
+             &Map
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Delay = DivU64x32 (Timeout, 1000) + 1;
+  do {
+    Status = AhciNcqCheckCommands (PciIo, AhciRegisters, Port, &CompletedSlots);
+    if (EFI_ERROR (Status) || (CompletedSlots != 0)) {
+      break;
+    }
+
+    //
+    // Stall for 100 microseconds.
+    //
+    MicroSecondDelay (100);
+
+    Delay--;
+  } while (Delay > 0);
+
+  if (Delay == 0) {
+    Status = EFI_TIMEOUT;
+  }
+
+  AhciDumpPortStatus (PciIo, Port, AtaStatusBlock);
+
+  AhciNcqStopCommands (
+    PciIo,
+    AhciRegisters,
+    Port,
+    PortMultiplier,
+    (BOOLEAN) EFI_ERROR (Status),
+    Timeout
+    );
+
+  PciIo->Unmap (
+           PciIo,
+           Map
+           );
+
+  return Status;
+}
+
 /**
   Allocate transfer-related data struct which is used at AHCI mode.
 
@@ -2127,6 +2590,106 @@ Error6:
   return Status;
 }
 
+/**
+  Allocate the command tables used by native command queuing at AHCI mode.
+
+  Every command slot gets a command table of its own, which is sized for the
+  largest queued transfer. Queued commands are not used when the HBA does not
+  support them or the tables can not be allocated.
+
+  @param  PciIo                 The PCI IO protocol instance.
+  @param  AhciRegisters         The pointer to the EFI_AHCI_REGISTERS.
+
+  @retval EFI_UNSUPPORTED       The HBA does not support native command queuing.
+  @retval EFI_OUT_OF_RESOURCES  The command tables can not be allocated.
+  @retval EFI_SUCCESS           The command tables are allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciCreateNcqTransferDescriptor (
+  IN     EFI_PCI_IO_PROTOCOL    *PciIo,
+  IN OUT EFI_AHCI_REGISTERS     *AhciRegisters
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Bytes;
+  VOID                  *Buffer;
+  UINT32                Capability;
+  UINT8                 MaxCommandSlotNumber;
+  BOOLEAN               Support64Bit;
+  UINT64                MaxNcqCommandTableSize;
+  EFI_PHYSICAL_ADDRESS  AhciNcqCommandTablePciAddr;
+
+  Capability           = AhciReadReg(PciIo, EFI_AHCI_CAPABILITY_OFFSET);
+  MaxCommandSlotNumber = (UINT8) (((Capability & 0x1F00) >> 8) + 1);
+  Support64Bit         = (BOOLEAN) (((Capability & BIT31) != 0) ? TRUE : FALSE);
+
+  if (((Capability & EFI_AHCI_CAP_SNCQ) == 0) || (MaxCommandSlotNumber < 2)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Buffer = NULL;
+  MaxNcqCommandTableSize = MaxCommandSlotNumber * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+                    &Buffer,
+                    0
+                    );
+
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Buffer, (UINTN)MaxNcqCommandTableSize);
+
+  AhciRegisters->AhciNcqCommandTable    = Buffer;
+  AhciRegisters->MaxNcqCommandTableSize = MaxNcqCommandTableSize;
+  Bytes  = (UINTN)MaxNcqCommandTableSize;
+
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Buffer,
+                    &Bytes,
+                    &AhciNcqCommandTablePciAddr,
+                    &AhciRegisters->MapNcqCommandTable
+                    );
+
+  if (EFI_ERROR (Status) || (Bytes != MaxNcqCommandTableSize)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error2;
+  }
+
+  if ((!Support64Bit) && (AhciNcqCommandTablePciAddr > 0x100000000ULL)) {
+    Status = EFI_DEVICE_ERROR;
+    goto Error1;
+  }
+  AhciRegisters->AhciNcqCommandTablePciAddr = (EFI_AHCI_NCQ_COMMAND_TABLE *)(UINTN)AhciNcqCommandTablePciAddr;
+  AhciRegisters->NcqCommandSlotNumber       = MaxCommandSlotNumber;
+  AhciRegisters->NcqActiveSlots             = 0;
+
+  return EFI_SUCCESS;
+
+Error1:
+  PciIo->Unmap (
+           PciIo,
+           AhciRegisters->MapNcqCommandTable
+           );
+Error2:
+  PciIo->FreeBuffer (
+           PciIo,
+           EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+           AhciRegisters->AhciNcqCommandTable
+           );
+  AhciRegisters->AhciNcqCommandTable = NULL;
+
+  return Status;
+}
+
 /**
   Initialize ATA host controller at AHCI mode.
 
@@ -2201,6 +2764,14 @@ AhciModeInitialization (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Native command queuing is optional, the HBA works without it.
+  //
+  if (PcdGetBool (PcdAtaNcqEnable)) {
+    Status = AhciCreateNcqTransferDescriptor (PciIo, AhciRegisters);
+    DEBUG ((EFI_D_INFO, "AHCI native command queuing: %r\n", Status));
+  }
+
   for (Port = 0; Port < MaxPortNumber; Port ++) {
     if ((PortImplementBitMap & (BIT0 << Port)) != 0) {
       IdeInit->NotifyPhase (IdeInit, EfiIdeBeforeChannelEnumeration, Port);
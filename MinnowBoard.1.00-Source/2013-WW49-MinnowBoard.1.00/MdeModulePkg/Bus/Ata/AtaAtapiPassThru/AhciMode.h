@@ -18,6 +18,7 @@
 
 #define EFI_AHCI_CAPABILITY_OFFSET             0x0000
 #define   EFI_AHCI_CAP_SSS                     BIT27
+#define   EFI_AHCI_CAP_SNCQ                    BIT30
 #define   EFI_AHCI_CAP_S64A                    BIT31
 #define EFI_AHCI_GHC_OFFSET                    0x0004
 #define   EFI_AHCI_GHC_RESET                   BIT0
@@ -59,6 +60,16 @@ typedef union {
 //
 #define EFI_AHCI_MAX_DATA_PER_PRDT             0x400000
 
+//
+// A queued (FPDMA) command moves at most 65536 sectors, which takes 8 PRDT entries.
+//
+#define EFI_AHCI_NCQ_MAX_PRDT_NUMBER           8
+
+//
+// Log page read by READ LOG EXT to recover the device after a failed queued command.
+//
+#define EFI_AHCI_NCQ_ERROR_LOG_PAGE            0x10
+
 #define EFI_AHCI_FIS_REGISTER_H2D              0x27      //Register FIS - Host to Device
 #define   EFI_AHCI_FIS_REGISTER_H2D_LENGTH     20 
 #define EFI_AHCI_FIS_REGISTER_D2H              0x34      //Register FIS - Device to Host
@@ -264,6 +275,17 @@ typedef struct {
   EFI_AHCI_COMMAND_PRDT     PrdtTable[65535];     // The scatter/gather list for data transfer
 } EFI_AHCI_COMMAND_TABLE;
 
+//
+// Command table used by a native command queuing slot. Each queued command owns
+// one so that several of them can be outstanding at a time.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;       // A software constructed FIS.
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;         // Not used by queued commands.
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[EFI_AHCI_NCQ_MAX_PRDT_NUMBER];
+} EFI_AHCI_NCQ_COMMAND_TABLE;
+
 //
 // Received FIS structure
 //
@@ -294,6 +316,16 @@ typedef struct {
   VOID                      *MapRFis;
   VOID                      *MapCmdList;
   VOID                      *MapCommandTable;
+  //
+  // Native command queuing. Slot 0 stays reserved for the non-queued commands,
+  // queued commands use slot N with its own table at AhciNcqCommandTable[N].
+  //
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTable;
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTablePciAddr;
+  UINT64                    MaxNcqCommandTableSize;
+  VOID                      *MapNcqCommandTable;
+  UINT8                     NcqCommandSlotNumber;  // Slots usable by queued commands, 0 if none.
+  UINT32                    NcqActiveSlots;        // Bit map of the outstanding queued commands.
 } EFI_AHCI_REGISTERS;
 
 /**
@@ -343,6 +375,23 @@ AhciStartCommand (
   IN  UINT64                    Timeout
   );
 
+/**
+  This function is used to dump the Status Registers and if there is ERR bit set
+  in the Status Register, the Error Register's value is also be dumped.
+
+  @param  PciIo            The PCI IO protocol instance.
+  @param  Port             The number of port.
+  @param  AtaStatusBlock   A pointer to EFI_ATA_STATUS_BLOCK data structure.
+
+**/
+VOID
+EFIAPI
+AhciDumpPortStatus (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     UINT8                      Port,
+  IN OUT EFI_ATA_STATUS_BLOCK       *AtaStatusBlock
+  );
+
 /**
   Stop command running for giving port
     
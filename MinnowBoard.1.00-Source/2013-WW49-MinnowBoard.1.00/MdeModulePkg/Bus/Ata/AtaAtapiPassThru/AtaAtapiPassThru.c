@@ -351,6 +351,24 @@ AtaPassThruPassThruExecute (
                      Task
                      );
           break;
+        case EFI_ATA_PASS_THRU_PROTOCOL_FPDMA:
+          //
+          // Non-blocking queued tasks are issued by AsyncNcqTransferRoutine().
+          //
+          ASSERT (Task == NULL);
+          Status = AhciNcqTransfer (
+                     Instance,
+                     &Instance->AhciRegisters,
+                     (UINT8)Port,
+                     (UINT8)PortMultiplierPort,
+                     (BOOLEAN) (Packet->InTransferLength != 0),
+                     Packet->Acb,
+                     Packet->Asb,
+                     (Packet->InTransferLength != 0) ? Packet->InDataBuffer : Packet->OutDataBuffer,
+                     (Packet->InTransferLength != 0) ? Packet->InTransferLength : Packet->OutTransferLength,
+                     Packet->Timeout
+                     );
+          break;
         default :
           return EFI_UNSUPPORTED;
       }
@@ -364,6 +382,179 @@ AtaPassThruPassThruExecute (
   return Status;
 }
 
+/**
+  Issue and reap the queued (FPDMA) tasks at the head of the non-blocking task list.
+
+  The FPDMA tasks for the port of the first task, up to the first task which is
+  not one, are issued into free command slots, so that several of them are
+  outstanding on the device at a time. The completed ones are reaped in whatever
+  order the device finished them, and the freed slots are refilled. A task whose
+  command can not be set up on the host, e.g. because its buffer can not be
+  mapped, never reaches the device; it fails on its own and the others go on.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+  @retval EFI_SUCCESS           All these tasks completed and were removed from the list.
+  @retval EFI_NOT_READY         Some of these tasks are still outstanding.
+  @retval Others                A task failed or timed out. The outstanding ones are
+                                aborted and left in the list.
+
+**/
+EFI_STATUS
+EFIAPI
+AsyncNcqTransferRoutine (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE *Instance
+  )
+{
+  LIST_ENTRY                       *Entry;
+  LIST_ENTRY                       *NextEntry;
+  LIST_ENTRY                       *EntryHeader;
+  ATA_NONBLOCK_TASK                *Task;
+  EFI_ATA_PASS_THRU_COMMAND_PACKET *Packet;
+  EFI_AHCI_REGISTERS               *AhciRegisters;
+  EFI_PCI_IO_PROTOCOL              *PciIo;
+  EFI_STATUS                       Status;
+  UINT16                           Port;
+  UINT16                           PortMultiplier;
+  UINT8                            SlotLimit;
+  UINT8                            Slot;
+  UINT32                           CompletedSlots;
+  BOOLEAN                          Read;
+
+  EntryHeader    = &Instance->NonBlockingTaskList;
+  AhciRegisters  = &Instance->AhciRegisters;
+  PciIo          = Instance->PciIo;
+  Task           = ATA_NON_BLOCK_TASK_FROM_ENTRY (GetFirstNode (EntryHeader));
+  Port           = Task->Port;
+  PortMultiplier = Task->PortMultiplier;
+
+  SlotLimit = AhciNcqSlotLimit (Instance, Port, PortMultiplier);
+  if (SlotLimit == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Reap the completed tasks. The started tasks always come first, since the
+  // tasks are issued in list order.
+  //
+  if (AhciRegisters->NcqActiveSlots != 0) {
+    Status = AhciNcqCheckCommands (PciIo, AhciRegisters, (UINT8) Port, &CompletedSlots);
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+
+    Entry = GetFirstNode (EntryHeader);
+    while (!IsNull (EntryHeader, Entry)) {
+      Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+      Entry = GetNextNode (EntryHeader, Entry);
+      if (!Task->IsStart ||
+          (Task->Packet->Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) ||
+          (Task->Port != Port) || (Task->PortMultiplier != PortMultiplier)) {
+        break;
+      }
+
+      if ((CompletedSlots & (BIT0 << Task->NcqSlot)) != 0) {
+        PciIo->Unmap (PciIo, Task->Map);
+        AhciDumpPortStatus (PciIo, (UINT8) Port, Task->Packet->Asb);
+        RemoveEntryList (&Task->Link);
+        gBS->SignalEvent (Task->Event);
+        FreePool (Task);
+      } else if (--Task->RetryTimes == 0) {
+        Status = EFI_TIMEOUT;
+        goto Exit;
+      }
+    }
+  }
+
+  //
+  // Issue the following tasks into the free slots.
+  //
+  Status = EFI_SUCCESS;
+  for (Entry = GetFirstNode (EntryHeader);
+       !IsNull (EntryHeader, Entry);
+       Entry = NextEntry) {
+    NextEntry = GetNextNode (EntryHeader, Entry);
+    Task      = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if ((Task->Packet->Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) ||
+        (Task->Port != Port) || (Task->PortMultiplier != PortMultiplier)) {
+      break;
+    }
+
+    if (Task->IsStart) {
+      continue;
+    }
+
+    for (Slot = 1; Slot < SlotLimit; Slot++) {
+      if ((AhciRegisters->NcqActiveSlots & (BIT0 << Slot)) == 0) {
+        break;
+      }
+    }
+    if (Slot == SlotLimit) {
+      break;
+    }
+
+    Packet = Task->Packet;
+    Read   = (BOOLEAN) (Packet->InTransferLength != 0);
+    Status = AhciNcqStartCommand (
+               PciIo,
+               AhciRegisters,
+               (UINT8) Port,
+               (UINT8) PortMultiplier,
+               Slot,
+               Read,
+               Packet->Acb,
+               Read ? Packet->InDataBuffer : Packet->OutDataBuffer,
+               Read ? Packet->InTransferLength : Packet->OutTransferLength,
+               Packet->Timeout,
+               &Task->Map
+               );
+    if (Status == EFI_BAD_BUFFER_SIZE) {
+      //
+      // The command was not issued, so the device and the commands
+      // outstanding on it are not affected.
+      //
+      DEBUG ((EFI_D_ERROR, "AHCI port %d NCQ task can not be mapped\n", Port));
+      Packet->Asb->AtaStatus = 0x01;
+      RemoveEntryList (&Task->Link);
+      gBS->SignalEvent (Task->Event);
+      FreePool (Task);
+      Status = EFI_SUCCESS;
+      continue;
+    }
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+
+    Task->IsStart    = TRUE;
+    Task->NcqSlot    = Slot;
+    Task->RetryTimes = DivU64x32 (Packet->Timeout, 1000) + 1;
+  }
+
+  if (AhciRegisters->NcqActiveSlots != 0) {
+    return EFI_NOT_READY;
+  }
+
+  AhciNcqStopCommands (PciIo, AhciRegisters, (UINT8) Port, (UINT8) PortMultiplier, FALSE, ATA_ATAPI_TIMEOUT);
+  return EFI_SUCCESS;
+
+Exit:
+  //
+  // The device aborts all outstanding queued commands after a failure.
+  //
+  for (Entry = GetFirstNode (EntryHeader);
+       !IsNull (EntryHeader, Entry);
+       Entry = GetNextNode (EntryHeader, Entry)) {
+    Task = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if (Task->IsStart && (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+      PciIo->Unmap (PciIo, Task->Map);
+      Task->IsStart = FALSE;
+    }
+  }
+
+  AhciNcqStopCommands (PciIo, AhciRegisters, (UINT8) Port, (UINT8) PortMultiplier, TRUE, ATA_ATAPI_TIMEOUT);
+  return Status;
+}
+
 /**
   Call back function when the timer event is signaled.
 
@@ -399,13 +590,24 @@ AsyncNonBlockingTransferRoutine (
       return;
     }
 
-    Status = AtaPassThruPassThruExecute (
-               Task->Port,
-               Task->PortMultiplier,
-               Task->Packet,
-               Instance,
-               Task
-               );
+    if ((Instance->Mode == EfiAtaAhciMode) &&
+        (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+      //
+      // Queued tasks are kept outstanding together rather than one at a time.
+      //
+      Status = AsyncNcqTransferRoutine (Instance);
+      if (Status == EFI_SUCCESS) {
+        continue;
+      }
+    } else {
+      Status = AtaPassThruPassThruExecute (
+                 Task->Port,
+                 Task->PortMultiplier,
+                 Task->Packet,
+                 Instance,
+                 Task
+                 );
+    }
 
     //
     // If the data transfer meet a error, remove all tasks in the list since these tasks are
@@ -934,6 +1136,17 @@ AtaAtapiPassThruStop (
   //
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    if (AhciRegisters->AhciNcqCommandTable != NULL) {
+      PciIo->Unmap (
+               PciIo,
+               AhciRegisters->MapNcqCommandTable
+               );
+      PciIo->FreeBuffer (
+               PciIo,
+               EFI_SIZE_TO_PAGES ((UINTN) AhciRegisters->MaxNcqCommandTableSize),
+               AhciRegisters->AhciNcqCommandTable
+               );
+    }
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
@@ -1261,6 +1474,15 @@ AtaPassThruPassThru (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // Queued (FPDMA) commands need native command queuing support of both the AHCI
+  // HBA and the device.
+  //
+  if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) &&
+      (AhciNcqSlotLimit (Instance, Port, PortMultiplierPort) == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
   //
   // convert the transfer length from sector count to byte.
   //
@@ -1302,6 +1524,13 @@ AtaPassThruPassThru (
     }
   }
 
+  //
+  // Queued commands always use 48-bit addressing and a 16-bit sector count.
+  //
+  if (Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) {
+    MaxSectorCount = 0x10000;
+  }
+
   //
   // If the data buffer described by InDataBuffer/OutDataBuffer and InTransferLength/OutTransferLength
   // is too big to be transferred in a single command, then no data is transferred and EFI_BAD_BUFFER_SIZE
@@ -139,6 +139,7 @@ struct _ATA_NONBLOCK_TASK {
   VOID                              *TableMap;// Pointer to PRD table map.
   EFI_ATA_DMA_PRD                   *MapBaseAddress; //  Pointer to range Base address for Map.
   UINTN                             PageCount;      //  The page numbers used by PCIO freebuffer.
+  UINT8                             NcqSlot;        //  The command slot of a queued (FPDMA) task.
 };
 
 //
@@ -535,6 +536,28 @@ AsyncNonBlockingTransferRoutine (
   VOID*      Context
   );
 
+/**
+  Issue and reap the queued (FPDMA) tasks at the head of the non-blocking task list.
+
+  The FPDMA tasks for the port of the first task, up to the first task which is
+  not one, are issued into free command slots, so that several of them are
+  outstanding on the device at a time. The completed ones are reaped in whatever
+  order the device finished them, and the freed slots are refilled.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+  @retval EFI_SUCCESS           All these tasks completed and were removed from the list.
+  @retval EFI_NOT_READY         Some of these tasks are still outstanding.
+  @retval Others                A task failed or timed out. The outstanding ones are
+                                aborted and left in the list.
+
+**/
+EFI_STATUS
+EFIAPI
+AsyncNcqTransferRoutine (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE *Instance
+  );
+
 /**
   Sends an ATA command to an ATA device that is attached to the ATA controller. This function
   supports both blocking I/O and non-blocking I/O. The blocking I/O functionality is required,
@@ -1192,6 +1215,160 @@ AhciPioTransfer (
   IN     ATA_NONBLOCK_TASK          *Task
   );
 
+/**
+  Get the command slots which queued (FPDMA) commands to a device may use.
+
+  Queued commands are issued only when both the HBA and the device support native
+  command queuing. The command slot number is used as the queue tag, so it has to
+  stay below the queue depth reported by the device. Slot 0 is left to the
+  non-queued commands.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port              The number of port.
+  @param[in]  PortMultiplier    The number of port multiplier.
+
+  @return The queued commands use the slots from 1 to the returned value minus 1.
+          0 means that queued commands are not supported.
+
+**/
+UINT8
+EFIAPI
+AhciNcqSlotLimit (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE    *Instance,
+  IN  UINT16                          Port,
+  IN  UINT16                          PortMultiplier
+  );
+
+/**
+  Issue a queued (FPDMA) command in a command slot of specific port.
+
+  The command is added to the queued commands already outstanding on the port,
+  the port is only started for the first one.
+
+  @param[in]       PciIo               The PCI IO protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Slot                The command slot, which is also the queue tag.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of start, uses 100ns as a unit.
+  @param[out]      Map                 The mapping of the data buffer, which is
+                                       unmapped when the command completes.
+
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can not be mapped for the transfer.
+  @retval EFI_TIMEOUT         The port start is time out.
+  @retval EFI_SUCCESS         The queued command is issued.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqStartCommand (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     UINT8                      Slot,
+  IN     BOOLEAN                    Read,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlock,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT32                     DataCount,
+  IN     UINT64                     Timeout,
+  OUT    VOID                       **Map
+  );
+
+/**
+  Check which queued (FPDMA) commands outstanding on specific port have completed.
+
+  A queued command is complete when the HBA has cleared its slot bit in both
+  PxCI and PxSACT. The slots of the completed commands are released.
+
+  @param[in]   PciIo               The PCI IO protocol instance.
+  @param[in]   AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]   Port                The number of port.
+  @param[out]  CompletedSlots      The bit map of the slots whose command completed.
+
+  @retval EFI_DEVICE_ERROR    A queued command failed. The device aborts all the
+                              queued commands outstanding on it then.
+  @retval EFI_SUCCESS         The completed slots are returned.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqCheckCommands (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  OUT    UINT32                     *CompletedSlots
+  );
+
+/**
+  Stop specific port once no queued (FPDMA) command is outstanding on it, or
+  abort the outstanding ones after a failure.
+
+  After a queued command failed the device rejects all commands until its NCQ
+  command error log is read, so the log is read here. The port is reset when
+  that does not succeed either.
+
+  @param[in]  PciIo               The PCI IO protocol instance.
+  @param[in]  AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  Port                The number of port.
+  @param[in]  PortMultiplier      The number of port multiplier.
+  @param[in]  Failed              Whether a queued command failed or timed out.
+  @param[in]  Timeout             The timeout value of stop, uses 100ns as a unit.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopCommands (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT8                     PortMultiplier,
+  IN  BOOLEAN                   Failed,
+  IN  UINT64                    Timeout
+  );
+
+/**
+  Start a queued (FPDMA) data transfer on specific port and wait for it.
+
+  This is the blocking flavor; non-blocking queued tasks are issued together by
+  AsyncNcqTransferRoutine().
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of data transfer, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR    The queued data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can not be mapped for the transfer.
+  @retval EFI_SUCCESS         The queued data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     BOOLEAN                    Read,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK       *AtaStatusBlock,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT32                     DataCount,
+  IN     UINT64                     Timeout
+  );
+
 /**
   Send ATA command into device with NON_DATA protocol
 
@@ -0,0 +1,750 @@
+/** @file
+  A software model of an AHCI HBA with a native command queuing disk on every
+  port, behind the EFI_PCI_IO_PROTOCOL the AtaAtapiPassThru driver uses.
+
+  The model acts on register writes at once. A write to PxCI fetches the
+  commands of the newly set slots from the command list: non-queued commands
+  complete immediately, queued (FPDMA) commands are only accepted and stay
+  outstanding in PxSACT until the test completes or fails them. DMA addresses
+  are host addresses, since PciIo->Map() maps one to one.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostTest.h"
+
+#include <stdlib.h>
+
+#define AHCI_MODEL_LOG_SIZE         0x200
+
+/**
+  Get the host address of a 64-bit bus address split into two registers.
+
+**/
+VOID *
+AhciModelAddress (
+  IN UINT32             Lower,
+  IN UINT32             Upper
+  )
+{
+  return (VOID *) (UINTN) (LShiftU64 (Upper, 32) | Lower);
+}
+
+/**
+  Copy between a PRDT and a buffer, as the DMA engine of the HBA does.
+
+  @param  Prdt          The physical region descriptor table.
+  @param  PrdtLength    The number of entries in the table.
+  @param  Buffer        The buffer.
+  @param  Length        The number of bytes to transfer.
+  @param  ToMemory      TRUE to copy from Buffer to the regions, FALSE for the
+                        other direction.
+
+  @return The number of bytes transferred.
+
+**/
+UINT32
+AhciModelDma (
+  IN EFI_AHCI_COMMAND_PRDT    *Prdt,
+  IN UINT32                   PrdtLength,
+  IN UINT8                    *Buffer,
+  IN UINT32                   Length,
+  IN BOOLEAN                  ToMemory
+  )
+{
+  UINT32    Index;
+  UINT32    Count;
+  UINT32    Done;
+  UINT8     *Region;
+
+  Done = 0;
+  for (Index = 0; (Index < PrdtLength) && (Done < Length); Index++) {
+    Region = AhciModelAddress (Prdt[Index].AhciPrdtDba, Prdt[Index].AhciPrdtDbau);
+    Count  = MIN (Prdt[Index].AhciPrdtDbc + 1, Length - Done);
+    if (ToMemory) {
+      CopyMem (Region, Buffer + Done, Count);
+    } else {
+      CopyMem (Buffer + Done, Region, Count);
+    }
+    Done += Count;
+  }
+
+  return Done;
+}
+
+/**
+  Post a FIS to the received FIS area of a port.
+
+**/
+VOID
+AhciModelPostFis (
+  IN AHCI_MODEL_PORT    *ModelPort,
+  IN UINTN              FisOffset,
+  IN UINT8              FisType
+  )
+{
+  UINT8     *Fis;
+
+  Fis = (UINT8 *) AhciModelAddress (ModelPort->Fb, ModelPort->Fbu) + FisOffset;
+  Fis[0] = FisType;
+  Fis[2] = (UINT8) ModelPort->Tfd;
+  Fis[3] = (UINT8) (ModelPort->Tfd >> 8);
+}
+
+/**
+  Let the device report a failed command.
+
+**/
+VOID
+AhciModelReportError (
+  IN AHCI_MODEL_PORT    *ModelPort
+  )
+{
+  ModelPort->Tfd  = AHCI_MODEL_TFD_ERROR;
+  ModelPort->Is  |= EFI_AHCI_PORT_IS_TFES;
+}
+
+/**
+  Let the device abort all its queued commands after a failure.
+
+**/
+VOID
+AhciModelAbort (
+  IN AHCI_MODEL_PORT    *ModelPort
+  )
+{
+  UINT32    Slot;
+
+  for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+    ModelPort->Queued[Slot].Valid = FALSE;
+  }
+  ModelPort->ErrorState = TRUE;
+  AhciModelReportError (ModelPort);
+}
+
+/**
+  Transfer the data of queued commands and clear their slots.
+
+**/
+VOID
+AhciModelFinish (
+  IN AHCI_MODEL_PORT    *ModelPort,
+  IN UINT32             Slots
+  )
+{
+  AHCI_MODEL_COMMAND    *Command;
+  UINT32                Slot;
+  UINT32                Length;
+
+  for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+    Command = &ModelPort->Queued[Slot];
+    if (((Slots & (BIT0 << Slot)) == 0) || !Command->Valid) {
+      continue;
+    }
+
+    Length = Command->SectorCount * AHCI_MODEL_SECTOR_SIZE;
+    if (AhciModelDma (
+          Command->Prdt,
+          Command->PrdtLength,
+          ModelPort->Disk + Command->Lba * AHCI_MODEL_SECTOR_SIZE,
+          Length,
+          Command->Read
+          ) != Length) {
+      ModelPort->BadCommands++;
+    }
+
+    Command->Valid   = FALSE;
+    ModelPort->Sact &= ~(BIT0 << Slot);
+    ModelPort->Ci   &= ~(BIT0 << Slot);
+    ModelPort->Is   |= EFI_AHCI_PORT_IS_SDBS;
+  }
+}
+
+/**
+  Execute a non-queued command. Only READ LOG EXT of the NCQ command error log
+  transfers data, every other command completes without any.
+
+**/
+VOID
+AhciModelExecute (
+  IN AHCI_MODEL_PORT         *ModelPort,
+  IN EFI_AHCI_COMMAND_LIST   *CmdList,
+  IN EFI_AHCI_COMMAND_TABLE  *CommandTable
+  )
+{
+  EFI_AHCI_COMMAND_FIS  *CFis;
+  UINT8                 Log[AHCI_MODEL_LOG_SIZE];
+
+  CFis = &CommandTable->CommandFis;
+  if ((CFis->AhciCFisCmd == ATA_CMD_READ_LOG_EXT) && (CFis->AhciCFisSecNum == EFI_AHCI_NCQ_ERROR_LOG_PAGE)) {
+    if (ModelPort->FailReadLog) {
+      AhciModelReportError (ModelPort);
+      AhciModelPostFis (ModelPort, EFI_AHCI_D2H_FIS_OFFSET, EFI_AHCI_FIS_REGISTER_D2H);
+      return;
+    }
+
+    //
+    // Reading the log ends the error condition. Byte 0 holds the tag of the
+    // failed command, bit 7 is set when no queued command failed.
+    //
+    ZeroMem (Log, sizeof (Log));
+    Log[0] = (UINT8) (ModelPort->ErrorState ? 0 : BIT7);
+
+    ModelPort->ErrorState = FALSE;
+    ModelPort->Tfd        = AHCI_MODEL_TFD_IDLE;
+    ModelPort->ReadLogs++;
+    CmdList->AhciCmdPrdbc = AhciModelDma (
+                              CommandTable->PrdtTable,
+                              CmdList->AhciCmdPrdtl,
+                              Log,
+                              sizeof (Log),
+                              TRUE
+                              );
+    AhciModelPostFis (ModelPort, EFI_AHCI_PIO_FIS_OFFSET, EFI_AHCI_FIS_PIO_SETUP);
+    return;
+  }
+
+  if (ModelPort->ErrorState) {
+    AhciModelReportError (ModelPort);
+  } else {
+    ModelPort->Tfd = AHCI_MODEL_TFD_IDLE;
+  }
+  AhciModelPostFis (ModelPort, EFI_AHCI_D2H_FIS_OFFSET, EFI_AHCI_FIS_REGISTER_D2H);
+}
+
+/**
+  Accept a queued (FPDMA) command, after checking that it follows the rules of
+  AHCI and ATA: the tag must be the command slot, the sector count must be in
+  the feature field and the slot must have been set in PxSACT first.
+
+  @retval TRUE    The command is accepted and stays outstanding.
+  @retval FALSE   The command is rejected.
+
+**/
+BOOLEAN
+AhciModelQueue (
+  IN AHCI_MODEL_PORT         *ModelPort,
+  IN UINT32                  Slot,
+  IN EFI_AHCI_COMMAND_LIST   *CmdList,
+  IN EFI_AHCI_COMMAND_TABLE  *CommandTable
+  )
+{
+  EFI_AHCI_COMMAND_FIS  *CFis;
+  AHCI_MODEL_COMMAND    *Command;
+
+  CFis = &CommandTable->CommandFis;
+  if (((UINT32) (CFis->AhciCFisSecCount >> 3) != Slot) ||
+      ((ModelPort->Sact & (BIT0 << Slot)) == 0) ||
+      ((CFis->AhciCFisDevHead & BIT6) == 0) ||
+      (CmdList->AhciCmdW != ((CFis->AhciCFisCmd == ATA_CMD_WRITE_FPDMA_QUEUED) ? 1 : 0)) ||
+      ModelPort->Queued[Slot].Valid) {
+    ModelPort->BadCommands++;
+    return FALSE;
+  }
+
+  if (ModelPort->ErrorState) {
+    return FALSE;
+  }
+
+  Command = &ModelPort->Queued[Slot];
+  Command->Valid       = TRUE;
+  Command->Read        = (BOOLEAN) (CFis->AhciCFisCmd == ATA_CMD_READ_FPDMA_QUEUED);
+  Command->Lba         = CFis->AhciCFisSecNum |
+                         LShiftU64 (CFis->AhciCFisClyLow, 8) |
+                         LShiftU64 (CFis->AhciCFisClyHigh, 16) |
+                         LShiftU64 (CFis->AhciCFisSecNumExp, 24) |
+                         LShiftU64 (CFis->AhciCFisClyLowExp, 32) |
+                         LShiftU64 (CFis->AhciCFisClyHighExp, 40);
+  Command->SectorCount = CFis->AhciCFisFeature | (CFis->AhciCFisFeatureExp << 8);
+  if (Command->SectorCount == 0) {
+    Command->SectorCount = 0x10000;
+  }
+  Command->Prdt        = CommandTable->PrdtTable;
+  Command->PrdtLength  = CmdList->AhciCmdPrdtl;
+
+  if (Command->Lba + Command->SectorCount > AHCI_MODEL_DISK_SECTORS) {
+    Command->Valid = FALSE;
+    ModelPort->BadCommands++;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Fetch and process the commands of the slots newly set in PxCI.
+
+**/
+VOID
+AhciModelIssue (
+  IN AHCI_MODEL_PORT    *ModelPort,
+  IN UINT32             Slots
+  )
+{
+  EFI_AHCI_COMMAND_LIST   *CmdList;
+  EFI_AHCI_COMMAND_TABLE  *CommandTable;
+  UINT8                   Command;
+  UINT32                  Slot;
+
+  for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+    if ((Slots & (BIT0 << Slot)) == 0) {
+      continue;
+    }
+
+    CmdList      = (EFI_AHCI_COMMAND_LIST *) AhciModelAddress (ModelPort->Clb, ModelPort->Clbu) + Slot;
+    CommandTable = AhciModelAddress (CmdList->AhciCmdCtba, CmdList->AhciCmdCtbau);
+    Command      = CommandTable->CommandFis.AhciCFisCmd;
+
+    if ((Command != ATA_CMD_READ_FPDMA_QUEUED) && (Command != ATA_CMD_WRITE_FPDMA_QUEUED)) {
+      AhciModelExecute (ModelPort, CmdList, CommandTable);
+      ModelPort->Ci   &= ~(BIT0 << Slot);
+      ModelPort->Sact &= ~(BIT0 << Slot);
+      continue;
+    }
+
+    if (!AhciModelQueue (ModelPort, Slot, CmdList, CommandTable) || ModelPort->FailOnIssue) {
+      AhciModelAbort (ModelPort);
+      continue;
+    }
+
+    if (!ModelPort->HoldIssue) {
+      ModelPort->Ci &= ~(BIT0 << Slot);
+    }
+    if (ModelPort->CompleteOnIssue) {
+      AhciModelFinish (ModelPort, BIT0 << Slot);
+    }
+  }
+}
+
+/**
+  Write a port register.
+
+**/
+VOID
+AhciModelWritePort (
+  IN AHCI_MODEL_PORT    *ModelPort,
+  IN UINT32             Offset,
+  IN UINT32             Data
+  )
+{
+  UINT32    Slot;
+
+  switch (Offset) {
+  case EFI_AHCI_PORT_CLB:
+    ModelPort->Clb = Data;
+    break;
+  case EFI_AHCI_PORT_CLBU:
+    ModelPort->Clbu = Data;
+    break;
+  case EFI_AHCI_PORT_FB:
+    ModelPort->Fb = Data;
+    break;
+  case EFI_AHCI_PORT_FBU:
+    ModelPort->Fbu = Data;
+    break;
+  case EFI_AHCI_PORT_IS:
+    ModelPort->Is &= ~Data;
+    break;
+  case EFI_AHCI_PORT_IE:
+    ModelPort->Ie = Data;
+    break;
+  case EFI_AHCI_PORT_CMD:
+    if (((Data & EFI_AHCI_PORT_CMD_ST) != 0) && ((ModelPort->Cmd & EFI_AHCI_PORT_CMD_ST) == 0)) {
+      ModelPort->Starts++;
+    }
+    if ((Data & EFI_AHCI_PORT_CMD_ST) == 0) {
+      //
+      // Stopping the port drops the commands the HBA holds.
+      //
+      ModelPort->Ci   = 0;
+      ModelPort->Sact = 0;
+      for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+        ModelPort->Queued[Slot].Valid = FALSE;
+      }
+    }
+    Data &= ~(EFI_AHCI_PORT_CMD_CR | EFI_AHCI_PORT_CMD_FR | EFI_AHCI_PORT_CMD_CLO);
+    if ((Data & EFI_AHCI_PORT_CMD_ST) != 0) {
+      Data |= EFI_AHCI_PORT_CMD_CR;
+    }
+    if ((Data & EFI_AHCI_PORT_CMD_FRE) != 0) {
+      Data |= EFI_AHCI_PORT_CMD_FR;
+    }
+    ModelPort->Cmd = Data;
+    break;
+  case EFI_AHCI_PORT_SCTL:
+    if (((ModelPort->Sctl & EFI_AHCI_PORT_SCTL_DET_MASK) == EFI_AHCI_PORT_SCTL_DET_INIT) &&
+        ((Data & EFI_AHCI_PORT_SCTL_DET_MASK) == 0)) {
+      ModelPort->Resets++;
+      ModelPort->ErrorState = FALSE;
+      ModelPort->Tfd        = AHCI_MODEL_TFD_IDLE;
+      for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+        ModelPort->Queued[Slot].Valid = FALSE;
+      }
+    }
+    ModelPort->Sctl = Data;
+    break;
+  case EFI_AHCI_PORT_SERR:
+    ModelPort->Serr &= ~Data;
+    break;
+  case EFI_AHCI_PORT_SACT:
+    if ((ModelPort->Cmd & EFI_AHCI_PORT_CMD_ST) != 0) {
+      ModelPort->Sact |= Data;
+    }
+    break;
+  case EFI_AHCI_PORT_CI:
+    if ((ModelPort->Cmd & EFI_AHCI_PORT_CMD_ST) != 0) {
+      Data &= ~ModelPort->Ci;
+      ModelPort->Ci |= Data;
+      AhciModelIssue (ModelPort, Data);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+  Read a port register.
+
+**/
+UINT32
+AhciModelReadPort (
+  IN AHCI_MODEL_PORT    *ModelPort,
+  IN UINT32             Offset
+  )
+{
+  switch (Offset) {
+  case EFI_AHCI_PORT_CLB:
+    return ModelPort->Clb;
+  case EFI_AHCI_PORT_CLBU:
+    return ModelPort->Clbu;
+  case EFI_AHCI_PORT_FB:
+    return ModelPort->Fb;
+  case EFI_AHCI_PORT_FBU:
+    return ModelPort->Fbu;
+  case EFI_AHCI_PORT_IS:
+    return ModelPort->Is;
+  case EFI_AHCI_PORT_IE:
+    return ModelPort->Ie;
+  case EFI_AHCI_PORT_CMD:
+    return ModelPort->Cmd;
+  case EFI_AHCI_PORT_TFD:
+    return ModelPort->Tfd;
+  case EFI_AHCI_PORT_SIG:
+    return EFI_AHCI_ATA_DEVICE_SIG;
+  case EFI_AHCI_PORT_SSTS:
+    return EFI_AHCI_PORT_SSTS_DET_PCE;
+  case EFI_AHCI_PORT_SCTL:
+    return ModelPort->Sctl;
+  case EFI_AHCI_PORT_SERR:
+    return ModelPort->Serr;
+  case EFI_AHCI_PORT_SACT:
+    return ModelPort->Sact;
+  case EFI_AHCI_PORT_CI:
+    return ModelPort->Ci;
+  default:
+    return 0;
+  }
+}
+
+/**
+  Access a register of the HBA. Only 32-bit accesses to BAR 5 are modeled.
+
+**/
+EFI_STATUS
+AhciModelAccess (
+  IN     EFI_PCI_IO_PROTOCOL        *This,
+  IN     EFI_PCI_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT8                      BarIndex,
+  IN     UINT64                     Offset,
+  IN     UINTN                      Count,
+  IN OUT UINT32                     *Buffer,
+  IN     BOOLEAN                    Write
+  )
+{
+  AHCI_MODEL    *Model;
+  UINT32        Port;
+  UINT32        PortOffset;
+
+  ASSERT ((Width == EfiPciIoWidthUint32) && (BarIndex == EFI_AHCI_BAR_INDEX) && (Count == 1));
+
+  Model = AHCI_MODEL_FROM_PCI_IO (This);
+  if (Offset >= EFI_AHCI_PORT_START) {
+    Port       = (UINT32) (Offset - EFI_AHCI_PORT_START) / EFI_AHCI_PORT_REG_WIDTH;
+    PortOffset = (UINT32) (Offset - EFI_AHCI_PORT_START) % EFI_AHCI_PORT_REG_WIDTH;
+    ASSERT (Port < AHCI_MODEL_PORTS);
+    if (Write) {
+      AhciModelWritePort (&Model->Port[Port], PortOffset, *Buffer);
+    } else {
+      *Buffer = AhciModelReadPort (&Model->Port[Port], PortOffset);
+    }
+    return EFI_SUCCESS;
+  }
+
+  switch ((UINT32) Offset) {
+  case EFI_AHCI_CAPABILITY_OFFSET:
+    if (!Write) {
+      *Buffer = Model->Cap;
+    }
+    break;
+  case EFI_AHCI_GHC_OFFSET:
+    if (Write) {
+      Model->Ghc = *Buffer & ~EFI_AHCI_GHC_RESET;
+    } else {
+      *Buffer = Model->Ghc;
+    }
+    break;
+  case EFI_AHCI_IS_OFFSET:
+    if (Write) {
+      Model->Is &= ~*Buffer;
+    } else {
+      *Buffer = Model->Is;
+    }
+    break;
+  case EFI_AHCI_PI_OFFSET:
+    if (!Write) {
+      *Buffer = Model->Pi;
+    }
+    break;
+  default:
+    if (!Write) {
+      *Buffer = 0;
+    }
+    break;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelMemRead (
+  IN     EFI_PCI_IO_PROTOCOL        *This,
+  IN     EFI_PCI_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT8                      BarIndex,
+  IN     UINT64                     Offset,
+  IN     UINTN                      Count,
+  IN OUT VOID                       *Buffer
+  )
+{
+  return AhciModelAccess (This, Width, BarIndex, Offset, Count, Buffer, FALSE);
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelMemWrite (
+  IN     EFI_PCI_IO_PROTOCOL        *This,
+  IN     EFI_PCI_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT8                      BarIndex,
+  IN     UINT64                     Offset,
+  IN     UINTN                      Count,
+  IN OUT VOID                       *Buffer
+  )
+{
+  return AhciModelAccess (This, Width, BarIndex, Offset, Count, Buffer, TRUE);
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelMap (
+  IN     EFI_PCI_IO_PROTOCOL            *This,
+  IN     EFI_PCI_IO_PROTOCOL_OPERATION  Operation,
+  IN     VOID                           *HostAddress,
+  IN OUT UINTN                          *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS           *DeviceAddress,
+  OUT    VOID                           **Mapping
+  )
+{
+  AHCI_MODEL    *Model;
+
+  Model = AHCI_MODEL_FROM_PCI_IO (This);
+  if (HostAddress == Model->FailMapAddress) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Model->Mappings++;
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS) (UINTN) HostAddress;
+  *Mapping       = HostAddress;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelUnmap (
+  IN  EFI_PCI_IO_PROTOCOL          *This,
+  IN  VOID                         *Mapping
+  )
+{
+  AHCI_MODEL    *Model;
+
+  Model = AHCI_MODEL_FROM_PCI_IO (This);
+  ASSERT (Model->Mappings > 0);
+  Model->Mappings--;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelAllocateBuffer (
+  IN  EFI_PCI_IO_PROTOCOL          *This,
+  IN  EFI_ALLOCATE_TYPE            Type,
+  IN  EFI_MEMORY_TYPE              MemoryType,
+  IN  UINTN                        Pages,
+  OUT VOID                         **HostAddress,
+  IN  UINT64                       Attributes
+  )
+{
+  if (posix_memalign (HostAddress, EFI_PAGE_SIZE, EFI_PAGES_TO_SIZE (Pages)) != 0) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+AhciModelFreeBuffer (
+  IN  EFI_PCI_IO_PROTOCOL          *This,
+  IN  UINTN                        Pages,
+  IN  VOID                         *HostAddress
+  )
+{
+  free (HostAddress);
+  return EFI_SUCCESS;
+}
+
+/**
+  Create a model of an AHCI HBA with a disk on every port.
+
+  @param  Capability    The value of the CAP register, which selects the number
+                        of command slots and whether NCQ is supported.
+
+  @return The model.
+
+**/
+AHCI_MODEL *
+AhciModelCreate (
+  IN UINT32             Capability
+  )
+{
+  AHCI_MODEL    *Model;
+  UINT32        Port;
+  UINT32        Index;
+
+  Model = AllocateZeroPool (sizeof (AHCI_MODEL));
+  ASSERT (Model != NULL);
+
+  Model->Signature              = AHCI_MODEL_SIGNATURE;
+  Model->PciIo.Mem.Read         = AhciModelMemRead;
+  Model->PciIo.Mem.Write        = AhciModelMemWrite;
+  Model->PciIo.Map              = AhciModelMap;
+  Model->PciIo.Unmap            = AhciModelUnmap;
+  Model->PciIo.AllocateBuffer   = AhciModelAllocateBuffer;
+  Model->PciIo.FreeBuffer       = AhciModelFreeBuffer;
+  Model->Cap                    = (Capability & ~0x1F) | (AHCI_MODEL_PORTS - 1);
+  Model->Ghc                    = EFI_AHCI_GHC_ENABLE;
+  Model->Pi                     = (1 << AHCI_MODEL_PORTS) - 1;
+
+  //
+  // Every sector of a disk is filled with its own LBA, so that the tests can
+  // tell which sectors a read transferred.
+  //
+  for (Port = 0; Port < AHCI_MODEL_PORTS; Port++) {
+    Model->Port[Port].Tfd  = AHCI_MODEL_TFD_IDLE;
+    Model->Port[Port].Disk = AllocatePool (AHCI_MODEL_DISK_SECTORS * AHCI_MODEL_SECTOR_SIZE);
+    ASSERT (Model->Port[Port].Disk != NULL);
+    for (Index = 0; Index < AHCI_MODEL_DISK_SECTORS * AHCI_MODEL_SECTOR_SIZE / sizeof (UINT32); Index++) {
+      ((UINT32 *) Model->Port[Port].Disk)[Index] = Index * sizeof (UINT32) / AHCI_MODEL_SECTOR_SIZE;
+    }
+  }
+
+  return Model;
+}
+
+/**
+  Free a model created by AhciModelCreate().
+
+  @param  Model         The model.
+
+**/
+VOID
+AhciModelDestroy (
+  IN AHCI_MODEL         *Model
+  )
+{
+  UINT32    Port;
+
+  for (Port = 0; Port < AHCI_MODEL_PORTS; Port++) {
+    FreePool (Model->Port[Port].Disk);
+  }
+  FreePool (Model);
+}
+
+/**
+  Let the device finish queued commands: their data is transferred and their
+  bits are cleared in PxSACT, in any order the caller chooses.
+
+  @param  Model         The model.
+  @param  Port          The port.
+  @param  Slots         The bit map of the slots whose command completes.
+
+**/
+VOID
+AhciModelCompleteQueued (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port,
+  IN UINT32             Slots
+  )
+{
+  AhciModelFinish (&Model->Port[Port], Slots);
+}
+
+/**
+  Let a queued command fail. The device aborts all its queued commands, and
+  the HBA reports a task file error.
+
+  @param  Model         The model.
+  @param  Port          The port.
+
+**/
+VOID
+AhciModelFailQueued (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port
+  )
+{
+  AhciModelAbort (&Model->Port[Port]);
+}
+
+/**
+  Get the slots of the queued commands the device holds.
+
+  @param  Model         The model.
+  @param  Port          The port.
+
+  @return The bit map of the slots.
+
+**/
+UINT32
+AhciModelQueuedSlots (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port
+  )
+{
+  UINT32    Slots;
+  UINT32    Slot;
+
+  Slots = 0;
+  for (Slot = 0; Slot < AHCI_MODEL_SLOTS; Slot++) {
+    if (Model->Port[Port].Queued[Slot].Valid) {
+      Slots |= BIT0 << Slot;
+    }
+  }
+  return Slots;
+}
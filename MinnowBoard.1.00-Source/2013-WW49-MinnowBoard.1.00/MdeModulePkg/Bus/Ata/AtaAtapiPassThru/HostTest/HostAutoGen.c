@@ -0,0 +1,33 @@
+/** @file
+  Stands in for the AutoGen.c that the EDK II build generates for a module:
+  the GUID globals of AtaAtapiPassThru and the libraries it uses.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostTest.h"
+
+#include <Protocol/DriverConfiguration.h>
+#include <Protocol/DriverConfiguration2.h>
+#include <Guid/GlobalVariable.h>
+
+GUID      gEfiCallerIdGuid   = { 0x5e523cb4, 0xd397, 0x4986, { 0x87, 0xbd, 0xa6, 0xdd, 0x8b, 0x22, 0xf4, 0x55 }};
+CHAR8     *gEfiCallerBaseName = "HostTest";
+
+EFI_GUID  gEfiDriverBindingProtocolGuid           = EFI_DRIVER_BINDING_PROTOCOL_GUID;
+EFI_GUID  gEfiDriverConfigurationProtocolGuid     = EFI_DRIVER_CONFIGURATION_PROTOCOL_GUID;
+EFI_GUID  gEfiDriverConfiguration2ProtocolGuid    = EFI_DRIVER_CONFIGURATION2_PROTOCOL_GUID;
+EFI_GUID  gEfiAtaPassThruProtocolGuid             = EFI_ATA_PASS_THRU_PROTOCOL_GUID;
+EFI_GUID  gEfiExtScsiPassThruProtocolGuid         = EFI_EXT_SCSI_PASS_THRU_PROTOCOL_GUID;
+EFI_GUID  gEfiIdeControllerInitProtocolGuid       = EFI_IDE_CONTROLLER_INIT_PROTOCOL_GUID;
+EFI_GUID  gEfiPciIoProtocolGuid                   = EFI_PCI_IO_PROTOCOL_GUID;
+EFI_GUID  gEfiDevicePathProtocolGuid              = EFI_DEVICE_PATH_PROTOCOL_GUID;
+EFI_GUID  gEfiGlobalVariableGuid                  = EFI_GLOBAL_VARIABLE;
@@ -0,0 +1,45 @@
+/** @file
+  Stands in for the AutoGen.h that the EDK II build generates for a module,
+  so that AtaAtapiPassThru and the libraries it uses build as one host program.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_AUTOGEN_H_
+#define _HOST_AUTOGEN_H_
+
+#include <Base.h>
+#include <Uefi.h>
+#include <Library/PcdLib.h>
+
+extern GUID  gEfiCallerIdGuid;
+extern CHAR8 *gEfiCallerBaseName;
+
+//
+// PCDs used by AtaAtapiPassThru and the MdePkg libraries built in
+//
+#define _PCD_GET_MODE_BOOL_PcdAtaSmartEnable                  FALSE
+#define _PCD_GET_MODE_BOOL_PcdAtaNcqEnable                    TRUE
+#define _PCD_GET_MODE_32_PcdMaximumAsciiStringLength          1000000U
+#define _PCD_GET_MODE_32_PcdMaximumUnicodeStringLength        1000000U
+#define _PCD_GET_MODE_32_PcdMaximumLinkedListLength           1000000U
+#define _PCD_GET_MODE_BOOL_PcdVerifyNodeInList                FALSE
+#define _PCD_GET_MODE_32_PcdMaximumDevicePathNodeCount        0
+#define _PCD_GET_MODE_PTR_PcdUefiVariableDefaultLang          ((VOID *) "eng")
+#define _PCD_GET_MODE_PTR_PcdUefiVariableDefaultPlatformLang  ((VOID *) "en-US")
+#define _PCD_GET_MODE_32_PcdUefiLibMaxPrintBufferSize         320
+#define _PCD_GET_MODE_BOOL_PcdUgaConsumeSupport               FALSE
+#define _PCD_GET_MODE_BOOL_PcdComponentNameDisable            TRUE
+#define _PCD_GET_MODE_BOOL_PcdComponentName2Disable           TRUE
+#define _PCD_GET_MODE_BOOL_PcdDriverDiagnosticsDisable        TRUE
+#define _PCD_GET_MODE_BOOL_PcdDriverDiagnostics2Disable       TRUE
+
+#endif
@@ -0,0 +1,769 @@
+/** @file
+  Host tests of native command queuing in AtaAtapiPassThru.
+
+  The tests drive the queued (FPDMA) command paths of the driver against the
+  AHCI model of AhciModel.c, which lets them decide when and in which order
+  the device completes queued commands, or fails them. They check the slots
+  the driver keeps in NcqActiveSlots, the completed slots it derives from
+  PxSACT and PxCI, the data transferred, and the recovery from a failed or
+  timed out queued command: the outstanding tasks are aborted, the NCQ
+  command error log is read, or the port reset when that fails too, and no
+  mapping is left behind.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostTest.h"
+
+#include <stdio.h>
+
+#define TEST_CAPABILITY           (EFI_AHCI_CAP_S64A | EFI_AHCI_CAP_SNCQ | (31 << 8))
+#define TEST_SECTORS              8
+#define TEST_TRANSFER_SIZE        (TEST_SECTORS * AHCI_MODEL_SECTOR_SIZE)
+#define TEST_WRITE_LBA            0x400
+#define TEST_MAX_REQUESTS         12
+#define TEST_MAX_ROUNDS           100
+#define TEST_RANDOM_SEED          0x2545F491
+
+typedef struct {
+  EFI_ATA_PASS_THRU_COMMAND_PACKET  Packet;
+  EFI_ATA_COMMAND_BLOCK             Acb;
+  EFI_ATA_STATUS_BLOCK              Asb;
+  HOST_EVENT                        Event;
+  BOOLEAN                           Read;
+  UINT64                            Lba;
+  UINT8                             Buffer[TEST_TRANSFER_SIZE];
+} TEST_REQUEST;
+
+typedef struct {
+  AHCI_MODEL                        *Model;
+  AHCI_MODEL_PORT                   *ModelPort;
+  ATA_ATAPI_PASS_THRU_INSTANCE      *Instance;
+  EFI_PCI_IO_PROTOCOL               *PciIo;
+  EFI_AHCI_REGISTERS                *AhciRegisters;
+  UINTN                             Mappings;     ///< Mappings held by the driver itself
+  TEST_REQUEST                      Requests[TEST_MAX_REQUESTS];
+} TEST_CONTEXT;
+
+typedef
+BOOLEAN
+(*TEST_FUNCTION) (
+  IN OUT TEST_CONTEXT     *Context
+  );
+
+//
+// A test runs against a disk on port 0 with the queue depth given, or sets up
+// its own instances when that is 0.
+//
+typedef struct {
+  CONST CHAR8             *Name;
+  TEST_FUNCTION           Function;
+  UINT8                   QueueDepth;
+} TEST;
+
+UINT64  mTestRandom = TEST_RANDOM_SEED;
+
+#define TEST_CHECK(Condition) \
+  do { \
+    if (!(Condition)) { \
+      fprintf (stderr, "check failed at line %u: %s\n", (unsigned) __LINE__, #Condition); \
+      return FALSE; \
+    } \
+  } while (FALSE)
+
+/**
+  Return the next number of a fixed pseudo random sequence.
+
+**/
+UINT64
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom ^= mTestRandom << 13;
+  mTestRandom ^= mTestRandom >> 7;
+  mTestRandom ^= mTestRandom << 17;
+  return mTestRandom;
+}
+
+/**
+  Create the model and a driver instance set up the way AhciModeInitialization()
+  leaves it, with a hard disk on port 0.
+
+  @param  Context       The test context.
+  @param  Capability    The CAP register of the HBA.
+  @param  QueueDepth    The NCQ queue depth the disk reports, 0 if the disk does
+                        not support NCQ.
+
+**/
+VOID
+TestSetUp (
+  OUT TEST_CONTEXT        *Context,
+  IN  UINT32              Capability,
+  IN  UINT8               QueueDepth
+  )
+{
+  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance;
+  EFI_IDENTIFY_DATA             Identify;
+  DATA_64                       Data64;
+  UINT8                         Port;
+  UINT32                        Offset;
+
+  ZeroMem (Context, sizeof (TEST_CONTEXT));
+  Context->Model     = AhciModelCreate (Capability);
+  Context->ModelPort = &Context->Model->Port[0];
+  Context->PciIo     = &Context->Model->PciIo;
+
+  Instance = AllocateZeroPool (sizeof (ATA_ATAPI_PASS_THRU_INSTANCE));
+  ASSERT (Instance != NULL);
+  Instance->Signature = ATA_ATAPI_PASS_THRU_SIGNATURE;
+  Instance->Mode      = EfiAtaAhciMode;
+  Instance->PciIo     = Context->PciIo;
+  InitializeListHead (&Instance->DeviceList);
+  InitializeListHead (&Instance->NonBlockingTaskList);
+  Context->Instance      = Instance;
+  Context->AhciRegisters = &Instance->AhciRegisters;
+
+  AhciCreateTransferDescriptor (Context->PciIo, Context->AhciRegisters);
+  AhciCreateNcqTransferDescriptor (Context->PciIo, Context->AhciRegisters);
+
+  for (Port = 0; Port < AHCI_MODEL_PORTS; Port++) {
+    Data64.Uint64 = (UINTN) (Context->AhciRegisters->AhciRFisPciAddr) + sizeof (EFI_AHCI_RECEIVED_FIS) * Port;
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_FB;
+    AhciWriteReg (Context->PciIo, Offset, Data64.Uint32.Lower32);
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_FBU;
+    AhciWriteReg (Context->PciIo, Offset, Data64.Uint32.Upper32);
+
+    Data64.Uint64 = (UINTN) (Context->AhciRegisters->AhciCmdListPciAddr);
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
+    AhciWriteReg (Context->PciIo, Offset, Data64.Uint32.Lower32);
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
+    AhciWriteReg (Context->PciIo, Offset, Data64.Uint32.Upper32);
+  }
+
+  //
+  // Word 76 bit 8 is the NCQ support, word 75 the queue depth minus 1.
+  //
+  ZeroMem (&Identify, sizeof (Identify));
+  if (QueueDepth != 0) {
+    Identify.AtaData.reserved_76_79[0] = BIT8;
+    Identify.AtaData.queue_depth       = (UINT16) (QueueDepth - 1);
+  }
+  CreateNewDeviceInfo (Instance, 0, 0, EfiIdeHarddisk, &Identify);
+
+  Context->Mappings = Context->Model->Mappings;
+}
+
+/**
+  Free what TestSetUp() created.
+
+**/
+VOID
+TestTearDown (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_AHCI_REGISTERS    *AhciRegisters;
+
+  AhciRegisters = Context->AhciRegisters;
+  DestroyAsynTaskList (Context->Instance, FALSE);
+  DestroyDeviceInfoList (Context->Instance);
+
+  Context->PciIo->FreeBuffer (Context->PciIo, 0, AhciRegisters->AhciRFis);
+  Context->PciIo->FreeBuffer (Context->PciIo, 0, AhciRegisters->AhciCmdList);
+  Context->PciIo->FreeBuffer (Context->PciIo, 0, AhciRegisters->AhciCommandTable);
+  if (AhciRegisters->AhciNcqCommandTable != NULL) {
+    Context->PciIo->FreeBuffer (Context->PciIo, 0, AhciRegisters->AhciNcqCommandTable);
+  }
+
+  FreePool (Context->Instance);
+  AhciModelDestroy (Context->Model);
+}
+
+/**
+  Build a READ or WRITE FPDMA QUEUED request. The buffer of a write is filled
+  with a pattern that differs for every request.
+
+**/
+TEST_REQUEST *
+TestBuildRequest (
+  IN OUT TEST_CONTEXT     *Context,
+  IN     UINTN            Index,
+  IN     BOOLEAN          Read,
+  IN     UINT64           Lba,
+  IN     UINT64           Timeout
+  )
+{
+  TEST_REQUEST            *Request;
+
+  Request = &Context->Requests[Index];
+  ZeroMem (Request, sizeof (TEST_REQUEST));
+  Request->Read = Read;
+  Request->Lba  = Lba;
+
+  Request->Acb.AtaCommand         = Read ? ATA_CMD_READ_FPDMA_QUEUED : ATA_CMD_WRITE_FPDMA_QUEUED;
+  Request->Acb.AtaSectorNumber    = (UINT8) Lba;
+  Request->Acb.AtaCylinderLow     = (UINT8) RShiftU64 (Lba, 8);
+  Request->Acb.AtaCylinderHigh    = (UINT8) RShiftU64 (Lba, 16);
+  Request->Acb.AtaSectorNumberExp = (UINT8) RShiftU64 (Lba, 24);
+  Request->Acb.AtaCylinderLowExp  = (UINT8) RShiftU64 (Lba, 32);
+  Request->Acb.AtaCylinderHighExp = (UINT8) RShiftU64 (Lba, 40);
+  Request->Acb.AtaDeviceHead      = BIT6;
+  Request->Acb.AtaFeatures        = TEST_SECTORS;
+  Request->Acb.AtaFeaturesExp     = 0;
+
+  Request->Packet.Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  Request->Packet.Acb      = &Request->Acb;
+  Request->Packet.Asb      = &Request->Asb;
+  Request->Packet.Timeout  = Timeout;
+  if (Read) {
+    Request->Packet.InDataBuffer     = Request->Buffer;
+    Request->Packet.InTransferLength = TEST_TRANSFER_SIZE;
+  } else {
+    SetMem (Request->Buffer, TEST_TRANSFER_SIZE, (UINT8) (0xA0 + Index));
+    Request->Packet.OutDataBuffer     = Request->Buffer;
+    Request->Packet.OutTransferLength = TEST_TRANSFER_SIZE;
+  }
+
+  return Request;
+}
+
+/**
+  Add a request to the non-blocking task list of port 0, as
+  AtaPassThruPassThru() does for a request with an event.
+
+**/
+VOID
+TestQueueTask (
+  IN OUT TEST_CONTEXT     *Context,
+  IN     TEST_REQUEST     *Request
+  )
+{
+  ATA_NONBLOCK_TASK       *Task;
+
+  Task = AllocateZeroPool (sizeof (ATA_NONBLOCK_TASK));
+  ASSERT (Task != NULL);
+  Task->Signature = ATA_NONBLOCKING_TASK_SIGNATURE;
+  Task->Port      = 0;
+  Task->Packet    = &Request->Packet;
+  Task->Event     = (EFI_EVENT) &Request->Event;
+  InsertTailList (&Context->Instance->NonBlockingTaskList, &Task->Link);
+}
+
+/**
+  Check that a request transferred its data: a read returns the sectors of the
+  disk, which hold their own LBA, a write leaves its pattern on the disk.
+
+**/
+BOOLEAN
+TestCheckData (
+  IN TEST_CONTEXT         *Context,
+  IN TEST_REQUEST         *Request
+  )
+{
+  UINT32                  Index;
+  UINT8                   *Disk;
+
+  Disk = Context->ModelPort->Disk + Request->Lba * AHCI_MODEL_SECTOR_SIZE;
+  if (!Request->Read) {
+    return (BOOLEAN) (CompareMem (Disk, Request->Buffer, TEST_TRANSFER_SIZE) == 0);
+  }
+
+  for (Index = 0; Index < TEST_TRANSFER_SIZE / sizeof (UINT32); Index++) {
+    if (((UINT32 *) Request->Buffer)[Index] != Request->Lba + Index * sizeof (UINT32) / AHCI_MODEL_SECTOR_SIZE) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Check the state the driver and the port are left in once no queued command
+  is outstanding any more.
+
+**/
+BOOLEAN
+TestCheckIdle (
+  IN TEST_CONTEXT         *Context
+  )
+{
+  TEST_CHECK (IsListEmpty (&Context->Instance->NonBlockingTaskList));
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0);
+  TEST_CHECK ((Context->ModelPort->Cmd & EFI_AHCI_PORT_CMD_ST) == 0);
+  TEST_CHECK (AhciModelQueuedSlots (Context->Model, 0) == 0);
+  TEST_CHECK (Context->Model->Mappings == Context->Mappings);
+  TEST_CHECK (Context->ModelPort->BadCommands == 0);
+  return TRUE;
+}
+
+/**
+  The queued commands use the slots below both the number of command slots of
+  the HBA and the queue depth of the device, and none when either of them
+  does not support NCQ.
+
+**/
+BOOLEAN
+TestSlotLimit (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  UINT8                   Limit;
+
+  TestSetUp (Context, TEST_CAPABILITY, 32);
+  Limit = AhciNcqSlotLimit (Context->Instance, 0, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 32);
+
+  TestSetUp (Context, TEST_CAPABILITY, 8);
+  Limit = AhciNcqSlotLimit (Context->Instance, 0, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 8);
+
+  TestSetUp (Context, EFI_AHCI_CAP_S64A | EFI_AHCI_CAP_SNCQ | (7 << 8), 32);
+  Limit = AhciNcqSlotLimit (Context->Instance, 0, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 8);
+
+  TestSetUp (Context, TEST_CAPABILITY, 0);
+  Limit = AhciNcqSlotLimit (Context->Instance, 0, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 0);
+
+  TestSetUp (Context, EFI_AHCI_CAP_S64A | (31 << 8), 32);
+  Limit = AhciNcqSlotLimit (Context->Instance, 0, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 0);
+
+  TestSetUp (Context, TEST_CAPABILITY, 32);
+  Limit = AhciNcqSlotLimit (Context->Instance, 1, 0);
+  TestTearDown (Context);
+  TEST_CHECK (Limit == 0);
+
+  return TRUE;
+}
+
+/**
+  Queued commands are added to the outstanding ones without restarting the
+  port, and are reported complete in the order the device finishes them, only
+  once their slot is clear in both PxSACT and PxCI.
+
+**/
+BOOLEAN
+TestStartCheck (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  TEST_REQUEST            *Request;
+  VOID                    *Map[5];
+  UINT32                  Completed;
+  UINT8                   Slot;
+
+  for (Slot = 1; Slot <= 3; Slot++) {
+    Request = TestBuildRequest (Context, Slot, TRUE, 0x10 * Slot, ATA_ATAPI_TIMEOUT);
+    TEST_CHECK (!EFI_ERROR (AhciNcqStartCommand (
+                              Context->PciIo,
+                              Context->AhciRegisters,
+                              0,
+                              0,
+                              Slot,
+                              TRUE,
+                              &Request->Acb,
+                              Request->Buffer,
+                              TEST_TRANSFER_SIZE,
+                              ATA_ATAPI_TIMEOUT,
+                              &Map[Slot]
+                              )));
+  }
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == (BIT1 | BIT2 | BIT3));
+  TEST_CHECK (AhciModelQueuedSlots (Context->Model, 0) == (BIT1 | BIT2 | BIT3));
+  TEST_CHECK (Context->ModelPort->Starts == 1);
+  TEST_CHECK (Context->ModelPort->BadCommands == 0);
+
+  TEST_CHECK (!EFI_ERROR (AhciNcqCheckCommands (Context->PciIo, Context->AhciRegisters, 0, &Completed)));
+  TEST_CHECK (Completed == 0);
+
+  AhciModelCompleteQueued (Context->Model, 0, BIT2);
+  TEST_CHECK (!EFI_ERROR (AhciNcqCheckCommands (Context->PciIo, Context->AhciRegisters, 0, &Completed)));
+  TEST_CHECK (Completed == BIT2);
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == (BIT1 | BIT3));
+  TEST_CHECK (TestCheckData (Context, &Context->Requests[2]));
+
+  AhciModelCompleteQueued (Context->Model, 0, BIT1 | BIT3);
+  TEST_CHECK (!EFI_ERROR (AhciNcqCheckCommands (Context->PciIo, Context->AhciRegisters, 0, &Completed)));
+  TEST_CHECK (Completed == (BIT1 | BIT3));
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0);
+  TEST_CHECK (TestCheckData (Context, &Context->Requests[1]));
+  TEST_CHECK (TestCheckData (Context, &Context->Requests[3]));
+
+  //
+  // A command the HBA has not fetched yet is outstanding, even when its slot
+  // is clear in PxSACT.
+  //
+  Context->ModelPort->HoldIssue = TRUE;
+  Request = TestBuildRequest (Context, 4, TRUE, 0x40, ATA_ATAPI_TIMEOUT);
+  TEST_CHECK (!EFI_ERROR (AhciNcqStartCommand (
+                            Context->PciIo,
+                            Context->AhciRegisters,
+                            0,
+                            0,
+                            4,
+                            TRUE,
+                            &Request->Acb,
+                            Request->Buffer,
+                            TEST_TRANSFER_SIZE,
+                            ATA_ATAPI_TIMEOUT,
+                            &Map[4]
+                            )));
+  Context->ModelPort->Sact &= ~BIT4;
+  TEST_CHECK (!EFI_ERROR (AhciNcqCheckCommands (Context->PciIo, Context->AhciRegisters, 0, &Completed)));
+  TEST_CHECK (Completed == 0);
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == BIT4);
+
+  Context->ModelPort->Sact |= BIT4;
+  AhciModelCompleteQueued (Context->Model, 0, BIT4);
+  TEST_CHECK (!EFI_ERROR (AhciNcqCheckCommands (Context->PciIo, Context->AhciRegisters, 0, &Completed)));
+  TEST_CHECK (Completed == BIT4);
+  TEST_CHECK (TestCheckData (Context, Request));
+
+  for (Slot = 1; Slot <= 4; Slot++) {
+    Context->PciIo->Unmap (Context->PciIo, Map[Slot]);
+  }
+  AhciNcqStopCommands (Context->PciIo, Context->AhciRegisters, 0, 0, FALSE, ATA_ATAPI_TIMEOUT);
+  TEST_CHECK (Context->ModelPort->ReadLogs == 0);
+  TEST_CHECK (Context->ModelPort->Resets == 0);
+  return TestCheckIdle (Context);
+}
+
+/**
+  Queue TEST_MAX_REQUESTS tasks, reads and writes in turn, and issue them.
+
+**/
+VOID
+TestQueueRequests (
+  IN OUT TEST_CONTEXT     *Context,
+  IN     UINTN            Count,
+  IN     UINT64           Timeout
+  )
+{
+  UINTN                   Index;
+  BOOLEAN                 Read;
+
+  for (Index = 0; Index < Count; Index++) {
+    Read = (BOOLEAN) ((Index & 1) == 0);
+    TestQueueTask (
+      Context,
+      TestBuildRequest (Context, Index, Read, (Read ? 0 : TEST_WRITE_LBA) + Index * TEST_SECTORS, Timeout)
+      );
+  }
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+}
+
+/**
+  The non-blocking tasks keep every slot the device allows busy, the completed
+  ones are reaped in whatever order the device finishes them and their slots
+  refilled, and the port is stopped once the list is empty.
+
+**/
+BOOLEAN
+TestAsyncTransfer (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  TEST_REQUEST            *Request;
+  UINT32                  Queued;
+  UINT32                  Slots;
+  UINTN                   Round;
+  UINTN                   Index;
+
+  TestQueueRequests (Context, TEST_MAX_REQUESTS, ATA_ATAPI_TIMEOUT);
+
+  //
+  // The disk reports a queue depth of 8, so slots 1 to 7 are used.
+  //
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0xFE);
+  TEST_CHECK (AhciModelQueuedSlots (Context->Model, 0) == 0xFE);
+
+  for (Round = 0; Round < TEST_MAX_ROUNDS; Round++) {
+    if (IsListEmpty (&Context->Instance->NonBlockingTaskList)) {
+      break;
+    }
+
+    Queued = AhciModelQueuedSlots (Context->Model, 0);
+    TEST_CHECK (Queued == Context->AhciRegisters->NcqActiveSlots);
+    Slots = Queued & (UINT32) TestRandom ();
+    if (Slots == 0) {
+      Slots = Queued & (UINT32) -(INT32) Queued;
+    }
+    AhciModelCompleteQueued (Context->Model, 0, Slots);
+    AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+  }
+
+  for (Index = 0; Index < TEST_MAX_REQUESTS; Index++) {
+    Request = &Context->Requests[Index];
+    TEST_CHECK (Request->Event.SignalCount == 1);
+    TEST_CHECK ((Request->Asb.AtaStatus & BIT0) == 0);
+    TEST_CHECK (TestCheckData (Context, Request));
+  }
+  TEST_CHECK (Context->ModelPort->Starts == 1);
+  TEST_CHECK (Context->ModelPort->ReadLogs == 0);
+  return TestCheckIdle (Context);
+}
+
+/**
+  Check that a failed queued task aborts the outstanding ones: the tasks
+  completed before the failure succeed, all the others are signaled with an
+  error status.
+
+**/
+BOOLEAN
+TestCheckAborted (
+  IN TEST_CONTEXT         *Context,
+  IN UINTN                Count,
+  IN UINTN                Succeeded
+  )
+{
+  TEST_REQUEST            *Request;
+  UINTN                   Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Request = &Context->Requests[Index];
+    TEST_CHECK (Request->Event.SignalCount == 1);
+    if (Index < Succeeded) {
+      TEST_CHECK ((Request->Asb.AtaStatus & BIT0) == 0);
+      TEST_CHECK (TestCheckData (Context, Request));
+    } else {
+      TEST_CHECK (Request->Asb.AtaStatus == 0x01);
+    }
+  }
+  return TestCheckIdle (Context);
+}
+
+/**
+  After a queued command fails, the driver reads the NCQ command error log,
+  which lets the device accept commands again.
+
+**/
+BOOLEAN
+TestAsyncError (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  TestQueueRequests (Context, 6, ATA_ATAPI_TIMEOUT);
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0x7E);
+
+  AhciModelCompleteQueued (Context->Model, 0, BIT1 | BIT2);
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0x78);
+
+  AhciModelFailQueued (Context->Model, 0);
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+
+  TEST_CHECK (Context->ModelPort->ReadLogs == 1);
+  TEST_CHECK (Context->ModelPort->Resets == 0);
+  TEST_CHECK (!Context->ModelPort->ErrorState);
+  return TestCheckAborted (Context, 6, 2);
+}
+
+/**
+  When the NCQ command error log can not be read either, the port is reset.
+
+**/
+BOOLEAN
+TestAsyncErrorReset (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  Context->ModelPort->FailReadLog = TRUE;
+  TestQueueRequests (Context, 4, ATA_ATAPI_TIMEOUT);
+
+  AhciModelCompleteQueued (Context->Model, 0, BIT1);
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+  AhciModelFailQueued (Context->Model, 0);
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+
+  TEST_CHECK (Context->ModelPort->ReadLogs == 0);
+  TEST_CHECK (Context->ModelPort->Resets == 1);
+  TEST_CHECK (!Context->ModelPort->ErrorState);
+  return TestCheckAborted (Context, 4, 1);
+}
+
+/**
+  A queued task the device never completes times out after the number of
+  polls its timeout allows, and is recovered from like a failed one.
+
+**/
+BOOLEAN
+TestAsyncTimeout (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  UINTN                   Round;
+
+  //
+  // A timeout of 2ms allows 21 polls.
+  //
+  TestQueueRequests (Context, 3, 20000);
+  for (Round = 1; Round < 21; Round++) {
+    AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+    TEST_CHECK (!IsListEmpty (&Context->Instance->NonBlockingTaskList));
+  }
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+
+  TEST_CHECK (Context->ModelPort->ReadLogs == 1);
+  TEST_CHECK (Context->ModelPort->Resets == 0);
+  return TestCheckAborted (Context, 3, 0);
+}
+
+/**
+  A task whose buffer can not be mapped never reaches the device, so it fails
+  on its own: the tasks outstanding on the device go on, and no error recovery
+  is done.
+
+**/
+BOOLEAN
+TestAsyncMapFailure (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  TEST_REQUEST            *Request;
+  UINTN                   Index;
+
+  Context->Model->FailMapAddress = Context->Requests[2].Buffer;
+  TestQueueRequests (Context, 6, ATA_ATAPI_TIMEOUT);
+
+  TEST_CHECK (Context->Requests[2].Event.SignalCount == 1);
+  TEST_CHECK (Context->Requests[2].Asb.AtaStatus == 0x01);
+  TEST_CHECK (Context->AhciRegisters->NcqActiveSlots == 0x3E);
+  TEST_CHECK (AhciModelQueuedSlots (Context->Model, 0) == 0x3E);
+
+  AhciModelCompleteQueued (Context->Model, 0, 0x3E);
+  AsyncNonBlockingTransferRoutine (NULL, Context->Instance);
+
+  for (Index = 0; Index < 6; Index++) {
+    if (Index == 2) {
+      continue;
+    }
+    Request = &Context->Requests[Index];
+    TEST_CHECK (Request->Event.SignalCount == 1);
+    TEST_CHECK ((Request->Asb.AtaStatus & BIT0) == 0);
+    TEST_CHECK (TestCheckData (Context, Request));
+  }
+  TEST_CHECK (Context->ModelPort->Starts == 1);
+  TEST_CHECK (Context->ModelPort->ReadLogs == 0);
+  TEST_CHECK (Context->ModelPort->Resets == 0);
+  return TestCheckIdle (Context);
+}
+
+/**
+  A blocking queued transfer returns once its command completes, and reports
+  a failed command with the status of the device.
+
+**/
+BOOLEAN
+TestBlockingTransfer (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  TEST_REQUEST            *Request;
+  EFI_STATUS              Status;
+  UINTN                   Index;
+
+  Context->ModelPort->CompleteOnIssue = TRUE;
+  for (Index = 0; Index < 2; Index++) {
+    Request = TestBuildRequest (Context, Index, (BOOLEAN) (Index == 0), TEST_WRITE_LBA * Index + 0x20, ATA_ATAPI_TIMEOUT);
+    Status = AhciNcqTransfer (
+               Context->Instance,
+               Context->AhciRegisters,
+               0,
+               0,
+               Request->Read,
+               &Request->Acb,
+               &Request->Asb,
+               Request->Buffer,
+               TEST_TRANSFER_SIZE,
+               ATA_ATAPI_TIMEOUT
+               );
+    TEST_CHECK (Status == EFI_SUCCESS);
+    TEST_CHECK ((Request->Asb.AtaStatus & BIT0) == 0);
+    TEST_CHECK (TestCheckData (Context, Request));
+    TEST_CHECK (TestCheckIdle (Context));
+  }
+  TEST_CHECK (Context->ModelPort->ReadLogs == 0);
+
+  Context->ModelPort->CompleteOnIssue = FALSE;
+  Context->ModelPort->FailOnIssue     = TRUE;
+  Request = TestBuildRequest (Context, 2, TRUE, 0x30, ATA_ATAPI_TIMEOUT);
+  Status = AhciNcqTransfer (
+             Context->Instance,
+             Context->AhciRegisters,
+             0,
+             0,
+             TRUE,
+             &Request->Acb,
+             &Request->Asb,
+             Request->Buffer,
+             TEST_TRANSFER_SIZE,
+             ATA_ATAPI_TIMEOUT
+             );
+  TEST_CHECK (Status == EFI_DEVICE_ERROR);
+  TEST_CHECK ((Request->Asb.AtaStatus & BIT0) != 0);
+  TEST_CHECK (Request->Asb.AtaError == (UINT8) (AHCI_MODEL_TFD_ERROR >> 8));
+  TEST_CHECK (Context->ModelPort->ReadLogs == 1);
+  return TestCheckIdle (Context);
+}
+
+TEST mTests[] = {
+  { "slot limit",         TestSlotLimit,         0 },
+  { "start and check",    TestStartCheck,       32 },
+  { "async transfer",     TestAsyncTransfer,     8 },
+  { "async error",        TestAsyncError,       32 },
+  { "async error reset",  TestAsyncErrorReset,  32 },
+  { "async timeout",      TestAsyncTimeout,     32 },
+  { "async map failure",  TestAsyncMapFailure,  32 },
+  { "blocking transfer",  TestBlockingTransfer, 32 }
+};
+
+int
+main (
+  int     Argc,
+  char    **Argv
+  )
+{
+  TEST_CONTEXT            *Context;
+  UINTN                   Index;
+  UINTN                   Failed;
+  BOOLEAN                 Passed;
+
+  HostInitializeServices ();
+
+  Context = AllocatePool (sizeof (TEST_CONTEXT));
+  ASSERT (Context != NULL);
+
+  Failed = 0;
+  for (Index = 0; Index < sizeof (mTests) / sizeof (mTests[0]); Index++) {
+    if (mTests[Index].QueueDepth == 0) {
+      Passed = mTests[Index].Function (Context);
+    } else {
+      TestSetUp (Context, TEST_CAPABILITY, mTests[Index].QueueDepth);
+      Passed = mTests[Index].Function (Context);
+      TestTearDown (Context);
+    }
+
+    printf ("%-24s %s\n", mTests[Index].Name, Passed ? "passed" : "FAILED");
+    if (!Passed) {
+      Failed++;
+    }
+  }
+
+  FreePool (Context);
+  printf ("%u of %u tests failed\n", (unsigned) Failed, (unsigned) (sizeof (mTests) / sizeof (mTests[0])));
+  return (Failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+/** @file
+  Declarations shared by the host tests of native command queuing in
+  AtaAtapiPassThru, the software model of an AHCI HBA and the host services.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include "AtaAtapiPassThru.h"
+#include "HostSupport.h"
+
+#define AHCI_MODEL_PORTS            2
+#define AHCI_MODEL_SLOTS            32
+#define AHCI_MODEL_SECTOR_SIZE      512
+#define AHCI_MODEL_DISK_SECTORS     0x800
+
+//
+// The status the model reports in PxTFD when the device is idle, and after
+// a failed command, with ABRT in the error register.
+//
+#define AHCI_MODEL_TFD_IDLE         0x0050
+#define AHCI_MODEL_TFD_ERROR        0x0451
+
+//
+// A queued command the device has accepted and not completed yet.
+//
+typedef struct {
+  BOOLEAN                   Valid;
+  BOOLEAN                   Read;
+  UINT64                    Lba;
+  UINT32                    SectorCount;
+  EFI_AHCI_COMMAND_PRDT     *Prdt;
+  UINT32                    PrdtLength;
+} AHCI_MODEL_COMMAND;
+
+typedef struct {
+  UINT32                    Clb;
+  UINT32                    Clbu;
+  UINT32                    Fb;
+  UINT32                    Fbu;
+  UINT32                    Is;
+  UINT32                    Ie;
+  UINT32                    Cmd;
+  UINT32                    Tfd;
+  UINT32                    Sctl;
+  UINT32                    Serr;
+  UINT32                    Sact;
+  UINT32                    Ci;
+  //
+  // Device state. After a failed queued command the device rejects every
+  // command but READ LOG EXT of the NCQ command error log, until that log is
+  // read or the port is reset.
+  //
+  BOOLEAN                   ErrorState;
+  AHCI_MODEL_COMMAND        Queued[AHCI_MODEL_SLOTS];
+  UINT8                     *Disk;
+  //
+  // Behavior selected by the tests
+  //
+  BOOLEAN                   HoldIssue;        ///< Leave PxCI set for accepted queued commands
+  BOOLEAN                   CompleteOnIssue;  ///< Complete queued commands as soon as they are accepted
+  BOOLEAN                   FailOnIssue;      ///< Fail queued commands as soon as they are accepted
+  BOOLEAN                   FailReadLog;      ///< Fail READ LOG EXT as well
+  //
+  // What the driver did to the port
+  //
+  UINTN                     Starts;           ///< Times PxCMD.ST was set
+  UINTN                     ReadLogs;         ///< NCQ command error log reads
+  UINTN                     Resets;           ///< COMRESETs through PxSCTL.DET
+  UINTN                     BadCommands;      ///< Commands built against the AHCI or ATA rules
+} AHCI_MODEL_PORT;
+
+#define AHCI_MODEL_SIGNATURE    SIGNATURE_32 ('a', 'h', 'c', 'i')
+
+typedef struct {
+  UINT32                    Signature;
+  EFI_PCI_IO_PROTOCOL       PciIo;
+  UINT32                    Cap;
+  UINT32                    Ghc;
+  UINT32                    Is;
+  UINT32                    Pi;
+  AHCI_MODEL_PORT           Port[AHCI_MODEL_PORTS];
+  UINTN                     Mappings;         ///< Outstanding PciIo->Map() mappings
+  VOID                      *FailMapAddress;  ///< PciIo->Map() of this buffer fails
+} AHCI_MODEL;
+
+#define AHCI_MODEL_FROM_PCI_IO(a)   CR (a, AHCI_MODEL, PciIo, AHCI_MODEL_SIGNATURE)
+
+/**
+  Create a model of an AHCI HBA with a disk on every port.
+
+  @param  Capability    The value of the CAP register, which selects the number
+                        of command slots and whether NCQ is supported.
+
+  @return The model.
+
+**/
+AHCI_MODEL *
+AhciModelCreate (
+  IN UINT32             Capability
+  );
+
+/**
+  Free a model created by AhciModelCreate().
+
+  @param  Model         The model.
+
+**/
+VOID
+AhciModelDestroy (
+  IN AHCI_MODEL         *Model
+  );
+
+/**
+  Let the device finish queued commands: their data is transferred and their
+  bits are cleared in PxSACT, in any order the caller chooses.
+
+  @param  Model         The model.
+  @param  Port          The port.
+  @param  Slots         The bit map of the slots whose command completes.
+
+**/
+VOID
+AhciModelCompleteQueued (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port,
+  IN UINT32             Slots
+  );
+
+/**
+  Let a queued command fail. The device aborts all its queued commands, and
+  the HBA reports a task file error.
+
+  @param  Model         The model.
+  @param  Port          The port.
+
+**/
+VOID
+AhciModelFailQueued (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port
+  );
+
+/**
+  Get the slots of the queued commands the device holds.
+
+  @param  Model         The model.
+  @param  Port          The port.
+
+  @return The bit map of the slots.
+
+**/
+UINT32
+AhciModelQueuedSlots (
+  IN AHCI_MODEL         *Model,
+  IN UINT8              Port
+  );
+
+//
+// Functions of AhciMode.c that AtaAtapiPassThru.h does not declare, which the
+// tests use to set up a driver instance the way AhciModeInitialization() does.
+//
+VOID
+EFIAPI
+AhciWriteReg (
+  IN EFI_PCI_IO_PROTOCOL  *PciIo,
+  IN UINT32               Offset,
+  IN UINT32               Data
+  );
+
+EFI_STATUS
+EFIAPI
+AhciCreateTransferDescriptor (
+  IN     EFI_PCI_IO_PROTOCOL    *PciIo,
+  IN OUT EFI_AHCI_REGISTERS     *AhciRegisters
+  );
+
+EFI_STATUS
+EFIAPI
+AhciCreateNcqTransferDescriptor (
+  IN     EFI_PCI_IO_PROTOCOL    *PciIo,
+  IN OUT EFI_AHCI_REGISTERS     *AhciRegisters
+  );
+
+#endif
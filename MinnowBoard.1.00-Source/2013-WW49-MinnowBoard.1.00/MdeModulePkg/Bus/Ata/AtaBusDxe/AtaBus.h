@@ -137,6 +137,7 @@ typedef struct {
 
   BOOLEAN                               UdmaValid;
   BOOLEAN                               Lba48Bit;
+  BOOLEAN                               NcqEnabled;  // Non-blocking transfers use READ/WRITE FPDMA QUEUED.
 
   //
   // Cached data for ATA identify data
@@ -70,6 +70,14 @@ UINT8 mAtaCommands[][2][2] = {
   }
 };
 
+//
+// Look up table (IsWrite) for the queued ATA_CMD
+//
+UINT8 mAtaNcqCommands[2] = {
+  ATA_CMD_READ_FPDMA_QUEUED,           // 48-bit LBA; queued DMA read
+  ATA_CMD_WRITE_FPDMA_QUEUED           // 48-bit LBA; queued DMA write
+};
+
 //
 // Look up table (UdmaValid, IsTrustSend) for ATA_CMD
 //
@@ -343,6 +351,18 @@ IdentifyAtaDevice (
     AtaDevice->Lba48Bit = FALSE;
   }
 
+  //
+  // Check whether the WORD 76 (Serial ATA capabilities) reports native command
+  // queuing support. Queued commands let several non-blocking requests be
+  // outstanding on the device at a time.
+  //
+  AtaDevice->NcqEnabled = FALSE;
+  if (AtaDevice->UdmaValid &&
+      (IdentifyData->reserved_76_79[0] != 0xFFFF) &&
+      ((IdentifyData->reserved_76_79[0] & BIT8) != 0)) {
+    AtaDevice->NcqEnabled = TRUE;
+  }
+
   //
   // Block Media Information:
   //
@@ -479,8 +499,10 @@ TransferAtaDevice (
   IN EFI_EVENT                            Event OPTIONAL
   )
 {
+  EFI_STATUS                        Status;
   EFI_ATA_COMMAND_BLOCK             *Acb;
   EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  BOOLEAN                           Queued;
 
   //
   // Ensure AtaDevice->UdmaValid, AtaDevice->Lba48Bit and IsWrite are valid boolean values
@@ -489,6 +511,10 @@ TransferAtaDevice (
   ASSERT ((UINTN) AtaDevice->Lba48Bit < 2);
   ASSERT ((UINTN) IsWrite < 2);
   //
+  // Non-blocking transfers are queued when the device supports it.
+  //
+  Queued = (BOOLEAN) (AtaDevice->NcqEnabled && (TaskPacket != NULL) && (Event != NULL));
+  //
   // Prepare for ATA command block.
   //
   Acb = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
@@ -498,7 +524,20 @@ TransferAtaDevice (
   Acb->AtaCylinderHigh = (UINT8) RShiftU64 (StartLba, 16);
   Acb->AtaDeviceHead = (UINT8) (BIT7 | BIT6 | BIT5 | (AtaDevice->PortMultiplierPort << 4));
   Acb->AtaSectorCount = (UINT8) TransferLength;
-  if (AtaDevice->Lba48Bit) {
+  if (Queued) {
+    //
+    // READ/WRITE FPDMA QUEUED take the sector count in the feature field. The
+    // ATA pass thru fills the queue tag into the sector count field.
+    //
+    Acb->AtaCommand = mAtaNcqCommands[IsWrite];
+    Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
+    Acb->AtaCylinderLowExp = (UINT8) RShiftU64 (StartLba, 32);
+    Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
+    Acb->AtaDeviceHead = BIT6;
+    Acb->AtaFeatures = (UINT8) TransferLength;
+    Acb->AtaFeaturesExp = (UINT8) (TransferLength >> 8);
+    Acb->AtaSectorCount = 0;
+  } else if (AtaDevice->Lba48Bit) {
     Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
     Acb->AtaCylinderLowExp = (UINT8) RShiftU64 (StartLba, 32);
     Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
@@ -524,7 +563,11 @@ TransferAtaDevice (
     Packet->InTransferLength = TransferLength;
   }
 
-  Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
+  if (Queued) {
+    Packet->Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  } else {
+    Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
+  }
   Packet->Length = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
   //
   // |------------------------|-----------------|------------------------|-----------------|
@@ -557,7 +600,24 @@ TransferAtaDevice (
   }
   
 
-  return AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  Status = AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  if (Queued && (Status == EFI_UNSUPPORTED)) {
+    //
+    // The ATA pass thru can not queue commands to this device, so use the
+    // DMA commands for this and all later transfers.
+    //
+    DEBUG ((EFI_D_INFO, "AtaBus - Port %x: native command queuing is not available\n", AtaDevice->Port));
+    AtaDevice->NcqEnabled = FALSE;
+    if (Packet->Asb != NULL) {
+      FreeAlignedBuffer (Packet->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+    }
+    if (Packet->Acb != NULL) {
+      FreePool (Packet->Acb);
+    }
+    return TransferAtaDevice (AtaDevice, TaskPacket, Buffer, StartLba, TransferLength, IsWrite, Event);
+  }
+
+  return Status;
 }
 
 /**
@@ -750,7 +810,11 @@ AccessAtaDevice(
   //
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // Without native command queuing the device runs one request at a time, so
+    // the request waits for the outstanding one. Queued requests go down at once.
+    //
+    if (!AtaDevice->NcqEnabled && !IsListEmpty (&AtaDevice->AtaSubTaskList)) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
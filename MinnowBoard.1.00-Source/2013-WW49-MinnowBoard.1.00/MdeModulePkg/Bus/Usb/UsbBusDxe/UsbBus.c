@@ -31,6 +31,8 @@ EFI_USB_IO_PROTOCOL mUsbIoProtocol = {
   UsbIoPortReset
 };
 
+EFI_DEFERRED_START_PROTOCOL *mUsbDeferredStart = NULL;
+
 EFI_DRIVER_BINDING_PROTOCOL mUsbBusDriverBinding = {
   UsbBusControllerDriverSupported,
   UsbBusControllerDriverStart,
@@ -799,6 +801,7 @@ ON_EXIT:
   @param  This                   The USB IO instance.
 
   @retval EFI_SUCCESS            The device is reset and configured.
+  @retval EFI_DEVICE_ERROR       A new device on the bus holds the default address.
   @retval Others                 Failed to reset the device.
 
 **/
@@ -825,6 +828,18 @@ UsbIoPortReset (
     goto ON_EXIT;
   }
 
+  //
+  // The device answers at the default address after the reset, where the
+  // device of the port enumeration that holds it may be answering too.
+  //
+  if (Dev->Bus->AddressOwner != NULL) {
+    DEBUG (( EFI_D_ERROR, "UsbIoPortReset: default address is in use, hub port %d@hub %d not reset\n",
+                Dev->ParentPort, Dev->ParentAddr));
+
+    Status = EFI_DEVICE_ERROR;
+    goto ON_EXIT;
+  }
+
   HubIf  = Dev->ParentIf;
   Status = HubIf->HubApi->ResetPort (HubIf, Dev->ParentPort);
 
@@ -998,6 +1013,7 @@ UsbBusBuildProtocol (
   // Initial the wanted child device path list, and add first RemainingDevicePath
   //
   InitializeListHead (&UsbBus->WantedUsbIoDPList);
+  InitializeListHead (&UsbBus->AddressQueue);
   Status = UsbBusAddWantedUsbIoDP (&UsbBus->BusId, RemainingDevicePath);
   ASSERT (!EFI_ERROR (Status));
   //
@@ -1105,6 +1121,14 @@ UsbBusDriverEntryPoint (
   IN EFI_SYSTEM_TABLE     *SystemTable
   )
 {
+  //
+  // Hub ports are debounced and reset from Deferred Start continuations
+  // when the DXE core offers them, instead of stalling in Start().
+  //
+  if (EFI_ERROR (gBS->LocateProtocol (&gEfiDeferredStartProtocolGuid, NULL, (VOID **) &mUsbDeferredStart))) {
+    mUsbDeferredStart = NULL;
+  }
+
   return EfiLibInstallDriverBindingComponentName2 (
            ImageHandle,
            SystemTable,
@@ -1484,6 +1508,9 @@ UsbBusControllerDriverStop (
 
   gBS->FreePool   (RootIf);
   gBS->FreePool   (RootHub);
+  if (Bus->ResetTimeout != NULL) {
+    gBS->CloseEvent (Bus->ResetTimeout);
+  }
   Status = UsbBusFreeUsbDPList (&Bus->WantedUsbIoDPList);
   ASSERT (!EFI_ERROR (Status));
 
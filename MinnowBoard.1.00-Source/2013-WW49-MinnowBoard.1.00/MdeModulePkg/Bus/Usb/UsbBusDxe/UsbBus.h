@@ -23,6 +23,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/UsbHostController.h>
 #include <Protocol/UsbIo.h>
 #include <Protocol/DevicePath.h>
+#include <Protocol/DeferredStart.h>
 
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
@@ -237,6 +238,12 @@ struct _USB_INTERFACE {
   // connected to EHCI.
   //
   UINT8                     MaxSpeed;
+
+  //
+  // Ports of the hub being enumerated from Deferred Start
+  // continuations, as USB_PORT_ENUM.
+  //
+  LIST_ENTRY                PortEnums;
 };
 
 //
@@ -276,6 +283,19 @@ struct _USB_BUS {
   //
   LIST_ENTRY                WantedUsbIoDPList;
 
+  //
+  // A new device answers at the default address from its port reset
+  // until it is addressed. AddressOwner is the port enumeration that
+  // holds the default address; the others wait on AddressQueue.
+  //
+  USB_PORT_ENUM             *AddressOwner;
+  LIST_ENTRY                AddressQueue;
+
+  //
+  // Timer signaled once the hub port reset of AddressOwner has taken
+  // too long. Created for the first such reset.
+  //
+  EFI_EVENT                 ResetTimeout;
 };
 
 //
@@ -765,5 +785,6 @@ extern EFI_USB_IO_PROTOCOL            mUsbIoProtocol;
 extern EFI_DRIVER_BINDING_PROTOCOL    mUsbBusDriverBinding;
 extern EFI_COMPONENT_NAME_PROTOCOL    mUsbBusComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL   mUsbBusComponentName2;
+extern EFI_DEFERRED_START_PROTOCOL    *mUsbDeferredStart;
 
 #endif
@@ -614,18 +614,19 @@ UsbFindChild (
 
 
 /**
-  Enumerate and configure the new device on the port of this HUB interface.
+  Create and configure the new device on a port of this HUB
+  interface that has just been reset.
 
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
 
-  @retval EFI_SUCCESS           The device is enumerated (added or removed).
+  @retval EFI_SUCCESS           The device is enumerated.
   @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
   @retval Others                Failed to enumerate the device.
 
 **/
 EFI_STATUS
-UsbEnumerateNewDev (
+UsbConfigureNewDev (
   IN USB_INTERFACE        *HubIf,
   IN UINT8                Port
   )
@@ -641,27 +642,9 @@ UsbEnumerateNewDev (
 
   Parent  = HubIf->Device;
   Bus     = Parent->Bus;
-  HubApi  = HubIf->HubApi;  
+  HubApi  = HubIf->HubApi;
   Address = Bus->MaxDevices;
 
-  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
-  
-  //
-  // Hub resets the device for at least 10 milliseconds.
-  // Host learns device speed. If device is of low/full speed
-  // and the hub is a EHCI root hub, ResetPort will release
-  // the device to its companion UHCI and return an error.
-  //
-  Status = HubApi->ResetPort (HubIf, Port);
-
-  if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to reset port %d - %r\n", Port, Status));
-
-    return Status;
-  }
-
-  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: hub port %d is reset\n", Port));
-
   Child = UsbCreateDevice (HubIf, Port);
 
   if (Child == NULL) {
@@ -675,12 +658,12 @@ UsbEnumerateNewDev (
   Status = HubApi->GetPortStatus (HubIf, Port, &PortState);
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to get speed of port %d\n", Port));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to get speed of port %d\n", Port));
     goto ON_ERROR;
   }
 
   if (!USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_CONNECTION)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: No device presented at port %d\n", Port));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: No device presented at port %d\n", Port));
     goto ON_ERROR;
   } else if (USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_SUPER_SPEED)){
     Child->Speed      = EFI_USB_SPEED_SUPER;
@@ -696,7 +679,7 @@ UsbEnumerateNewDev (
     Child->MaxPacket0 = 8;
   }
 
-  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: device is of %d speed\n", Child->Speed));
+  DEBUG (( EFI_D_INFO, "UsbConfigureNewDev: device is of %d speed\n", Child->Speed));
 
   if (((Child->Speed == EFI_USB_SPEED_LOW) || (Child->Speed == EFI_USB_SPEED_FULL)) &&
       (Parent->Speed == EFI_USB_SPEED_HIGH)) {
@@ -712,7 +695,7 @@ UsbEnumerateNewDev (
   } else {
     Child->Translator = Parent->Translator;
   }
-  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: device uses translator (%d, %d)\n",
+  DEBUG (( EFI_D_INFO, "UsbConfigureNewDev: device uses translator (%d, %d)\n",
            Child->Translator.TranslatorHubAddress,
            Child->Translator.TranslatorPortNumber));
 
@@ -736,7 +719,7 @@ UsbEnumerateNewDev (
   }
 
   if (Address >= Bus->MaxDevices) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: address pool is full for port %d\n", Port));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: address pool is full for port %d\n", Port));
 
     Status = EFI_ACCESS_DENIED;
     goto ON_ERROR;
@@ -747,13 +730,13 @@ UsbEnumerateNewDev (
   Bus->Devices[Address] = Child;
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to set device address - %r\n", Status));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to set device address - %r\n", Status));
     goto ON_ERROR;
   }
 
   gBS->Stall (USB_SET_DEVICE_ADDRESS_STALL);
 
-  DEBUG ((EFI_D_INFO, "UsbEnumerateNewDev: device is now ADDRESSED at %d\n", Address));
+  DEBUG ((EFI_D_INFO, "UsbConfigureNewDev: device is now ADDRESSED at %d\n", Address));
 
   //
   // Host sends a Get_Descriptor request to learn the max packet
@@ -762,11 +745,11 @@ UsbEnumerateNewDev (
   Status = UsbGetMaxPacketSize0 (Child);
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to get max packet for EP 0 - %r\n", Status));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to get max packet for EP 0 - %r\n", Status));
     goto ON_ERROR;
   }
 
-  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: max packet size for EP 0 is %d\n", Child->MaxPacket0));
+  DEBUG (( EFI_D_INFO, "UsbConfigureNewDev: max packet size for EP 0 is %d\n", Child->MaxPacket0));
 
   //
   // Host learns about the device's abilities by requesting device's
@@ -775,7 +758,7 @@ UsbEnumerateNewDev (
   Status = UsbBuildDescTable (Child);
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to build descriptor table - %r\n", Status));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to build descriptor table - %r\n", Status));
     goto ON_ERROR;
   }
 
@@ -787,11 +770,11 @@ UsbEnumerateNewDev (
   Status = UsbSetConfig (Child, Config);
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to set configure %d - %r\n", Config, Status));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to set configure %d - %r\n", Config, Status));
     goto ON_ERROR;
   }
 
-  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: device %d is now in CONFIGED state\n", Address));
+  DEBUG (( EFI_D_INFO, "UsbConfigureNewDev: device %d is now in CONFIGED state\n", Address));
 
   //
   // Host assigns and loads a device driver.
@@ -799,7 +782,7 @@ UsbEnumerateNewDev (
   Status = UsbSelectConfig (Child, Config);
 
   if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to create interfaces - %r\n", Status));
+    DEBUG ((EFI_D_ERROR, "UsbConfigureNewDev: failed to create interfaces - %r\n", Status));
     goto ON_ERROR;
   }
 
@@ -832,6 +815,488 @@ ON_ERROR:
 }
 
 
+/**
+  Enumerate and configure the new device on the port of this HUB interface.
+
+  @param  HubIf                 The HUB that has the device connected.
+  @param  Port                  The port index of the hub (started with zero).
+
+  @retval EFI_SUCCESS           The device is enumerated (added or removed).
+  @retval EFI_NOT_READY         A port enumeration holds the default address
+                                of the bus, the port is not reset.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
+  @retval Others                Failed to enumerate the device.
+
+**/
+EFI_STATUS
+UsbEnumerateNewDev (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port
+  )
+{
+  USB_HUB_API             *HubApi;
+  EFI_STATUS              Status;
+
+  HubApi  = HubIf->HubApi;  
+
+  //
+  // The device of the port enumeration that holds the default address
+  // may be answering at it, and so would the device reset here.
+  //
+  if (HubIf->Device->Bus->AddressOwner != NULL) {
+    DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: default address is in use, port %d waits\n", Port));
+    return EFI_NOT_READY;
+  }
+
+  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
+  
+  //
+  // Hub resets the device for at least 10 milliseconds.
+  // Host learns device speed. If device is of low/full speed
+  // and the hub is a EHCI root hub, ResetPort will release
+  // the device to its companion UHCI and return an error.
+  //
+  Status = HubApi->ResetPort (HubIf, Port);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to reset port %d - %r\n", Port, Status));
+
+    return Status;
+  }
+
+  DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: hub port %d is reset\n", Port));
+
+  return UsbConfigureNewDev (HubIf, Port);
+}
+
+
+VOID
+EFIAPI
+UsbPortEnumStep (
+  IN VOID                 *Context
+  );
+
+EFI_STATUS
+UsbEnumeratePort (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port
+  );
+
+
+/**
+  Find the enumeration in progress on a hub port.
+
+  @param  HubIf                 The hub interface.
+  @param  Port                  The port of the hub.
+
+  @return The port enumeration or NULL.
+
+**/
+USB_PORT_ENUM *
+UsbFindPortEnum (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port
+  )
+{
+  LIST_ENTRY              *Entry;
+  USB_PORT_ENUM           *PortEnum;
+
+  for (Entry = HubIf->PortEnums.ForwardLink; Entry != &HubIf->PortEnums; Entry = Entry->ForwardLink) {
+    PortEnum = USB_PORT_ENUM_FROM_LINK (Entry);
+
+    if ((PortEnum->State != USB_PORT_ENUM_SCAN) && (PortEnum->Port == Port)) {
+      return PortEnum;
+    }
+  }
+
+  return NULL;
+}
+
+
+/**
+  Create a port enumeration and post its first step.
+
+  @param  HubIf                 The hub interface.
+  @param  Port                  The port of the hub.
+  @param  State                 The first step.
+  @param  Stall                 The delay before the first step, in microseconds.
+
+  @return The port enumeration, or NULL if it cannot be started.
+
+**/
+USB_PORT_ENUM *
+UsbCreatePortEnum (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port,
+  IN UINT8                State,
+  IN UINTN                Stall
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  EFI_STATUS              Status;
+
+  if (mUsbDeferredStart == NULL) {
+    return NULL;
+  }
+
+  PortEnum = AllocateZeroPool (sizeof (USB_PORT_ENUM));
+
+  if (PortEnum == NULL) {
+    return NULL;
+  }
+
+  PortEnum->Signature = USB_PORT_ENUM_SIGNATURE;
+  PortEnum->HubIf     = HubIf;
+  PortEnum->Port      = Port;
+  PortEnum->State     = State;
+
+  Status = mUsbDeferredStart->PostContinuation (
+                                mUsbDeferredStart,
+                                MultU64x32 (Stall, 10),
+                                UsbPortEnumStep,
+                                PortEnum
+                                );
+
+  if (EFI_ERROR (Status)) {
+    FreePool (PortEnum);
+    return NULL;
+  }
+
+  InsertTailList (&HubIf->PortEnums, &PortEnum->Link);
+  return PortEnum;
+}
+
+
+/**
+  Move a port enumeration to its next step once a delay has passed.
+
+  @param  PortEnum              The port enumeration.
+  @param  State                 The next step.
+  @param  Stall                 The delay in microseconds.
+
+  @retval EFI_SUCCESS           The next step is posted.
+  @retval Others                Failed to post the next step.
+
+**/
+EFI_STATUS
+UsbPostPortEnum (
+  IN USB_PORT_ENUM        *PortEnum,
+  IN UINT8                State,
+  IN UINTN                Stall
+  )
+{
+  PortEnum->State = State;
+
+  return mUsbDeferredStart->PostContinuation (
+                              mUsbDeferredStart,
+                              MultU64x32 (Stall, 10),
+                              UsbPortEnumStep,
+                              PortEnum
+                              );
+}
+
+
+/**
+  Give up the default address of the bus and hand it to the next
+  port enumeration waiting for it.
+
+  @param  Bus                   The USB bus.
+
+**/
+VOID
+UsbReleaseDefaultAddress (
+  IN USB_BUS              *Bus
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  EFI_STATUS              Status;
+
+  Bus->AddressOwner = NULL;
+
+  while (!IsListEmpty (&Bus->AddressQueue)) {
+    PortEnum = USB_PORT_ENUM_FROM_QUEUE (Bus->AddressQueue.ForwardLink);
+    RemoveEntryList (&PortEnum->Queue);
+
+    //
+    // Start the reset from a continuation, as this may be called
+    // while the hub that owned the address is being released.
+    //
+    Status = UsbPostPortEnum (PortEnum, USB_PORT_ENUM_WAIT_ADDRESS, 0);
+
+    if (!EFI_ERROR (Status)) {
+      Bus->AddressOwner = PortEnum;
+      return;
+    }
+
+    DEBUG ((EFI_D_ERROR, "UsbReleaseDefaultAddress: failed to resume port %d - %r\n", PortEnum->Port, Status));
+    PortEnum->HubIf->HubApi->ClearPortChange (PortEnum->HubIf, PortEnum->Port);
+    RemoveEntryList (&PortEnum->Link);
+    FreePool (PortEnum);
+  }
+}
+
+
+/**
+  End a port enumeration: ACK the port change bits, as
+  UsbEnumeratePort() would have done, and free it.
+
+  @param  PortEnum              The port enumeration.
+
+**/
+VOID
+UsbEndPortEnum (
+  IN USB_PORT_ENUM        *PortEnum
+  )
+{
+  USB_INTERFACE           *HubIf;
+  USB_BUS                 *Bus;
+
+  HubIf = PortEnum->HubIf;
+  Bus   = HubIf->Device->Bus;
+
+  if (Bus->AddressOwner == PortEnum) {
+    UsbReleaseDefaultAddress (Bus);
+  }
+
+  if (PortEnum->State != USB_PORT_ENUM_SCAN) {
+    HubIf->HubApi->ClearPortChange (HubIf, PortEnum->Port);
+  }
+
+  RemoveEntryList (&PortEnum->Link);
+  FreePool (PortEnum);
+}
+
+
+/**
+  Start driving the reset signal on the port. The caller owns the
+  default address of the bus. See USB 2.0 spec section 7.1.7.5 for
+  the timing requirements.
+
+  @param  PortEnum              The port enumeration.
+
+**/
+VOID
+UsbResetPortEnum (
+  IN USB_PORT_ENUM        *PortEnum
+  )
+{
+  USB_INTERFACE           *HubIf;
+  USB_BUS                 *Bus;
+  EFI_STATUS              Status;
+
+  HubIf  = PortEnum->HubIf;
+  Bus    = HubIf->Device->Bus;
+  Status = EFI_SUCCESS;
+
+  if (HubIf->HubApi != &mUsbRootHubApi) {
+    //
+    // The end of the reset is polled for until the timer expires. CheckEvent()
+    // clears the signal left from an earlier reset.
+    //
+    if (Bus->ResetTimeout == NULL) {
+      Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &Bus->ResetTimeout);
+    }
+
+    if (!EFI_ERROR (Status)) {
+      gBS->CheckEvent (Bus->ResetTimeout);
+      Status = gBS->SetTimer (Bus->ResetTimeout, TimerRelative, MultU64x32 (USB_PORT_ENUM_RESET_TIMEOUT, 10));
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = HubIf->HubApi->SetPortFeature (HubIf, PortEnum->Port, EfiUsbPortReset);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = UsbPostPortEnum (
+               PortEnum,
+               USB_PORT_ENUM_RESET,
+               (HubIf->HubApi == &mUsbRootHubApi) ? USB_SET_ROOT_PORT_RESET_STALL : USB_SET_PORT_RESET_STALL
+               );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbResetPortEnum: failed to reset port %d - %r\n", PortEnum->Port, Status));
+    UsbEndPortEnum (PortEnum);
+  }
+}
+
+
+/**
+  Run the next step of a port enumeration. Every step either posts
+  the following one or ends the enumeration.
+
+  @param  Context               The port enumeration.
+
+**/
+VOID
+EFIAPI
+UsbPortEnumStep (
+  IN VOID                 *Context
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  USB_INTERFACE           *HubIf;
+  USB_BUS                 *Bus;
+  EFI_USB_PORT_STATUS     PortState;
+  EFI_STATUS              Status;
+  UINT8                   Index;
+
+  PortEnum = (USB_PORT_ENUM *) Context;
+  HubIf    = PortEnum->HubIf;
+
+  if (HubIf == NULL) {
+    FreePool (PortEnum);
+    return;
+  }
+
+  Bus    = HubIf->Device->Bus;
+  Status = EFI_SUCCESS;
+
+  switch (PortEnum->State) {
+  case USB_PORT_ENUM_SCAN:
+    for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+      UsbEnumeratePort (HubIf, Index);
+    }
+
+    UsbHubAckHubStatus (HubIf->Device);
+    UsbEndPortEnum (PortEnum);
+    return;
+
+  case USB_PORT_ENUM_DEBOUNCE:
+    //
+    // Every new device answers at the default address until it is
+    // addressed, so only one port of the bus is reset at a time.
+    //
+    if (Bus->AddressOwner != NULL) {
+      PortEnum->State = USB_PORT_ENUM_WAIT_ADDRESS;
+      InsertTailList (&Bus->AddressQueue, &PortEnum->Queue);
+      return;
+    }
+
+    Bus->AddressOwner = PortEnum;
+    UsbResetPortEnum (PortEnum);
+    return;
+
+  case USB_PORT_ENUM_WAIT_ADDRESS:
+    ASSERT (Bus->AddressOwner == PortEnum);
+    UsbResetPortEnum (PortEnum);
+    return;
+
+  case USB_PORT_ENUM_RESET:
+    if (HubIf->HubApi == &mUsbRootHubApi) {
+      Status = HubIf->HubApi->ClearPortFeature (HubIf, PortEnum->Port, EfiUsbPortReset);
+
+      if (!EFI_ERROR (Status)) {
+        Status = UsbPostPortEnum (PortEnum, USB_PORT_ENUM_RESET_CLEARED, USB_CLR_ROOT_PORT_RESET_STALL);
+      }
+      break;
+    }
+
+    //
+    // The hub sets USB_PORT_STAT_C_RESET once the reset is done.
+    //
+    Status = HubIf->HubApi->GetPortStatus (HubIf, PortEnum->Port, &PortState);
+
+    if (!EFI_ERROR (Status) && USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)) {
+      Status = UsbPostPortEnum (PortEnum, USB_PORT_ENUM_RECOVERY, USB_SET_PORT_RECOVERY_STALL);
+    } else if (gBS->CheckEvent (Bus->ResetTimeout) == EFI_NOT_READY) {
+      Status = UsbPostPortEnum (PortEnum, USB_PORT_ENUM_RESET, USB_PORT_ENUM_RESET_POLL);
+    } else {
+      Status = EFI_TIMEOUT;
+    }
+    break;
+
+  case USB_PORT_ENUM_RESET_CLEARED:
+    Status = UsbRootHubFinishPortReset (HubIf, PortEnum->Port);
+
+    if (!EFI_ERROR (Status)) {
+      DEBUG (( EFI_D_INFO, "UsbPortEnumStep: root hub port %d is reset\n", PortEnum->Port));
+      UsbConfigureNewDev (HubIf, PortEnum->Port);
+    }
+
+    UsbEndPortEnum (PortEnum);
+    return;
+
+  case USB_PORT_ENUM_RECOVERY:
+    DEBUG (( EFI_D_INFO, "UsbPortEnumStep: hub port %d is reset\n", PortEnum->Port));
+    UsbConfigureNewDev (HubIf, PortEnum->Port);
+    UsbEndPortEnum (PortEnum);
+    return;
+
+  default:
+    ASSERT (FALSE);
+    Status = EFI_INVALID_PARAMETER;
+    break;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbPortEnumStep: failed to reset port %d - %r\n", PortEnum->Port, Status));
+    UsbEndPortEnum (PortEnum);
+  }
+}
+
+
+/**
+  Stop the port enumerations of a hub that is being released.
+  Enumerations waiting for the default address are freed at once;
+  the others are detached from the hub and freed by their next step.
+
+  @param  HubIf                 The hub interface.
+
+**/
+VOID
+UsbCancelPortEnums (
+  IN USB_INTERFACE        *HubIf
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  USB_BUS                 *Bus;
+
+  Bus = HubIf->Device->Bus;
+
+  while (!IsListEmpty (&HubIf->PortEnums)) {
+    PortEnum = USB_PORT_ENUM_FROM_LINK (HubIf->PortEnums.ForwardLink);
+    RemoveEntryList (&PortEnum->Link);
+
+    if (PortEnum->State == USB_PORT_ENUM_WAIT_ADDRESS && Bus->AddressOwner != PortEnum) {
+      RemoveEntryList (&PortEnum->Queue);
+      FreePool (PortEnum);
+      continue;
+    }
+
+    PortEnum->HubIf = NULL;
+
+    if (Bus->AddressOwner == PortEnum) {
+      UsbReleaseDefaultAddress (Bus);
+    }
+  }
+}
+
+
+/**
+  Scan all the ports of a hub once their power is good, from a
+  Deferred Start continuation. Devices present when the hub is
+  started are thus enumerated before the continuations BDS waits
+  on are all done, rather than whenever the hub reports them.
+
+  @param  HubIf                 The hub interface.
+  @param  Stall                 The power on to power good time, in microseconds.
+
+  @retval TRUE                  The scan is posted.
+  @retval FALSE                 The ports are left to the hub's change reports.
+
+**/
+BOOLEAN
+UsbDeferHubScan (
+  IN USB_INTERFACE        *HubIf,
+  IN UINTN                Stall
+  )
+{
+  return (BOOLEAN) (UsbCreatePortEnum (HubIf, 0, USB_PORT_ENUM_SCAN, Stall) != NULL);
+}
+
+
 /**
   Process the events on the port.
 
@@ -857,6 +1322,14 @@ UsbEnumeratePort (
   Child   = NULL;
   HubApi  = HubIf->HubApi;
 
+  //
+  // The port keeps reporting its changes until the enumeration
+  // of its new device is done and ACKs them.
+  //
+  if (UsbFindPortEnum (HubIf, Port) != NULL) {
+    return EFI_SUCCESS;
+  }
+
   //
   // Host learns of the new device by polling the hub for port changes.
   //
@@ -939,7 +1412,24 @@ UsbEnumeratePort (
     // Now, new device connected, enumerate and configure the device 
     //
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: new device connected at port %d\n", Port));
+
+    //
+    // Wait for the connection to be stable, then reset and configure
+    // the device from Deferred Start continuations. The port change
+    // bits are ACKed once that is done.
+    //
+    if (UsbCreatePortEnum (HubIf, Port, USB_PORT_ENUM_DEBOUNCE, USB_WAIT_PORT_STABLE_STALL) != NULL) {
+      return EFI_SUCCESS;
+    }
+
     Status = UsbEnumerateNewDev (HubIf, Port);
+
+    if (Status == EFI_NOT_READY) {
+      //
+      // Leave the port change bits set, so the hub reports the port again.
+      //
+      return Status;
+    }
   
   } else {
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
@@ -91,6 +91,46 @@ EFI_STATUS
   IN USB_INTERFACE        *UsbIf
   );
 
+//
+// Steps of a port enumeration driven by Deferred Start continuations:
+// wait for the connection to be stable, wait for the default address
+// of the bus, drive the reset signal, then configure the new device.
+// A SCAN enumeration instead looks at every port of a newly powered hub.
+//
+#define USB_PORT_ENUM_SCAN          0
+#define USB_PORT_ENUM_DEBOUNCE      1
+#define USB_PORT_ENUM_WAIT_ADDRESS  2
+#define USB_PORT_ENUM_RESET         3
+#define USB_PORT_ENUM_RESET_CLEARED 4
+#define USB_PORT_ENUM_RECOVERY      5
+
+//
+// Poll a hub port for the end of its reset every millisecond, until
+// as much time has passed since the reset started as UsbHubResetPort()
+// would wait. A continuation may run well after its delay, so the
+// polls are not counted.
+//
+#define USB_PORT_ENUM_RESET_POLL    USB_BUS_1_MILLISECOND
+#define USB_PORT_ENUM_RESET_TIMEOUT \
+          (USB_SET_PORT_RESET_STALL + USB_WAIT_PORT_STS_CHANGE_LOOP * USB_WAIT_PORT_STS_CHANGE_STALL)
+
+#define USB_PORT_ENUM_SIGNATURE     SIGNATURE_32 ('U', 'S', 'B', 'P')
+
+#define USB_PORT_ENUM_FROM_LINK(a) \
+          CR(a, USB_PORT_ENUM, Link, USB_PORT_ENUM_SIGNATURE)
+
+#define USB_PORT_ENUM_FROM_QUEUE(a) \
+          CR(a, USB_PORT_ENUM, Queue, USB_PORT_ENUM_SIGNATURE)
+
+typedef struct {
+  UINTN                   Signature;
+  LIST_ENTRY              Link;       // On the hub's PortEnums
+  LIST_ENTRY              Queue;      // On the bus's AddressQueue, in WAIT_ADDRESS
+  USB_INTERFACE           *HubIf;     // NULL once the hub is released
+  UINT8                   Port;
+  UINT8                   State;
+} USB_PORT_ENUM;
+
 /**
   Return the endpoint descriptor in this interface.
 
@@ -200,4 +240,32 @@ UsbRootHubEnumeration (
   IN EFI_EVENT            Event,
   IN VOID                 *Context
   );
+
+/**
+  Stop the port enumerations of a hub that is being released.
+
+  @param  HubIf                 The hub interface.
+
+**/
+VOID
+UsbCancelPortEnums (
+  IN USB_INTERFACE        *HubIf
+  );
+
+/**
+  Scan all the ports of a hub once their power is good, from a
+  Deferred Start continuation.
+
+  @param  HubIf                 The hub interface.
+  @param  Stall                 The power on to power good time, in microseconds.
+
+  @retval TRUE                  The scan is posted.
+  @retval FALSE                 The ports are left to the hub's change reports.
+
+**/
+BOOLEAN
+UsbDeferHubScan (
+  IN USB_INTERFACE        *HubIf,
+  IN UINTN                Stall
+  );
 #endif
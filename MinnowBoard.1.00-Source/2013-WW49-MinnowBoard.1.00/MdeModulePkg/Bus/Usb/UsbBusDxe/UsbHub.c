@@ -699,6 +699,7 @@ UsbHubInit (
   UINT8                   Index;
   UINT8                   NumEndpoints;
   UINT16                  Depth;
+  UINTN                   PowerGood;
 
   //
   // Locate the interrupt endpoint for port change map
@@ -745,6 +746,8 @@ UsbHubInit (
   HubIf->IsHub  = TRUE;
   HubIf->HubApi = &mUsbHubApi;
   HubIf->HubEp  = EpDesc;
+  InitializeListHead (&HubIf->PortEnums);
+  PowerGood     = 0;
 
   if (HubIf->Device->Speed == EFI_USB_SPEED_SUPER) {
     Depth = (UINT16)(HubIf->Device->Tier - 1);
@@ -764,12 +767,17 @@ UsbHubInit (
     }
 
     //
-    // Update for the usb hub has no power on delay requirement
+    // Update for the usb hub has no power on delay requirement.
+    // With Deferred Start, the ports are scanned once power is good.
     //
-    if (HubDesc.PwrOn2PwrGood > 0) {
-      gBS->Stall (HubDesc.PwrOn2PwrGood * USB_SET_PORT_POWER_STALL);
+    PowerGood = HubDesc.PwrOn2PwrGood * USB_SET_PORT_POWER_STALL;
+
+    if (mUsbDeferredStart == NULL) {
+      if (PowerGood > 0) {
+        gBS->Stall (PowerGood);
+      }
+      UsbHubAckHubStatus (HubIf->Device);
     }
-    UsbHubAckHubStatus (HubIf->Device);
   }
 
   //
@@ -818,6 +826,13 @@ UsbHubInit (
     return Status;
   }
 
+  //
+  // Look at every port once, so that the devices already attached are
+  // enumerated before the continuations BDS waits on are all done.
+  // Otherwise they would only be found when the hub reports them.
+  //
+  UsbDeferHubScan (HubIf, PowerGood);
+
   DEBUG (( EFI_D_INFO, "UsbHubInit: hub %d initialized\n", HubDev->Address));
   return Status;
 }
@@ -1017,6 +1032,8 @@ UsbHubRelease (
   EFI_USB_IO_PROTOCOL     *UsbIo;
   EFI_STATUS              Status;
 
+  UsbCancelPortEnums (HubIf);
+
   UsbIo  = &HubIf->UsbIo;
   Status = UsbIo->UsbAsyncInterruptTransfer (
                     UsbIo,
@@ -1079,6 +1096,7 @@ UsbRootHubInit (
   HubIf->MaxSpeed   = MaxSpeed;
   HubIf->NumOfPort  = NumOfPort;
   HubIf->HubNotify  = NULL;
+  InitializeListHead (&HubIf->PortEnums);
 
   //
   // Create a timer to poll root hub ports periodically
@@ -1259,8 +1277,6 @@ UsbRootHubResetPort (
 {
   USB_BUS                 *Bus;
   EFI_STATUS              Status;
-  EFI_USB_PORT_STATUS     PortState;
-  UINTN                   Index;
 
   //
   // Notice: although EHCI requires that ENABLED bit be cleared
@@ -1290,6 +1306,38 @@ UsbRootHubResetPort (
 
   gBS->Stall (USB_CLR_ROOT_PORT_RESET_STALL);
 
+  return UsbRootHubFinishPortReset (RootIf, Port);
+}
+
+
+/**
+  Finish the reset of a root hub port once the reset signal has been
+  driven and released: wait for the host controller to end the reset,
+  then enable the port or hand the device over to the companion UHCI.
+
+  @param  RootIf                The root hub interface.
+  @param  Port                  The port being reset.
+
+  @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_TIMEOUT           Failed to reset the port in time.
+  @retval EFI_NOT_FOUND         The low/full speed device connected to high  speed.
+                                root hub is released to the companion UHCI.
+  @retval Others                Failed to reset the port.
+
+**/
+EFI_STATUS
+UsbRootHubFinishPortReset (
+  IN USB_INTERFACE        *RootIf,
+  IN UINT8                Port
+  )
+{
+  USB_BUS                 *Bus;
+  EFI_STATUS              Status;
+  EFI_USB_PORT_STATUS     PortState;
+  UINTN                   Index;
+
+  Bus     = RootIf->Device->Bus;
+
   //
   // USB host controller won't clear the RESET bit until
   // reset is actually finished.
@@ -1364,6 +1412,8 @@ UsbRootHubRelease (
   gBS->SetTimer (HubIf->HubNotify, TimerCancel, USB_ROOTHUB_POLL_INTERVAL);
   gBS->CloseEvent (HubIf->HubNotify);
 
+  UsbCancelPortEnums (HubIf);
+
   return EFI_SUCCESS;
 }
 
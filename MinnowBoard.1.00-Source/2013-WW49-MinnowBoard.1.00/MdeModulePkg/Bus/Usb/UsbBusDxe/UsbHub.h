@@ -193,6 +193,27 @@ UsbHubAckHubStatus (
   IN  USB_DEVICE         *UsbDev
   );
 
+
+/**
+  Finish the reset of a root hub port once the reset signal has been
+  driven and released.
+
+  @param  RootIf                The root hub interface.
+  @param  Port                  The port being reset.
+
+  @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_TIMEOUT           Failed to reset the port in time.
+  @retval EFI_NOT_FOUND         The low/full speed device connected to high  speed.
+                                root hub is released to the companion UHCI.
+  @retval Others                Failed to reset the port.
+
+**/
+EFI_STATUS
+UsbRootHubFinishPortReset (
+  IN USB_INTERFACE        *RootIf,
+  IN UINT8                Port
+  );
+
 extern USB_HUB_API        mUsbHubApi;
 extern USB_HUB_API        mUsbRootHubApi;
 #endif
@@ -240,8 +240,24 @@ UsbBootExecCmdWithRetry (
   UINTN                       Retry;
   EFI_EVENT                   TimeoutEvt;
 
-  Retry  = 0;
-  Status = EFI_SUCCESS;
+  //
+  // Most commands succeed at the first attempt, so the retry timer is only
+  // created once the command has failed.
+  //
+  Status = UsbBootExecCmd (
+             UsbMass,
+             Cmd,
+             CmdLen,
+             DataDir,
+             Data,
+             DataLen,
+             Timeout
+             );
+  if (Status == EFI_SUCCESS || Status == EFI_MEDIA_CHANGED || Status == EFI_NO_MEDIA) {
+    return Status;
+  }
+
+  Retry  = (Status == EFI_NOT_READY) ? 0 : 1;
   Status = gBS->CreateEvent (
                   EVT_TIMER,
                   TPL_CALLBACK,
@@ -727,6 +743,12 @@ ON_ERROR:
            &UsbMass->BlockIo,
            &UsbMass->BlockIo
            );
+    gBS->ReinstallProtocolInterface (
+           UsbMass->Controller,
+           &gEfiBlockIo2ProtocolGuid,
+           &UsbMass->BlockIo2,
+           &UsbMass->BlockIo2
+           );
 
     ASSERT (EfiGetCurrentTpl () == TPL_CALLBACK);
     gBS->RaiseTPL (OldTpl);
@@ -753,6 +775,35 @@ ON_ERROR:
 }
 
 
+/**
+  Get the maximum number of blocks carried by one READ/WRITE command.
+
+  The limit is the larger one of USB_BOOT_IO_BLOCKS and the number of blocks
+  fitting into the max transfer size of the BOT transport, and is at most
+  0xFFFF so that it fits into the transfer length of READ10/WRITE10 too.
+
+  @param  UsbMass                The USB mass storage device.
+
+  @return The maximum number of blocks of one command.
+
+**/
+UINTN
+UsbBootGetMaxTransferBlocks (
+  IN  USB_MASS_DEVICE       *UsbMass
+  )
+{
+  UINTN                     MaxBlock;
+
+  MaxBlock = USB_BOOT_IO_BLOCKS;
+
+  if (UsbMass->Transport->Protocol == USB_MASS_STORE_BOT) {
+    MaxBlock = MAX (MaxBlock, ((USB_BOT_PROTOCOL *) UsbMass->Context)->MaxTransferSize / UsbMass->BlockIoMedia.BlockSize);
+  }
+
+  return MIN (MaxBlock, 0xFFFF);
+}
+
+
 /**
   Read some blocks from the device.
 
@@ -779,8 +830,10 @@ UsbBootReadBlocks (
   UINT32                    BlockSize;
   UINT32                    ByteSize;
   UINT32                    Timeout;
+  UINTN                     MaxBlock;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  MaxBlock  = UsbBootGetMaxTransferBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -789,7 +842,7 @@ UsbBootReadBlocks (
     // on the device. We must split the total block because the READ10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16)((TotalBlock < MaxBlock) ? TotalBlock : MaxBlock);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -855,8 +908,10 @@ UsbBootWriteBlocks (
   UINT32                BlockSize;
   UINT32                ByteSize;
   UINT32                Timeout;
+  UINTN                 MaxBlock;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  MaxBlock  = UsbBootGetMaxTransferBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -865,7 +920,7 @@ UsbBootWriteBlocks (
     // on the device. We must split the total block because the WRITE10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16)((TotalBlock < MaxBlock) ? TotalBlock : MaxBlock);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -931,15 +986,17 @@ UsbBootReadBlocks16 (
   UINT32                    BlockSize;
   UINT32                    ByteSize;
   UINT32                    Timeout;
+  UINTN                     MaxBlock;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  MaxBlock  = UsbBootGetMaxTransferBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16)((TotalBlock < MaxBlock) ? TotalBlock : MaxBlock);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -1005,15 +1062,17 @@ UsbBootWriteBlocks16 (
   UINT32                BlockSize;
   UINT32                ByteSize;
   UINT32                Timeout;
+  UINTN                 MaxBlock;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  MaxBlock  = UsbBootGetMaxTransferBlocks (UsbMass);
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16)((TotalBlock < MaxBlock) ? TotalBlock : MaxBlock);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -64,7 +64,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define USB_PDT_SIMPLE_DIRECT           0x0E       ///< Simplified direct access device
 
 //
-// Other parameters, Max carried size is 512B * 128 = 64KB
+// Other parameters, Max carried size is 512B * 128 = 64KB by default.
+// High speed and super speed BOT devices carry more, see UsbBotInit().
 //
 #define USB_BOOT_IO_BLOCKS              128
 
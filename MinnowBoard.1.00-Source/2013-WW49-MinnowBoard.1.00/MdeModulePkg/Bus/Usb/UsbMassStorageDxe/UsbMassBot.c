@@ -112,6 +112,16 @@ UsbBotInit (
     goto ON_ERROR;
   }
 
+  //
+  // Bulk endpoints with max packet size 1024 or 512 bytes can only be super
+  // speed or high speed, which allows much larger data per command.
+  //
+  if (UsbBot->BulkInEndpoint->MaxPacketSize >= 1024) {
+    UsbBot->MaxTransferSize = USB_BOT_MAX_TRANSFER_SIZE_SUPER_SPEED;
+  } else if (UsbBot->BulkInEndpoint->MaxPacketSize >= 512) {
+    UsbBot->MaxTransferSize = USB_BOT_MAX_TRANSFER_SIZE_HIGH_SPEED;
+  }
+
   //
   // The USB BOT protocol uses CBWTag to match the CBW and CSW.
   //
@@ -53,6 +53,15 @@ extern USB_MASS_TRANSPORT mUsbBotTransport;
 #define USB_BOT_RECV_CSW_TIMEOUT     (3 * USB_MASS_1_SECOND)
 #define USB_BOT_RESET_DEVICE_TIMEOUT (3 * USB_MASS_1_SECOND)
 
+//
+// Usb Bot maximum data length carried by one command, chosen by the speed of
+// the bulk endpoints. Full speed devices keep the boot command set default
+// (USB_BOOT_IO_BLOCKS). The high speed and super speed limits are those widely
+// used by host operating systems, which most mass storage devices handle well.
+//
+#define USB_BOT_MAX_TRANSFER_SIZE_HIGH_SPEED   0x1E000
+#define USB_BOT_MAX_TRANSFER_SIZE_SUPER_SPEED  0x100000
+
 #pragma pack(1)
 ///
 /// The CBW (Command Block Wrapper) structures used by the USB BOT protocol.
@@ -87,6 +96,7 @@ typedef struct {
   EFI_USB_ENDPOINT_DESCRIPTOR   *BulkOutEndpoint;
   UINT32                        CbwTag;
   EFI_USB_IO_PROTOCOL           *UsbIo;
+  UINT32                        MaxTransferSize; ///< Max data length of one command, 0 for the default
 } USB_BOT_PROTOCOL;
 
 /**
@@ -330,6 +330,360 @@ UsbMassFlushBlocks (
   return EFI_SUCCESS;
 }
 
+/**
+  Complete all the queued non-blocking Block I/O 2 requests with EFI_ABORTED.
+
+  @param  UsbMass                The USB mass storage device
+
+**/
+VOID
+UsbMassAbortBlockIo2Requests (
+  IN USB_MASS_DEVICE          *UsbMass
+  )
+{
+  USB_MASS_BLOCK_IO2_REQUEST  *Request;
+  EFI_TPL                     OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  while (!IsListEmpty (&UsbMass->BlockIo2Queue)) {
+    Request = USB_MASS_BLOCK_IO2_REQUEST_FROM_LINK (GetFirstNode (&UsbMass->BlockIo2Queue));
+    RemoveEntryList (&Request->Link);
+
+    Request->Token->TransactionStatus = EFI_ABORTED;
+    gBS->SignalEvent (Request->Token->Event);
+    FreePool (Request);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Execute the queued non-blocking Block I/O 2 requests.
+
+  The requests are executed back to back in the order they were queued, so
+  the device gets the next command right after the status of the previous one
+  instead of waiting for the requester to submit it. Each request's event is
+  signaled as soon as the request is completed.
+
+  @param  Event                  The timer event.
+  @param  Context                The USB mass storage device.
+
+**/
+VOID
+EFIAPI
+UsbMassExecuteBlockIo2Requests (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  USB_MASS_DEVICE             *UsbMass;
+  USB_MASS_BLOCK_IO2_REQUEST  *Request;
+  EFI_STATUS                  Status;
+  EFI_TPL                     OldTpl;
+
+  UsbMass = (USB_MASS_DEVICE *) Context;
+
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if (IsListEmpty (&UsbMass->BlockIo2Queue)) {
+      gBS->RestoreTPL (OldTpl);
+      break;
+    }
+    Request = USB_MASS_BLOCK_IO2_REQUEST_FROM_LINK (GetFirstNode (&UsbMass->BlockIo2Queue));
+    RemoveEntryList (&Request->Link);
+    gBS->RestoreTPL (OldTpl);
+
+    if (Request->BufferSize == 0) {
+      //
+      // A flush request, all the requests queued before it are done.
+      //
+      Status = EFI_SUCCESS;
+    } else if (Request->IsWrite) {
+      Status = UsbMassWriteBlocks (&UsbMass->BlockIo, Request->MediaId, Request->Lba, Request->BufferSize, Request->Buffer);
+    } else {
+      Status = UsbMassReadBlocks (&UsbMass->BlockIo, Request->MediaId, Request->Lba, Request->BufferSize, Request->Buffer);
+    }
+
+    Request->Token->TransactionStatus = Status;
+    gBS->SignalEvent (Request->Token->Event);
+    FreePool (Request);
+  }
+}
+
+/**
+  Queue a non-blocking Block I/O 2 request of the USB mass storage device.
+
+  The parameters which can be checked without accessing the device are
+  validated here. The media is detected when the request is executed.
+
+  @param  UsbMass                The USB mass storage device.
+  @param  MediaId                The media ID that the request is for.
+  @param  Lba                    The starting logical block address.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes, 0 for a flush request.
+  @param  Buffer                 The buffer of the data.
+  @param  IsWrite                TRUE for a write request, FALSE for a read request.
+
+  @retval EFI_SUCCESS            The request is queued.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER  The request contains LBAs that are not valid.
+  @retval EFI_OUT_OF_RESOURCES   The request could not be queued due to a lack of resources.
+
+**/
+EFI_STATUS
+UsbMassQueueBlockIo2Request (
+  IN     USB_MASS_DEVICE        *UsbMass,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer,
+  IN     BOOLEAN                IsWrite
+  )
+{
+  USB_MASS_BLOCK_IO2_REQUEST  *Request;
+  EFI_BLOCK_IO_MEDIA          *Media;
+  EFI_TPL                     OldTpl;
+
+  Media = &UsbMass->BlockIoMedia;
+
+  if (BufferSize != 0) {
+    if (!Media->RemovableMedia) {
+      if (!(Media->MediaPresent)) {
+        return EFI_NO_MEDIA;
+      }
+
+      if (MediaId != Media->MediaId) {
+        return EFI_MEDIA_CHANGED;
+      }
+    }
+
+    if (Buffer == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if ((BufferSize % Media->BlockSize) != 0) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (Lba + BufferSize / Media->BlockSize - 1 > Media->LastBlock) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  Request = AllocatePool (sizeof (USB_MASS_BLOCK_IO2_REQUEST));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request->Signature  = USB_MASS_BLOCK_IO2_REQUEST_SIGNATURE;
+  Request->Token      = Token;
+  Request->MediaId    = MediaId;
+  Request->Lba        = Lba;
+  Request->BufferSize = BufferSize;
+  Request->Buffer     = Buffer;
+  Request->IsWrite    = IsWrite;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&UsbMass->BlockIo2Queue, &Request->Link);
+  gBS->SetTimer (UsbMass->BlockIo2Timer, TimerRelative, 0);
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.Reset(). All the queued
+  non-blocking requests are aborted before the device is reset.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  ExtendedVerification   Indicates that the driver may perform a more exhaustive
+                                 verification operation of the device during reset.
+
+  @retval EFI_SUCCESS            The block device was reset.
+  @retval EFI_DEVICE_ERROR       The block device is not functioning correctly and could not be reset.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN BOOLEAN                  ExtendedVerification
+  )
+{
+  USB_MASS_DEVICE *UsbMass;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  UsbMassAbortBlockIo2Requests (UsbMass);
+
+  return UsbMassReset (&UsbMass->BlockIo, ExtendedVerification);
+}
+
+/**
+  Reads the requested number of blocks from the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx(). If Token
+  or Token->Event is NULL, the blocks are read before returning. Otherwise the
+  request is queued, and Token->Event is signaled once it is completed.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the read request is for.
+  @param  Lba                    The starting logical block address to read from on the device.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 A pointer to the destination buffer for the data. The caller is
+                                 responsible for either having implicit or explicit ownership of the buffer.
+
+  @retval EFI_SUCCESS            The read request was queued if Event is not NULL.
+                                 The data was read correctly from the device if the Event is NULL.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the read operation.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER  The read request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES   The request could not be queued due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  USB_MASS_DEVICE     *UsbMass;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return UsbMassReadBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  if (BufferSize == 0) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return UsbMassQueueBlockIo2Request (UsbMass, MediaId, Lba, Token, BufferSize, Buffer, FALSE);
+}
+
+/**
+  Writes a specified number of blocks to the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx(). If Token
+  or Token->Event is NULL, the blocks are written before returning. Otherwise
+  the request is queued, and Token->Event is signaled once it is completed.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the write request is for.
+  @param  Lba                    The starting logical block address to be written.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 Pointer to the source buffer for the data.
+
+  @retval EFI_SUCCESS            The write request was queued if Event is not NULL.
+                                 The data was written correctly to the device if the Event is NULL.
+  @retval EFI_WRITE_PROTECTED    The device cannot be written to.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the write operation.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic
+                                 block size of the device.
+  @retval EFI_INVALID_PARAMETER  The write request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES   The request could not be queued due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  USB_MASS_DEVICE     *UsbMass;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return UsbMassWriteBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  if (BufferSize == 0) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return UsbMassQueueBlockIo2Request (UsbMass, MediaId, Lba, Token, BufferSize, Buffer, TRUE);
+}
+
+/**
+  Flushes all modified data to a physical block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  USB mass storage device doesn't support write cache, so the token
+  is signaled once the requests queued before it are completed.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  Token                  A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS            All outstanding data were written correctly to the device.
+  @retval EFI_OUT_OF_RESOURCES   The request could not be queued due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  USB_MASS_DEVICE     *UsbMass;
+  EFI_TPL             OldTpl;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    //
+    // Blocking requests are done once they return, so only the queued
+    // requests need to be drained. The drain runs at the TPL of the
+    // BlockIo2Timer, which otherwise could execute a later request in
+    // between and signal a queued flush before an earlier write is done.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+    UsbMassExecuteBlockIo2Requests (NULL, UsbMass);
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  if (IsListEmpty (&UsbMass->BlockIo2Queue)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return UsbMassQueueBlockIo2Request (UsbMass, 0, 0, Token, 0, NULL, TRUE);
+}
+
 /**
   Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
 
@@ -501,10 +855,27 @@ UsbMassInitMultiLun (
     UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
     UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
     UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+    UsbMass->BlockIo2.Media       = &UsbMass->BlockIoMedia;
+    UsbMass->BlockIo2.Reset       = UsbMassResetEx;
+    UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+    UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+    UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
     UsbMass->OpticalStorage       = FALSE;
     UsbMass->Transport            = Transport;
     UsbMass->Context              = Context;
     UsbMass->Lun                  = Index;
+    InitializeListHead (&UsbMass->BlockIo2Queue);
+
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    UsbMassExecuteBlockIo2Requests,
+                    UsbMass,
+                    &UsbMass->BlockIo2Timer
+                    );
+    if (EFI_ERROR (Status)) {
+      goto ON_ERROR;
+    }
     
     //
     // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -556,6 +927,8 @@ UsbMassInitMultiLun (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -586,6 +959,8 @@ UsbMassInitMultiLun (
              UsbMass->DevicePath,
              &gEfiBlockIoProtocolGuid,
              &UsbMass->BlockIo,
+             &gEfiBlockIo2ProtocolGuid,
+             &UsbMass->BlockIo2,
              &gEfiDiskInfoProtocolGuid,
              &UsbMass->DiskInfo,
              NULL
@@ -600,6 +975,9 @@ UsbMassInitMultiLun (
 
 ON_ERROR:
   if (UsbMass != NULL) {
+    if (UsbMass->BlockIo2Timer != NULL) {
+      gBS->CloseEvent (UsbMass->BlockIo2Timer);
+    }
     if (UsbMass->DevicePath != NULL) {
       FreePool (UsbMass->DevicePath);
     }
@@ -674,10 +1052,27 @@ UsbMassInitNonLun (
   UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
   UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
   UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+  UsbMass->BlockIo2.Media       = &UsbMass->BlockIoMedia;
+  UsbMass->BlockIo2.Reset       = UsbMassResetEx;
+  UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+  UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+  UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
   UsbMass->OpticalStorage       = FALSE;
   UsbMass->Transport            = Transport;
   UsbMass->Context              = Context;
-  
+  InitializeListHead (&UsbMass->BlockIo2Queue);
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  UsbMassExecuteBlockIo2Requests,
+                  UsbMass,
+                  &UsbMass->BlockIo2Timer
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
   //
   // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
   //
@@ -705,6 +1100,8 @@ UsbMassInitNonLun (
                   &Controller,
                   &gEfiBlockIoProtocolGuid,
                   &UsbMass->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &UsbMass->BlockIo2,
                   &gEfiDiskInfoProtocolGuid,
                   &UsbMass->DiskInfo,
                   NULL
@@ -717,6 +1114,9 @@ UsbMassInitNonLun (
 
 ON_ERROR:
   if (UsbMass != NULL) {
+    if (UsbMass->BlockIo2Timer != NULL) {
+      gBS->CloseEvent (UsbMass->BlockIo2Timer);
+    }
     FreePool (UsbMass);
   }
   if (UsbIo != NULL) {
@@ -1012,6 +1412,8 @@ USBMassDriverBindingStop (
                     Controller,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -1027,6 +1429,9 @@ USBMassDriverBindingStop (
           Controller
           );
   
+    UsbMassAbortBlockIo2Requests (UsbMass);
+    gBS->CloseEvent (UsbMass->BlockIo2Timer);
+
     UsbMass->Transport->CleanUp (UsbMass->Context);
     FreePool (UsbMass);
     
@@ -1072,6 +1477,8 @@ USBMassDriverBindingStop (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -1096,6 +1503,9 @@ USBMassDriverBindingStop (
       //
       // Succeed to stop this multi-lun handle, so go on with next child.
       //
+      UsbMassAbortBlockIo2Requests (UsbMass);
+      gBS->CloseEvent (UsbMass->BlockIo2Timer);
+
       if (((Index + 1) == NumberOfChildren) && AllChildrenStopped) {
         UsbMass->Transport->CleanUp (UsbMass->Context);
       }
@@ -10,8 +10,11 @@
 
   Step #2 - Dispatch. Remove driver from the mScheduledQueue and load and
             start it. After mScheduledQueue is drained check the
-            mDiscoveredList to see if any item has a Depex that is ready to
-            be placed on the mScheduledQueue.
+            mDepexWakeList to see if any item has a Depex that is ready to
+            be placed on the mScheduledQueue. A driver is put on the
+            mDepexWakeList when it is discovered or requested, and again
+            each time a protocol its Depex pushes is installed, so Depex
+            that can not have changed are not evaluated again.
 
   Step #3 - Adding to the mScheduledQueue requires that you process Before
             and After dependencies. This is done recursively as the call to add
@@ -51,13 +54,44 @@ LIST_ENTRY  mDiscoveredList = INITIALIZE_LIST_HEAD_VARIABLE (mDiscoveredList);
 //
 LIST_ENTRY  mScheduledQueue = INITIALIZE_LIST_HEAD_VARIABLE (mScheduledQueue);
 
+//
+// Drivers whose Depex has to be evaluated by the next dispatcher pass, in
+// mDiscoveredList order. List of EFI_CORE_DRIVER_ENTRY.
+//
+LIST_ENTRY  mDepexWakeList = INITIALIZE_LIST_HEAD_VARIABLE (mDepexWakeList);
+
+//
+// Drivers with a BEFORE or AFTER Depex, in mDiscoveredList order.
+// List of EFI_CORE_DRIVER_ENTRY.
+//
+LIST_ENTRY  mBeforeAfterList = INITIALIZE_LIST_HEAD_VARIABLE (mBeforeAfterList);
+
+//
+// Number of drivers added to the mDiscoveredList.
+//
+UINTN       mDiscoveredCount = 0;
+
+//
+// DEPEX_WATCH - records that the Depex of a driver pushes a protocol GUID.
+// Watches are hashed by GUID into mDepexWatchHash and never freed.
+//
+#define DEPEX_WATCH_HASH_SIZE   128
+
+typedef struct _DEPEX_WATCH {
+  struct _DEPEX_WATCH             *Next;
+  EFI_GUID                        *Protocol;
+  EFI_CORE_DRIVER_ENTRY           *DriverEntry;
+} DEPEX_WATCH;
+
+DEPEX_WATCH *mDepexWatchHash[DEPEX_WATCH_HASH_SIZE];
+
 //
 // List of handles who's Fv's have been parsed and added to the mFwDriverList.
 //
 LIST_ENTRY  mFvHandleList = INITIALIZE_LIST_HEAD_VARIABLE (mFvHandleList);           // list of KNOWN_HANDLE
 
 //
-// Lock for mDiscoveredList, mScheduledQueue, gDispatcherRunning.
+// Lock for mDiscoveredList, mScheduledQueue, mDepexWakeList, gDispatcherRunning.
 //
 EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 
@@ -229,6 +263,163 @@ CoreReleaseDispatcherLock (
 }
 
 
+/**
+  Computes the mDepexWatchHash bucket of a protocol GUID. Depex GUIDs are
+  not aligned.
+
+  @param  Protocol              The GUID to hash.
+
+  @return Index into mDepexWatchHash.
+
+**/
+UINTN
+DepexWatchHashIndex (
+  IN  EFI_GUID    *Protocol
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((UINT32 *) Protocol) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 1) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 2) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return (UINTN) Hash & (DEPEX_WATCH_HASH_SIZE - 1);
+}
+
+
+/**
+  Insert DriverEntry onto a list that is kept in mDiscoveredList order.
+
+  @param  List                  The list to insert on.
+  @param  Entry                 The link of DriverEntry for List.
+  @param  DriverEntry           The driver to insert.
+
+**/
+VOID
+CoreInsertInDiscoveredOrder (
+  IN  LIST_ENTRY              *List,
+  IN  LIST_ENTRY              *Entry,
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  LIST_ENTRY            *Link;
+  EFI_CORE_DRIVER_ENTRY *Other;
+  UINTN                 Offset;
+
+  //
+  // Drivers are normally woken in discovery order, so search from the tail.
+  //
+  Offset = (UINTN) Entry - (UINTN) DriverEntry;
+  for (Link = List->BackLink; Link != List; Link = Link->BackLink) {
+    Other = (EFI_CORE_DRIVER_ENTRY *) ((UINTN) Link - Offset);
+    if (Other->Order < DriverEntry->Order) {
+      break;
+    }
+  }
+  InsertHeadList (Link, Entry);
+}
+
+
+/**
+  Put DriverEntry on the mDepexWakeList unless it is already on it.
+  The mDispatcherLock must be owned.
+
+  @param  DriverEntry           The driver whose Depex must be evaluated again.
+
+**/
+VOID
+CoreWakeDriver (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  ASSERT_LOCKED (&mDispatcherLock);
+
+  if (DriverEntry->WakeLink.ForwardLink == NULL) {
+    CoreInsertInDiscoveredOrder (&mDepexWakeList, &DriverEntry->WakeLink, DriverEntry);
+  }
+}
+
+
+/**
+  Add a watch to mDepexWatchHash for every protocol GUID the Depex of
+  DriverEntry pushes. BEFORE, AFTER and malformed Depex are not indexed.
+
+  @param  DriverEntry           The driver whose Depex was just read.
+
+**/
+VOID
+CoreWatchDepexProtocols (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  UINT8       *Iterator;
+  UINT8       *End;
+  DEPEX_WATCH *Watch;
+  UINTN       Index;
+
+  if (DriverEntry->Depex == NULL || DriverEntry->Before || DriverEntry->After) {
+    return;
+  }
+
+  Iterator = DriverEntry->Depex;
+  End      = Iterator + DriverEntry->DepexSize;
+  while (Iterator < End && *Iterator != EFI_DEP_END) {
+    if (*Iterator == EFI_DEP_PUSH) {
+      if (Iterator + 1 + sizeof (EFI_GUID) > End) {
+        break;
+      }
+      Watch = AllocatePool (sizeof (DEPEX_WATCH));
+      ASSERT (Watch != NULL);
+      if (Watch == NULL) {
+        break;
+      }
+      Watch->Protocol    = (EFI_GUID *) (Iterator + 1);
+      Watch->DriverEntry = DriverEntry;
+
+      Index = DepexWatchHashIndex (Watch->Protocol);
+      CoreAcquireDispatcherLock ();
+      Watch->Next            = mDepexWatchHash[Index];
+      mDepexWatchHash[Index] = Watch;
+      CoreReleaseDispatcherLock ();
+
+      Iterator += sizeof (EFI_GUID);
+    } else if (*Iterator > EFI_DEP_SOR) {
+      break;
+    }
+    Iterator++;
+  }
+}
+
+
+/**
+  Marks every Dependent driver whose dependency expression pushes Protocol
+  for re-evaluation by the next dispatcher pass. Called when an interface of
+  Protocol is installed, and when one is uninstalled, which can satisfy a
+  dependency expression that applies NOT to the protocol.
+
+  @param  Protocol              The GUID of the protocol that was installed
+                                or uninstalled.
+
+**/
+VOID
+CoreWakeDriversOnProtocol (
+  IN  EFI_GUID                *Protocol
+  )
+{
+  DEPEX_WATCH *Watch;
+
+  CoreAcquireDispatcherLock ();
+  for (Watch = mDepexWatchHash[DepexWatchHashIndex (Protocol)]; Watch != NULL; Watch = Watch->Next) {
+    if (Watch->DriverEntry->Dependent && CompareGuid (Watch->Protocol, Protocol)) {
+      CoreWakeDriver (Watch->DriverEntry);
+    }
+  }
+  CoreReleaseDispatcherLock ();
+}
+
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -288,6 +479,13 @@ CoreGetDepexSectionAndPreProccess (
     //
     CorePreProcessDepex (DriverEntry);
     DriverEntry->DepexProtocolError = FALSE;
+
+    CoreWatchDepexProtocols (DriverEntry);
+    if (DriverEntry->Before || DriverEntry->After) {
+      CoreAcquireDispatcherLock ();
+      CoreInsertInDiscoveredOrder (&mBeforeAfterList, &DriverEntry->BeforeAfterLink, DriverEntry);
+      CoreReleaseDispatcherLock ();
+    }
   }
 
   return Status;
@@ -332,6 +530,7 @@ CoreSchedule (
       CoreAcquireDispatcherLock ();
       DriverEntry->Unrequested  = FALSE;
       DriverEntry->Dependent    = TRUE;
+      CoreWakeDriver (DriverEntry);
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -434,6 +633,7 @@ CoreDispatcher (
   EFI_STATUS                      Status;
   EFI_STATUS                      ReturnStatus;
   LIST_ENTRY                      *Link;
+  LIST_ENTRY                      WakeList;
   EFI_CORE_DRIVER_ENTRY           *DriverEntry;
   BOOLEAN                         ReadyToRun;
   EFI_EVENT                       DxeDispatchEvent;
@@ -568,11 +768,29 @@ CoreDispatcher (
     }
 
     //
-    // Search DriverList for items to place on Scheduled Queue
+    // Search the woken drivers for items to place on Scheduled Queue. Any other
+    // Dependent driver evaluated to FALSE before and none of the protocols its
+    // Depex pushes has been installed since. Take the woken drivers off
+    // mDepexWakeList first, so that protocols installed while the Depex are
+    // being evaluated wake them again.
     //
+    InitializeListHead (&WakeList);
+    CoreAcquireDispatcherLock ();
+    while (!IsListEmpty (&mDepexWakeList)) {
+      Link = mDepexWakeList.ForwardLink;
+      RemoveEntryList (Link);
+      InsertTailList (&WakeList, Link);
+    }
+    CoreReleaseDispatcherLock ();
+
     ReadyToRun = FALSE;
-    for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-      DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    while (!IsListEmpty (&WakeList)) {
+      DriverEntry = CR (WakeList.ForwardLink, EFI_CORE_DRIVER_ENTRY, WakeLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+
+      CoreAcquireDispatcherLock ();
+      RemoveEntryList (&DriverEntry->WakeLink);
+      DriverEntry->WakeLink.ForwardLink = NULL;
+      CoreReleaseDispatcherLock ();
 
       if (DriverEntry->DepexProtocolError){
         //
@@ -585,6 +803,7 @@ CoreDispatcher (
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
+          continue;
         }
       } else {
         if (DriverEntry->Unrequested) {
@@ -593,6 +812,18 @@ CoreDispatcher (
           DEBUG ((DEBUG_DISPATCH, "  RESULT = FALSE\n"));
         }
       }
+
+      //
+      // A Depex that could not be read yet, and the implied Depex of a driver
+      // without one, do not depend on protocols in the watch index, so these
+      // drivers are evaluated on every pass.
+      //
+      if (DriverEntry->DepexProtocolError ||
+          (DriverEntry->Dependent && DriverEntry->Depex == NULL)) {
+        CoreAcquireDispatcherLock ();
+        CoreWakeDriver (DriverEntry);
+        CoreReleaseDispatcherLock ();
+      }
     }
   } while (ReadyToRun);
 
@@ -629,8 +860,8 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   //
   // Process Before Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+  for (Link = mBeforeAfterList.ForwardLink; Link != &mBeforeAfterList; Link = Link->ForwardLink) {
+    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, BeforeAfterLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
     if (DriverEntry->Before && DriverEntry->Dependent && DriverEntry != InsertedDriverEntry) {
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
       DEBUG ((DEBUG_DISPATCH, "  BEFORE FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
@@ -660,8 +891,8 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   //
   // Process After Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+  for (Link = mBeforeAfterList.ForwardLink; Link != &mBeforeAfterList; Link = Link->ForwardLink) {
+    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, BeforeAfterLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
     if (DriverEntry->After && DriverEntry->Dependent && DriverEntry != InsertedDriverEntry) {
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
       DEBUG ((DEBUG_DISPATCH, "  AFTER FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
@@ -906,12 +1137,14 @@ CoreAddToDriverList (
   DriverEntry->FvHandle         = FvHandle;
   DriverEntry->Fv               = Fv;
   DriverEntry->FvFileDevicePath = CoreFvToDevicePath (Fv, FvHandle, DriverName);
+  DriverEntry->Order            = mDiscoveredCount++;
 
   CoreGetDepexSectionAndPreProccess (DriverEntry);
 
   CoreAcquireDispatcherLock ();
 
   InsertTailList (&mDiscoveredList, &DriverEntry->Link);
+  CoreWakeDriver (DriverEntry);
 
   CoreReleaseDispatcherLock ();
 
@@ -53,6 +53,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/TcgService.h>
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
+#include <Protocol/DeferredStart.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -67,6 +68,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Guid/EventExitBootServiceFailed.h>
 #include <Guid/LoadModuleAtFixedAddress.h>
 #include <Guid/IdleLoopEvent.h>
+#include <Guid/HobIndex.h>
+#include <Guid/TimerStatistics.h>
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -147,6 +150,10 @@ typedef struct {
 
   LIST_ENTRY                      ScheduledLink;    // mScheduledQueue
 
+  LIST_ENTRY                      WakeLink;         // mDepexWakeList
+  LIST_ENTRY                      BeforeAfterLink;  // mBeforeAfterList
+  UINTN                           Order;            // Position on mDiscoveredList
+
   EFI_HANDLE                      FvHandle;
   EFI_GUID                        FileName;
   EFI_DEVICE_PATH_PROTOCOL        *FvFileDevicePath;
@@ -197,6 +204,7 @@ extern EFI_DXE_SERVICES                         *gDxeCoreDS;
 extern EFI_HANDLE                               gDxeCoreImageHandle;
 
 extern EFI_DECOMPRESS_PROTOCOL                  gEfiDecompress;
+extern EFI_DEFERRED_START_PROTOCOL              gEfiDeferredStart;
 
 extern EFI_RUNTIME_ARCH_PROTOCOL                *gRuntime;
 extern EFI_CPU_ARCH_PROTOCOL                    *gCpu;
@@ -214,6 +222,7 @@ extern EFI_GUID                                 *gDxeCoreFileName;
 extern EFI_LOADED_IMAGE_PROTOCOL                *gDxeCoreLoadedImage;
 
 extern EFI_MEMORY_TYPE_INFORMATION              gMemoryTypeInformation[EfiMaxMemoryType + 1];
+extern TIMER_STATISTICS                         gTimerStatistics;
 
 extern BOOLEAN                                  gDispatcherRunning;
 extern EFI_RUNTIME_ARCH_PROTOCOL                gRuntimeTemplate;
@@ -414,6 +423,22 @@ CoreInitializeDispatcher (
   );
 
 
+/**
+  Marks every Dependent driver whose dependency expression pushes Protocol
+  for re-evaluation by the next dispatcher pass. Called when an interface of
+  Protocol is installed, and when one is uninstalled, which can satisfy a
+  dependency expression that applies NOT to the protocol.
+
+  @param  Protocol              The GUID of the protocol that was installed
+                                or uninstalled.
+
+**/
+VOID
+CoreWakeDriversOnProtocol (
+  IN  EFI_GUID                *Protocol
+  );
+
+
 /**
   This is the POSTFIX version of the dependency evaluator.  This code does
   not need to handle Before or After, as it is not valid to call this
@@ -523,6 +548,19 @@ CoreInstallConfigurationTable (
   );
 
 
+/**
+  Builds the index of the GUID extension HOBs in the HOB list and installs it
+  into the EFI System Table's Configuration Table.
+
+  @param  HobStart       The start of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndex (
+  IN VOID   *HobStart
+  );
+
+
 
 /**
   Raise the task priority level to the new level.
@@ -1157,6 +1195,19 @@ CoreDisconnectController (
   );
 
 
+/**
+  Print the number of Supported() calls made to each driver binding by
+  ConnectController(), how many of them returned EFI_UNSUPPORTED, how many
+  were answered from the cache of negative results, and the time spent in
+  them.
+
+**/
+VOID
+CoreDumpSupportedStatistics (
+  VOID
+  );
+
+
 
 /**
   Allocates pages from the memory map.
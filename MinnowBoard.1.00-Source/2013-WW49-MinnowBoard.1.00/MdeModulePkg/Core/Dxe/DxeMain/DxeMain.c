@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // DXE Core Global Variables for Protocols from PEI
 //
 EFI_HANDLE                                mDecompressHandle = NULL;
+EFI_HANDLE                                mDeferredStartHandle = NULL;
 
 //
 // DXE Core globals for Architecture Protocols
@@ -303,12 +304,24 @@ DxeMain (
   Status = CoreInstallConfigurationTable (&gEfiHobListGuid, HobStart);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Install the index of the GUIDed HOBs, so that drivers looking them up do
+  // not have to walk the whole HOB list
+  //
+  CoreInstallHobIndex (HobStart);
+
   //
   // Install Memory Type Information Table into the EFI System Tables's Configuration Table
   //
   Status = CoreInstallConfigurationTable (&gEfiMemoryTypeInformationGuid, &gMemoryTypeInformation);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Install the timer event statistics into the EFI System Tables's Configuration Table
+  //
+  Status = CoreInstallConfigurationTable (&gTimerStatisticsGuid, &gTimerStatistics);
+  ASSERT_EFI_ERROR (Status);
+
   //
   // If Loading modules At fixed address feature is enabled, install Load moduels at fixed address
   // Configuration Table so that user could easily to retrieve the top address to load Dxe and PEI
@@ -389,6 +402,17 @@ DxeMain (
              );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Publish the Deferred Start protocol so that drivers can finish their
+  // Start() from timer events instead of stalling
+  //
+  Status = CoreInstallMultipleProtocolInterfaces (
+             &mDeferredStartHandle,
+             &gEfiDeferredStartProtocolGuid,        &gEfiDeferredStart,
+             NULL
+             );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Register for the GUIDs of the Architectural Protocols, so the rest of the
   // EFI Boot Services and EFI Runtime Services tables can be filled in.
@@ -686,6 +710,10 @@ CoreExitBootServices (
 {
   EFI_STATUS                Status;
 
+  DEBUG_CODE (
+    CoreDumpSupportedStatistics ();
+  );
+
   //
   // Disable Timer
   //
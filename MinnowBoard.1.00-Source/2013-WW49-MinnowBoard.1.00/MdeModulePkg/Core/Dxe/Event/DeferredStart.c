@@ -0,0 +1,244 @@
+/** @file
+  Deferred Start Protocol.
+
+  Every continuation is a one-shot timer event whose notify function runs the
+  continuation and then frees the event. A count of outstanding continuations
+  lets WaitForContinuations() tell when all deferred work has finished.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+#include "Event.h"
+
+typedef struct {
+  EFI_EVENT                        Event;
+  EFI_DEFERRED_START_CONTINUATION  Continuation;
+  VOID                             *Context;
+} DEFERRED_START_ENTRY;
+
+EFI_STATUS
+EFIAPI
+CoreDeferredStartPost (
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Delay,
+  IN EFI_DEFERRED_START_CONTINUATION  Continuation,
+  IN VOID                             *Context    OPTIONAL
+  );
+
+EFI_STATUS
+EFIAPI
+CoreDeferredStartWait (
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Timeout
+  );
+
+EFI_DEFERRED_START_PROTOCOL  gEfiDeferredStart = {
+  CoreDeferredStartPost,
+  CoreDeferredStartWait
+};
+
+//
+// Continuations posted but not yet run, and the event signalled each time the
+// count drops to zero. Both are only changed at TPL_NOTIFY.
+//
+UINTN      mDeferredStartPending   = 0;
+EFI_EVENT  mDeferredStartIdleEvent = NULL;
+
+/**
+  Run a continuation whose delay has passed.
+
+  @param  Event                 The timer event of the continuation.
+  @param  Context               The DEFERRED_START_ENTRY of the continuation.
+
+**/
+VOID
+EFIAPI
+CoreDeferredStartNotify (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  DEFERRED_START_ENTRY  *Entry;
+  EFI_TPL               OldTpl;
+
+  Entry = (DEFERRED_START_ENTRY *) Context;
+  CoreCloseEvent (Entry->Event);
+
+  Entry->Continuation (Entry->Context);
+  CoreFreePool (Entry);
+
+  //
+  // Drop the count only after the continuation has run, so that one which
+  // posts the next step of its work never lets the count touch zero.
+  //
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  ASSERT (mDeferredStartPending > 0);
+  mDeferredStartPending--;
+  if (mDeferredStartPending == 0 && mDeferredStartIdleEvent != NULL) {
+    CoreSignalEvent (mDeferredStartIdleEvent);
+  }
+  CoreRestoreTpl (OldTpl);
+}
+
+/**
+  Arrange for a continuation to run once a delay has passed.
+
+  @param  This          The protocol instance pointer.
+  @param  Delay         The least time, in 100ns units, before Continuation runs.
+  @param  Continuation  The function to run.
+  @param  Context       Passed to Continuation.
+
+  @retval EFI_SUCCESS            The continuation was posted.
+  @retval EFI_INVALID_PARAMETER  Continuation is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources available to
+                                 post the continuation.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreDeferredStartPost (
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Delay,
+  IN EFI_DEFERRED_START_CONTINUATION  Continuation,
+  IN VOID                             *Context    OPTIONAL
+  )
+{
+  DEFERRED_START_ENTRY  *Entry;
+  EFI_STATUS            Status;
+  EFI_TPL               OldTpl;
+
+  if (Continuation == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Entry = AllocatePool (sizeof (DEFERRED_START_ENTRY));
+  if (Entry == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Entry->Continuation = Continuation;
+  Entry->Context      = Context;
+
+  Status = CoreCreateEvent (
+             EVT_TIMER | EVT_NOTIFY_SIGNAL,
+             TPL_CALLBACK,
+             CoreDeferredStartNotify,
+             Entry,
+             &Entry->Event
+             );
+  if (EFI_ERROR (Status)) {
+    CoreFreePool (Entry);
+    return Status;
+  }
+
+  //
+  // Count the continuation before arming its timer, as the timer may fire as
+  // soon as the TPL drops.
+  //
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  mDeferredStartPending++;
+  CoreRestoreTpl (OldTpl);
+
+  //
+  // A relative timer of zero is checked at once, from within CoreSetTimer().
+  // Any other delay waits for the next timer interrupt, so the continuation
+  // cannot run before this call returns.
+  //
+  if (Delay == 0) {
+    Delay = 1;
+  }
+  Status = CoreSetTimer (Entry->Event, TimerRelative, Delay);
+  if (EFI_ERROR (Status)) {
+    OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+    mDeferredStartPending--;
+    if (mDeferredStartPending == 0 && mDeferredStartIdleEvent != NULL) {
+      CoreSignalEvent (mDeferredStartIdleEvent);
+    }
+    CoreRestoreTpl (OldTpl);
+
+    CoreCloseEvent (Entry->Event);
+    CoreFreePool (Entry);
+  }
+
+  return Status;
+}
+
+/**
+  Wait until no continuation is outstanding.
+
+  @param  This     The protocol instance pointer.
+  @param  Timeout  The longest time to wait, in 100ns units. Zero waits
+                   without limit.
+
+  @retval EFI_SUCCESS            No continuation is outstanding.
+  @retval EFI_TIMEOUT            Continuations were still outstanding when
+                                 Timeout expired.
+  @retval EFI_UNSUPPORTED        The caller does not run at TPL_APPLICATION.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreDeferredStartWait (
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Timeout
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   WaitList[2];
+  UINTN       NumberOfEvents;
+  UINTN       Index;
+
+  if (gEfiCurrentTpl != TPL_APPLICATION) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (mDeferredStartIdleEvent == NULL) {
+    Status = CoreCreateEvent (0, 0, NULL, NULL, &mDeferredStartIdleEvent);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Forget an idle signal from an earlier burst of work before looking at the
+  // count. If the count drops to zero after this point the event is signalled
+  // again and the wait below ends.
+  //
+  CoreCheckEvent (mDeferredStartIdleEvent);
+  if (mDeferredStartPending == 0) {
+    return EFI_SUCCESS;
+  }
+
+  WaitList[0]    = mDeferredStartIdleEvent;
+  NumberOfEvents = 1;
+  if (Timeout != 0) {
+    Status = CoreCreateEvent (EVT_TIMER, 0, NULL, NULL, &WaitList[1]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Status = CoreSetTimer (WaitList[1], TimerRelative, Timeout);
+    if (EFI_ERROR (Status)) {
+      CoreCloseEvent (WaitList[1]);
+      return Status;
+    }
+    NumberOfEvents = 2;
+  }
+
+  Status = CoreWaitForEvent (NumberOfEvents, WaitList, &Index);
+  if (NumberOfEvents == 2) {
+    CoreCloseEvent (WaitList[1]);
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return (Index == 0) ? EFI_SUCCESS : EFI_TIMEOUT;
+}
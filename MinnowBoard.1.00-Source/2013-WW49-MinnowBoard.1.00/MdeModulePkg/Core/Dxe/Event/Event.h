@@ -29,7 +29,15 @@ extern  UINTN                   gEventPending;
 ///
 typedef struct {
   LIST_ENTRY      Link;
+  ///
+  /// The requested trigger time, which periodic timers advance by Period
+  ///
   UINT64          TriggerTime;
+  ///
+  /// TriggerTime rounded up to the coalescing period, which is when the
+  /// timer is actually checked and fired
+  ///
+  UINT64          FireTime;
   UINT64          Period;
 } TIMER_EVENT_INFO;
 
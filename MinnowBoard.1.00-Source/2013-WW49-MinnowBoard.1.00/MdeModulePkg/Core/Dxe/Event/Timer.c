@@ -16,20 +16,94 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "DxeMain.h"
 #include "Event.h"
 
+//
+// The timer database is a hierarchical timer wheel.  Time is divided into
+// wheel ticks of 2^TIMER_WHEEL_TICK_SHIFT 100ns units.  Level 0 has one slot
+// per wheel tick; every higher level slot spans a whole rotation of the level
+// below it and is cascaded down into that level when the wheel reaches it.
+// Inserting and cancelling a timer are O(1).
+//
+#define TIMER_WHEEL_TICK_SHIFT    14
+#define TIMER_WHEEL_ROOT_BITS     8
+#define TIMER_WHEEL_ROOT_SIZE     (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_ROOT_MASK     (TIMER_WHEEL_ROOT_SIZE - 1)
+#define TIMER_WHEEL_LEVEL_BITS    6
+#define TIMER_WHEEL_LEVEL_SIZE    (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVEL_MASK    (TIMER_WHEEL_LEVEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS        4
+
+#define TIMER_WHEEL_LEVEL_SHIFT(Level)  (TIMER_WHEEL_ROOT_BITS + ((Level) * TIMER_WHEEL_LEVEL_BITS))
+
+///
+/// Largest distance, in wheel ticks, that the wheel can represent, which is
+/// 2^TIMER_WHEEL_LEVEL_SHIFT (TIMER_WHEEL_LEVELS) - 1.  Timers further out
+/// are parked in the last level and re-queued when it is cascaded.
+///
+#define TIMER_WHEEL_MAX_DELTA     0xFFFFFFFF
+
 //
 // Internal data
 //
 
-LIST_ENTRY       mEfiTimerList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+LIST_ENTRY       mEfiTimerWheelRoot[TIMER_WHEEL_ROOT_SIZE];
+LIST_ENTRY       mEfiTimerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE];
+UINT64           mEfiTimerWheelTick  = 0;
+UINTN            mEfiTimerCount      = 0;
+UINT64           mEfiTimerNextCheck  = (UINT64) -1;
+
 EFI_LOCK         mEfiTimerLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT        mEfiCheckTimerEvent = NULL;
 
 EFI_LOCK         mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64           mEfiSystemTime = 0;
 
+//
+// Timer fire latency statistics, published as a configuration table
+//
+TIMER_STATISTICS gTimerStatistics = { 0, 0, 0 };
+
 //
 // Timer functions
 //
+
+/**
+  Returns the current system time.
+
+  @return The current system time
+
+**/
+UINT64
+CoreCurrentSystemTime (
+  VOID
+  )
+{
+  UINT64          SystemTime;
+
+  CoreAcquireLock (&mEfiSystemTimeLock);
+  SystemTime = mEfiSystemTime;
+  CoreReleaseLock (&mEfiSystemTimeLock);
+
+  return SystemTime;
+}
+
+/**
+  Sets the earliest system time at which CoreTimerTick() has to run
+  CoreCheckTimers().  The value is read by the timer interrupt, so it is
+  updated under mEfiSystemTimeLock.
+
+  @param  NextCheck              The system time of the next check
+
+**/
+VOID
+CoreSetTimerNextCheck (
+  IN UINT64   NextCheck
+  )
+{
+  CoreAcquireLock (&mEfiSystemTimeLock);
+  mEfiTimerNextCheck = NextCheck;
+  CoreReleaseLock (&mEfiSystemTimeLock);
+}
+
 /**
   Inserts the timer event.
 
@@ -42,53 +116,254 @@ CoreInsertEventTimer (
   IN IEVENT   *Event
   )
 {
-  UINT64          TriggerTime;
-  LIST_ENTRY      *Link;
-  IEVENT          *Event2;
+  UINT64          FireTime;
+  UINT64          Expires;
+  UINT64          Delta;
+  UINTN           Level;
+  LIST_ENTRY      *Slot;
 
   ASSERT_LOCKED (&mEfiTimerLock);
 
   //
-  // Get the timer's trigger time
+  // An empty wheel can be moved to the current time for free.  This keeps
+  // CoreCheckTimers() from walking over ticks in which nothing was queued.
   //
-  TriggerTime = Event->Timer.TriggerTime;
+  if (mEfiTimerCount == 0) {
+    mEfiTimerWheelTick = RShiftU64 (CoreCurrentSystemTime (), TIMER_WHEEL_TICK_SHIFT);
+  }
 
   //
-  // Insert the timer into the timer database in assending sorted order
+  // Get the time the timer fires at
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  FireTime    = Event->Timer.FireTime;
+  Expires     = RShiftU64 (FireTime, TIMER_WHEEL_TICK_SHIFT);
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
+  //
+  // Timers that are already due go to the slot of the current wheel tick
+  //
+  if (Expires < mEfiTimerWheelTick) {
+    Expires = mEfiTimerWheelTick;
+  }
+  Delta = Expires - mEfiTimerWheelTick;
+
+  if (Delta < TIMER_WHEEL_ROOT_SIZE) {
+    Slot = &mEfiTimerWheelRoot[(UINTN) Expires & TIMER_WHEEL_ROOT_MASK];
+  } else {
+    if (Delta > TIMER_WHEEL_MAX_DELTA) {
+      Expires = mEfiTimerWheelTick + TIMER_WHEEL_MAX_DELTA;
+      Delta   = TIMER_WHEEL_MAX_DELTA;
+    }
+    for (Level = 0; Level < TIMER_WHEEL_LEVELS - 1; Level++) {
+      if (RShiftU64 (Delta, TIMER_WHEEL_LEVEL_SHIFT (Level + 1)) == 0) {
+        break;
+      }
+    }
+    Slot = &mEfiTimerWheel[Level][(UINTN) RShiftU64 (Expires, TIMER_WHEEL_LEVEL_SHIFT (Level)) & TIMER_WHEEL_LEVEL_MASK];
+  }
+
+  InsertTailList (Slot, &Event->Timer.Link);
+  mEfiTimerCount++;
+
+  if (FireTime < mEfiTimerNextCheck) {
+    CoreSetTimerNextCheck (FireTime);
+  }
+}
+
+/**
+  Removes a queued timer event from the timer wheel.
+
+  @param  Event                  Points to the internal structure of timer event
+                                 to be removed
+
+**/
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT   *Event
+  )
+{
+  ASSERT_LOCKED (&mEfiTimerLock);
+  ASSERT (mEfiTimerCount > 0);
+
+  RemoveEntryList (&Event->Timer.Link);
+  Event->Timer.Link.ForwardLink = NULL;
+  mEfiTimerCount--;
+}
+
+/**
+  Moves every timer of a higher level wheel slot down to the lower levels.
+
+  @param  Level                  The wheel level to cascade
+  @param  Index                  The slot of the level to cascade
+
+**/
+VOID
+CoreCascadeTimerWheel (
+  IN UINTN    Level,
+  IN UINTN    Index
+  )
+{
+  LIST_ENTRY      *Slot;
+  IEVENT          *Event;
+
+  //
+  // Re-queueing moves a timer to a lower level, or for a timer beyond the
+  // wheel horizon to another slot of this level, so the loop terminates.
+  //
+  Slot = &mEfiTimerWheel[Level][Index];
+  while (!IsListEmpty (Slot)) {
+    Event = CR (Slot->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+    CoreRemoveEventTimer (Event);
+    CoreInsertEventTimer (Event);
+  }
+}
+
+/**
+  Advances the timer wheel by one wheel tick and cascades the higher levels
+  when a lower level completes a rotation.
+
+**/
+VOID
+CoreAdvanceTimerWheel (
+  VOID
+  )
+{
+  UINTN           Level;
+  UINTN           Index;
+
+  mEfiTimerWheelTick++;
+
+  for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++) {
+    if ((mEfiTimerWheelTick & (LShiftU64 (1, TIMER_WHEEL_LEVEL_SHIFT (Level)) - 1)) != 0) {
       break;
     }
+    Index = (UINTN) RShiftU64 (mEfiTimerWheelTick, TIMER_WHEEL_LEVEL_SHIFT (Level)) & TIMER_WHEEL_LEVEL_MASK;
+    CoreCascadeTimerWheel (Level, Index);
+    if (Index != 0) {
+      break;
+    }
+  }
+}
+
+/**
+  Moves the timer wheel straight to a new wheel tick by re-queueing every
+  timer.  Used when the wheel has fallen so far behind the system time that
+  stepping through the missed wheel ticks would cost more than re-queueing.
+
+  @param  Tick                   The new wheel tick
+
+**/
+VOID
+CoreRebaseTimerWheel (
+  IN UINT64   Tick
+  )
+{
+  LIST_ENTRY      Pending;
+  LIST_ENTRY      *Slot;
+  IEVENT          *Event;
+  UINTN           Level;
+  UINTN           Index;
+
+  InitializeListHead (&Pending);
+  for (Index = 0; Index < TIMER_WHEEL_ROOT_SIZE; Index++) {
+    Slot = &mEfiTimerWheelRoot[Index];
+    while (!IsListEmpty (Slot)) {
+      Event = CR (Slot->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+      CoreRemoveEventTimer (Event);
+      InsertTailList (&Pending, &Event->Timer.Link);
+    }
+  }
+  for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++) {
+    for (Index = 0; Index < TIMER_WHEEL_LEVEL_SIZE; Index++) {
+      Slot = &mEfiTimerWheel[Level][Index];
+      while (!IsListEmpty (Slot)) {
+        Event = CR (Slot->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+        CoreRemoveEventTimer (Event);
+        InsertTailList (&Pending, &Event->Timer.Link);
+      }
+    }
   }
 
-  InsertTailList (Link, &Event->Timer.Link);
+  mEfiTimerWheelTick = Tick;
+  while (!IsListEmpty (&Pending)) {
+    Event = CR (Pending.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+    RemoveEntryList (&Event->Timer.Link);
+    CoreInsertEventTimer (Event);
+  }
 }
 
 /**
-  Returns the current system time.
+  Computes the earliest system time at which a queued timer may expire.
+  Only the level 0 slots are searched.  If they are all empty the next check
+  is the end of the current level 0 rotation, where level 1 is cascaded.
 
-  @return The current system time
+  @return The system time of the next check
 
 **/
 UINT64
-CoreCurrentSystemTime (
+CoreNextTimerCheck (
   VOID
   )
 {
-  UINT64          SystemTime;
+  UINT64          Tick;
+  UINT64          NextCheck;
+  LIST_ENTRY      *Slot;
+  LIST_ENTRY      *Link;
+  IEVENT          *Event;
 
-  CoreAcquireLock (&mEfiSystemTimeLock);
-  SystemTime = mEfiSystemTime;
-  CoreReleaseLock (&mEfiSystemTimeLock);
+  ASSERT_LOCKED (&mEfiTimerLock);
 
-  return SystemTime;
+  if (mEfiTimerCount == 0) {
+    return (UINT64) -1;
+  }
+
+  for (Tick = mEfiTimerWheelTick; ((UINTN) Tick & TIMER_WHEEL_ROOT_MASK) != 0 || Tick == mEfiTimerWheelTick; Tick++) {
+    Slot = &mEfiTimerWheelRoot[(UINTN) Tick & TIMER_WHEEL_ROOT_MASK];
+    if (!IsListEmpty (Slot)) {
+      NextCheck = (UINT64) -1;
+      for (Link = Slot->ForwardLink; Link != Slot; Link = Link->ForwardLink) {
+        Event = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+        if (Event->Timer.FireTime < NextCheck) {
+          NextCheck = Event->Timer.FireTime;
+        }
+      }
+      return NextCheck;
+    }
+  }
+
+  return LShiftU64 (Tick, TIMER_WHEEL_TICK_SHIFT);
+}
+
+/**
+  Rounds a timer's trigger time up to the coalescing period, so that timers
+  due at nearly the same time are fired by the same timer check.
+
+  @param  TriggerTime            The requested trigger time
+
+  @return The coalesced trigger time
+
+**/
+UINT64
+CoreCoalesceTriggerTime (
+  IN UINT64   TriggerTime
+  )
+{
+  UINT32          Period;
+  UINT32          Remainder;
+
+  Period = PcdGet32 (PcdDxeCoreTimerCoalescingPeriod);
+  if (Period == 0) {
+    return TriggerTime;
+  }
+
+  DivU64x32Remainder (TriggerTime, Period, &Remainder);
+  if (Remainder == 0 || TriggerTime > (UINT64) -1 - Period) {
+    return TriggerTime;
+  }
+  return TriggerTime - Remainder + Period;
 }
 
 /**
-  Checks the sorted timer list against the current system time.
+  Checks the timer wheel against the current system time.
   Signals any expired event timer.
 
   @param  CheckEvent             Not used
@@ -103,6 +378,11 @@ CoreCheckTimers (
   )
 {
   UINT64                  SystemTime;
+  UINT64                  Now;
+  UINT64                  Latency;
+  LIST_ENTRY              Expired;
+  LIST_ENTRY              *Slot;
+  LIST_ENTRY              *Link;
   IEVENT                  *Event;
 
   //
@@ -110,24 +390,68 @@ CoreCheckTimers (
   //
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
+  Now        = RShiftU64 (SystemTime, TIMER_WHEEL_TICK_SHIFT);
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  //
+  // The wheel is normally checked at least once per level 0 rotation.  If it
+  // fell further behind, re-queue all timers instead of stepping through the
+  // missed wheel ticks.
+  //
+  if (mEfiTimerWheelTick + TIMER_WHEEL_ROOT_SIZE < Now) {
+    CoreRebaseTimerWheel (Now);
+  }
 
-    //
-    // If this timer is not expired, then we're done
-    //
-    if (Event->Timer.TriggerTime > SystemTime) {
+  //
+  // Walk the wheel up to the current time, collecting the expired timers
+  //
+  InitializeListHead (&Expired);
+  while (mEfiTimerCount != 0) {
+    Slot = &mEfiTimerWheelRoot[(UINTN) mEfiTimerWheelTick & TIMER_WHEEL_ROOT_MASK];
+    for (Link = Slot->ForwardLink; Link != Slot; ) {
+      Event = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+      Link  = Link->ForwardLink;
+      if (Event->Timer.FireTime <= SystemTime) {
+        CoreRemoveEventTimer (Event);
+        InsertTailList (&Expired, &Event->Timer.Link);
+      }
+    }
+
+    if (mEfiTimerWheelTick >= Now) {
       break;
     }
+    ASSERT (IsListEmpty (Slot));
 
     //
-    // Remove this timer from the timer queue
+    // Empty level 0 slots before the end of the rotation need no cascade,
+    // so step over them directly.
     //
+    while (((UINTN) mEfiTimerWheelTick & TIMER_WHEEL_ROOT_MASK) != TIMER_WHEEL_ROOT_MASK &&
+           mEfiTimerWheelTick + 1 < Now &&
+           IsListEmpty (&mEfiTimerWheelRoot[(UINTN) (mEfiTimerWheelTick + 1) & TIMER_WHEEL_ROOT_MASK])) {
+      mEfiTimerWheelTick++;
+    }
+    CoreAdvanceTimerWheel ();
+  }
+
+  while (!IsListEmpty (&Expired)) {
+    Event = CR (Expired.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
 
+    //
+    // Remove this timer from the expired list
+    //
     RemoveEntryList (&Event->Timer.Link);
     Event->Timer.Link.ForwardLink = NULL;
 
+    //
+    // Update the fire latency statistics
+    //
+    Latency = SystemTime - Event->Timer.TriggerTime;
+    gTimerStatistics.FireCount++;
+    gTimerStatistics.LatencyTotal += Latency;
+    if (Latency > gTimerStatistics.LatencyMax) {
+      gTimerStatistics.LatencyMax = Latency;
+    }
+
     //
     // Signal it
     //
@@ -138,15 +462,19 @@ CoreCheckTimers (
     //
     if (Event->Timer.Period != 0) {
       //
-      // Compute the timers new trigger time
+      // Compute the timers new trigger time.  It is advanced from the
+      // requested trigger time rather than the coalesced one, so that the
+      // rounding does not accumulate from one period to the next.
       //
       Event->Timer.TriggerTime = Event->Timer.TriggerTime + Event->Timer.Period;
+      Event->Timer.FireTime    = CoreCoalesceTriggerTime (Event->Timer.TriggerTime);
 
       //
       // If that's before now, then reset the timer to start from now
       //
       if (Event->Timer.TriggerTime <= SystemTime) {
         Event->Timer.TriggerTime = SystemTime;
+        Event->Timer.FireTime    = SystemTime;
         CoreSignalEvent (mEfiCheckTimerEvent);
       }
 
@@ -157,6 +485,8 @@ CoreCheckTimers (
     }
   }
 
+  CoreSetTimerNextCheck (CoreNextTimerCheck ());
+
   CoreReleaseLock (&mEfiTimerLock);
 }
 
@@ -171,6 +501,17 @@ CoreInitializeTimer (
   )
 {
   EFI_STATUS  Status;
+  UINTN       Level;
+  UINTN       Index;
+
+  for (Index = 0; Index < TIMER_WHEEL_ROOT_SIZE; Index++) {
+    InitializeListHead (&mEfiTimerWheelRoot[Index]);
+  }
+  for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++) {
+    for (Index = 0; Index < TIMER_WHEEL_LEVEL_SIZE; Index++) {
+      InitializeListHead (&mEfiTimerWheel[Level][Index]);
+    }
+  }
 
   Status = CoreCreateEventInternal (
              EVT_NOTIFY_SIGNAL,
@@ -197,8 +538,6 @@ CoreTimerTick (
   IN UINT64   Duration
   )
 {
-  IEVENT          *Event;
-
   //
   // Check runtiem flag in case there are ticks while exiting boot services
   //
@@ -210,15 +549,11 @@ CoreTimerTick (
   mEfiSystemTime += Duration;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the earliest queued timer may have expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    if (Event->Timer.TriggerTime <= mEfiSystemTime) {
-      CoreSignalEvent (mEfiCheckTimerEvent);
-    }
+  if (mEfiTimerNextCheck <= mEfiSystemTime) {
+    CoreSignalEvent (mEfiCheckTimerEvent);
   }
 
   CoreReleaseLock (&mEfiSystemTimeLock);
@@ -271,11 +606,11 @@ CoreSetTimer (
   // If the timer is queued to the timer database, remove it
   //
   if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);
   }
 
   Event->Timer.TriggerTime = 0;
+  Event->Timer.FireTime = 0;
   Event->Timer.Period = 0;
 
   if (Type != TimerCancel) {
@@ -285,6 +620,10 @@ CoreSetTimer (
     }
 
     Event->Timer.TriggerTime = CoreCurrentSystemTime () + TriggerTime;
+    Event->Timer.FireTime    = Event->Timer.TriggerTime;
+    if (TriggerTime != 0) {
+      Event->Timer.FireTime  = CoreCoalesceTriggerTime (Event->Timer.TriggerTime);
+    }
     CoreInsertEventTimer (Event);
 
     if (TriggerTime == 0) {
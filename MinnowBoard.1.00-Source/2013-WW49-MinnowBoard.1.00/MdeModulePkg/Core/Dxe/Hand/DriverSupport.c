@@ -15,6 +15,259 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "DxeMain.h"
 #include "Handle.h"
 
+//
+// Number of entries in the cache of negative Supported() results, and of
+// buckets in the Supported() statistics hash.  Both must be a power of 2.
+//
+#define SUPPORTED_CACHE_SIZE            256
+#define SUPPORTED_STATISTICS_HASH_SIZE  64
+
+///
+/// SUPPORTED_CACHE_ENTRY - a driver binding that returned EFI_UNSUPPORTED for a
+/// controller, and the state of both when it did
+///
+typedef struct {
+  EFI_DRIVER_BINDING_PROTOCOL   *DriverBinding;
+  /// Handle Database Key of the driver binding handle, which tells a reused protocol instance apart
+  UINT64                        DriverBindingKey;
+  EFI_HANDLE                    ControllerHandle;
+  /// Summary of the protocols on the controller and of who has them open
+  UINT64                        ControllerState;
+} SUPPORTED_CACHE_ENTRY;
+
+///
+/// SUPPORTED_STATISTICS - Supported() calls made to one driver binding
+///
+typedef struct _SUPPORTED_STATISTICS {
+  /// Next SUPPORTED_STATISTICS in the same hash bucket
+  struct _SUPPORTED_STATISTICS  *NextHash;
+  EFI_DRIVER_BINDING_PROTOCOL   *DriverBinding;
+  EFI_HANDLE                    ImageHandle;
+  UINT64                        Calls;
+  UINT64                        Unsupported;
+  UINT64                        CacheHits;
+  /// Performance counter ticks spent in Supported()
+  UINT64                        Ticks;
+} SUPPORTED_STATISTICS;
+
+//
+// mSupportedCache       - Direct mapped cache of negative Supported() results
+// mSupportedStatistics  - Supported() statistics hashed by driver binding
+// mCounterCountsDown    - TRUE if the performance counter decrements
+//
+SUPPORTED_CACHE_ENTRY   mSupportedCache[SUPPORTED_CACHE_SIZE];
+SUPPORTED_STATISTICS    *mSupportedStatistics[SUPPORTED_STATISTICS_HASH_SIZE];
+BOOLEAN                 mCounterCountsDown;
+
+
+/**
+  Computes a summary of the state of a controller that a driver's Supported()
+  can depend on: the protocol interfaces on the handle, and the opens of them
+  that affect what OpenProtocol() returns.  The handle's Key tells a handle
+  apart from an earlier one at the same address.
+
+  @param  ControllerHandle       The handle of the controller
+
+  @return The controller state
+
+**/
+UINT64
+CoreGetControllerState (
+  IN EFI_HANDLE                 ControllerHandle
+  )
+{
+  IHANDLE             *Handle;
+  PROTOCOL_INTERFACE  *Prot;
+  OPEN_PROTOCOL_DATA  *OpenData;
+  LIST_ENTRY          *ProtLink;
+  LIST_ENTRY          *Link;
+  UINT64              State;
+
+  Handle = (IHANDLE *) ControllerHandle;
+
+  CoreAcquireProtocolLock ();
+
+  State = Handle->Key;
+  for (ProtLink = Handle->Protocols.ForwardLink; ProtLink != &Handle->Protocols; ProtLink = ProtLink->ForwardLink) {
+    Prot  = CR (ProtLink, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    State = MultU64x32 (State, 0x01000193) ^ (UINTN) Prot->Protocol;
+    State = MultU64x32 (State, 0x01000193) ^ (UINTN) Prot->Interface;
+    for (Link = Prot->OpenList.ForwardLink; Link != &Prot->OpenList; Link = Link->ForwardLink) {
+      OpenData = CR (Link, OPEN_PROTOCOL_DATA, Link, OPEN_PROTOCOL_DATA_SIGNATURE);
+      if ((OpenData->Attributes &
+          (EFI_OPEN_PROTOCOL_BY_HANDLE_PROTOCOL | EFI_OPEN_PROTOCOL_GET_PROTOCOL | EFI_OPEN_PROTOCOL_TEST_PROTOCOL)) != 0) {
+        continue;
+      }
+      State = MultU64x32 (State, 0x01000193) ^ (UINTN) OpenData->AgentHandle;
+      State = MultU64x32 (State, 0x01000193) ^ (UINTN) OpenData->ControllerHandle;
+      State = MultU64x32 (State, 0x01000193) ^ OpenData->Attributes;
+    }
+  }
+
+  CoreReleaseProtocolLock ();
+
+  return State;
+}
+
+
+/**
+  Finds the Supported() statistics of a driver binding, creating them on
+  first use.
+
+  @param  DriverBinding          The driver binding
+
+  @return The statistics, or NULL if there is not enough memory for them
+
+**/
+SUPPORTED_STATISTICS *
+CoreGetSupportedStatistics (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *DriverBinding
+  )
+{
+  SUPPORTED_STATISTICS  *Statistics;
+  UINTN                 Index;
+  UINT64                StartValue;
+  UINT64                EndValue;
+
+  Index = ((UINTN) DriverBinding >> 3) & (SUPPORTED_STATISTICS_HASH_SIZE - 1);
+  for (Statistics = mSupportedStatistics[Index]; Statistics != NULL; Statistics = Statistics->NextHash) {
+    if (Statistics->DriverBinding == DriverBinding && Statistics->ImageHandle == DriverBinding->ImageHandle) {
+      return Statistics;
+    }
+  }
+
+  Statistics = AllocateZeroPool (sizeof (SUPPORTED_STATISTICS));
+  if (Statistics == NULL) {
+    return NULL;
+  }
+
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  mCounterCountsDown = (BOOLEAN) (StartValue > EndValue);
+
+  Statistics->DriverBinding   = DriverBinding;
+  Statistics->ImageHandle     = DriverBinding->ImageHandle;
+  Statistics->NextHash        = mSupportedStatistics[Index];
+  mSupportedStatistics[Index] = Statistics;
+  return Statistics;
+}
+
+
+/**
+  Calls the Supported() service of a driver binding for a controller, unless
+  the driver binding returned EFI_UNSUPPORTED for the controller before and
+  neither has changed since.  Negative results are only cached for a NULL
+  RemainingDevicePath, as any other result depends on it.
+
+  @param  DriverBinding          The driver binding
+  @param  ControllerHandle       The handle of the controller
+  @param  RemainingDevicePath    The remaining device path to pass to Supported()
+  @param  ControllerState        The state of the controller from
+                                 CoreGetControllerState()
+
+  @return The status returned by Supported(), or EFI_UNSUPPORTED from the cache
+
+**/
+EFI_STATUS
+CoreDriverBindingSupported (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *DriverBinding,
+  IN EFI_HANDLE                   ControllerHandle,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath  OPTIONAL,
+  IN UINT64                       ControllerState
+  )
+{
+  EFI_STATUS             Status;
+  SUPPORTED_STATISTICS   *Statistics;
+  SUPPORTED_CACHE_ENTRY  *Entry;
+  UINT64                 DriverBindingKey;
+  UINT64                 StartTicks;
+  UINT64                 EndTicks;
+  UINTN                  Index;
+
+  Statistics       = CoreGetSupportedStatistics (DriverBinding);
+  Entry            = NULL;
+  DriverBindingKey = 0;
+
+  if (FeaturePcdGet (PcdDxeCoreSupportedCache) && RemainingDevicePath == NULL &&
+      !EFI_ERROR (CoreValidateHandle (DriverBinding->DriverBindingHandle))) {
+    DriverBindingKey = ((IHANDLE *) DriverBinding->DriverBindingHandle)->Key;
+    Index = (((UINTN) DriverBinding >> 3) ^ ((UINTN) ControllerHandle >> 3) * 31) & (SUPPORTED_CACHE_SIZE - 1);
+    Entry = &mSupportedCache[Index];
+    if (Entry->DriverBinding == DriverBinding && Entry->DriverBindingKey == DriverBindingKey &&
+        Entry->ControllerHandle == ControllerHandle && Entry->ControllerState == ControllerState) {
+      if (Statistics != NULL) {
+        Statistics->CacheHits++;
+      }
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  StartTicks = GetPerformanceCounter ();
+  PERF_START (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
+  Status = DriverBinding->Supported (
+                            DriverBinding,
+                            ControllerHandle,
+                            RemainingDevicePath
+                            );
+  PERF_END (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
+  EndTicks = GetPerformanceCounter ();
+
+  if (Statistics != NULL) {
+    Statistics->Calls++;
+    Statistics->Ticks += mCounterCountsDown ? StartTicks - EndTicks : EndTicks - StartTicks;
+    if (Status == EFI_UNSUPPORTED) {
+      Statistics->Unsupported++;
+    }
+  }
+
+  if (Entry != NULL && Status == EFI_UNSUPPORTED) {
+    Entry->DriverBinding    = DriverBinding;
+    Entry->DriverBindingKey = DriverBindingKey;
+    Entry->ControllerHandle = ControllerHandle;
+    Entry->ControllerState  = ControllerState;
+  }
+
+  return Status;
+}
+
+
+/**
+  Print the number of Supported() calls made to each driver binding by
+  ConnectController(), how many of them returned EFI_UNSUPPORTED, how many
+  were answered from the cache of negative results, and the time spent in
+  them.
+
+**/
+VOID
+CoreDumpSupportedStatistics (
+  VOID
+  )
+{
+  SUPPORTED_STATISTICS       *Statistics;
+  EFI_LOADED_IMAGE_PROTOCOL  *LoadedImage;
+  CHAR8                      *PdbPointer;
+  UINTN                      Index;
+
+  DEBUG ((DEBUG_INFO, "Driver binding Supported() calls     Unsupported   Cached   Time(us)\n"));
+  for (Index = 0; Index < SUPPORTED_STATISTICS_HASH_SIZE; Index++) {
+    for (Statistics = mSupportedStatistics[Index]; Statistics != NULL; Statistics = Statistics->NextHash) {
+      PdbPointer = NULL;
+      if (!EFI_ERROR (CoreHandleProtocol (Statistics->ImageHandle, &gEfiLoadedImageProtocolGuid, (VOID **) &LoadedImage))) {
+        PdbPointer = PeCoffLoaderGetPdbPointer (LoadedImage->ImageBase);
+      }
+      DEBUG ((
+        DEBUG_INFO,
+        "  %p %10ld %10ld %8ld %10ld %a\n",
+        Statistics->DriverBinding,
+        Statistics->Calls,
+        Statistics->Unsupported,
+        Statistics->CacheHits,
+        DivU64x32 (GetTimeInNanoSecond (Statistics->Ticks), 1000),
+        PdbPointer == NULL ? "" : PdbPointer
+        ));
+    }
+  }
+}
+
 
 //
 // Driver Support Functions
@@ -407,6 +660,7 @@ CoreConnectSingleController (
   UINTN                                      SortIndex;
   BOOLEAN                                    OneStarted;
   BOOLEAN                                    DriverFound;
+  UINT64                                     ControllerState;
 
   //
   // Initialize local variables
@@ -614,23 +868,32 @@ CoreConnectSingleController (
   OneStarted = FALSE;
   do {
 
+    //
+    // A driver's Start() may have removed the last protocol interface from
+    // ControllerHandle, and the handle is freed with it.
+    //
+    if (EFI_ERROR (CoreValidateHandle (ControllerHandle))) {
+      break;
+    }
+
     //
     // Loop through the sorted Driver Binding Protocol Instances in order, and see if
     // any of the Driver Binding Protocols support the controller specified by
     // ControllerHandle.
+    // The controller state is taken again on each pass, as starting a driver changes it.
     //
     DriverBinding = NULL;
     DriverFound = FALSE;
+    ControllerState = FeaturePcdGet (PcdDxeCoreSupportedCache) ? CoreGetControllerState (ControllerHandle) : 0;
     for (Index = 0; (Index < NumberOfSortedDriverBindingProtocols) && !DriverFound; Index++) {
       if (SortedDriverBindingProtocols[Index] != NULL) {
         DriverBinding = SortedDriverBindingProtocols[Index];
-        PERF_START (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
-        Status = DriverBinding->Supported(
-                                  DriverBinding,
-                                  ControllerHandle,
-                                  RemainingDevicePath
-                                  );
-        PERF_END (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
+        Status = CoreDriverBindingSupported (
+                   DriverBinding,
+                   ControllerHandle,
+                   RemainingDevicePath,
+                   ControllerState
+                   );
         if (!EFI_ERROR (Status)) {
           SortedDriverBindingProtocols[Index] = NULL;
           DriverFound = TRUE;
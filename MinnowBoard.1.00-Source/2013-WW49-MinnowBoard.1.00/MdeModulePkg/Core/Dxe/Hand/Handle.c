@@ -17,17 +17,127 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 
 //
-// mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// Number of buckets in the protocol GUID and handle hash tables.  Both must
+// be a power of 2.
+//
+#define PROTOCOL_HASH_SIZE    128
+#define HANDLE_HASH_SIZE      256
+
+//
+// mProtocolDatabase     - A list of all protocols in the system.
+// mProtocolHash         - mProtocolDatabase hashed by protocol GUID
 // gHandleList           - A list of all the handles in the system
+// mHandleHash           - gHandleList hashed by handle address, used to validate handles
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+PROTOCOL_ENTRY  *mProtocolHash[PROTOCOL_HASH_SIZE];
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
+IHANDLE         *mHandleHash[HANDLE_HASH_SIZE];
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
 
 
+/**
+  Computes the protocol hash bucket of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Index into mProtocolHash
+
+**/
+UINTN
+ProtocolHashIndex (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((UINT32 *) Protocol) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 1) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 2) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return (UINTN) Hash & (PROTOCOL_HASH_SIZE - 1);
+}
+
+
+/**
+  Computes the handle hash bucket of a handle.  Handles are pool
+  allocations, so the low address bits carry no information.
+
+  @param  UserHandle             The handle
+
+  @return Index into mHandleHash
+
+**/
+UINTN
+HandleHashIndex (
+  IN EFI_HANDLE   UserHandle
+  )
+{
+  UINTN   Hash;
+
+  Hash = (UINTN) UserHandle >> 4;
+  Hash ^= Hash >> 8;
+  return Hash & (HANDLE_HASH_SIZE - 1);
+}
+
+
+/**
+  Adds a newly created handle to gHandleList and to the handle hash.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandle (
+  IN IHANDLE    *Handle
+  )
+{
+  UINTN   Index;
+
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  InsertTailList (&gHandleList, &Handle->AllHandles);
+
+  Index = HandleHashIndex (Handle);
+  Handle->NextHash   = mHandleHash[Index];
+  mHandleHash[Index] = Handle;
+}
+
+
+/**
+  Removes a handle from gHandleList and from the handle hash.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandle (
+  IN IHANDLE    *Handle
+  )
+{
+  IHANDLE   **Link;
+
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  RemoveEntryList (&Handle->AllHandles);
+
+  for (Link = &mHandleHash[HandleHashIndex (Handle)]; *Link != NULL; Link = &(*Link)->NextHash) {
+    if (*Link == Handle) {
+      *Link = Handle->NextHash;
+      break;
+    }
+  }
+  Handle->NextHash = NULL;
+}
+
+
 
 /**
   Acquire lock on gProtocolDatabaseLock.
@@ -72,14 +182,33 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
+  EFI_STATUS          LockStatus;
 
-  Handle = (IHANDLE *)UserHandle;
-  if (Handle == NULL) {
+  if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
-  if (Handle->Signature != EFI_HANDLE_SIGNATURE) {
+
+  //
+  // Only handles present in the handle hash are valid.  UserHandle is never
+  // dereferenced, so stale or bogus pointers are rejected safely.  Callers
+  // may or may not already own the protocol database lock.
+  //
+  LockStatus = CoreAcquireLockOrFail (&gProtocolDatabaseLock);
+
+  for (Handle = mHandleHash[HandleHashIndex (UserHandle)]; Handle != NULL; Handle = Handle->NextHash) {
+    if (Handle == (IHANDLE *) UserHandle) {
+      break;
+    }
+  }
+
+  if (!EFI_ERROR (LockStatus)) {
+    CoreReleaseProtocolLock ();
+  }
+
+  if (Handle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
+  ASSERT_IS_HANDLE (Handle);
   return EFI_SUCCESS;
 }
 
@@ -101,29 +230,18 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
-  LIST_ENTRY          *Link;
-  PROTOCOL_ENTRY      *Item;
+  UINTN               Index;
   PROTOCOL_ENTRY      *ProtEntry;
 
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the GUID for the matching protocol entry
   //
-
-  ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
-       Link = Link->ForwardLink) {
-
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
-    if (CompareGuid (&Item->ProtocolID, Protocol)) {
-
-      //
-      // This is the protocol entry
-      //
-
-      ProtEntry = Item;
+  Index = ProtocolHashIndex (Protocol);
+  for (ProtEntry = mProtocolHash[Index]; ProtEntry != NULL; ProtEntry = ProtEntry->NextHash) {
+    ASSERT (ProtEntry->Signature == PROTOCOL_ENTRY_SIGNATURE);
+    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
       break;
     }
   }
@@ -145,9 +263,11 @@ CoreFindProtocolEntry (
       InitializeListHead (&ProtEntry->Notify);
 
       //
-      // Add it to protocol database
+      // Add it to protocol database and to its hash bucket
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      ProtEntry->NextHash  = mProtocolHash[Index];
+      mProtocolHash[Index] = ProtEntry;
     }
   }
 
@@ -427,7 +547,7 @@ CoreInstallProtocolInterfaceNotify (
     // Add this handle to the list global list of all handles
     // in the system
     //
-    InsertTailList (&gHandleList, &Handle->AllHandles);
+    CoreInsertHandle (Handle);
   }
 
   Status = CoreValidateHandle (Handle);
@@ -466,6 +586,11 @@ CoreInstallProtocolInterfaceNotify (
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
 
+  //
+  // Let the dispatcher re-evaluate the Depex of drivers waiting for this protocol
+  //
+  CoreWakeDriversOnProtocol (Protocol);
+
   //
   // Notify the notification list for this protocol
   //
@@ -782,14 +907,19 @@ CoreUninstallProtocolInterface (
     Prot->Signature = 0;
     CoreFreePool (Prot);
     Status = EFI_SUCCESS;
+
+    //
+    // Let the dispatcher re-evaluate the Depex of drivers that NOT this protocol
+    //
+    CoreWakeDriversOnProtocol (Protocol);
   }
 
   //
   // If there are no more handlers for the handle, free the handle
   //
   if (IsListEmpty (&Handle->Protocols)) {
+    CoreRemoveHandle (Handle);
     Handle->Signature = 0;
-    RemoveEntryList (&Handle->AllHandles);
     CoreFreePool (Handle);
   }
 
@@ -899,13 +1029,20 @@ CoreGetProtocolInterface (
 
   Handle = (IHANDLE *)UserHandle;
 
+  //
+  // Resolve the GUID once, then match protocol interfaces by entry
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
   //
   // Look at each protocol interface for a match
   //
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
     Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    if (Prot->Protocol == ProtEntry) {
       return Prot;
     }
   }
@@ -21,10 +21,12 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
-typedef struct {
+typedef struct _IHANDLE {
   UINTN               Signature;
   /// All handles list of IHANDLE
   LIST_ENTRY          AllHandles;
+  /// Next IHANDLE in the same handle validation hash bucket
+  struct _IHANDLE     *NextHash;
   /// List of PROTOCOL_INTERFACE's for this handle
   LIST_ENTRY          Protocols;      
   UINTN               LocateRequest;
@@ -41,10 +43,12 @@ typedef struct {
 /// database.  Each handler that supports this protocol is listed, along
 /// with a list of registered notifies.
 ///
-typedef struct {
+typedef struct _PROTOCOL_ENTRY {
   UINTN               Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY          AllEntries;  
+  /// Next PROTOCOL_ENTRY in the same protocol GUID hash bucket
+  struct _PROTOCOL_ENTRY  *NextHash;
   /// ID of the protocol
   EFI_GUID            ProtocolID;  
   /// All protocol interfaces
@@ -37,7 +37,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP  MEMORY_MAP;
+struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -48,7 +49,18 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
-} MEMORY_MAP;
+
+  //
+  // Every descriptor in gMemoryMap is also a node of a balanced (AVL) tree
+  // ordered by Start.  MaxFreeBytes caches the size of the largest
+  // EfiConventionalMemory descriptor in the subtree rooted at this node.
+  //
+  MEMORY_MAP      *Parent;
+  MEMORY_MAP      *Left;
+  MEMORY_MAP      *Right;
+  UINTN           Height;
+  UINT64          MaxFreeBytes;
+};
 
 //
 // Internal prototypes
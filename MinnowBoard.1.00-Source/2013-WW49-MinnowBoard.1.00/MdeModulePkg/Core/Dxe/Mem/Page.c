@@ -51,6 +51,10 @@ UINTN         mFreeMapStack = 0;
 ///
 LIST_ENTRY   mFreeMemoryMapEntryList = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
 BOOLEAN      mMemoryTypeInformationInitialized = FALSE;
+///
+/// Root of the address ordered tree over the descriptors in gMemoryMap
+///
+MEMORY_MAP   *mMemoryMapRoot = NULL;
 
 EFI_MEMORY_TYPE_STATISTICS mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
   { 0, MAX_ADDRESS, 0, 0, EfiMaxMemoryType, TRUE,  FALSE },  // EfiReservedMemoryType
@@ -126,6 +130,261 @@ CoreReleaseMemoryLock (
 
 
 
+/**
+  Internal function.  Recomputes the height and the largest free descriptor
+  size cached in a memory map tree node from the node and its children.
+
+  @param  Node                   The tree node to update
+
+**/
+VOID
+UpdateMemoryMapNode (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  UINTN   LeftHeight;
+  UINTN   RightHeight;
+  UINT64  MaxFreeBytes;
+
+  LeftHeight   = (Node->Left  == NULL) ? 0 : Node->Left->Height;
+  RightHeight  = (Node->Right == NULL) ? 0 : Node->Right->Height;
+  Node->Height = MAX (LeftHeight, RightHeight) + 1;
+
+  MaxFreeBytes = 0;
+  if (Node->Type == EfiConventionalMemory) {
+    MaxFreeBytes = Node->End - Node->Start + 1;
+  }
+  if (Node->Left != NULL && Node->Left->MaxFreeBytes > MaxFreeBytes) {
+    MaxFreeBytes = Node->Left->MaxFreeBytes;
+  }
+  if (Node->Right != NULL && Node->Right->MaxFreeBytes > MaxFreeBytes) {
+    MaxFreeBytes = Node->Right->MaxFreeBytes;
+  }
+  Node->MaxFreeBytes = MaxFreeBytes;
+}
+
+/**
+  Internal function.  Replaces a child link of a memory map tree node, or the
+  tree root if the node has no parent.
+
+  @param  Parent                 The parent of OldChild, or NULL for the root
+  @param  OldChild               The child being replaced
+  @param  NewChild               The node that takes the place of OldChild
+
+**/
+VOID
+ReplaceMemoryMapChild (
+  IN OUT MEMORY_MAP      *Parent,
+  IN     MEMORY_MAP      *OldChild,
+  IN OUT MEMORY_MAP      *NewChild
+  )
+{
+  if (Parent == NULL) {
+    mMemoryMapRoot = NewChild;
+  } else if (Parent->Left == OldChild) {
+    Parent->Left = NewChild;
+  } else {
+    Parent->Right = NewChild;
+  }
+
+  if (NewChild != NULL) {
+    NewChild->Parent = Parent;
+  }
+}
+
+/**
+  Internal function.  Rotates a memory map tree node to the left or right.
+
+  @param  Node                   The node to rotate down
+  @param  Left                   TRUE to rotate left, FALSE to rotate right
+
+  @return The node that took the place of Node
+
+**/
+MEMORY_MAP *
+RotateMemoryMapNode (
+  IN OUT MEMORY_MAP      *Node,
+  IN     BOOLEAN         Left
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot = Left ? Node->Right : Node->Left;
+  ReplaceMemoryMapChild (Node->Parent, Node, Pivot);
+  if (Left) {
+    Node->Right  = Pivot->Left;
+    Pivot->Left  = Node;
+    if (Node->Right != NULL) {
+      Node->Right->Parent = Node;
+    }
+  } else {
+    Node->Left   = Pivot->Right;
+    Pivot->Right = Node;
+    if (Node->Left != NULL) {
+      Node->Left->Parent = Node;
+    }
+  }
+  Node->Parent = Pivot;
+
+  UpdateMemoryMapNode (Node);
+  UpdateMemoryMapNode (Pivot);
+  return Pivot;
+}
+
+/**
+  Internal function.  Updates the cached data of a memory map tree node and of
+  all its ancestors, restoring the AVL balance on the way up.
+
+  @param  Node                   The lowest node whose subtree changed
+
+**/
+VOID
+RebalanceMemoryMapTree (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  INTN  Balance;
+
+  while (Node != NULL) {
+    UpdateMemoryMapNode (Node);
+    Balance = (INTN) ((Node->Left  == NULL) ? 0 : Node->Left->Height) -
+              (INTN) ((Node->Right == NULL) ? 0 : Node->Right->Height);
+    if (Balance > 1) {
+      if (Node->Left->Right != NULL &&
+          (Node->Left->Left == NULL || Node->Left->Left->Height < Node->Left->Right->Height)) {
+        RotateMemoryMapNode (Node->Left, TRUE);
+      }
+      Node = RotateMemoryMapNode (Node, FALSE);
+    } else if (Balance < -1) {
+      if (Node->Right->Left != NULL &&
+          (Node->Right->Right == NULL || Node->Right->Right->Height < Node->Right->Left->Height)) {
+        RotateMemoryMapNode (Node->Right, FALSE);
+      }
+      Node = RotateMemoryMapNode (Node, TRUE);
+    }
+    Node = Node->Parent;
+  }
+}
+
+/**
+  Internal function.  Finds the descriptor that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The descriptor whose range contains Address, or NULL if there is none
+
+**/
+MEMORY_MAP *
+LookupMemoryMapEntry (
+  IN UINT64              Address
+  )
+{
+  MEMORY_MAP  *Node;
+
+  Node = mMemoryMapRoot;
+  while (Node != NULL) {
+    if (Address < Node->Start) {
+      Node = Node->Left;
+    } else if (Address > Node->End) {
+      Node = Node->Right;
+    } else {
+      return Node;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Internal function.  Adds a descriptor entry to gMemoryMap and to the tree.
+  gMemoryMap is kept sorted by address.
+
+  @param  Entry                  The entry to add
+
+**/
+VOID
+InsertMemoryMapEntry (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Next;
+
+  Parent = NULL;
+  Next   = NULL;
+  Node   = mMemoryMapRoot;
+  while (Node != NULL) {
+    Parent = Node;
+    if (Entry->Start < Node->Start) {
+      Next = Node;
+      Node = Node->Left;
+    } else {
+      Node = Node->Right;
+    }
+  }
+
+  Entry->Left  = NULL;
+  Entry->Right = NULL;
+  UpdateMemoryMapNode (Entry);
+  Entry->Parent = Parent;
+  if (Parent == NULL) {
+    mMemoryMapRoot = Entry;
+  } else if (Entry->Start < Parent->Start) {
+    Parent->Left = Entry;
+  } else {
+    Parent->Right = Entry;
+  }
+  RebalanceMemoryMapTree (Parent);
+
+  //
+  // Next is the in-order successor of Entry
+  //
+  InsertTailList ((Next == NULL) ? &gMemoryMap : &Next->Link, &Entry->Link);
+}
+
+/**
+  Internal function.  Unlinks a descriptor entry from gMemoryMap and from the
+  tree without releasing it.
+
+  @param  Entry                  The entry to unlink
+
+**/
+VOID
+UnlinkMemoryMapEntry (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Successor;
+  MEMORY_MAP  *Rebalance;
+
+  if (Entry->Left != NULL && Entry->Right != NULL) {
+    //
+    // Move the in-order successor into the place of Entry
+    //
+    Successor = Entry->Right;
+    while (Successor->Left != NULL) {
+      Successor = Successor->Left;
+    }
+    Rebalance = Successor;
+    if (Successor->Parent != Entry) {
+      Rebalance = Successor->Parent;
+      ReplaceMemoryMapChild (Successor->Parent, Successor, Successor->Right);
+      Successor->Right         = Entry->Right;
+      Successor->Right->Parent = Successor;
+    }
+    ReplaceMemoryMapChild (Entry->Parent, Entry, Successor);
+    Successor->Left         = Entry->Left;
+    Successor->Left->Parent = Successor;
+  } else {
+    Rebalance = Entry->Parent;
+    ReplaceMemoryMapChild (Entry->Parent, Entry, (Entry->Left != NULL) ? Entry->Left : Entry->Right);
+  }
+  RebalanceMemoryMapTree (Rebalance);
+
+  RemoveEntryList (&Entry->Link);
+  Entry->Link.ForwardLink = NULL;
+}
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -137,8 +396,7 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP      *Entry
   )
 {
-  RemoveEntryList (&Entry->Link);
-  Entry->Link.ForwardLink = NULL;
+  UnlinkMemoryMapEntry (Entry);
 
   if (Entry->FromPages) {
     //
@@ -168,7 +426,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -215,29 +472,16 @@ CoreAddRange (
   // and the same Attribute
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
-
-      Start = Entry->Start;
-      RemoveMemoryMapEntry (Entry);
-
-    } else if (Entry->Start == End + 1) {
+  Entry = (Start == 0) ? NULL : LookupMemoryMapEntry (Start - 1);
+  if (Entry != NULL && Entry->Type == Type && Entry->Attribute == Attribute && Entry->End + 1 == Start) {
+    Start = Entry->Start;
+    RemoveMemoryMapEntry (Entry);
+  }
 
-      End = Entry->End;
-      RemoveMemoryMapEntry (Entry);
-    }
+  Entry = (End + 1 == 0) ? NULL : LookupMemoryMapEntry (End + 1);
+  if (Entry != NULL && Entry->Type == Type && Entry->Attribute == Attribute && Entry->Start == End + 1) {
+    End = Entry->End;
+    RemoveMemoryMapEntry (Entry);
   }
 
   //
@@ -251,7 +495,7 @@ CoreAddRange (
   mMapStack[mMapDepth].End           = End;
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
-  InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapEntry (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -319,8 +563,6 @@ CoreFreeMemoryMapStack (
   )
 {
   MEMORY_MAP      *Entry;
-  MEMORY_MAP      *Entry2;
-  LIST_ENTRY      *Link2;
 
   ASSERT_LOCKED (&gMemoryLock);
 
@@ -354,23 +596,12 @@ CoreFreeMemoryMapStack (
       //
       // Move this entry to general memory
       //
-      RemoveEntryList (&mMapStack[mMapDepth].Link);
-      mMapStack[mMapDepth].Link.ForwardLink = NULL;
+      UnlinkMemoryMapEntry (&mMapStack[mMapDepth]);
 
       CopyMem (Entry , &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
 
-      //
-      // Find insertion location
-      //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && Entry2->Start > Entry->Start) {
-          break;
-        }
-      }
-
-      InsertTailList (Link2, &Entry->Link);
+      InsertMemoryMapEntry (Entry);
 
     } else {
       //
@@ -698,7 +929,6 @@ CoreConvertPages (
   UINT64          End;
   UINT64          RangeEnd;
   UINT64          Attribute;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -723,15 +953,9 @@ CoreConvertPages (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
+    Entry = LookupMemoryMapEntry (Start);
 
-    if (Link == &gMemoryMap) {
+    if (Entry == NULL) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -790,6 +1014,7 @@ CoreConvertPages (
       // Clip start
       //
       Entry->Start = RangeEnd + 1;
+      RebalanceMemoryMapTree (Entry);
 
     } else if (Entry->End == RangeEnd) {
 
@@ -797,6 +1022,7 @@ CoreConvertPages (
       // Clip end
       //
       Entry->End = Start - 1;
+      RebalanceMemoryMapTree (Entry);
 
     } else {
 
@@ -820,9 +1046,10 @@ CoreConvertPages (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      RebalanceMemoryMapTree (Entry);
 
       Entry = &mMapStack[mMapDepth];
-      InsertTailList (&gMemoryMap, &Entry->Link);
+      InsertMemoryMapEntry (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -881,6 +1108,94 @@ CoreConvertPages (
 
 
 
+/**
+  Internal function.  Searches a subtree of the memory map for the highest
+  free range that satisfies a page request.
+
+  Subtrees whose largest free descriptor is smaller than the request, or that
+  lie entirely outside of [MinAddress, MaxAddress], are skipped.  Descriptors
+  never overlap, so the first fit found while walking down from the highest
+  address is also the one with the highest end address.
+
+  @param  Node                   The root of the subtree to search
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+
+  @return The last address of the range, or 0 if no range was found
+
+**/
+UINT64
+FindFreePagesInTree (
+  IN MEMORY_MAP       *Node,
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfBytes,
+  IN UINTN            Alignment
+  )
+{
+  UINT64          Target;
+  UINT64          DescStart;
+  UINT64          DescEnd;
+  UINT64          DescNumberOfBytes;
+
+  if (Node == NULL || Node->MaxFreeBytes < NumberOfBytes) {
+    return 0;
+  }
+
+  //
+  // Everything in the right subtree is above this descriptor
+  //
+  if (Node->Start < MaxAddress) {
+    Target = FindFreePagesInTree (Node->Right, MaxAddress, MinAddress, NumberOfBytes, Alignment);
+    if (Target != 0) {
+      return Target;
+    }
+  }
+
+  //
+  // If it's a free entry within the allowed addresses, see if it fits
+  //
+  DescStart = Node->Start;
+  DescEnd   = Node->End;
+  if (Node->Type == EfiConventionalMemory && DescStart < MaxAddress && DescEnd >= MinAddress) {
+    //
+    // If desc ends past max allowed address, clip the end
+    //
+    if (DescEnd >= MaxAddress) {
+      DescEnd = MaxAddress;
+    }
+
+    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
+
+    //
+    // Compute the number of bytes we can used from this
+    // descriptor, and see it's enough to satisfy the request
+    //
+    if (DescEnd >= DescStart) {
+      DescNumberOfBytes = DescEnd - DescStart + 1;
+
+      //
+      // The start of the allocated range must not be below the min address allowed
+      //
+      if (DescNumberOfBytes >= NumberOfBytes && (DescEnd - NumberOfBytes + 1) >= MinAddress) {
+        return DescEnd;
+      }
+    }
+  }
+
+  //
+  // Everything in the left subtree is below this descriptor
+  //
+  if (Node->Start > MinAddress) {
+    return FindFreePagesInTree (Node->Left, MaxAddress, MinAddress, NumberOfBytes, Alignment);
+  }
+
+  return 0;
+}
+
+
 /**
   Internal function. Finds a consecutive free page range below
   the requested address.
@@ -906,11 +1221,6 @@ CoreFindFreePagesI (
 {
   UINT64          NumberOfBytes;
   UINT64          Target;
-  UINT64          DescStart;
-  UINT64          DescEnd;
-  UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
-  MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
     return 0;
@@ -939,59 +1249,7 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target = 0;
-
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
-
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        Target = DescEnd;
-      }
-    }
-  }
+  Target = FindFreePagesInTree (mMemoryMapRoot, MaxAddress, MinAddress, NumberOfBytes, Alignment);
 
   //
   // If this is a grow down, adjust target to be the allocation base
@@ -1212,7 +1470,6 @@ CoreFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
 
@@ -1224,14 +1481,8 @@ CoreFreePages (
   //
   // Find the entry that the covers the range
   //
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = LookupMemoryMapEntry (Memory);
+  if (Entry == NULL) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -1499,10 +1750,15 @@ CoreGetMemoryMap (
     }
 
     //
-    // Check to see if the new Memory Map Descriptor can be merged with an 
-    // existing descriptor if they are adjacent and have the same attributes
+    // Check to see if the new Memory Map Descriptor can be merged with the
+    // previous descriptor if they are adjacent and have the same attributes.
+    // gMemoryMap is sorted by address, so no other descriptor can be adjacent.
     //
-    MemoryMap = MergeMemoryMapDescriptor (MemoryMapStart, MemoryMap, Size);
+    if (MemoryMap == MemoryMapStart) {
+      MemoryMap = NEXT_MEMORY_DESCRIPTOR (MemoryMap, Size);
+    } else {
+      MemoryMap = MergeMemoryMapDescriptor ((EFI_MEMORY_DESCRIPTOR *) ((UINT8 *) MemoryMap - Size), MemoryMap, Size);
+    }
   }
 
   for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
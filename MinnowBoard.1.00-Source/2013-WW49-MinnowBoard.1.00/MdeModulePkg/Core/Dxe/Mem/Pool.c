@@ -56,6 +56,42 @@ typedef struct {
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Segregated-fit slab allocator used when PcdDxeCorePoolSlabAllocator is TRUE.
+//
+// Small requests are rounded up to a size class (16, 24, 32, 48, 64, ... 768, 1024
+// bytes: every power of two and the 3/4 point between two powers of two) and carved
+// out of DEFAULT_PAGE_ALLOCATION sized slabs.  Objects carry no head or tail; the
+// owning slab is found by aligning the object address down to the slab boundary, and
+// the slab tracks its free objects in a bitmap, so both allocate and free are O(1).
+//
+#define POOL_SLAB_MIN_SHIFT     4
+#define POOL_SLAB_MIN_SIZE      (1 << POOL_SLAB_MIN_SHIFT)
+#define POOL_SLAB_CLASS_COUNT   13
+#define POOL_SLAB_MAX_SIZE      1024
+#define POOL_SLAB_MAP_WORDS     ((DEFAULT_PAGE_ALLOCATION / POOL_SLAB_MIN_SIZE + 31) / 32)
+
+#define POOL_SLAB_SIGNATURE   SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32          Signature;
+  UINT16          Class;
+  UINT16          FreeCount;
+  VOID            *Pool;
+  LIST_ENTRY      Link;
+  UINT32          FreeMap[POOL_SLAB_MAP_WORDS];
+} POOL_SLAB;
+
+#define SIZE_OF_POOL_SLAB   ALIGN_VALUE (sizeof (POOL_SLAB), 8)
+
+#define SLAB_CLASS_TO_SIZE(a)   \
+  (((a) & 1) != 0 ? (UINTN) 3 << (((a) >> 1) + POOL_SLAB_MIN_SHIFT - 1) : (UINTN) 1 << (((a) >> 1) + POOL_SLAB_MIN_SHIFT))
+
+#define SLAB_CLASS_TO_COUNT(a)  \
+  ((DEFAULT_PAGE_ALLOCATION - SIZE_OF_POOL_SLAB) / SLAB_CLASS_TO_SIZE (a))
+
+#define BUFFER_TO_SLAB(a)       \
+  ((POOL_SLAB *) ((UINTN) (a) & ~((UINTN) DEFAULT_PAGE_ALLOCATION - 1)))
+
 //
 // Globals
 //
@@ -66,6 +102,7 @@ typedef struct {
     UINTN            Used;
     EFI_MEMORY_TYPE  MemoryType;
     LIST_ENTRY       FreeList[MAX_POOL_LIST];
+    LIST_ENTRY       SlabList[POOL_SLAB_CLASS_COUNT];
     LIST_ENTRY       Link;
 } POOL;
 
@@ -99,6 +136,9 @@ CoreInitializePool (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
         InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+    for (Index=0; Index < POOL_SLAB_CLASS_COUNT; Index++) {
+        InitializeListHead (&mPoolHead[Type].SlabList[Index]);
+    }
   }
 }
 
@@ -148,6 +188,9 @@ LookupPoolHead (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&Pool->FreeList[Index]);
     }
+    for (Index=0; Index < POOL_SLAB_CLASS_COUNT; Index++) {
+      InitializeListHead (&Pool->SlabList[Index]);
+    }
 
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
@@ -158,6 +201,189 @@ LookupPoolHead (
 }
 
 
+/**
+  Map an aligned request size to its slab size class.
+
+  @param  Size                   The aligned number of bytes requested, at most
+                                 POOL_SLAB_MAX_SIZE.
+
+  @return The index of the smallest size class that can hold Size bytes.
+
+**/
+UINTN
+SizeToSlabClass (
+  IN UINTN            Size
+  )
+{
+  UINTN   Shift;
+
+  if (Size <= POOL_SLAB_MIN_SIZE) {
+    return 0;
+  }
+
+  //
+  // 2^Shift < Size <= 2^(Shift + 1); use the 3/4 class when it is big enough
+  //
+  Shift = (UINTN) HighBitSet32 ((UINT32) (Size - 1));
+  if (Size <= ((UINTN) 3 << (Shift - 1))) {
+    return ((Shift - POOL_SLAB_MIN_SHIFT) << 1) + 1;
+  }
+  return (Shift + 1 - POOL_SLAB_MIN_SHIFT) << 1;
+}
+
+
+/**
+  Internal function to allocate an object from the slab of a size class.
+  Caller must have the memory lock held
+
+  @param  Pool                   Pool head of the memory type to allocate from
+  @param  Class                  The size class of the object
+
+  @return The allocated object, or NULL
+
+**/
+VOID *
+CoreAllocateSlabObject (
+  IN POOL             *Pool,
+  IN UINTN            Class
+  )
+{
+  POOL_SLAB   *Slab;
+  UINTN       Count;
+  UINTN       Index;
+  UINTN       Bit;
+
+  ASSERT (Class < POOL_SLAB_CLASS_COUNT);
+
+  if (IsListEmpty (&Pool->SlabList[Class])) {
+    //
+    // No partially used slab left for this class, start a new one
+    //
+    Slab = CoreAllocatePoolPages (Pool->MemoryType, EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION), DEFAULT_PAGE_ALLOCATION);
+    if (Slab == NULL) {
+      return NULL;
+    }
+
+    Count = SLAB_CLASS_TO_COUNT (Class);
+    ASSERT (Count <= POOL_SLAB_MAP_WORDS * 32);
+
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Class     = (UINT16) Class;
+    Slab->FreeCount = (UINT16) Count;
+    Slab->Pool      = Pool;
+    SetMem (Slab->FreeMap, sizeof (Slab->FreeMap), 0);
+    for (Index = 0; Index < Count / 32; Index++) {
+      Slab->FreeMap[Index] = 0xFFFFFFFF;
+    }
+    if ((Count % 32) != 0) {
+      Slab->FreeMap[Index] = (UINT32) (LShiftU64 (1, Count % 32) - 1);
+    }
+    InsertHeadList (&Pool->SlabList[Class], &Slab->Link);
+  }
+
+  Slab = CR (Pool->SlabList[Class].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  ASSERT (Slab->FreeCount != 0);
+
+  for (Index = 0; Slab->FreeMap[Index] == 0; Index++) {
+    ASSERT (Index < POOL_SLAB_MAP_WORDS - 1);
+  }
+  Bit = (UINTN) LowBitSet32 (Slab->FreeMap[Index]);
+  Slab->FreeMap[Index] &= ~(1U << Bit);
+
+  //
+  // A full slab leaves the list until one of its objects is freed
+  //
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    RemoveEntryList (&Slab->Link);
+  }
+
+  return (CHAR8 *) Slab + SIZE_OF_POOL_SLAB + (Index * 32 + Bit) * SLAB_CLASS_TO_SIZE (Class);
+}
+
+
+/**
+  Unlink an empty slab and return its page.
+
+  @param  Slab                   The slab to release
+
+**/
+VOID
+CoreFreeSlab (
+  IN POOL_SLAB        *Slab
+  )
+{
+  RemoveEntryList (&Slab->Link);
+  Slab->Signature = 0;
+  CoreFreePoolPages ((EFI_PHYSICAL_ADDRESS) (UINTN) Slab, EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION));
+}
+
+
+/**
+  Internal function to return an object to its slab.
+  Caller must have the memory lock held
+
+  @param  Slab                   The slab that holds the object
+  @param  Buffer                 The object to free
+
+  @retval EFI_INVALID_PARAMETER  Buffer is not an allocated object of Slab
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+EFI_STATUS
+CoreFreeSlabObject (
+  IN POOL_SLAB        *Slab,
+  IN VOID             *Buffer
+  )
+{
+  POOL        *Pool;
+  UINTN       Size;
+  UINTN       Offset;
+  UINTN       Object;
+
+  if (Slab->Class >= POOL_SLAB_CLASS_COUNT) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Size   = SLAB_CLASS_TO_SIZE (Slab->Class);
+  Offset = (UINTN) Buffer - (UINTN) Slab;
+  if (Offset < SIZE_OF_POOL_SLAB || ((Offset - SIZE_OF_POOL_SLAB) % Size) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Object = (Offset - SIZE_OF_POOL_SLAB) / Size;
+  if (Object >= SLAB_CLASS_TO_COUNT (Slab->Class) ||
+      (Slab->FreeMap[Object / 32] & (1U << (Object % 32))) != 0) {
+    //
+    // Out of range or already free
+    //
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Pool = (POOL *) Slab->Pool;
+  Pool->Used -= Size;
+  DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Buffer, (UINT64) Size, (UINT64) Pool->Used));
+  DEBUG_CLEAR_MEMORY (Buffer, Size);
+
+  Slab->FreeMap[Object / 32] |= 1U << (Object % 32);
+  if (Slab->FreeCount == 0) {
+    InsertHeadList (&Pool->SlabList[Slab->Class], &Slab->Link);
+  }
+  Slab->FreeCount++;
+
+  //
+  // Give an empty slab back unless it is the last one of its class, which is
+  // kept to avoid allocating and freeing the same page on every call
+  //
+  if (Slab->FreeCount == SLAB_CLASS_TO_COUNT (Slab->Class) &&
+      Pool->SlabList[Slab->Class].ForwardLink != Pool->SlabList[Slab->Class].BackLink) {
+    CoreFreeSlab (Slab);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 
 /**
   Allocate pool of a particular type.
@@ -259,12 +485,31 @@ CoreAllocatePoolI (
   //
   Size = ALIGN_VARIABLE (Size);
 
-  Size += POOL_OVERHEAD;
-  Index = SIZE_TO_LIST(Size);
   Pool = LookupPoolHead (PoolType);
   if (Pool== NULL) {
     return NULL;
   }
+
+  //
+  // Small requests are carved out of a slab without any head or tail
+  //
+  if (FeaturePcdGet (PcdDxeCorePoolSlabAllocator) && Size <= POOL_SLAB_MAX_SIZE) {
+    Index  = SizeToSlabClass (Size);
+    Size   = SLAB_CLASS_TO_SIZE (Index);
+    Buffer = CoreAllocateSlabObject (Pool, Index);
+    if (Buffer == NULL) {
+      DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate %ld bytes\n", (UINT64) Size));
+      return NULL;
+    }
+
+    DEBUG_CLEAR_MEMORY (Buffer, Size);
+    Pool->Used += Size;
+    DEBUG ((DEBUG_POOL, "AllocatePoolI: Type %x, Addr %p (len %lx) %,ld\n", PoolType, Buffer, (UINT64) Size, (UINT64) Pool->Used));
+    return Buffer;
+  }
+
+  Size += POOL_OVERHEAD;
+  Index = SIZE_TO_LIST(Size);
   Head = NULL;
 
   //
@@ -416,8 +661,30 @@ CoreFreePoolI (
   UINTN       FSize;
   UINTN       Offset;
   BOOLEAN     AllFree;
+  POOL_SLAB   *Slab;
+  EFI_STATUS  Status;
 
   ASSERT(Buffer != NULL);
+
+  //
+  // Every page owned by the pool starts with a pool head, a free pool entry or
+  // a slab header, so the signature at the start of the page of Buffer tells
+  // whether Buffer is a slab object.
+  //
+  if (FeaturePcdGet (PcdDxeCorePoolSlabAllocator)) {
+    Slab = BUFFER_TO_SLAB (Buffer);
+    if (Slab->Signature == POOL_SLAB_SIGNATURE) {
+      ASSERT_LOCKED (&gMemoryLock);
+      Pool   = (POOL *) Slab->Pool;
+      Status = CoreFreeSlabObject (Slab, Buffer);
+      ASSERT_EFI_ERROR (Status);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      goto FreePoolHead;
+    }
+  }
+
   //
   // Get the head & tail of the pool entry
   //
@@ -545,12 +812,18 @@ CoreFreePoolI (
     }
   }
 
+FreePoolHead:
   //
   // If this is an OS specific memory type, then check to see if the last
   // portion of that memory type has been freed.  If it has, then free the
-  // list entry for that memory type
+  // list entry for that memory type, along with the empty slabs it still caches
   //
   if (Pool->MemoryType < 0 && Pool->Used == 0) {
+    for (Index = 0; Index < POOL_SLAB_CLASS_COUNT; Index++) {
+      while (!IsListEmpty (&Pool->SlabList[Index])) {
+        CoreFreeSlab (CR (Pool->SlabList[Index].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE));
+      }
+    }
     RemoveEntryList (&Pool->Link);
     CoreFreePoolI (Pool);
   }
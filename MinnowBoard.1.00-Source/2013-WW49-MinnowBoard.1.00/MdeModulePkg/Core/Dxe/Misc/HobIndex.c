@@ -0,0 +1,96 @@
+/** @file
+  Index of the GUID extension HOBs in the HOB list.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+
+/**
+  Builds the index of the GUID extension HOBs in the HOB list and installs it
+  into the EFI System Table's Configuration Table.
+
+  The index is only an accelerator for the HOB Library, which walks the HOB
+  list itself when the index is absent, so failing to build it is not fatal.
+
+  @param  HobStart       The start of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndex (
+  IN VOID   *HobStart
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINT32                EntryCount;
+  UINT32                BucketCount;
+  HOB_INDEX_HEADER      *Index;
+  HOB_INDEX_ENTRY       *Entries;
+  UINT32                *Buckets;
+  UINT32                EntryIndex;
+  UINT32                Bucket;
+
+  //
+  // Count the GUID extension HOBs, and find the end of the list
+  //
+  EntryCount = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (Hob.Header->HobType == EFI_HOB_TYPE_GUID_EXTENSION) {
+      EntryCount++;
+    }
+  }
+
+  BucketCount = 1;
+  while (BucketCount < EntryCount) {
+    BucketCount <<= 1;
+  }
+
+  Index = AllocatePool (
+            sizeof (HOB_INDEX_HEADER) +
+            EntryCount * sizeof (HOB_INDEX_ENTRY) +
+            BucketCount * sizeof (UINT32)
+            );
+  if (Index == NULL) {
+    return;
+  }
+
+  Index->HobList     = HobStart;
+  Index->HobEnd      = Hob.Raw;
+  Index->BucketCount = BucketCount;
+  Index->EntryCount  = EntryCount;
+  Entries            = HOB_INDEX_ENTRIES (Index);
+  Buckets            = HOB_INDEX_BUCKETS (Index);
+  SetMem (Buckets, BucketCount * sizeof (UINT32), 0xFF);
+
+  //
+  // Record the HOBs in list order, then chain them from the last one back,
+  // so that every chain is in the order of the HOB list.
+  //
+  EntryIndex = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (Hob.Header->HobType == EFI_HOB_TYPE_GUID_EXTENSION) {
+      Entries[EntryIndex++].Hob = Hob.Guid;
+    }
+  }
+
+  while (EntryIndex > 0) {
+    EntryIndex--;
+    Bucket                   = HOB_INDEX_BUCKET (&Entries[EntryIndex].Hob->Name, BucketCount);
+    Entries[EntryIndex].Next = Buckets[Bucket];
+    Buckets[Bucket]          = EntryIndex;
+  }
+
+  Status = CoreInstallConfigurationTable (&gHobIndexGuid, Index);
+  if (EFI_ERROR (Status)) {
+    FreePool (Index);
+  }
+}
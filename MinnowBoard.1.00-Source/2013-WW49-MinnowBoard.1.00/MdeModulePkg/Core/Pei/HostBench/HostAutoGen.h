@@ -0,0 +1,45 @@
+/** @file
+  Stands in for the AutoGen.h that the EDK II build generates for a module,
+  so that the PPI services of the PEI Core and the libraries they use build
+  as one host program.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_AUTOGEN_H_
+#define _HOST_AUTOGEN_H_
+
+#include <Base.h>
+#include <PiPei.h>
+#include <Library/PcdLib.h>
+
+extern GUID  gEfiCallerIdGuid;
+extern CHAR8 *gEfiCallerBaseName;
+
+//
+// The size of the PPI database can be set from the make command line.
+//
+#ifndef HOST_MAX_PPI_SUPPORTED
+#define HOST_MAX_PPI_SUPPORTED                                64
+#endif
+
+//
+// PCDs used by the PEI Core and the MdePkg libraries built in
+//
+#define _PCD_VALUE_PcdPeiCoreMaxPpiSupported                  HOST_MAX_PPI_SUPPORTED
+#define _PCD_VALUE_PcdPeiCoreMaxFvSupported                   6
+#define _PCD_VALUE_PcdPeiCoreMaxPeimPerFv                     32
+#define _PCD_GET_MODE_32_PcdMaximumAsciiStringLength          1000000U
+#define _PCD_GET_MODE_32_PcdMaximumUnicodeStringLength        1000000U
+#define _PCD_GET_MODE_32_PcdMaximumLinkedListLength           1000000U
+#define _PCD_GET_MODE_BOOL_PcdVerifyNodeInList                FALSE
+
+#endif
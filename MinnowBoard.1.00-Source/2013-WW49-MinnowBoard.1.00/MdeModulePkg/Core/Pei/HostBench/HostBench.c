@@ -0,0 +1,768 @@
+/** @file
+  Benchmark of the PEI Core PPI services that runs on a build host.
+
+  The program links Ppi.c of the PEI Core into an ordinary program, checks
+  that a scripted sequence of installs, reinstalls, notifies and locates
+  produces the PPIs and notification callbacks the PI specification asks
+  for, and then times InstallPpi, LocatePpi, NotifyPpi and the dispatch
+  level notifications on a PPI database filled with random GUIDs.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "PeiMain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_RANDOM_SEED         0x2545F491
+#define BENCH_LOG_SIZE            32
+#define BENCH_MAX_PPI             FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)
+
+GUID    gEfiCallerIdGuid;
+CHAR8   *gEfiCallerBaseName = "HostBench";
+
+typedef struct {
+  UINT32                      Ppis;
+  UINT32                      Notifies;
+  UINT32                      Rounds;
+} BENCH_CONFIG;
+
+typedef struct {
+  BENCH_CONFIG                *Config;
+  PEI_CORE_INSTANCE           *Private;
+  CONST EFI_PEI_SERVICES      **PeiServices;
+  ///
+  /// GUIDs of the PPIs, followed by GUIDs that are never installed
+  ///
+  EFI_GUID                    *Guids;
+  EFI_PEI_PPI_DESCRIPTOR      *PpiList;
+  EFI_PEI_NOTIFY_DESCRIPTOR   *NotifyList;
+  UINT64                      Operations;
+  double                      Seconds;
+} BENCH_CONTEXT;
+
+typedef
+EFI_STATUS
+(*BENCH_FUNCTION) (
+  IN OUT BENCH_CONTEXT        *Context
+  );
+
+typedef struct {
+  CONST CHAR8                 *Name;
+  BENCH_FUNCTION              Function;
+} BENCHMARK;
+
+///
+/// A notification callback as the verification sees it
+///
+typedef struct {
+  EFI_PEI_NOTIFY_DESCRIPTOR   *Notify;
+  VOID                        *Ppi;
+} BENCH_LOG_ENTRY;
+
+UINT64                  mBenchRandom = BENCH_RANDOM_SEED;
+CONST EFI_PEI_SERVICES  **mPeiServices;
+UINT64                  mNotified;
+BENCH_LOG_ENTRY         mLog[BENCH_LOG_SIZE];
+UINTN                   mLogCount;
+
+/**
+  Return the next number of a fixed pseudo random sequence.
+
+**/
+UINT64
+BenchRandom (
+  VOID
+  )
+{
+  mBenchRandom ^= mBenchRandom << 13;
+  mBenchRandom ^= mBenchRandom >> 7;
+  mBenchRandom ^= mBenchRandom << 17;
+  return mBenchRandom;
+}
+
+/**
+  Return a monotonic time stamp in seconds.
+
+**/
+double
+BenchNow (
+  VOID
+  )
+{
+  struct timespec   Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+//
+// PeiServicesTablePointerLib
+//
+
+CONST EFI_PEI_SERVICES **
+EFIAPI
+GetPeiServicesTablePointer (
+  VOID
+  )
+{
+  return mPeiServices;
+}
+
+/**
+  Notification callback of the benchmarks, which only counts.
+
+**/
+EFI_STATUS
+EFIAPI
+BenchNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  mNotified++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Notification callback of the verification, which records the callback.
+
+**/
+EFI_STATUS
+EFIAPI
+BenchLogNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  if (mLogCount < BENCH_LOG_SIZE) {
+    mLog[mLogCount].Notify = NotifyDescriptor;
+    mLog[mLogCount].Ppi    = Ppi;
+  }
+  mLogCount++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Empty the PPI database, as the PEI Core finds it when it is entered first.
+
+**/
+VOID
+BenchReset (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  ZeroMem (Context->Private, sizeof (PEI_CORE_INSTANCE));
+  Context->Private->Signature = PEI_CORE_HANDLE_SIGNATURE;
+  Context->Private->Ps        = &Context->Private->ServiceTableShadow;
+  Context->PeiServices        = (CONST EFI_PEI_SERVICES **) &Context->Private->Ps;
+  mPeiServices                = Context->PeiServices;
+  mNotified                   = 0;
+  mLogCount                   = 0;
+
+  InitializePpiServices (Context->Private, NULL);
+}
+
+/**
+  Make the notify descriptors of the benchmarks callback or dispatch level.
+
+**/
+VOID
+BenchSetNotifyType (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     UINTN            NotifyType
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < Context->Config->Notifies; Index++) {
+    Context->NotifyList[Index].Flags = NotifyType | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+  }
+}
+
+/**
+  Install all the PPIs of the benchmarks, one InstallPpi() call each.
+
+**/
+EFI_STATUS
+BenchInstallAll (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+
+  for (Index = 0; Index < Context->Config->Ppis; Index++) {
+    Status = PeiInstallPpi (Context->PeiServices, &Context->PpiList[Index]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Register all the notifies of the benchmarks, one NotifyPpi() call each.
+
+**/
+EFI_STATUS
+BenchNotifyAll (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+
+  for (Index = 0; Index < Context->Config->Notifies; Index++) {
+    Status = PeiNotifyPpi (Context->PeiServices, &Context->NotifyList[Index]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  The number of callbacks that installing all the PPIs and registering all
+  the notifies makes: every other notify watches an installed PPI.
+
+**/
+UINT64
+BenchMatches (
+  IN BENCH_CONTEXT        *Context
+  )
+{
+  return (Context->Config->Notifies + 1) / 2;
+}
+
+/**
+  Install the PPIs into a database whose notifies are already registered.
+
+**/
+EFI_STATUS
+BenchInstall (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Round;
+  double      Start;
+
+  BenchSetNotifyType (Context, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK);
+  for (Round = 0; Round < Context->Config->Rounds; Round++) {
+    BenchReset (Context);
+    Status = BenchNotifyAll (Context);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Start  = BenchNow ();
+    Status = BenchInstallAll (Context);
+    Context->Seconds    += BenchNow () - Start;
+    Context->Operations += Context->Config->Ppis;
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Register the notifies with a database whose PPIs are already installed.
+
+**/
+EFI_STATUS
+BenchRegisterNotify (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Round;
+  double      Start;
+
+  BenchSetNotifyType (Context, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK);
+  for (Round = 0; Round < Context->Config->Rounds; Round++) {
+    BenchReset (Context);
+    Status = BenchInstallAll (Context);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Start  = BenchNow ();
+    Status = BenchNotifyAll (Context);
+    Context->Seconds    += BenchNow () - Start;
+    Context->Operations += Context->Config->Notifies;
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Install the PPIs with dispatch level notifies registered, processing the
+  notify list after each install as the dispatcher does after each PEIM.
+
+**/
+EFI_STATUS
+BenchDispatch (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Round;
+  UINT32      Index;
+  double      Start;
+
+  BenchSetNotifyType (Context, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH);
+  for (Round = 0; Round < Context->Config->Rounds; Round++) {
+    BenchReset (Context);
+    Status = BenchNotifyAll (Context);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Start = BenchNow ();
+    for (Index = 0; Index < Context->Config->Ppis; Index++) {
+      Status = PeiInstallPpi (Context->PeiServices, &Context->PpiList[Index]);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      ProcessNotifyList (Context->Private);
+    }
+    Context->Seconds    += BenchNow () - Start;
+    Context->Operations += Context->Config->Ppis;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Locate the PPIs, or GUIDs that are not installed, in a full database.
+
+**/
+EFI_STATUS
+BenchLocateGuids (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     BOOLEAN          Installed
+  )
+{
+  EFI_STATUS              Status;
+  UINT32                  Round;
+  UINT32                  Index;
+  EFI_GUID                *Guids;
+  EFI_PEI_PPI_DESCRIPTOR  *Descriptor;
+  VOID                    *Ppi;
+  double                  Start;
+
+  BenchSetNotifyType (Context, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK);
+  BenchReset (Context);
+  Status = BenchNotifyAll (Context);
+  if (!EFI_ERROR (Status)) {
+    Status = BenchInstallAll (Context);
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Guids = Installed ? Context->Guids : Context->Guids + BENCH_MAX_PPI;
+  Start = BenchNow ();
+  for (Round = 0; Round < Context->Config->Rounds; Round++) {
+    for (Index = 0; Index < Context->Config->Ppis; Index++) {
+      Status = PeiLocatePpi (Context->PeiServices, &Guids[Index], 0, &Descriptor, &Ppi);
+      if (Installed ? (EFI_ERROR (Status) || Descriptor != &Context->PpiList[Index]) : (Status != EFI_NOT_FOUND)) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+  }
+  Context->Seconds    += BenchNow () - Start;
+  Context->Operations += (UINT64) Context->Config->Rounds * Context->Config->Ppis;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+BenchLocate (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  return BenchLocateGuids (Context, TRUE);
+}
+
+EFI_STATUS
+BenchLocateMissing (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  return BenchLocateGuids (Context, FALSE);
+}
+
+BENCHMARK mBenchmarks[] = {
+  { "install",        BenchInstall        },
+  { "notify",         BenchRegisterNotify },
+  { "dispatch",       BenchDispatch       },
+  { "locate",         BenchLocate         },
+  { "locate-missing", BenchLocateMissing  }
+};
+
+/**
+  Check the callbacks made since the last check against the expected ones.
+
+**/
+BOOLEAN
+BenchCheckLog (
+  IN CONST CHAR8            *Step,
+  IN UINTN                  Count,
+  IN CONST BENCH_LOG_ENTRY  *Expected
+  )
+{
+  UINTN   Index;
+
+  if (mLogCount != Count) {
+    fprintf (stderr, "verify %s: %u callbacks, expected %u\n", Step, (unsigned) mLogCount, (unsigned) Count);
+    return FALSE;
+  }
+  for (Index = 0; Index < Count; Index++) {
+    if (mLog[Index].Notify != Expected[Index].Notify || mLog[Index].Ppi != Expected[Index].Ppi) {
+      fprintf (stderr, "verify %s: callback %u is not the expected one\n", Step, (unsigned) Index);
+      return FALSE;
+    }
+  }
+  mLogCount = 0;
+  return TRUE;
+}
+
+/**
+  Check a LocatePpi() result.
+
+**/
+BOOLEAN
+BenchCheckLocate (
+  IN CONST CHAR8              *Step,
+  IN BENCH_CONTEXT            *Context,
+  IN EFI_GUID                 *Guid,
+  IN UINTN                    Instance,
+  IN EFI_PEI_PPI_DESCRIPTOR   *Expected
+  )
+{
+  EFI_STATUS              Status;
+  EFI_PEI_PPI_DESCRIPTOR  *Descriptor;
+  VOID                    *Ppi;
+
+  Descriptor = NULL;
+  Status     = PeiLocatePpi (Context->PeiServices, Guid, Instance, &Descriptor, &Ppi);
+  if (Expected == NULL ? (Status != EFI_NOT_FOUND) : (EFI_ERROR (Status) || Descriptor != Expected || Ppi != Expected->Ppi)) {
+    fprintf (stderr, "verify %s: instance %u is not the expected one\n", Step, (unsigned) Instance);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+#define BENCH_PPI(Name, PpiGuid, PpiFlags) \
+  do { \
+    Name.Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | (PpiFlags); \
+    Name.Guid  = (PpiGuid); \
+    Name.Ppi   = &Name; \
+  } while (FALSE)
+
+#define BENCH_NOTIFY(Name, NotifyGuid, NotifyFlags) \
+  do { \
+    Name.Flags  = (NotifyFlags); \
+    Name.Guid   = (NotifyGuid); \
+    Name.Notify = BenchLogNotify; \
+  } while (FALSE)
+
+#define BENCH_CHECK_LOG(Step, ...) \
+  do { \
+    BENCH_LOG_ENTRY  Expected_[] = { { NULL, NULL }, __VA_ARGS__ }; \
+    if (!BenchCheckLog (Step, sizeof (Expected_) / sizeof (Expected_[0]) - 1, Expected_ + 1)) { \
+      return FALSE; \
+    } \
+  } while (FALSE)
+
+#define BENCH_CHECK_LOCATE(Step, Guid, Instance, Expected) \
+  do { \
+    if (!BenchCheckLocate (Step, Context, Guid, Instance, Expected)) { \
+      return FALSE; \
+    } \
+  } while (FALSE)
+
+/**
+  Run a scripted sequence of PPI services and check the PPIs they find and
+  the callbacks they make, in the order the PEI Core has always made them:
+  for each notify from the oldest, the matching PPIs from the oldest.
+
+**/
+BOOLEAN
+BenchVerify (
+  IN OUT BENCH_CONTEXT    *Context
+  )
+{
+  EFI_GUID                    *A;
+  EFI_GUID                    *B;
+  EFI_GUID                    *C;
+  EFI_GUID                    *D;
+  EFI_PEI_PPI_DESCRIPTOR      List1[3];
+  EFI_PEI_PPI_DESCRIPTOR      List2[2];
+  EFI_PEI_PPI_DESCRIPTOR      List3[2];
+  EFI_PEI_PPI_DESCRIPTOR      A3;
+  EFI_PEI_PPI_DESCRIPTOR      A4;
+  EFI_PEI_PPI_DESCRIPTOR      C1;
+  EFI_PEI_PPI_DESCRIPTOR      D1;
+  EFI_PEI_NOTIFY_DESCRIPTOR   Notifies[3];
+  EFI_PEI_NOTIFY_DESCRIPTOR   N4;
+  EFI_PEI_NOTIFY_DESCRIPTOR   N5;
+
+  A = &Context->Guids[0];
+  B = &Context->Guids[1];
+  C = &Context->Guids[2];
+  D = &Context->Guids[3];
+
+  BENCH_PPI (List1[0], A, 0);
+  BENCH_PPI (List1[1], B, 0);
+  BENCH_PPI (List1[2], A, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (List2[0], D, 0);
+  BENCH_PPI (List2[1], B, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (List3[0], A, 0);
+  BENCH_PPI (List3[1], A, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (A3, A, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (A4, A, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (C1, C, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_PPI (D1, D, EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_NOTIFY (Notifies[0], A, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK);
+  BENCH_NOTIFY (Notifies[1], B, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK);
+  BENCH_NOTIFY (Notifies[2], A, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_NOTIFY (N4, B, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+  BENCH_NOTIFY (N5, D, EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST);
+
+  BenchReset (Context);
+
+  PeiNotifyPpi (Context->PeiServices, Notifies);
+  BENCH_CHECK_LOG ("notify before install");
+
+  PeiInstallPpi (Context->PeiServices, List1);
+  BENCH_CHECK_LOG (
+    "install list",
+    { &Notifies[0], &List1[0] }, { &Notifies[0], &List1[2] },
+    { &Notifies[1], &List1[1] },
+    { &Notifies[2], &List1[0] }, { &Notifies[2], &List1[2] }
+    );
+
+  PeiNotifyPpi (Context->PeiServices, &N4);
+  BENCH_CHECK_LOG ("notify after install", { &N4, &List1[1] });
+
+  PeiReInstallPpi (Context->PeiServices, &List1[0], &A3);
+  BENCH_CHECK_LOG ("reinstall", { &Notifies[0], &A3 }, { &Notifies[2], &A3 });
+
+  PeiReInstallPpi (Context->PeiServices, &List1[1], &C1);
+  BENCH_CHECK_LOG ("reinstall other GUID");
+  BENCH_CHECK_LOCATE ("reinstall other GUID", B, 0, NULL);
+  BENCH_CHECK_LOCATE ("reinstall other GUID", C, 0, &C1);
+
+  BENCH_CHECK_LOCATE ("instances", A, 0, &A3);
+  BENCH_CHECK_LOCATE ("instances", A, 1, &List1[2]);
+  BENCH_CHECK_LOCATE ("instances", A, 2, NULL);
+  BENCH_CHECK_LOCATE ("instances", D, 0, NULL);
+
+  PeiNotifyPpi (Context->PeiServices, &N5);
+  PeiInstallPpi (Context->PeiServices, &D1);
+  BENCH_CHECK_LOG ("dispatch notify at install");
+  ProcessNotifyList (Context->Private);
+  BENCH_CHECK_LOG ("dispatch notify", { &N5, &D1 });
+
+  PeiInstallPpi (Context->PeiServices, &A4);
+  BENCH_CHECK_LOG ("install after dispatch notify", { &Notifies[0], &A4 }, { &Notifies[2], &A4 });
+  ProcessNotifyList (Context->Private);
+  BENCH_CHECK_LOG ("dispatch notify again");
+
+  PeiInstallPpi (Context->PeiServices, List2);
+  BENCH_CHECK_LOG ("install mixed list", { &Notifies[1], &List2[1] }, { &N4, &List2[1] });
+  ProcessNotifyList (Context->Private);
+  BENCH_CHECK_LOG ("dispatch mixed list", { &N5, &List2[0] });
+
+  PeiInstallPpi (Context->PeiServices, List3);
+  BENCH_CHECK_LOG (
+    "install same GUIDs",
+    { &Notifies[0], &List3[0] }, { &Notifies[0], &List3[1] },
+    { &Notifies[2], &List3[0] }, { &Notifies[2], &List3[1] }
+    );
+
+  BENCH_CHECK_LOCATE ("all instances", A, 0, &A3);
+  BENCH_CHECK_LOCATE ("all instances", A, 1, &List1[2]);
+  BENCH_CHECK_LOCATE ("all instances", A, 2, &A4);
+  BENCH_CHECK_LOCATE ("all instances", A, 3, &List3[0]);
+  BENCH_CHECK_LOCATE ("all instances", A, 4, &List3[1]);
+  BENCH_CHECK_LOCATE ("all instances", A, 5, NULL);
+  BENCH_CHECK_LOCATE ("all instances", B, 0, &List2[1]);
+  BENCH_CHECK_LOCATE ("all instances", D, 1, &List2[0]);
+  return TRUE;
+}
+
+/**
+  Run one benchmark and print its results.
+
+**/
+EFI_STATUS
+BenchRun (
+  IN OUT BENCH_CONTEXT    *Context,
+  IN     BENCHMARK        *Benchmark
+  )
+{
+  EFI_STATUS  Status;
+
+  Context->Operations = 0;
+  Context->Seconds    = 0;
+  mNotified           = 0;
+
+  Status = Benchmark->Function (Context);
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "%s failed with status 0x%llx\n", Benchmark->Name, (unsigned long long) Status);
+    return Status;
+  }
+
+  //
+  // Every round ends with all PPIs installed and all notifies registered, so
+  // the last one must have made every callback exactly once.
+  //
+  if (mNotified != BenchMatches (Context)) {
+    fprintf (stderr, "%s made %llu callbacks, expected %llu\n", Benchmark->Name,
+      (unsigned long long) mNotified, (unsigned long long) BenchMatches (Context));
+    return EFI_DEVICE_ERROR;
+  }
+
+  printf (
+    "%-16s %10llu %9.1f %9.3f %9llu\n",
+    Benchmark->Name,
+    (unsigned long long) Context->Operations,
+    Context->Seconds * 1e9 / Context->Operations,
+    Context->Seconds,
+    (unsigned long long) mNotified
+    );
+  return EFI_SUCCESS;
+}
+
+/**
+  Print the command line syntax.
+
+**/
+VOID
+BenchUsage (
+  VOID
+  )
+{
+  fprintf (
+    stderr,
+    "Usage: HostBench [options]\n"
+    "Times the PEI Core PPI services on a database of %u entries.\n"
+    "  -p N       number of PPIs installed (default 3/4 of the database)\n"
+    "  -n N       number of notifies registered (default the rest)\n"
+    "  -r N       number of rounds (default 20000)\n"
+    "  -b NAME    run only the named benchmark\n",
+    (unsigned) BENCH_MAX_PPI
+    );
+}
+
+int
+main (
+  int       Argc,
+  char      **Argv
+  )
+{
+  BENCH_CONFIG    Config;
+  BENCH_CONTEXT   Context;
+  CONST CHAR8     *Only;
+  UINTN           Index;
+  int             Option;
+  BOOLEAN         Failed;
+
+  Config.Ppis     = BENCH_MAX_PPI * 3 / 4;
+  Config.Notifies = BENCH_MAX_PPI - 1 - Config.Ppis;
+  Config.Rounds   = 20000;
+  Only            = NULL;
+
+  while ((Option = getopt (Argc, Argv, "p:n:r:b:h")) != -1) {
+    switch (Option) {
+    case 'p': Config.Ppis     = (UINT32) atoi (optarg); break;
+    case 'n': Config.Notifies = (UINT32) atoi (optarg); break;
+    case 'r': Config.Rounds   = (UINT32) atoi (optarg); break;
+    case 'b': Only            = optarg; break;
+    default:
+      BenchUsage ();
+      return 2;
+    }
+  }
+
+  //
+  // The verification needs 14 entries, and the notifies watch every other
+  // PPI.
+  //
+  if (optind != Argc || BENCH_MAX_PPI < 16 || Config.Ppis == 0 || Config.Rounds == 0 ||
+      Config.Ppis + Config.Notifies >= BENCH_MAX_PPI || Config.Notifies > 2 * Config.Ppis) {
+    BenchUsage ();
+    return 2;
+  }
+
+  ZeroMem (&Context, sizeof (Context));
+  Context.Config     = &Config;
+  Context.Private    = malloc (sizeof (PEI_CORE_INSTANCE));
+  Context.Guids      = malloc (2 * BENCH_MAX_PPI * sizeof (EFI_GUID));
+  Context.PpiList    = malloc (Config.Ppis * sizeof (EFI_PEI_PPI_DESCRIPTOR));
+  Context.NotifyList = malloc ((Config.Notifies + 1) * sizeof (EFI_PEI_NOTIFY_DESCRIPTOR));
+  if (Context.Private == NULL || Context.Guids == NULL || Context.PpiList == NULL || Context.NotifyList == NULL) {
+    fprintf (stderr, "out of memory\n");
+    return 1;
+  }
+
+  for (Index = 0; Index < 2 * BENCH_MAX_PPI; Index++) {
+    WriteUnaligned64 ((UINT64 *) &Context.Guids[Index], BenchRandom ());
+    WriteUnaligned64 ((UINT64 *) &Context.Guids[Index] + 1, BenchRandom ());
+  }
+  for (Index = 0; Index < Config.Ppis; Index++) {
+    Context.PpiList[Index].Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+    Context.PpiList[Index].Guid  = &Context.Guids[Index];
+    Context.PpiList[Index].Ppi   = &Context.PpiList[Index];
+  }
+  //
+  // Even notifies watch PPIs that get installed, odd ones PPIs that never do.
+  //
+  for (Index = 0; Index < Config.Notifies; Index++) {
+    Context.NotifyList[Index].Guid   = (Index % 2 == 0) ? &Context.Guids[Index / 2] : &Context.Guids[BENCH_MAX_PPI + Index];
+    Context.NotifyList[Index].Notify = BenchNotify;
+  }
+
+  if (!BenchVerify (&Context)) {
+    return 1;
+  }
+
+  printf (
+    "%u entries, %u PPIs, %u notifies\n"
+    "%-16s %10s %9s %9s %9s\n",
+    (unsigned) BENCH_MAX_PPI, Config.Ppis, Config.Notifies,
+    "benchmark", "ops", "ns/op", "seconds", "callbacks"
+    );
+
+  Failed = FALSE;
+  for (Index = 0; Index < sizeof (mBenchmarks) / sizeof (mBenchmarks[0]); Index++) {
+    if (Only != NULL && strcmp (Only, mBenchmarks[Index].Name) != 0) {
+      continue;
+    }
+    if (EFI_ERROR (BenchRun (&Context, &mBenchmarks[Index]))) {
+      Failed = TRUE;
+      break;
+    }
+  }
+
+  return Failed ? 1 : 0;
+}
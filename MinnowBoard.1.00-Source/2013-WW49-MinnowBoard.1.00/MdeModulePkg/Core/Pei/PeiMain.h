@@ -61,10 +61,22 @@ typedef union {
   VOID                        *Raw;
 } PEI_PPI_LIST_POINTERS;
 
+///
+/// Ends a hash chain of the PPI database.
+///
+#define PEI_PPI_HASH_END    (-1)
+
 ///
 /// PPI database structure which contains two link: PpiList and NotifyList. PpiList
 /// is in head of PpiListPtrs array and notify is in end of PpiListPtrs.
 ///
+/// The entries are also chained by the hash of their GUID, so that PPIs and
+/// notifies are found without a pass over the whole array. The chains of PPIs
+/// run in ascending index order, which is the order they were installed in;
+/// the chains of notifies run in descending index order, which is the order
+/// they were registered in. Chains hold indexes rather than pointers, so that
+/// they survive the move of the PEI Core data to permanent memory.
+///
 typedef struct {
   ///
   /// index of end of PpiList link list.
@@ -90,6 +102,19 @@ typedef struct {
   /// Ppi database.
   ///
   PEI_PPI_LIST_POINTERS   PpiListPtrs[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
+  ///
+  /// First and last PPI of the chain of each hash bucket.
+  ///
+  INTN                    PpiHashHead[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
+  INTN                    PpiHashTail[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
+  ///
+  /// First notify of the chain of each hash bucket.
+  ///
+  INTN                    NotifyHashHead[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
+  ///
+  /// Next entry in the chain of each entry of PpiListPtrs.
+  ///
+  INTN                    HashNext[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
 } PEI_PPI_DATABASE;
 
 
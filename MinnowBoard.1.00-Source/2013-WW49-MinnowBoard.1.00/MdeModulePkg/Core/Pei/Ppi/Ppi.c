@@ -14,6 +14,241 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "PeiMain.h"
 
+/**
+
+  Compare two GUIDs of the PPI database.
+
+  Don't use CompareGuid function here for performance reasons.
+  Instead we compare the GUID as INT32 at a time and branch
+  on the first failed comparison.
+
+  @param Guid1           Pointer to the first GUID.
+  @param Guid2           Pointer to the second GUID.
+
+  @retval TRUE           The GUIDs are the same.
+  @retval FALSE          The GUIDs differ.
+
+**/
+BOOLEAN
+PpiGuidMatch (
+  IN CONST EFI_GUID     *Guid1,
+  IN CONST EFI_GUID     *Guid2
+  )
+{
+  return (BOOLEAN) ((((INT32 *)Guid1)[0] == ((INT32 *)Guid2)[0]) &&
+                    (((INT32 *)Guid1)[1] == ((INT32 *)Guid2)[1]) &&
+                    (((INT32 *)Guid1)[2] == ((INT32 *)Guid2)[2]) &&
+                    (((INT32 *)Guid1)[3] == ((INT32 *)Guid2)[3]));
+}
+
+/**
+
+  Get the hash bucket of a GUID in the PPI database.
+
+  @param Guid            Pointer to the GUID.
+
+  @return The index of the hash bucket.
+
+**/
+UINTN
+PpiHashBucket (
+  IN CONST EFI_GUID     *Guid
+  )
+{
+  return (((UINT32 *)Guid)[0] ^ ((UINT32 *)Guid)[1] ^ ((UINT32 *)Guid)[2] ^ ((UINT32 *)Guid)[3]) %
+         FixedPcdGet32 (PcdPeiCoreMaxPpiSupported);
+}
+
+/**
+
+  Add an installed PPI to the chain of its hash bucket.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Index           Index of the PPI in the PPI database.
+
+**/
+VOID
+PpiHashInsert (
+  IN PEI_CORE_INSTANCE  *PrivateData,
+  IN INTN               Index
+  )
+{
+  PEI_PPI_DATABASE      *PpiData;
+  UINTN                 Bucket;
+  INTN                  Previous;
+  INTN                  Next;
+
+  PpiData = &PrivateData->PpiData;
+  Bucket  = PpiHashBucket (PpiData->PpiListPtrs[Index].Ppi->Guid);
+
+  //
+  // PPIs are installed at the end of the list, so they go at the tail of
+  // their chain. Only a reinstalled PPI can go in the middle.
+  //
+  if (PpiData->PpiHashTail[Bucket] < Index) {
+    if (PpiData->PpiHashTail[Bucket] == PEI_PPI_HASH_END) {
+      PpiData->PpiHashHead[Bucket] = Index;
+    } else {
+      PpiData->HashNext[PpiData->PpiHashTail[Bucket]] = Index;
+    }
+    PpiData->HashNext[Index]     = PEI_PPI_HASH_END;
+    PpiData->PpiHashTail[Bucket] = Index;
+    return;
+  }
+
+  Previous = PEI_PPI_HASH_END;
+  Next     = PpiData->PpiHashHead[Bucket];
+  while (Next < Index) {
+    Previous = Next;
+    Next     = PpiData->HashNext[Next];
+  }
+  PpiData->HashNext[Index] = Next;
+  if (Previous == PEI_PPI_HASH_END) {
+    PpiData->PpiHashHead[Bucket] = Index;
+  } else {
+    PpiData->HashNext[Previous] = Index;
+  }
+}
+
+/**
+
+  Remove a PPI from the chain of its hash bucket.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Index           Index of the PPI in the PPI database.
+  @param Guid            GUID the PPI was added to its chain with.
+
+  @retval TRUE           The PPI was removed.
+  @retval FALSE          The PPI is not in the chain of Guid.
+
+**/
+BOOLEAN
+PpiHashRemove (
+  IN PEI_CORE_INSTANCE  *PrivateData,
+  IN INTN               Index,
+  IN CONST EFI_GUID     *Guid
+  )
+{
+  PEI_PPI_DATABASE      *PpiData;
+  UINTN                 Bucket;
+  INTN                  Previous;
+  INTN                  Next;
+
+  PpiData  = &PrivateData->PpiData;
+  Bucket   = PpiHashBucket (Guid);
+  Previous = PEI_PPI_HASH_END;
+  Next     = PpiData->PpiHashHead[Bucket];
+  while (Next != Index) {
+    if (Next == PEI_PPI_HASH_END) {
+      return FALSE;
+    }
+    Previous = Next;
+    Next     = PpiData->HashNext[Next];
+  }
+
+  if (Previous == PEI_PPI_HASH_END) {
+    PpiData->PpiHashHead[Bucket] = PpiData->HashNext[Index];
+  } else {
+    PpiData->HashNext[Previous] = PpiData->HashNext[Index];
+  }
+  if (PpiData->PpiHashTail[Bucket] == Index) {
+    PpiData->PpiHashTail[Bucket] = Previous;
+  }
+  return TRUE;
+}
+
+/**
+
+  Rebuild the hash chains of all installed PPIs.
+
+  @param PrivateData     Pointer to the PEI Core data.
+
+**/
+VOID
+PpiHashRebuild (
+  IN PEI_CORE_INSTANCE  *PrivateData
+  )
+{
+  UINTN                 Bucket;
+  INTN                  Index;
+
+  for (Bucket = 0; Bucket < FixedPcdGet32 (PcdPeiCoreMaxPpiSupported); Bucket++) {
+    PrivateData->PpiData.PpiHashHead[Bucket] = PEI_PPI_HASH_END;
+    PrivateData->PpiData.PpiHashTail[Bucket] = PEI_PPI_HASH_END;
+  }
+  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
+    PpiHashInsert (PrivateData, Index);
+  }
+}
+
+/**
+
+  Add a registered notify to the end of the chain of its hash bucket.
+
+  Notifies are registered at the bottom of the notify list, so a new notify
+  has the lowest index in its chain.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Index           Index of the notify in the PPI database.
+
+**/
+VOID
+NotifyHashAppend (
+  IN PEI_CORE_INSTANCE  *PrivateData,
+  IN INTN               Index
+  )
+{
+  PEI_PPI_DATABASE      *PpiData;
+  UINTN                 Bucket;
+  INTN                  Chain;
+
+  PpiData = &PrivateData->PpiData;
+  Bucket  = PpiHashBucket (PpiData->PpiListPtrs[Index].Notify->Guid);
+
+  PpiData->HashNext[Index] = PEI_PPI_HASH_END;
+  if (PpiData->NotifyHashHead[Bucket] == PEI_PPI_HASH_END) {
+    PpiData->NotifyHashHead[Bucket] = Index;
+    return;
+  }
+  for (Chain = PpiData->NotifyHashHead[Bucket];
+       PpiData->HashNext[Chain] != PEI_PPI_HASH_END;
+       Chain = PpiData->HashNext[Chain]) {
+  }
+  PpiData->HashNext[Chain] = Index;
+}
+
+/**
+
+  Rebuild the hash chains of all registered notifies.
+
+  Registering a dispatch level notify moves the callback level notifies
+  within the notify list, so the chains are rebuilt after such a registration.
+  Notifies are never removed, so the buckets of the registered notifies are
+  all the buckets that can hold a chain.
+
+  @param PrivateData     Pointer to the PEI Core data.
+
+**/
+VOID
+NotifyHashRebuild (
+  IN PEI_CORE_INSTANCE  *PrivateData
+  )
+{
+  PEI_PPI_DATABASE      *PpiData;
+  UINTN                 Bucket;
+  INTN                  Index;
+
+  PpiData = &PrivateData->PpiData;
+  for (Index = PpiData->NotifyListEnd + 1; Index < (INTN) FixedPcdGet32 (PcdPeiCoreMaxPpiSupported); Index++) {
+    PpiData->NotifyHashHead[PpiHashBucket (PpiData->PpiListPtrs[Index].Notify->Guid)] = PEI_PPI_HASH_END;
+  }
+  for (Index = PpiData->NotifyListEnd + 1; Index < (INTN) FixedPcdGet32 (PcdPeiCoreMaxPpiSupported); Index++) {
+    Bucket                          = PpiHashBucket (PpiData->PpiListPtrs[Index].Notify->Guid);
+    PpiData->HashNext[Index]        = PpiData->NotifyHashHead[Bucket];
+    PpiData->NotifyHashHead[Bucket] = Index;
+  }
+}
+
 /**
 
   Initialize PPI services.
@@ -29,10 +264,17 @@ InitializePpiServices (
   IN PEI_CORE_INSTANCE *OldCoreData
   )
 {
+  UINTN   Bucket;
+
   if (OldCoreData == NULL) {
     PrivateData->PpiData.NotifyListEnd = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
     PrivateData->PpiData.DispatchListEnd = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
     PrivateData->PpiData.LastDispatchedNotify = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
+    for (Bucket = 0; Bucket < FixedPcdGet32 (PcdPeiCoreMaxPpiSupported); Bucket++) {
+      PrivateData->PpiData.PpiHashHead[Bucket]    = PEI_PPI_HASH_END;
+      PrivateData->PpiData.PpiHashTail[Bucket]    = PEI_PPI_HASH_END;
+      PrivateData->PpiData.NotifyHashHead[Bucket] = PEI_PPI_HASH_END;
+    }
   }
 }
 
@@ -214,6 +456,9 @@ PeiInstallPpi (
     // PcdPeiCoreMaxPpiSupported can be set to a larger value in DSC to satisfy more PPI requirement.
     //
     if (Index == PrivateData->PpiData.NotifyListEnd + 1) {
+      for (Index = LastCallbackInstall; Index < PrivateData->PpiData.PpiListEnd; Index++) {
+        PpiHashInsert (PrivateData, Index);
+      }
       return  EFI_OUT_OF_RESOURCES;
     }
     //
@@ -242,6 +487,10 @@ PeiInstallPpi (
     Index++;
   }
 
+  for (Index = LastCallbackInstall; Index < PrivateData->PpiData.PpiListEnd; Index++) {
+    PpiHashInsert (PrivateData, Index);
+  }
+
   //
   // Dispatch any callback level notifies for newly installed PPIs.
   //
@@ -285,6 +534,7 @@ PeiReInstallPpi (
 {
   PEI_CORE_INSTANCE   *PrivateData;
   INTN                Index;
+  BOOLEAN             Removed;
 
 
   if ((OldPpi == NULL) || (NewPpi == NULL)) {
@@ -315,7 +565,16 @@ PeiReInstallPpi (
   //
   DEBUG((EFI_D_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
   ASSERT (Index < (INTN)(FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)));
+  Removed = PpiHashRemove (PrivateData, Index, OldPpi->Guid);
   PrivateData->PpiData.PpiListPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  if (Removed) {
+    PpiHashInsert (PrivateData, Index);
+  } else {
+    //
+    // The GUID of the old descriptor changed after it was installed.
+    //
+    PpiHashRebuild (PrivateData);
+  }
 
   //
   // Dispatch any callback level notifies for the newly installed PPI.
@@ -361,28 +620,21 @@ PeiLocatePpi (
 {
   PEI_CORE_INSTANCE   *PrivateData;
   INTN                Index;
-  EFI_GUID            *CheckGuid;
   EFI_PEI_PPI_DESCRIPTOR  *TempPtr;
 
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
 
   //
-  // Search the data base for the matching instance of the GUIDed PPI.
+  // Search the chain of the GUID for the matching instance of the GUIDed PPI.
+  // The chain is in installation order, as the instance numbers are.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
+  for (Index = PrivateData->PpiData.PpiHashHead[PpiHashBucket (Guid)];
+       Index != PEI_PPI_HASH_END;
+       Index = PrivateData->PpiData.HashNext[Index]) {
     TempPtr = PrivateData->PpiData.PpiListPtrs[Index].Ppi;
-    CheckGuid = TempPtr->Guid;
 
-    //
-    // Don't use CompareGuid function here for performance reasons.
-    // Instead we compare the GUID as INT32 at a time and branch
-    // on the first failed comparison.
-    //
-    if ((((INT32 *)Guid)[0] == ((INT32 *)CheckGuid)[0]) &&
-        (((INT32 *)Guid)[1] == ((INT32 *)CheckGuid)[1]) &&
-        (((INT32 *)Guid)[2] == ((INT32 *)CheckGuid)[2]) &&
-        (((INT32 *)Guid)[3] == ((INT32 *)CheckGuid)[3])) {
+    if (PpiGuidMatch (Guid, TempPtr->Guid)) {
       if (Instance == 0) {
 
         if (PpiDescriptor != NULL) {
@@ -456,6 +708,9 @@ PeiNotifyPpi (
     // PcdPeiCoreMaxPpiSupported can be set to a larger value in DSC to satisfy more Notify PPIs requirement.
     //
     if (Index == PrivateData->PpiData.PpiListEnd - 1) {
+      for (NotifyIndex = LastCallbackNotify; NotifyIndex > PrivateData->PpiData.NotifyListEnd; NotifyIndex--) {
+        NotifyHashAppend (PrivateData, NotifyIndex);
+      }
       return  EFI_OUT_OF_RESOURCES;
     }
 
@@ -504,6 +759,12 @@ PeiNotifyPpi (
     }
 
     LastCallbackNotify -= NotifyDispatchCount;
+
+    NotifyHashRebuild (PrivateData);
+  } else {
+    for (NotifyIndex = LastCallbackNotify; NotifyIndex > PrivateData->PpiData.NotifyListEnd; NotifyIndex--) {
+      NotifyHashAppend (PrivateData, NotifyIndex);
+    }
   }
 
   //
@@ -609,29 +870,79 @@ DispatchNotify (
 {
   INTN                   Index1;
   INTN                   Index2;
+  INTN                   Chain;
+  INTN                   Next;
   EFI_GUID                *SearchGuid;
   EFI_GUID                *CheckGuid;
   EFI_PEI_NOTIFY_DESCRIPTOR   *NotifyDescriptor;
+  PEI_PPI_DATABASE       *PpiData;
+
+  PpiData = &PrivateData->PpiData;
 
   //
-  // Remember that Installs moves up and Notifies moves down.
+  // Remember that Installs moves up and Notifies moves down. The notifies
+  // fire from the oldest one, each for the matching PPIs from the oldest one.
   //
-  for (Index1 = NotifyStartIndex; Index1 > NotifyStopIndex; Index1--) {
-    NotifyDescriptor = PrivateData->PpiData.PpiListPtrs[Index1].Notify;
+  if (NotifyStartIndex - NotifyStopIndex <= InstallStopIndex - InstallStartIndex) {
+    //
+    // Few notifies, such as the ones just registered: look each one up in
+    // the chains of installed PPIs.
+    //
+    for (Index1 = NotifyStartIndex; Index1 > NotifyStopIndex; Index1--) {
+      NotifyDescriptor = PpiData->PpiListPtrs[Index1].Notify;
+
+      CheckGuid = NotifyDescriptor->Guid;
+
+      for (Index2 = PpiData->PpiHashHead[PpiHashBucket (CheckGuid)];
+           Index2 != PEI_PPI_HASH_END && Index2 < InstallStopIndex;
+           Index2 = PpiData->HashNext[Index2]) {
+        SearchGuid = PpiData->PpiListPtrs[Index2].Ppi->Guid;
+        if (Index2 >= InstallStartIndex && PpiGuidMatch (SearchGuid, CheckGuid)) {
+          DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
+            SearchGuid,
+            NotifyDescriptor->Notify
+            ));
+          NotifyDescriptor->Notify (
+                              (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
+                              NotifyDescriptor,
+                              (PpiData->PpiListPtrs[Index2].Ppi)->Ppi
+                              );
+        }
+      }
+    }
+    return;
+  }
+
+  //
+  // Few PPIs, such as the ones just installed: find the next notify to fire
+  // in the chains of notifies of their GUIDs, which run from the oldest one.
+  //
+  Index1 = NotifyStartIndex + 1;
+  for (;;) {
+    Next = NotifyStopIndex;
+    for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
+      SearchGuid = PpiData->PpiListPtrs[Index2].Ppi->Guid;
+      for (Chain = PpiData->NotifyHashHead[PpiHashBucket (SearchGuid)];
+           Chain > Next;
+           Chain = PpiData->HashNext[Chain]) {
+        if (Chain < Index1 && PpiGuidMatch (SearchGuid, PpiData->PpiListPtrs[Chain].Notify->Guid)) {
+          Next = Chain;
+          break;
+        }
+      }
+    }
+    if (Next == NotifyStopIndex) {
+      break;
+    }
+
+    Index1           = Next;
+    NotifyDescriptor = PpiData->PpiListPtrs[Index1].Notify;
 
     CheckGuid = NotifyDescriptor->Guid;
 
     for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
-      SearchGuid = PrivateData->PpiData.PpiListPtrs[Index2].Ppi->Guid;
-      //
-      // Don't use CompareGuid function here for performance reasons.
-      // Instead we compare the GUID as INT32 at a time and branch
-      // on the first failed comparison.
-      //
-      if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
-          (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
-          (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
-          (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3])) {
+      SearchGuid = PpiData->PpiListPtrs[Index2].Ppi->Guid;
+      if (PpiGuidMatch (SearchGuid, CheckGuid)) {
         DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
           SearchGuid,
           NotifyDescriptor->Notify
@@ -639,10 +950,9 @@ DispatchNotify (
         NotifyDescriptor->Notify (
                             (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
                             NotifyDescriptor,
-                            (PrivateData->PpiData.PpiListPtrs[Index2].Ppi)->Ppi
+                            (PpiData->PpiListPtrs[Index2].Ppi)->Ppi
                             );
       }
     }
   }
 }
-
@@ -0,0 +1,65 @@
+/** @file
+  Index of the GUID extension HOBs in the HOB list, published by the DXE Core
+  in the EFI System Configuration Table.
+
+  The DXE Core builds the index once, after it has processed the HOB list, so
+  that HOB Library instances can find GUIDed HOBs without walking the whole
+  HOB list on every lookup. The table is laid out as a HOB_INDEX_HEADER,
+  followed by EntryCount HOB_INDEX_ENTRY structures and BucketCount UINT32
+  bucket heads. Every bucket holds the index of the first entry of a chain
+  linked through Next and ended by HOB_INDEX_END. The entries of a chain are
+  in the order the HOBs appear in the HOB list.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __HOB_INDEX_H__
+#define __HOB_INDEX_H__
+
+#define HOB_INDEX_GUID \
+  { 0x2897ddd3, 0xaba7, 0x4936, { 0x93, 0x1b, 0x0a, 0x1c, 0x3e, 0x97, 0x76, 0x75 } }
+
+extern EFI_GUID gHobIndexGuid;
+
+///
+/// Terminates a chain of entries.
+///
+#define HOB_INDEX_END               0xFFFFFFFF
+
+///
+/// Bucket of a GUID. BucketCount is always a power of two.
+///
+#define HOB_INDEX_BUCKET(Guid, BucketCount) \
+  ((((CONST UINT32 *) (Guid))[0] ^ ((CONST UINT32 *) (Guid))[1] ^ \
+    ((CONST UINT32 *) (Guid))[2] ^ ((CONST UINT32 *) (Guid))[3]) & ((BucketCount) - 1))
+
+typedef struct {
+  ///
+  /// The HOB list the index was built from.
+  ///
+  VOID                  *HobList;
+  ///
+  /// The end of list HOB of that HOB list.
+  ///
+  VOID                  *HobEnd;
+  UINT32                BucketCount;
+  UINT32                EntryCount;
+} HOB_INDEX_HEADER;
+
+typedef struct {
+  EFI_HOB_GUID_TYPE     *Hob;
+  UINT32                Next;
+} HOB_INDEX_ENTRY;
+
+#define HOB_INDEX_ENTRIES(Index)    ((HOB_INDEX_ENTRY *) ((HOB_INDEX_HEADER *) (Index) + 1))
+#define HOB_INDEX_BUCKETS(Index)    ((UINT32 *) (HOB_INDEX_ENTRIES (Index) + ((HOB_INDEX_HEADER *) (Index))->EntryCount))
+
+#endif
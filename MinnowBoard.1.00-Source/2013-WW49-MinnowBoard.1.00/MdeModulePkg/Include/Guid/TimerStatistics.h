@@ -0,0 +1,45 @@
+/** @file
+  Timer event statistics, published by the DXE Core in the EFI System
+  Configuration Table.
+
+  The table points at the counters the DXE Core updates as it signals timer
+  events, so it always holds the current values. All times are in 100ns
+  units. The latency of a timer is the time between its requested trigger
+  time and the signal of its event, so it includes any delay added by timer
+  coalescing.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __TIMER_STATISTICS_H__
+#define __TIMER_STATISTICS_H__
+
+#define TIMER_STATISTICS_GUID \
+  { 0x8529836d, 0x538e, 0x4bc1, { 0xb0, 0x01, 0xca, 0xf3, 0x38, 0x4b, 0xcd, 0xd5 } }
+
+extern EFI_GUID gTimerStatisticsGuid;
+
+typedef struct {
+  ///
+  /// The number of timer events signaled.
+  ///
+  UINT64                FireCount;
+  ///
+  /// The sum of the latencies of those timer events.
+  ///
+  UINT64                LatencyTotal;
+  ///
+  /// The largest latency of those timer events.
+  ///
+  UINT64                LatencyMax;
+} TIMER_STATISTICS;
+
+#endif
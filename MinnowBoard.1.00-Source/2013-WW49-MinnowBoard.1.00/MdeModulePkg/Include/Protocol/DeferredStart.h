@@ -0,0 +1,114 @@
+/** @file
+
+  EFI Deferred Start Protocol.
+
+  Lets a driver that has to wait for hardware during Start() return and have
+  the rest of its work run later from a timer, rather than stalling. While the
+  hardware settles the boot manager connects other controllers, and waits for
+  all outstanding work once every controller has been started.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available under 
+the terms and conditions of the BSD License that accompanies this distribution.  
+The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php.                                            
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,                     
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+
+#ifndef __DEFERRED_START_H__
+#define __DEFERRED_START_H__
+
+//
+// Deferred Start Protocol GUID value
+//
+#define EFI_DEFERRED_START_PROTOCOL_GUID \
+    { \
+      0xcc161907, 0x684, 0x47a4, { 0x9f, 0x46, 0xd3, 0xc7, 0x53, 0x28, 0x68, 0xa4 } \
+    }
+
+//
+// Forward reference for pure ANSI compatability
+//
+typedef struct _EFI_DEFERRED_START_PROTOCOL  EFI_DEFERRED_START_PROTOCOL;
+
+/**
+  Continue work that was waiting for hardware.
+
+  The continuation runs at TPL_CALLBACK. It may post further continuations.
+
+  @param  Context              The context passed to PostContinuation().
+
+**/
+typedef
+VOID
+(EFIAPI *EFI_DEFERRED_START_CONTINUATION)(
+  IN VOID  *Context
+  );
+
+/**
+  Arrange for a continuation to run once a delay has passed.
+
+  The continuation never runs before PostContinuation() returns, even when
+  Delay is zero. Continuations that are still outstanding are what
+  WaitForContinuations() waits for.
+
+  @param  This          The protocol instance pointer.
+  @param  Delay         The least time, in 100ns units, before Continuation runs.
+  @param  Continuation  The function to run.
+  @param  Context       Passed to Continuation.
+
+  @retval EFI_SUCCESS            The continuation was posted.
+  @retval EFI_INVALID_PARAMETER  Continuation is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There are not enough resources available to
+                                 post the continuation.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DEFERRED_START_POST)(
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Delay,
+  IN EFI_DEFERRED_START_CONTINUATION  Continuation,
+  IN VOID                             *Context    OPTIONAL
+  );
+
+/**
+  Wait until no continuation is outstanding.
+
+  Must be called below TPL_CALLBACK, otherwise no continuation could run.
+
+  @param  This     The protocol instance pointer.
+  @param  Timeout  The longest time to wait, in 100ns units. Zero waits
+                   without limit.
+
+  @retval EFI_SUCCESS            No continuation is outstanding.
+  @retval EFI_TIMEOUT            Continuations were still outstanding when
+                                 Timeout expired.
+  @retval EFI_UNSUPPORTED        The caller runs at TPL_CALLBACK or above.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DEFERRED_START_WAIT)(
+  IN EFI_DEFERRED_START_PROTOCOL      *This,
+  IN UINT64                           Timeout
+  );
+
+///
+/// Deferred Start Protocol structure.
+///
+struct _EFI_DEFERRED_START_PROTOCOL {
+  EFI_DEFERRED_START_POST  PostContinuation;
+  EFI_DEFERRED_START_WAIT  WaitForContinuations;
+};
+
+///
+/// Deferred Start Protocol GUID variable.
+///
+extern EFI_GUID gEfiDeferredStartProtocolGuid;
+
+#endif
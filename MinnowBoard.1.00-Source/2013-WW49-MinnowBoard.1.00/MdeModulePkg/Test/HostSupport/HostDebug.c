@@ -0,0 +1,106 @@
+/** @file
+  DebugLib for the host harnesses. Messages at DEBUG_ERROR level and failed
+  assertions go to stderr; a failed assertion ends the program.
+
+  Only Base.h types are used, so that PEI harnesses can link it as well.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Base.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PrintLib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HOST_DEBUG_BUFFER_SIZE    0x200
+
+VOID
+EFIAPI
+DebugPrint (
+  IN  UINTN             ErrorLevel,
+  IN  CONST CHAR8       *Format,
+  ...
+  )
+{
+  CHAR8     Buffer[HOST_DEBUG_BUFFER_SIZE];
+  VA_LIST   Marker;
+
+  if ((ErrorLevel & DEBUG_ERROR) == 0) {
+    return;
+  }
+
+  VA_START (Marker, Format);
+  AsciiVSPrint (Buffer, sizeof (Buffer), Format, Marker);
+  VA_END (Marker);
+  fputs (Buffer, stderr);
+}
+
+VOID
+EFIAPI
+DebugAssert (
+  IN CONST CHAR8        *FileName,
+  IN UINTN              LineNumber,
+  IN CONST CHAR8        *Description
+  )
+{
+  fprintf (stderr, "ASSERT %s(%u): %s\n", FileName, (unsigned) LineNumber, Description);
+  abort ();
+}
+
+VOID *
+EFIAPI
+DebugClearMemory (
+  OUT VOID              *Buffer,
+  IN UINTN              Length
+  )
+{
+  return SetMem (Buffer, Length, 0xAF);
+}
+
+BOOLEAN
+EFIAPI
+DebugAssertEnabled (
+  VOID
+  )
+{
+  return TRUE;
+}
+
+BOOLEAN
+EFIAPI
+DebugPrintEnabled (
+  VOID
+  )
+{
+  return TRUE;
+}
+
+BOOLEAN
+EFIAPI
+DebugCodeEnabled (
+  VOID
+  )
+{
+  return TRUE;
+}
+
+BOOLEAN
+EFIAPI
+DebugClearMemoryEnabled (
+  VOID
+  )
+{
+  return FALSE;
+}
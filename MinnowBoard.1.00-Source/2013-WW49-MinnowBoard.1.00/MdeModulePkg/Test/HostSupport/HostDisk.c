@@ -0,0 +1,263 @@
+/** @file
+  Block I/O and Disk I/O over an image file for the host harnesses.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostSupport.h"
+
+#include <Library/DebugLib.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HOST_DISK_SIGNATURE   SIGNATURE_32 ('h', 'd', 's', 'k')
+
+typedef struct {
+  UINT32                  Signature;
+  int                     Fd;
+  EFI_HANDLE              Handle;
+  EFI_BLOCK_IO_MEDIA      Media;
+  EFI_BLOCK_IO_PROTOCOL   BlockIo;
+  EFI_DISK_IO_PROTOCOL    DiskIo;
+} HOST_DISK;
+
+#define HOST_DISK_FROM_BLOCK_IO(a)  CR (a, HOST_DISK, BlockIo, HOST_DISK_SIGNATURE)
+#define HOST_DISK_FROM_DISK_IO(a)   CR (a, HOST_DISK, DiskIo, HOST_DISK_SIGNATURE)
+
+HOST_DISK_COUNTERS        gHostDiskCounters;
+
+/**
+  Read from or write to the image file, counting the request. A write to
+  read-only media is only counted.
+
+**/
+EFI_STATUS
+HostDiskTransfer (
+  IN     HOST_DISK          *Disk,
+  IN     BOOLEAN            Write,
+  IN     UINT64             Offset,
+  IN     UINTN              Size,
+  IN OUT VOID               *Buffer
+  )
+{
+  ssize_t   Done;
+
+  if (Write && Disk->Media.ReadOnly) {
+    gHostDiskCounters.Writes++;
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (Offset + Size > MultU64x32 (Disk->Media.LastBlock + 1, Disk->Media.BlockSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Write) {
+    gHostDiskCounters.Writes++;
+    gHostDiskCounters.WriteBytes += Size;
+    Done = pwrite (Disk->Fd, Buffer, Size, (off_t) Offset);
+  } else {
+    gHostDiskCounters.Reads++;
+    gHostDiskCounters.ReadBytes += Size;
+    Done = pread (Disk->Fd, Buffer, Size, (off_t) Offset);
+  }
+
+  return (Done == (ssize_t) Size) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+}
+
+EFI_STATUS
+EFIAPI
+HostBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostBlockIoReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL *This,
+  IN  UINT32                MediaId,
+  IN  EFI_LBA               Lba,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  HOST_DISK   *Disk;
+
+  Disk = HOST_DISK_FROM_BLOCK_IO (This);
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+  if (BufferSize % Disk->Media.BlockSize != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  return HostDiskTransfer (Disk, FALSE, MultU64x32 (Lba, Disk->Media.BlockSize), BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+HostBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  HOST_DISK   *Disk;
+
+  Disk = HOST_DISK_FROM_BLOCK_IO (This);
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+  if (BufferSize % Disk->Media.BlockSize != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  return HostDiskTransfer (Disk, TRUE, MultU64x32 (Lba, Disk->Media.BlockSize), BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+HostBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  gHostDiskCounters.Flushes++;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostDiskIoReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL  *This,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  HOST_DISK   *Disk;
+
+  Disk = HOST_DISK_FROM_DISK_IO (This);
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  return HostDiskTransfer (Disk, FALSE, Offset, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+HostDiskIoWriteDisk (
+  IN EFI_DISK_IO_PROTOCOL   *This,
+  IN UINT32                 MediaId,
+  IN UINT64                 Offset,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  HOST_DISK   *Disk;
+
+  Disk = HOST_DISK_FROM_DISK_IO (This);
+  if (MediaId != Disk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  return HostDiskTransfer (Disk, TRUE, Offset, BufferSize, Buffer);
+}
+
+EFI_STATUS
+HostOpenDisk (
+  IN  CONST CHAR8       *Path,
+  IN  UINT32            BlockSize,
+  IN  BOOLEAN           ReadOnly,
+  OUT EFI_HANDLE        *Handle
+  )
+{
+  HOST_DISK   *Disk;
+  off_t       Size;
+  EFI_STATUS  Status;
+
+  Disk = AllocateZeroPool (sizeof (HOST_DISK));
+  if (Disk == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Disk->Fd = open (Path, ReadOnly ? O_RDONLY : O_RDWR);
+  if (Disk->Fd < 0) {
+    FreePool (Disk);
+    return EFI_NOT_FOUND;
+  }
+  Size = lseek (Disk->Fd, 0, SEEK_END);
+
+  Disk->Signature               = HOST_DISK_SIGNATURE;
+  Disk->Media.MediaId           = 1;
+  Disk->Media.MediaPresent      = TRUE;
+  Disk->Media.ReadOnly          = ReadOnly;
+  Disk->Media.BlockSize         = BlockSize;
+  Disk->Media.LastBlock         = (EFI_LBA) (Size / BlockSize) - 1;
+  Disk->BlockIo.Revision        = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  Disk->BlockIo.Media           = &Disk->Media;
+  Disk->BlockIo.Reset           = HostBlockIoReset;
+  Disk->BlockIo.ReadBlocks      = HostBlockIoReadBlocks;
+  Disk->BlockIo.WriteBlocks     = HostBlockIoWriteBlocks;
+  Disk->BlockIo.FlushBlocks     = HostBlockIoFlushBlocks;
+  Disk->DiskIo.Revision         = EFI_DISK_IO_PROTOCOL_REVISION;
+  Disk->DiskIo.ReadDisk         = HostDiskIoReadDisk;
+  Disk->DiskIo.WriteDisk        = HostDiskIoWriteDisk;
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Disk->Handle,
+                  &gEfiBlockIoProtocolGuid,
+                  &Disk->BlockIo,
+                  &gEfiDiskIoProtocolGuid,
+                  &Disk->DiskIo,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    close (Disk->Fd);
+    FreePool (Disk);
+    return Status;
+  }
+
+  *Handle = Disk->Handle;
+  return EFI_SUCCESS;
+}
+
+VOID
+HostCloseDisk (
+  IN EFI_HANDLE         Handle
+  )
+{
+  EFI_BLOCK_IO_PROTOCOL   *BlockIo;
+  HOST_DISK               *Disk;
+
+  if (EFI_ERROR (HostHandleProtocol (Handle, &gEfiBlockIoProtocolGuid, (VOID **) &BlockIo))) {
+    return;
+  }
+
+  Disk = HOST_DISK_FROM_BLOCK_IO (BlockIo);
+  gBS->UninstallMultipleProtocolInterfaces (
+         Disk->Handle,
+         &gEfiBlockIoProtocolGuid,
+         &Disk->BlockIo,
+         &gEfiDiskIoProtocolGuid,
+         &Disk->DiskIo,
+         NULL
+         );
+  close (Disk->Fd);
+  FreePool (Disk);
+}
@@ -0,0 +1,83 @@
+/** @file
+  MemoryAllocationLib for the host harnesses, over the C library heap.
+
+  Only the pool functions are provided.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Base.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include <stdlib.h>
+
+VOID *
+EFIAPI
+AllocatePool (
+  IN UINTN              AllocationSize
+  )
+{
+  return malloc (AllocationSize);
+}
+
+VOID *
+EFIAPI
+AllocateZeroPool (
+  IN UINTN              AllocationSize
+  )
+{
+  return calloc (1, AllocationSize);
+}
+
+VOID *
+EFIAPI
+AllocateCopyPool (
+  IN UINTN              AllocationSize,
+  IN CONST VOID         *Buffer
+  )
+{
+  VOID  *Memory;
+
+  Memory = malloc (AllocationSize);
+  if (Memory != NULL) {
+    CopyMem (Memory, Buffer, AllocationSize);
+  }
+  return Memory;
+}
+
+VOID *
+EFIAPI
+ReallocatePool (
+  IN UINTN              OldSize,
+  IN UINTN              NewSize,
+  IN VOID               *OldBuffer  OPTIONAL
+  )
+{
+  VOID  *NewBuffer;
+
+  NewBuffer = AllocateZeroPool (NewSize);
+  if (NewBuffer != NULL && OldBuffer != NULL) {
+    CopyMem (NewBuffer, OldBuffer, MIN (OldSize, NewSize));
+    FreePool (OldBuffer);
+  }
+  return NewBuffer;
+}
+
+VOID
+EFIAPI
+FreePool (
+  IN VOID               *Buffer
+  )
+{
+  free (Buffer);
+}
@@ -0,0 +1,381 @@
+/** @file
+  Host implementations of the system table, boot services and runtime
+  services that the modules built by the host harnesses use.
+
+  Only what those modules need is provided. The handle database keeps a few
+  protocols per handle and does not track agents; protocol open attributes
+  are ignored.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostSupport.h"
+
+#include <time.h>
+
+#define HOST_MAX_HANDLES          32
+#define HOST_MAX_PROTOCOLS        8
+
+typedef struct {
+  BOOLEAN                 InUse;
+  UINTN                   ProtocolCount;
+  EFI_GUID                Protocol[HOST_MAX_PROTOCOLS];
+  VOID                    *Interface[HOST_MAX_PROTOCOLS];
+} HOST_HANDLE;
+
+EFI_HANDLE                gImageHandle;
+EFI_SYSTEM_TABLE          *gST;
+EFI_BOOT_SERVICES         *gBS;
+EFI_RUNTIME_SERVICES      *gRT;
+
+HOST_HANDLE               mHostHandles[HOST_MAX_HANDLES];
+EFI_TPL                   mHostTpl = TPL_APPLICATION;
+UINT32                    mHostCrcTable[256];
+
+EFI_SYSTEM_TABLE          mHostSystemTable;
+EFI_BOOT_SERVICES         mHostBootServices;
+EFI_RUNTIME_SERVICES      mHostRuntimeServices;
+
+//
+// Handle database
+//
+
+/**
+  Find a protocol on a handle.
+
+  @param  Handle                The handle.
+  @param  Protocol              The protocol GUID.
+
+  @return The index of the protocol on the handle, or HOST_MAX_PROTOCOLS.
+
+**/
+UINTN
+HostFindProtocol (
+  IN HOST_HANDLE        *Handle,
+  IN EFI_GUID           *Protocol
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < Handle->ProtocolCount; Index++) {
+    if (CompareGuid (&Handle->Protocol[Index], Protocol)) {
+      return Index;
+    }
+  }
+
+  return HOST_MAX_PROTOCOLS;
+}
+
+EFI_STATUS
+HostHandleProtocol (
+  IN  EFI_HANDLE        Handle,
+  IN  EFI_GUID          *Protocol,
+  OUT VOID              **Interface
+  )
+{
+  HOST_HANDLE   *HostHandle;
+  UINTN         Index;
+
+  HostHandle = (HOST_HANDLE *) Handle;
+  if (HostHandle == NULL || !HostHandle->InUse) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Index = HostFindProtocol (HostHandle, Protocol);
+  if (Index == HOST_MAX_PROTOCOLS) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Interface != NULL) {
+    *Interface = HostHandle->Interface[Index];
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostInstallMultipleProtocolInterfaces (
+  IN OUT EFI_HANDLE     *Handle,
+  ...
+  )
+{
+  VA_LIST       Args;
+  HOST_HANDLE   *HostHandle;
+  EFI_GUID      *Protocol;
+  UINTN         Index;
+
+  HostHandle = (HOST_HANDLE *) *Handle;
+  if (HostHandle == NULL) {
+    for (Index = 0; Index < HOST_MAX_HANDLES && mHostHandles[Index].InUse; Index++) {
+    }
+    if (Index == HOST_MAX_HANDLES) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    HostHandle = &mHostHandles[Index];
+    ZeroMem (HostHandle, sizeof (HOST_HANDLE));
+    HostHandle->InUse = TRUE;
+    *Handle = HostHandle;
+  }
+
+  VA_START (Args, Handle);
+  for (Protocol = VA_ARG (Args, EFI_GUID *); Protocol != NULL; Protocol = VA_ARG (Args, EFI_GUID *)) {
+    if (HostFindProtocol (HostHandle, Protocol) != HOST_MAX_PROTOCOLS) {
+      VA_END (Args);
+      return EFI_ALREADY_STARTED;
+    }
+    if (HostHandle->ProtocolCount == HOST_MAX_PROTOCOLS) {
+      VA_END (Args);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    CopyGuid (&HostHandle->Protocol[HostHandle->ProtocolCount], Protocol);
+    HostHandle->Interface[HostHandle->ProtocolCount] = VA_ARG (Args, VOID *);
+    HostHandle->ProtocolCount++;
+  }
+  VA_END (Args);
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostUninstallMultipleProtocolInterfaces (
+  IN EFI_HANDLE         Handle,
+  ...
+  )
+{
+  VA_LIST       Args;
+  HOST_HANDLE   *HostHandle;
+  EFI_GUID      *Protocol;
+  UINTN         Index;
+
+  HostHandle = (HOST_HANDLE *) Handle;
+  VA_START (Args, Handle);
+  for (Protocol = VA_ARG (Args, EFI_GUID *); Protocol != NULL; Protocol = VA_ARG (Args, EFI_GUID *)) {
+    VA_ARG (Args, VOID *);
+    Index = HostFindProtocol (HostHandle, Protocol);
+    if (Index == HOST_MAX_PROTOCOLS) {
+      VA_END (Args);
+      return EFI_NOT_FOUND;
+    }
+    HostHandle->ProtocolCount--;
+    CopyGuid (&HostHandle->Protocol[Index], &HostHandle->Protocol[HostHandle->ProtocolCount]);
+    HostHandle->Interface[Index] = HostHandle->Interface[HostHandle->ProtocolCount];
+  }
+  VA_END (Args);
+
+  if (HostHandle->ProtocolCount == 0) {
+    HostHandle->InUse = FALSE;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostOpenProtocol (
+  IN  EFI_HANDLE        Handle,
+  IN  EFI_GUID          *Protocol,
+  OUT VOID              **Interface,
+  IN  EFI_HANDLE        AgentHandle,
+  IN  EFI_HANDLE        ControllerHandle,
+  IN  UINT32            Attributes
+  )
+{
+  return HostHandleProtocol (Handle, Protocol, Interface);
+}
+
+EFI_STATUS
+EFIAPI
+HostCloseProtocol (
+  IN EFI_HANDLE         Handle,
+  IN EFI_GUID           *Protocol,
+  IN EFI_HANDLE         AgentHandle,
+  IN EFI_HANDLE         ControllerHandle
+  )
+{
+  return HostHandleProtocol (Handle, Protocol, NULL);
+}
+
+EFI_STATUS
+EFIAPI
+HostLocateHandleBuffer (
+  IN     EFI_LOCATE_SEARCH_TYPE   SearchType,
+  IN     EFI_GUID                 *Protocol,
+  IN     VOID                     *SearchKey,
+  IN OUT UINTN                    *NoHandles,
+  OUT    EFI_HANDLE               **Buffer
+  )
+{
+  UINTN   Index;
+
+  if (SearchType != ByProtocol) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *Buffer = AllocatePool (HOST_MAX_HANDLES * sizeof (EFI_HANDLE));
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *NoHandles = 0;
+  for (Index = 0; Index < HOST_MAX_HANDLES; Index++) {
+    if (mHostHandles[Index].InUse && HostFindProtocol (&mHostHandles[Index], Protocol) != HOST_MAX_PROTOCOLS) {
+      (*Buffer)[(*NoHandles)++] = &mHostHandles[Index];
+    }
+  }
+
+  if (*NoHandles == 0) {
+    FreePool (*Buffer);
+    *Buffer = NULL;
+    return EFI_NOT_FOUND;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostDisconnectController (
+  IN EFI_HANDLE         ControllerHandle,
+  IN EFI_HANDLE         DriverImageHandle,
+  IN EFI_HANDLE         ChildHandle
+  )
+{
+  return EFI_SUCCESS;
+}
+
+//
+// Other boot and runtime services
+//
+
+EFI_TPL
+EFIAPI
+HostRaiseTpl (
+  IN EFI_TPL            NewTpl
+  )
+{
+  EFI_TPL   OldTpl;
+
+  OldTpl   = mHostTpl;
+  mHostTpl = NewTpl;
+  return OldTpl;
+}
+
+VOID
+EFIAPI
+HostRestoreTpl (
+  IN EFI_TPL            OldTpl
+  )
+{
+  mHostTpl = OldTpl;
+}
+
+EFI_STATUS
+EFIAPI
+HostSignalEvent (
+  IN EFI_EVENT          Event
+  )
+{
+  ((HOST_EVENT *) Event)->SignalCount++;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostCalculateCrc32 (
+  IN  VOID              *Data,
+  IN  UINTN             DataSize,
+  OUT UINT32            *Crc32
+  )
+{
+  UINT32    Crc;
+  UINT8     *Byte;
+
+  Crc = 0xFFFFFFFF;
+  for (Byte = Data; DataSize > 0; DataSize--, Byte++) {
+    Crc = (Crc >> 8) ^ mHostCrcTable[(UINT8) Crc ^ *Byte];
+  }
+
+  *Crc32 = Crc ^ 0xFFFFFFFF;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostGetTime (
+  OUT EFI_TIME                  *Time,
+  OUT EFI_TIME_CAPABILITIES     *Capabilities
+  )
+{
+  time_t      Now;
+  struct tm   *Tm;
+
+  Now = time (NULL);
+  Tm  = gmtime (&Now);
+  ZeroMem (Time, sizeof (EFI_TIME));
+  Time->Year     = (UINT16) (Tm->tm_year + 1900);
+  Time->Month    = (UINT8) (Tm->tm_mon + 1);
+  Time->Day      = (UINT8) Tm->tm_mday;
+  Time->Hour     = (UINT8) Tm->tm_hour;
+  Time->Minute   = (UINT8) Tm->tm_min;
+  Time->Second   = (UINT8) Tm->tm_sec;
+  Time->TimeZone = EFI_UNSPECIFIED_TIMEZONE;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HostGetVariable (
+  IN     CHAR16             *VariableName,
+  IN     EFI_GUID           *VendorGuid,
+  OUT    UINT32             *Attributes,
+  IN OUT UINTN              *DataSize,
+  OUT    VOID               *Data
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+VOID
+HostInitializeServices (
+  VOID
+  )
+{
+  UINT32  Index;
+  UINT32  Bit;
+  UINT32  Crc;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = Index;
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc & 1) != 0 ? (Crc >> 1) ^ 0xEDB88320 : Crc >> 1;
+    }
+    mHostCrcTable[Index] = Crc;
+  }
+
+  mHostBootServices.RaiseTPL                            = HostRaiseTpl;
+  mHostBootServices.RestoreTPL                          = HostRestoreTpl;
+  mHostBootServices.SignalEvent                         = HostSignalEvent;
+  mHostBootServices.OpenProtocol                        = HostOpenProtocol;
+  mHostBootServices.CloseProtocol                       = HostCloseProtocol;
+  mHostBootServices.LocateHandleBuffer                  = HostLocateHandleBuffer;
+  mHostBootServices.DisconnectController                = HostDisconnectController;
+  mHostBootServices.InstallMultipleProtocolInterfaces   = HostInstallMultipleProtocolInterfaces;
+  mHostBootServices.UninstallMultipleProtocolInterfaces = HostUninstallMultipleProtocolInterfaces;
+  mHostBootServices.CalculateCrc32                      = HostCalculateCrc32;
+  mHostRuntimeServices.GetTime                          = HostGetTime;
+  mHostRuntimeServices.GetVariable                      = HostGetVariable;
+  mHostSystemTable.BootServices                         = &mHostBootServices;
+  mHostSystemTable.RuntimeServices                      = &mHostRuntimeServices;
+
+  gST           = &mHostSystemTable;
+  gBS           = &mHostBootServices;
+  gRT           = &mHostRuntimeServices;
+  gImageHandle  = NULL;
+}
@@ -0,0 +1,123 @@
+/** @file
+  Host implementations of the UEFI services and library classes that the host
+  harnesses of EDK II modules build against.
+
+  A harness links the sources of this directory it needs into an ordinary
+  program for the build host, together with the module under test and a
+  HostAutoGen.h and HostAutoGen.c of its own, which stand in for the AutoGen
+  files the EDK II build generates: the PCDs, gEfiCallerIdGuid and the GUID
+  globals of the module.
+
+    HostServices.c    system table, boot services and runtime services
+    HostDisk.c        Block I/O and Disk I/O over an image file
+    HostMemory.c      MemoryAllocationLib
+    HostDebug.c       DebugLib
+    HostTimer.c       TimerLib
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_SUPPORT_H_
+#define _HOST_SUPPORT_H_
+
+#include <Uefi.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/DiskIo.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+//
+// There is no CreateEvent(). A harness passes the address of a HOST_EVENT
+// as the event, and SignalEvent() only counts how often it was signaled.
+//
+typedef struct {
+  UINTN   SignalCount;
+} HOST_EVENT;
+
+//
+// Requests that reached the image file, as the device would see them
+//
+typedef struct {
+  UINT64  Reads;
+  UINT64  ReadBytes;
+  UINT64  Writes;
+  UINT64  WriteBytes;
+  UINT64  Flushes;
+} HOST_DISK_COUNTERS;
+
+extern HOST_DISK_COUNTERS  gHostDiskCounters;
+
+/**
+  Set up the system table, boot services and runtime services.
+
+**/
+VOID
+HostInitializeServices (
+  VOID
+  );
+
+/**
+  Find the interface of a protocol on a handle.
+
+  @param  Handle                The handle.
+  @param  Protocol              The protocol GUID.
+  @param  Interface             Receives the interface.
+
+  @retval EFI_SUCCESS           The protocol is on the handle.
+  @retval EFI_UNSUPPORTED       The protocol is not on the handle.
+
+**/
+EFI_STATUS
+HostHandleProtocol (
+  IN  EFI_HANDLE        Handle,
+  IN  EFI_GUID          *Protocol,
+  OUT VOID              **Interface
+  );
+
+/**
+  Create a handle carrying Block I/O and Disk I/O for an image file. On
+  read-only media writes fail and are counted.
+
+  @param  Path                  The image file.
+  @param  BlockSize             The block size reported through Block I/O.
+  @param  ReadOnly              TRUE to open the image file read-only.
+  @param  Handle                Receives the new handle.
+
+  @retval EFI_SUCCESS           The disk is ready.
+  @retval EFI_NOT_FOUND         The image file cannot be opened.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+**/
+EFI_STATUS
+HostOpenDisk (
+  IN  CONST CHAR8       *Path,
+  IN  UINT32            BlockSize,
+  IN  BOOLEAN           ReadOnly,
+  OUT EFI_HANDLE        *Handle
+  );
+
+/**
+  Close the image file behind a handle created by HostOpenDisk().
+
+  @param  Handle                The handle.
+
+**/
+VOID
+HostCloseDisk (
+  IN EFI_HANDLE         Handle
+  );
+
+#endif
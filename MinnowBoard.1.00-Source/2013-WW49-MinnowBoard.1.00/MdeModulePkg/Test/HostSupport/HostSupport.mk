@@ -0,0 +1,71 @@
+## @file
+# Rules shared by the GNU makefiles of the host harnesses.
+#
+# A harness makefile sets the variables below and then includes this file,
+# which provides the all and clean targets. Objects go to $(OUTPUT).
+#
+#   WORKSPACE        the root of the tree
+#   APPNAME          the program to build
+#   LIBRARIES        the MdePkg library instances to build in, as directories
+#                    of MdePkg/Library; their objects are archived so that only
+#                    the members the program uses are linked, as the EDK II
+#                    build does with library instances
+#   SOURCES          the sources of the harness and of the modules under test,
+#                    found through vpath
+#   HOST_SOURCES     the sources of this directory to link in
+#   DEPENDENCIES     the headers the objects of SOURCES depend on
+#   CFLAGS           the compiler flags, with -include HostAutoGen.h
+#   LIB_CFLAGS       the compiler flags for the library instances, if they
+#                    differ from CFLAGS
+#
+# It defines MDEPKG, HOST_SUPPORT, and HOST_INCLUDE with the include paths of
+# MdePkg, of the library instances and of this directory.
+#
+# Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+# This program and the accompanying materials
+# are licensed and made available under the terms and conditions of the BSD License
+# which accompanies this distribution.  The full text of the license may be found at
+# http://opensource.org/licenses/bsd-license.php
+#
+# THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+# WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+OUTPUT ?= Build
+CC ?= gcc
+AR ?= ar
+
+MDEPKG       = $(WORKSPACE)/MdePkg
+HOST_SUPPORT = $(WORKSPACE)/MdeModulePkg/Test/HostSupport
+
+HOST_INCLUDE = -I. -I$(MDEPKG)/Include -I$(MDEPKG)/Include/X64 -I$(HOST_SUPPORT) \
+               $(foreach Lib,$(LIBRARIES),-I$(MDEPKG)/Library/$(Lib))
+
+LIB_CFLAGS ?= $(CFLAGS)
+
+LIB_SOURCES = $(foreach Lib,$(LIBRARIES),$(wildcard $(MDEPKG)/Library/$(Lib)/*.c))
+LIB_OBJECTS = $(patsubst $(WORKSPACE)/%.c,$(OUTPUT)/%.o,$(LIB_SOURCES))
+
+OBJECTS = $(patsubst %.c,$(OUTPUT)/%.o,$(SOURCES) $(HOST_SOURCES))
+
+vpath %.c $(HOST_SUPPORT)
+
+all: $(APPNAME)
+
+$(APPNAME): $(OBJECTS) $(OUTPUT)/libMde.a
+	$(CC) -o $@ $(OBJECTS) $(OUTPUT)/libMde.a
+
+$(OUTPUT)/libMde.a: $(LIB_OBJECTS)
+	$(AR) crs $@ $^
+
+$(OUTPUT)/%.o: %.c HostAutoGen.h $(HOST_SUPPORT)/HostSupport.h $(DEPENDENCIES)
+	@mkdir -p $(dir $@)
+	$(CC) $(CFLAGS) -c -o $@ $<
+
+$(OUTPUT)/MdePkg/%.o: $(MDEPKG)/%.c HostAutoGen.h
+	@mkdir -p $(dir $@)
+	$(CC) $(LIB_CFLAGS) -c -o $@ $<
+
+clean:
+	rm -rf $(OUTPUT)
+
+.PHONY: all run clean
@@ -0,0 +1,29 @@
+/** @file
+  TimerLib for the host harnesses. Nothing on the host waits for hardware,
+  so delays return at once.
+
+  Only the functions the modules built by the harnesses use are provided.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Base.h>
+
+#include <Library/TimerLib.h>
+
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN UINTN              MicroSeconds
+  )
+{
+  return MicroSeconds;
+}
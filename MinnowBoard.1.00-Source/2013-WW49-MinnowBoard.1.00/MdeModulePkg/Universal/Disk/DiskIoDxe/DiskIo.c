@@ -36,7 +36,7 @@ EFI_DRIVER_BINDING_PROTOCOL gDiskIoDriverBinding = {
 
 //
 // Template for DiskIo private data structure.
-// The pointer to BlockIo protocol interface is assigned dynamically.
+// The pointers to BlockIo and BlockIo2 protocol interfaces are assigned dynamically.
 //
 DISK_IO_PRIVATE_DATA        gDiskIoPrivateDataTemplate = {
   DISK_IO_PRIVATE_DATA_SIGNATURE,
@@ -45,6 +45,14 @@ DISK_IO_PRIVATE_DATA        gDiskIoPrivateDataTemplate = {
     DiskIoReadDisk,
     DiskIoWriteDisk
   },
+  {
+    EFI_DISK_IO2_PROTOCOL_REVISION,
+    DiskIo2Cancel,
+    DiskIo2ReadDiskEx,
+    DiskIo2WriteDiskEx,
+    DiskIo2FlushDiskEx
+  },
+  NULL,
   NULL
 };
 
@@ -103,7 +111,8 @@ DiskIoDriverBindingSupported (
 
 /**
   Start this driver on ControllerHandle by opening a Block IO protocol and
-  installing a Disk IO protocol on ControllerHandle.
+  installing a Disk IO protocol on ControllerHandle. If ControllerHandle also
+  supports Block IO2, Disk IO2 is installed as well.
 
   @param  This                 Protocol instance pointer.
   @param  ControllerHandle     Handle of device to bind driver to
@@ -153,21 +162,58 @@ DiskIoDriverBindingStart (
     Status = EFI_OUT_OF_RESOURCES;
     goto ErrorExit;
   }
-  
+
+  InitializeListHead (&Private->TaskQueue);
+  EfiInitializeLock (&Private->TaskQueueLock, TPL_NOTIFY);
+
   //
-  // Install protocol interfaces for the Disk IO device.
+  // Block IO2 is optional. Without it only the blocking Disk IO protocol is produced.
   //
-  Status = gBS->InstallProtocolInterface (
-                  &ControllerHandle,
-                  &gEfiDiskIoProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  &Private->DiskIo
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiBlockIo2ProtocolGuid,
+                  (VOID **) &Private->BlockIo2,
+                  This->DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
                   );
+  if (EFI_ERROR (Status)) {
+    Private->BlockIo2 = NULL;
+  }
+
+  //
+  // Install protocol interfaces for the Disk IO device.
+  //
+  if (Private->BlockIo2 != NULL) {
+    Status = gBS->InstallMultipleProtocolInterfaces (
+                    &ControllerHandle,
+                    &gEfiDiskIoProtocolGuid,
+                    &Private->DiskIo,
+                    &gEfiDiskIo2ProtocolGuid,
+                    &Private->DiskIo2,
+                    NULL
+                    );
+  } else {
+    Status = gBS->InstallProtocolInterface (
+                    &ControllerHandle,
+                    &gEfiDiskIoProtocolGuid,
+                    EFI_NATIVE_INTERFACE,
+                    &Private->DiskIo
+                    );
+  }
 
 ErrorExit:
   if (EFI_ERROR (Status)) {
 
     if (Private != NULL) {
+      if (Private->BlockIo2 != NULL) {
+        gBS->CloseProtocol (
+              ControllerHandle,
+              &gEfiBlockIo2ProtocolGuid,
+              This->DriverBindingHandle,
+              ControllerHandle
+              );
+      }
       FreePool (Private);
     }
 
@@ -187,7 +233,10 @@ ErrorExit1:
 
 /**
   Stop this driver on ControllerHandle by removing Disk IO protocol and closing
-  the Block IO protocol on ControllerHandle.
+  the Block IO protocol on ControllerHandle. Outstanding Disk IO2 requests are
+  cancelled and their Block IO2 transfers are allowed to drain first. If they
+  do not drain within DISK_IO2_DRAIN_TIMEOUT, the protocols are reinstalled
+  and the driver stays on ControllerHandle.
 
   @param  This              Protocol instance pointer.
   @param  ControllerHandle  Handle of device to stop driver on
@@ -196,6 +245,7 @@ ErrorExit1:
   @param  ChildHandleBuffer List of Child Handles to Stop.
 
   @retval EFI_SUCCESS       This driver is removed ControllerHandle
+  @retval EFI_DEVICE_ERROR  Block IO2 transfers are still outstanding
   @retval other             This driver was not removed from this device
 
 **/
@@ -211,6 +261,8 @@ DiskIoDriverBindingStop (
   EFI_STATUS            Status;
   EFI_DISK_IO_PROTOCOL  *DiskIo;
   DISK_IO_PRIVATE_DATA  *Private;
+  BOOLEAN               AllTasksDone;
+  UINTN                 Waited;
 
   //
   // Get our context back.
@@ -229,11 +281,63 @@ DiskIoDriverBindingStop (
 
   Private = DISK_IO_PRIVATE_DATA_FROM_THIS (DiskIo);
 
-  Status = gBS->UninstallProtocolInterface (
-                  ControllerHandle,
-                  &gEfiDiskIoProtocolGuid,
-                  &Private->DiskIo
-                  );
+  if (Private->BlockIo2 != NULL) {
+    Status = gBS->UninstallMultipleProtocolInterfaces (
+                    ControllerHandle,
+                    &gEfiDiskIoProtocolGuid,
+                    &Private->DiskIo,
+                    &gEfiDiskIo2ProtocolGuid,
+                    &Private->DiskIo2,
+                    NULL
+                    );
+  } else {
+    Status = gBS->UninstallProtocolInterface (
+                    ControllerHandle,
+                    &gEfiDiskIoProtocolGuid,
+                    &Private->DiskIo
+                    );
+  }
+
+  if (!EFI_ERROR (Status) && Private->BlockIo2 != NULL) {
+    //
+    // The Block IO2 transfers of cancelled requests still own their buffers,
+    // so wait for them before the instance is freed.
+    //
+    DiskIo2Cancel (&Private->DiskIo2);
+    for (Waited = 0; ; Waited += DISK_IO2_DRAIN_STALL) {
+      EfiAcquireLock (&Private->TaskQueueLock);
+      AllTasksDone = IsListEmpty (&Private->TaskQueue);
+      EfiReleaseLock (&Private->TaskQueueLock);
+      if (AllTasksDone || Waited >= DISK_IO2_DRAIN_TIMEOUT) {
+        break;
+      }
+      gBS->Stall (DISK_IO2_DRAIN_STALL);
+    }
+
+    if (!AllTasksDone) {
+      //
+      // The instance cannot be freed while the device may still write into
+      // it, so keep the driver on the controller.
+      //
+      gBS->InstallMultipleProtocolInterfaces (
+             &ControllerHandle,
+             &gEfiDiskIoProtocolGuid,
+             &Private->DiskIo,
+             &gEfiDiskIo2ProtocolGuid,
+             &Private->DiskIo2,
+             NULL
+             );
+      return EFI_DEVICE_ERROR;
+    }
+
+    gBS->CloseProtocol (
+          ControllerHandle,
+          &gEfiBlockIo2ProtocolGuid,
+          This->DriverBindingHandle,
+          ControllerHandle
+          );
+  }
+
   if (!EFI_ERROR (Status)) {
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -708,6 +812,1027 @@ Done:
 }
 
 
+/**
+  Allocate a subtask for one Block IO2 transfer of an asynchronous request.
+
+  When Bounce is TRUE the transfer goes through a buffer that satisfies the
+  media IoAlign, and CopyLength bytes at Offset of it are exchanged with
+  Buffer; for writes the data is copied in here. Otherwise Buffer is used
+  for the transfer directly.
+
+  @param  Write         TRUE for a write transfer, FALSE for a read.
+  @param  Lba           The starting LBA of the transfer.
+  @param  Length        The transfer size in bytes, a multiple of the block size.
+  @param  IoAlign       The alignment the media requires for transfer buffers.
+  @param  Offset        Offset of the caller's data within the bounce buffer.
+  @param  CopyLength    Number of bytes exchanged with the caller's buffer.
+  @param  Buffer        The caller's buffer.
+  @param  Bounce        Whether the transfer needs a bounce buffer.
+
+  @return The subtask, or NULL if memory could not be allocated.
+
+**/
+DISK_IO_SUBTASK *
+DiskIoCreateSubtask (
+  IN BOOLEAN          Write,
+  IN UINT64           Lba,
+  IN UINTN            Length,
+  IN UINT32           IoAlign,
+  IN UINTN            Offset,
+  IN UINTN            CopyLength,
+  IN UINT8            *Buffer,
+  IN BOOLEAN          Bounce
+  )
+{
+  DISK_IO_SUBTASK     *Subtask;
+
+  Subtask = AllocateZeroPool (sizeof (DISK_IO_SUBTASK));
+  if (Subtask == NULL) {
+    return NULL;
+  }
+
+  Subtask->Signature  = DISK_IO_SUBTASK_SIGNATURE;
+  Subtask->Write      = Write;
+  Subtask->Lba        = Lba;
+  Subtask->Length     = Length;
+  Subtask->Offset     = Offset;
+  Subtask->CopyLength = CopyLength;
+  Subtask->Buffer     = Buffer;
+
+  if (Bounce) {
+    if (IoAlign > 1) {
+      Subtask->PreData       = AllocatePool (Length + IoAlign);
+      Subtask->WorkingBuffer = Subtask->PreData - ((UINTN) Subtask->PreData & (IoAlign - 1)) + IoAlign;
+    } else {
+      Subtask->PreData       = AllocatePool (Length);
+      Subtask->WorkingBuffer = Subtask->PreData;
+    }
+
+    if (Subtask->PreData == NULL) {
+      FreePool (Subtask);
+      return NULL;
+    }
+
+    if (Write) {
+      CopyMem (Subtask->WorkingBuffer + Offset, Buffer, CopyLength);
+    }
+  }
+
+  return Subtask;
+}
+
+/**
+  Free a subtask and its bounce buffer.
+
+  @param  Subtask       The subtask to free.
+
+**/
+VOID
+DiskIoFreeSubtask (
+  IN DISK_IO_SUBTASK  *Subtask
+  )
+{
+  if (Subtask->PreData != NULL) {
+    FreePool (Subtask->PreData);
+  }
+  FreePool (Subtask);
+}
+
+/**
+  Free subtasks that were never submitted.
+
+  @param  Pending       The list of subtasks.
+
+**/
+VOID
+DiskIoFreeSubtasks (
+  IN LIST_ENTRY           *Pending
+  )
+{
+  DISK_IO_SUBTASK         *Subtask;
+
+  while (!IsListEmpty (Pending)) {
+    Subtask = DISK_IO_SUBTASK_FROM_LINK (GetFirstNode (Pending));
+    RemoveEntryList (&Subtask->Link);
+    DiskIoFreeSubtask (Subtask);
+  }
+}
+
+/**
+  Check whether a task has to wait for a write that was queued before it.
+
+  Block IO2 transfers of different requests may complete in any order. A
+  partial block write reads the block and writes it back, so it must not
+  overlap any earlier outstanding write to that block, and no later write
+  may overlap it either. Whole block writes do not depend on each other.
+  A flush has to wait for every task queued before it.
+  The caller must hold the task queue lock.
+
+  @param  Instance      The Disk IO instance.
+  @param  Task          The task, already in the task queue.
+
+  @retval TRUE          An earlier task has to complete before Task.
+  @retval FALSE         Task can be submitted.
+
+**/
+BOOLEAN
+DiskIo2TaskIsBlocked (
+  IN DISK_IO_PRIVATE_DATA   *Instance,
+  IN DISK_IO2_TASK          *Task
+  )
+{
+  LIST_ENTRY                *Link;
+  DISK_IO2_TASK             *Earlier;
+
+  if (Task->Flush) {
+    return (BOOLEAN) (GetFirstNode (&Instance->TaskQueue) != &Task->Link);
+  }
+
+  if (!Task->Write) {
+    return FALSE;
+  }
+
+  for (Link = GetFirstNode (&Instance->TaskQueue)
+      ; Link != &Task->Link
+      ; Link = GetNextNode (&Instance->TaskQueue, Link)
+      ) {
+    Earlier = DISK_IO2_TASK_FROM_LINK (Link);
+    if (Earlier->Write &&
+        (Earlier->ReadModifyWrite || Task->ReadModifyWrite) &&
+        Earlier->Lba <= Task->LastLba && Task->Lba <= Earlier->LastLba) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Remove a finished task from the task queue, signal its token and free it.
+  A cancelled task is reported as EFI_ABORTED.
+
+  @param  Task          The task whose subtasks have all completed.
+
+**/
+VOID
+DiskIo2FinishTask (
+  IN DISK_IO2_TASK        *Task
+  )
+{
+  DISK_IO_PRIVATE_DATA    *Instance;
+  BOOLEAN                 Cancelled;
+
+  Instance = Task->Instance;
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  RemoveEntryList (&Task->Link);
+  Cancelled = Task->Cancelled;
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  Task->Token->TransactionStatus = Cancelled ? EFI_ABORTED : Task->Status;
+  gBS->SignalEvent (Task->Token->Event);
+
+  FreePool (Task);
+}
+
+//
+// Starting a task can complete it, which in turn starts the tasks waiting for it.
+//
+EFI_STATUS
+DiskIo2StartTask (
+  IN DISK_IO_PRIVATE_DATA   *Instance,
+  IN DISK_IO2_TASK          *Task
+  );
+
+/**
+  Start the waiting tasks that no earlier write blocks any more. A task
+  that cannot be started is finished with the error.
+
+  @param  Instance      The Disk IO instance.
+
+**/
+VOID
+DiskIo2StartWaitingTasks (
+  IN DISK_IO_PRIVATE_DATA   *Instance
+  )
+{
+  EFI_STATUS                Status;
+  LIST_ENTRY                *Link;
+  DISK_IO2_TASK             *Task;
+  DISK_IO2_TASK             *Ready;
+
+  do {
+    Ready = NULL;
+
+    EfiAcquireLock (&Instance->TaskQueueLock);
+    for (Link = GetFirstNode (&Instance->TaskQueue)
+        ; !IsNull (&Instance->TaskQueue, Link)
+        ; Link = GetNextNode (&Instance->TaskQueue, Link)
+        ) {
+      Task = DISK_IO2_TASK_FROM_LINK (Link);
+      if (Task->Waiting && !DiskIo2TaskIsBlocked (Instance, Task)) {
+        Task->Waiting = FALSE;
+        Ready         = Task;
+        break;
+      }
+    }
+    EfiReleaseLock (&Instance->TaskQueueLock);
+
+    if (Ready != NULL) {
+      Status = DiskIo2StartTask (Instance, Ready);
+      if (EFI_ERROR (Status)) {
+        Ready->Status = Status;
+        DiskIo2FinishTask (Ready);
+      }
+    }
+  } while (Ready != NULL);
+}
+
+/**
+  Finish a task whose subtasks have all completed, and start the tasks that
+  were waiting for it.
+
+  @param  Task          The task whose subtasks have all completed.
+
+**/
+VOID
+DiskIo2CompleteTask (
+  IN DISK_IO2_TASK        *Task
+  )
+{
+  DISK_IO_PRIVATE_DATA    *Instance;
+
+  Instance = Task->Instance;
+  DiskIo2FinishTask (Task);
+  DiskIo2StartWaitingTasks (Instance);
+}
+
+/**
+  The completion notification of a Block IO2 transfer issued for a subtask.
+
+  For a partial block write this is first the completion of the read of the
+  block: the caller's data is merged into it and the block is written back
+  with the same Block IO2 token.
+
+  @param  Event         The Block IO2 token event.
+  @param  Context       The DISK_IO_SUBTASK the transfer belongs to.
+
+**/
+VOID
+EFIAPI
+DiskIo2OnSubtaskComplete (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  DISK_IO_SUBTASK         *Subtask;
+  DISK_IO2_TASK           *Task;
+  DISK_IO_PRIVATE_DATA    *Instance;
+  EFI_STATUS              Status;
+  BOOLEAN                 Cancelled;
+  BOOLEAN                 TaskDone;
+
+  Subtask  = (DISK_IO_SUBTASK *) Context;
+  Task     = Subtask->Task;
+  Instance = Task->Instance;
+  Status   = Subtask->BlockIo2Token.TransactionStatus;
+
+  ASSERT (Subtask->Signature == DISK_IO_SUBTASK_SIGNATURE);
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  Cancelled = Task->Cancelled;
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  if (Subtask->ReadModifyWrite) {
+    Subtask->ReadModifyWrite = FALSE;
+    if (!EFI_ERROR (Status) && !Cancelled) {
+      CopyMem (Subtask->WorkingBuffer + Subtask->Offset, Subtask->Buffer, Subtask->CopyLength);
+      Status = Instance->BlockIo2->WriteBlocksEx (
+                                     Instance->BlockIo2,
+                                     Task->MediaId,
+                                     Subtask->Lba,
+                                     &Subtask->BlockIo2Token,
+                                     Subtask->Length,
+                                     Subtask->WorkingBuffer
+                                     );
+      if (!EFI_ERROR (Status)) {
+        return;
+      }
+    }
+  }
+
+  gBS->CloseEvent (Event);
+
+  if (!EFI_ERROR (Status) && !Subtask->Write && Subtask->WorkingBuffer != NULL && !Cancelled) {
+    CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->CopyLength);
+  }
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  if (EFI_ERROR (Status) && !EFI_ERROR (Task->Status)) {
+    Task->Status = Status;
+  }
+  RemoveEntryList (&Subtask->Link);
+  TaskDone = (BOOLEAN) (!Task->Submitting && IsListEmpty (&Task->Subtasks));
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  DiskIoFreeSubtask (Subtask);
+
+  if (TaskDone) {
+    DiskIo2CompleteTask (Task);
+  }
+}
+
+/**
+  Submit the pending subtasks of a task to the Block IO2 protocol.
+
+  Subtasks are moved from Task->Pending onto the task one at a time just
+  before they are submitted, and the task is held open until the submission
+  loop is over. A transfer that completes inside ReadBlocksEx() or
+  WriteBlocksEx() therefore cannot finish the task while later subtasks are
+  still pending.
+
+  @param  Instance      The Disk IO instance.
+  @param  Task          The task, already in the task queue.
+
+  @retval EFI_SUCCESS   At least one subtask was submitted, or there was
+                        nothing to submit. The task finishes on its own.
+  @retval others        No subtask could be submitted. The task is still in
+                        the task queue and the caller has to finish it.
+
+**/
+EFI_STATUS
+DiskIo2StartTask (
+  IN DISK_IO_PRIVATE_DATA   *Instance,
+  IN DISK_IO2_TASK          *Task
+  )
+{
+  EFI_STATUS                Status;
+  EFI_BLOCK_IO2_PROTOCOL    *BlockIo2;
+  DISK_IO_SUBTASK           *Subtask;
+  UINTN                     Submitted;
+  BOOLEAN                   TaskDone;
+
+  BlockIo2  = Instance->BlockIo2;
+  Status    = EFI_SUCCESS;
+  Submitted = 0;
+
+  while (!IsListEmpty (&Task->Pending)) {
+    Subtask       = DISK_IO_SUBTASK_FROM_LINK (GetFirstNode (&Task->Pending));
+    Subtask->Task = Task;
+
+    //
+    // The notification function may issue further Block IO2 requests, which
+    // are only allowed up to TPL_CALLBACK.
+    //
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    DiskIo2OnSubtaskComplete,
+                    Subtask,
+                    &Subtask->BlockIo2Token.Event
+                    );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    EfiAcquireLock (&Instance->TaskQueueLock);
+    RemoveEntryList (&Subtask->Link);
+    InsertTailList (&Task->Subtasks, &Subtask->Link);
+    EfiReleaseLock (&Instance->TaskQueueLock);
+
+    if (Task->Flush) {
+      Status = BlockIo2->FlushBlocksEx (BlockIo2, &Subtask->BlockIo2Token);
+    } else if (Subtask->Write && !Subtask->ReadModifyWrite) {
+      Status = BlockIo2->WriteBlocksEx (
+                           BlockIo2,
+                           Task->MediaId,
+                           Subtask->Lba,
+                           &Subtask->BlockIo2Token,
+                           Subtask->Length,
+                           (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                           );
+    } else {
+      Status = BlockIo2->ReadBlocksEx (
+                           BlockIo2,
+                           Task->MediaId,
+                           Subtask->Lba,
+                           &Subtask->BlockIo2Token,
+                           Subtask->Length,
+                           (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                           );
+    }
+
+    if (EFI_ERROR (Status)) {
+      EfiAcquireLock (&Instance->TaskQueueLock);
+      RemoveEntryList (&Subtask->Link);
+      EfiReleaseLock (&Instance->TaskQueueLock);
+      gBS->CloseEvent (Subtask->BlockIo2Token.Event);
+      DiskIoFreeSubtask (Subtask);
+      break;
+    }
+
+    Submitted++;
+  }
+
+  //
+  // Whatever was not submitted will never complete.
+  //
+  DiskIoFreeSubtasks (&Task->Pending);
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  if (EFI_ERROR (Status) && !EFI_ERROR (Task->Status)) {
+    Task->Status = Status;
+  }
+  Task->Submitting = FALSE;
+  TaskDone = IsListEmpty (&Task->Subtasks);
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  if (TaskDone && Submitted == 0 && EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (TaskDone) {
+    DiskIo2CompleteTask (Task);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue a task and submit its subtasks to the Block IO2 protocol, unless an
+  earlier write to the same blocks is still outstanding. In that case the
+  task waits in the task queue and is started when that write completes.
+
+  @param  Instance      The Disk IO instance.
+  @param  Task          The task, with its subtasks in Task->Pending.
+
+  @retval EFI_SUCCESS   The task was queued. Task->Token will be signaled.
+  @retval others        No subtask could be submitted. The task is freed
+                        and Task->Token is not signaled.
+
+**/
+EFI_STATUS
+DiskIo2QueueTask (
+  IN DISK_IO_PRIVATE_DATA   *Instance,
+  IN DISK_IO2_TASK          *Task
+  )
+{
+  EFI_STATUS                Status;
+  BOOLEAN                   Waiting;
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  InsertTailList (&Instance->TaskQueue, &Task->Link);
+  Task->Waiting = DiskIo2TaskIsBlocked (Instance, Task);
+  Waiting       = Task->Waiting;
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  if (Waiting) {
+    return EFI_SUCCESS;
+  }
+
+  Status = DiskIo2StartTask (Instance, Task);
+  if (EFI_ERROR (Status)) {
+    EfiAcquireLock (&Instance->TaskQueueLock);
+    RemoveEntryList (&Task->Link);
+    EfiReleaseLock (&Instance->TaskQueueLock);
+    FreePool (Task);
+
+    //
+    // A task queued in the meantime may have been waiting for this one.
+    //
+    DiskIo2StartWaitingTasks (Instance);
+  }
+
+  return Status;
+}
+
+/**
+  Split the aligned part of an asynchronous request into subtasks. A
+  buffer that satisfies IoAlign is transferred in one piece; otherwise
+  the transfer goes through bounce buffers of DATA_BUFFER_BLOCK_NUM blocks.
+
+  @param  Write         TRUE for a write, FALSE for a read.
+  @param  Media         The media of the device.
+  @param  Lba           The first LBA of the aligned part.
+  @param  Length        The size of the aligned part in bytes.
+  @param  Buffer        The caller's buffer for the aligned part.
+  @param  Pending       The list the subtasks are appended to.
+
+  @retval EFI_SUCCESS           The subtasks were created.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+
+**/
+EFI_STATUS
+DiskIoCreateBodySubtasks (
+  IN BOOLEAN              Write,
+  IN EFI_BLOCK_IO_MEDIA   *Media,
+  IN UINT64               Lba,
+  IN UINTN                Length,
+  IN UINT8                *Buffer,
+  IN OUT LIST_ENTRY       *Pending
+  )
+{
+  DISK_IO_SUBTASK         *Subtask;
+  UINTN                   DataBufferSize;
+
+  if (Media->IoAlign <= 1 || ((UINTN) Buffer & (UINTN) (Media->IoAlign - 1)) == 0) {
+    Subtask = DiskIoCreateSubtask (Write, Lba, Length, Media->IoAlign, 0, Length, Buffer, FALSE);
+    if (Subtask == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    InsertTailList (Pending, &Subtask->Link);
+    return EFI_SUCCESS;
+  }
+
+  DataBufferSize = Media->BlockSize * DATA_BUFFER_BLOCK_NUM;
+  while (Length > 0) {
+    if (DataBufferSize > Length) {
+      DataBufferSize = Length;
+    }
+
+    Subtask = DiskIoCreateSubtask (Write, Lba, DataBufferSize, Media->IoAlign, 0, DataBufferSize, Buffer, TRUE);
+    if (Subtask == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    InsertTailList (Pending, &Subtask->Link);
+
+    Length -= DataBufferSize;
+    Buffer += DataBufferSize;
+    Lba    += DATA_BUFFER_BLOCK_NUM;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Validate an asynchronous request against the media and allocate its task.
+
+  @param  Instance      The Disk IO instance.
+  @param  Write         TRUE for a write, FALSE for a read.
+  @param  MediaId       ID of the medium.
+  @param  Offset        The starting byte offset of the request.
+  @param  Token         The caller's token.
+  @param  BufferSize    The size of the request in bytes.
+  @param  Task          Returns the allocated task.
+
+  @retval EFI_SUCCESS           The task was allocated.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHANGED     The MediaId is not for the current medium.
+  @retval EFI_INVALID_PARAMETER The request lies outside the device.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+
+**/
+EFI_STATUS
+DiskIo2CreateTask (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  BOOLEAN               Write,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  EFI_DISK_IO2_TOKEN    *Token,
+  IN  UINTN                 BufferSize,
+  OUT DISK_IO2_TASK         **Task
+  )
+{
+  EFI_BLOCK_IO_MEDIA        *Media;
+  UINT64                    DiskSize;
+
+  Media = Instance->BlockIo->Media;
+
+  if (!Media->MediaPresent) {
+    return EFI_NO_MEDIA;
+  }
+
+  if (Media->MediaId != MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  DiskSize = MultU64x32 (Media->LastBlock + 1, Media->BlockSize);
+  if (Offset > DiskSize || BufferSize > DiskSize - Offset) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Task = AllocateZeroPool (sizeof (DISK_IO2_TASK));
+  if (*Task == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*Task)->Signature  = DISK_IO2_TASK_SIGNATURE;
+  (*Task)->Token      = Token;
+  (*Task)->Status     = EFI_SUCCESS;
+  (*Task)->MediaId    = MediaId;
+  (*Task)->Submitting = TRUE;
+  (*Task)->Instance   = Instance;
+  InitializeListHead (&(*Task)->Subtasks);
+  InitializeListHead (&(*Task)->Pending);
+
+  //
+  // An empty write touches no block, so it never has to wait.
+  //
+  (*Task)->Write = (BOOLEAN) (Write && BufferSize != 0);
+  if (BufferSize != 0) {
+    (*Task)->Lba     = DivU64x32 (Offset, Media->BlockSize);
+    (*Task)->LastLba = DivU64x32 (Offset + BufferSize - 1, Media->BlockSize);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Terminate outstanding asynchronous requests to a device.
+
+  All outstanding requests are aborted. Block IO2 transfers already issued
+  for them run to completion, but no more data is copied between bounce
+  buffers and the callers' buffers, and the tokens are signaled with
+  EFI_ABORTED only once those transfers have completed, so a caller may
+  reuse its buffer as soon as its token is signaled. Requests still waiting
+  for an earlier write have no transfer outstanding and are signaled at once.
+
+  @param  This                  Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS           All outstanding requests were successfully terminated.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the cancel
+                                operation.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2Cancel (
+  IN EFI_DISK_IO2_PROTOCOL  *This
+  )
+{
+  DISK_IO_PRIVATE_DATA      *Instance;
+  DISK_IO2_TASK             *Task;
+  LIST_ENTRY                *Link;
+  LIST_ENTRY                *NextLink;
+  LIST_ENTRY                Aborted;
+
+  Instance = DISK_IO_PRIVATE_DATA_FROM_DISK_IO2 (This);
+  InitializeListHead (&Aborted);
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  for (Link = GetFirstNode (&Instance->TaskQueue)
+      ; !IsNull (&Instance->TaskQueue, Link)
+      ; Link = NextLink
+      ) {
+    NextLink = GetNextNode (&Instance->TaskQueue, Link);
+    Task     = DISK_IO2_TASK_FROM_LINK (Link);
+    Task->Cancelled = TRUE;
+    if (Task->Waiting) {
+      RemoveEntryList (&Task->Link);
+      InsertTailList (&Aborted, &Task->Link);
+    }
+  }
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  while (!IsListEmpty (&Aborted)) {
+    Task = DISK_IO2_TASK_FROM_LINK (GetFirstNode (&Aborted));
+    RemoveEntryList (&Task->Link);
+    DiskIoFreeSubtasks (&Task->Pending);
+    Task->Token->TransactionStatus = EFI_ABORTED;
+    gBS->SignalEvent (Task->Token->Event);
+    FreePool (Task);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads a specified number of bytes from a device.
+
+  The aligned part of the request goes straight to the Block IO2 protocol;
+  partial blocks at either end are read through a bounce buffer. If Token
+  or Token->Event is NULL the request is serviced by DiskIoReadDisk().
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  MediaId               ID of the medium to be read.
+  @param  Offset                The starting byte offset on the logical block I/O device to read from.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+  @param  BufferSize            The size in bytes of Buffer. The number of bytes to read from the device.
+  @param  Buffer                A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was read correctly from the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the read.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_INVALID_PARAMETER The read request contains device addresses that are not valid for the device.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2ReadDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN UINT64                       Offset,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token,
+  IN UINTN                        BufferSize,
+  OUT VOID                        *Buffer
+  )
+{
+  EFI_STATUS                      Status;
+  DISK_IO_PRIVATE_DATA            *Instance;
+  EFI_BLOCK_IO_MEDIA              *Media;
+  DISK_IO2_TASK                   *Task;
+  DISK_IO_SUBTASK                 *Subtask;
+  UINT8                           *WorkingBuffer;
+  UINTN                           WorkingBufferSize;
+  UINT64                          Lba;
+  UINT32                          UnderRun;
+  UINTN                           OverRun;
+  UINTN                           Length;
+
+  Instance = DISK_IO_PRIVATE_DATA_FROM_DISK_IO2 (This);
+
+  if (Token == NULL || Token->Event == NULL) {
+    return DiskIoReadDisk (&Instance->DiskIo, MediaId, Offset, BufferSize, Buffer);
+  }
+
+  Status = DiskIo2CreateTask (Instance, FALSE, MediaId, Offset, Token, BufferSize, &Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Media             = Instance->BlockIo->Media;
+  WorkingBuffer     = Buffer;
+  WorkingBufferSize = BufferSize;
+
+  Lba = DivU64x32Remainder (Offset, Media->BlockSize, &UnderRun);
+  if (UnderRun != 0 && WorkingBufferSize != 0) {
+    //
+    // Offset starts in the middle of an Lba, so read the entire block.
+    //
+    Length = MIN (Media->BlockSize - UnderRun, WorkingBufferSize);
+    Subtask = DiskIoCreateSubtask (FALSE, Lba, Media->BlockSize, Media->IoAlign, UnderRun, Length, WorkingBuffer, TRUE);
+    if (Subtask == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto ErrorExit;
+    }
+    InsertTailList (&Task->Pending, &Subtask->Link);
+
+    WorkingBuffer     += Length;
+    WorkingBufferSize -= Length;
+    Lba               += 1;
+  }
+
+  OverRun = WorkingBufferSize % Media->BlockSize;
+  Length  = WorkingBufferSize - OverRun;
+  if (Length != 0) {
+    Status = DiskIoCreateBodySubtasks (FALSE, Media, Lba, Length, WorkingBuffer, &Task->Pending);
+    if (EFI_ERROR (Status)) {
+      goto ErrorExit;
+    }
+
+    WorkingBuffer += Length;
+    Lba           += Length / Media->BlockSize;
+  }
+
+  if (OverRun != 0) {
+    //
+    // Last read is not a complete block.
+    //
+    Subtask = DiskIoCreateSubtask (FALSE, Lba, Media->BlockSize, Media->IoAlign, 0, OverRun, WorkingBuffer, TRUE);
+    if (Subtask == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto ErrorExit;
+    }
+    InsertTailList (&Task->Pending, &Subtask->Link);
+  }
+
+  return DiskIo2QueueTask (Instance, Task);
+
+ErrorExit:
+  DiskIoFreeSubtasks (&Task->Pending);
+  FreePool (Task);
+  return Status;
+}
+
+/**
+  Writes a specified number of bytes to a device.
+
+  Partial blocks at either end need a read modify write, which is done
+  through a bounce buffer: the block is read, the data is merged and the
+  block is written back. Such a request is queued behind any earlier
+  outstanding write to the same blocks, and later writes to those blocks
+  are queued behind it. If Token or Token->Event is NULL the request is
+  serviced by DiskIoWriteDisk().
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  MediaId               ID of the medium to be written.
+  @param  Offset                The starting byte offset on the logical block I/O device to write to.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+  @param  BufferSize            The size in bytes of Buffer. The number of bytes to write to the device.
+  @param  Buffer                A pointer to the buffer containing the data to be written.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was written correctly to the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_WRITE_PROTECTED   The device cannot be written to.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the write operation.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_INVALID_PARAMETER The write request contains device addresses that are not valid for the device.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2WriteDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN UINT64                       Offset,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  )
+{
+  EFI_STATUS                      Status;
+  DISK_IO_PRIVATE_DATA            *Instance;
+  EFI_BLOCK_IO_MEDIA              *Media;
+  DISK_IO2_TASK                   *Task;
+  DISK_IO_SUBTASK                 *Subtask;
+  UINT8                           *WorkingBuffer;
+  UINTN                           WorkingBufferSize;
+  UINT64                          Lba;
+  UINT32                          UnderRun;
+  UINTN                           OverRun;
+  UINTN                           Length;
+
+  Instance = DISK_IO_PRIVATE_DATA_FROM_DISK_IO2 (This);
+
+  if (Token == NULL || Token->Event == NULL) {
+    return DiskIoWriteDisk (&Instance->DiskIo, MediaId, Offset, BufferSize, Buffer);
+  }
+
+  Media = Instance->BlockIo->Media;
+  if (Media->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  Status = DiskIo2CreateTask (Instance, TRUE, MediaId, Offset, Token, BufferSize, &Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  WorkingBuffer     = Buffer;
+  WorkingBufferSize = BufferSize;
+
+  Lba = DivU64x32Remainder (Offset, Media->BlockSize, &UnderRun);
+  if (UnderRun != 0 && WorkingBufferSize != 0) {
+    //
+    // Offset starts in the middle of an Lba, so do read modify write.
+    //
+    Length = MIN (Media->BlockSize - UnderRun, WorkingBufferSize);
+    Subtask = DiskIoCreateSubtask (TRUE, Lba, Media->BlockSize, Media->IoAlign, UnderRun, Length, WorkingBuffer, TRUE);
+    if (Subtask == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto ErrorExit;
+    }
+    Subtask->ReadModifyWrite = TRUE;
+    Task->ReadModifyWrite    = TRUE;
+    InsertTailList (&Task->Pending, &Subtask->Link);
+
+    WorkingBuffer     += Length;
+    WorkingBufferSize -= Length;
+    Lba               += 1;
+  }
+
+  OverRun = WorkingBufferSize % Media->BlockSize;
+  Length  = WorkingBufferSize - OverRun;
+  if (Length != 0) {
+    Status = DiskIoCreateBodySubtasks (TRUE, Media, Lba, Length, WorkingBuffer, &Task->Pending);
+    if (EFI_ERROR (Status)) {
+      goto ErrorExit;
+    }
+
+    WorkingBuffer += Length;
+    Lba           += Length / Media->BlockSize;
+  }
+
+  if (OverRun != 0) {
+    //
+    // Last bit is not a complete block, so do a read modify write.
+    //
+    Subtask = DiskIoCreateSubtask (TRUE, Lba, Media->BlockSize, Media->IoAlign, 0, OverRun, WorkingBuffer, TRUE);
+    if (Subtask == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto ErrorExit;
+    }
+    Subtask->ReadModifyWrite = TRUE;
+    Task->ReadModifyWrite    = TRUE;
+    InsertTailList (&Task->Pending, &Subtask->Link);
+  }
+
+  return DiskIo2QueueTask (Instance, Task);
+
+ErrorExit:
+  DiskIoFreeSubtasks (&Task->Pending);
+  FreePool (Task);
+  return Status;
+}
+
+/**
+  Flushes all modified data to a physical block device.
+
+  The flush is queued as a task that waits until every task queued before
+  it has completed, so the data of earlier asynchronous writes, including
+  their read modify write of partial blocks, is covered by it. A blocking
+  flush queues a task only to mark its position in the task queue, waits
+  for the tasks ahead of it and then flushes synchronously.
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was flushed successfully to the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_WRITE_PROTECTED   The device cannot be written to.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the write operation,
+                                or the earlier requests did not complete in time.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2FlushDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token
+  )
+{
+  EFI_STATUS                      Status;
+  DISK_IO_PRIVATE_DATA            *Instance;
+  DISK_IO2_TASK                   *Task;
+  DISK_IO_SUBTASK                 *Subtask;
+  BOOLEAN                         Drained;
+  UINTN                           Waited;
+
+  Instance = DISK_IO_PRIVATE_DATA_FROM_DISK_IO2 (This);
+
+  if (Token == NULL || Token->Event == NULL) {
+    Token = NULL;
+  }
+
+  Status = DiskIo2CreateTask (Instance, FALSE, Instance->BlockIo->Media->MediaId, 0, Token, 0, &Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Task->Flush = TRUE;
+
+  if (Token != NULL) {
+    Subtask = DiskIoCreateSubtask (FALSE, 0, 0, 0, 0, 0, NULL, FALSE);
+    if (Subtask == NULL) {
+      FreePool (Task);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    InsertTailList (&Task->Pending, &Subtask->Link);
+
+    return DiskIo2QueueTask (Instance, Task);
+  }
+
+  //
+  // The task is never started and never waits, so neither the completion of
+  // other tasks nor DiskIo2Cancel() touch it.
+  //
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  InsertTailList (&Instance->TaskQueue, &Task->Link);
+  EfiReleaseLock (&Instance->TaskQueueLock);
+
+  for (Waited = 0; ; Waited += DISK_IO2_DRAIN_STALL) {
+    EfiAcquireLock (&Instance->TaskQueueLock);
+    Drained = (BOOLEAN) !DiskIo2TaskIsBlocked (Instance, Task);
+    EfiReleaseLock (&Instance->TaskQueueLock);
+    if (Drained || Waited >= DISK_IO2_FLUSH_TIMEOUT) {
+      break;
+    }
+    gBS->Stall (DISK_IO2_DRAIN_STALL);
+  }
+
+  if (Drained) {
+    Status = Instance->BlockIo2->FlushBlocksEx (Instance->BlockIo2, NULL);
+  } else {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  EfiAcquireLock (&Instance->TaskQueueLock);
+  RemoveEntryList (&Task->Link);
+  EfiReleaseLock (&Instance->TaskQueueLock);
+  FreePool (Task);
+
+  //
+  // Flushes queued in the meantime waited for this one.
+  //
+  DiskIo2StartWaitingTasks (Instance);
+
+  return Status;
+}
+
+
 /**
   The user Entry Point for module DiskIo. The user code starts with this function.
 
@@ -17,9 +17,11 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <Uefi.h>
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/DiskIo.h>
+#include <Protocol/DiskIo2.h>
 #include <Library/DebugLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiLib.h>
@@ -31,15 +33,92 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define DATA_BUFFER_BLOCK_NUM             64
 
+//
+// Poll interval and time limit in microseconds while Stop() waits for the
+// Block IO2 transfers of cancelled Disk IO2 requests.
+//
+#define DISK_IO2_DRAIN_STALL              1000
+#define DISK_IO2_DRAIN_TIMEOUT            1000000
+
+//
+// Time limit in microseconds while a blocking FlushDiskEx() waits for the
+// asynchronous requests queued before it.
+//
+#define DISK_IO2_FLUSH_TIMEOUT            30000000
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 
 typedef struct {
-  UINTN                 Signature;
-  EFI_DISK_IO_PROTOCOL  DiskIo;
-  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  UINTN                   Signature;
+  EFI_DISK_IO_PROTOCOL    DiskIo;
+  EFI_DISK_IO2_PROTOCOL   DiskIo2;
+  EFI_BLOCK_IO_PROTOCOL   *BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+
+  //
+  // Outstanding asynchronous Disk IO2 requests, protected by TaskQueueLock
+  //
+  LIST_ENTRY              TaskQueue;
+  EFI_LOCK                TaskQueueLock;
 } DISK_IO_PRIVATE_DATA;
 
-#define DISK_IO_PRIVATE_DATA_FROM_THIS(a) CR (a, DISK_IO_PRIVATE_DATA, DiskIo, DISK_IO_PRIVATE_DATA_SIGNATURE)
+#define DISK_IO_PRIVATE_DATA_FROM_THIS(a)     CR (a, DISK_IO_PRIVATE_DATA, DiskIo, DISK_IO_PRIVATE_DATA_SIGNATURE)
+#define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a) CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
+
+#define DISK_IO2_TASK_SIGNATURE           SIGNATURE_32 ('d', 'k', 'i', 't')
+
+//
+// One asynchronous ReadDiskEx/WriteDiskEx/FlushDiskEx request. It completes
+// when the last of its subtasks completes. A write that only covers part of
+// a block waits in the task queue until earlier writes to its blocks are
+// done, and a flush waits until every earlier request is done.
+//
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+  LIST_ENTRY              Subtasks;       ///< Subtasks submitted to Block IO2
+  LIST_ENTRY              Pending;        ///< Subtasks not submitted yet
+  EFI_DISK_IO2_TOKEN      *Token;
+  EFI_STATUS              Status;
+  UINT32                  MediaId;
+  BOOLEAN                 Write;
+  BOOLEAN                 ReadModifyWrite; ///< Some block is only partly written
+  UINT64                  Lba;            ///< First block of the request
+  UINT64                  LastLba;        ///< Last block of the request
+  BOOLEAN                 Waiting;        ///< Waiting for an earlier task to complete
+  BOOLEAN                 Submitting;     ///< Subtasks are still being submitted
+  BOOLEAN                 Cancelled;
+  BOOLEAN                 Flush;          ///< Flush request, its subtask carries no data
+  DISK_IO_PRIVATE_DATA    *Instance;
+} DISK_IO2_TASK;
+
+#define DISK_IO2_TASK_FROM_LINK(a)        CR (a, DISK_IO2_TASK, Link, DISK_IO2_TASK_SIGNATURE)
+
+#define DISK_IO_SUBTASK_SIGNATURE         SIGNATURE_32 ('d', 'k', 's', 't')
+
+//
+// One Block IO2 transfer issued on behalf of a DISK_IO2_TASK. Partial blocks
+// and buffers that violate IoAlign are transferred through WorkingBuffer and
+// copied from/to the caller's Buffer at Offset for CopyLength bytes. A write
+// of a partial block first reads the block into WorkingBuffer.
+//
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+  BOOLEAN                 Write;
+  BOOLEAN                 ReadModifyWrite; ///< The block still has to be read
+  UINT64                  Lba;
+  UINTN                   Length;
+  UINT8                   *PreData;
+  UINT8                   *WorkingBuffer;
+  UINTN                   Offset;
+  UINTN                   CopyLength;
+  UINT8                   *Buffer;
+  EFI_BLOCK_IO2_TOKEN     BlockIo2Token;
+  DISK_IO2_TASK           *Task;
+} DISK_IO_SUBTASK;
+
+#define DISK_IO_SUBTASK_FROM_LINK(a)      CR (a, DISK_IO_SUBTASK, Link, DISK_IO_SUBTASK_SIGNATURE)
 
 //
 // Global Variables
@@ -189,6 +268,129 @@ DiskIoWriteDisk (
   IN VOID                  *Buffer
   );
 
+//
+// Disk I/O 2 Protocol Interface
+//
+/**
+  Terminate outstanding asynchronous requests to a device.
+
+  @param  This                  Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS           All outstanding requests were successfully terminated.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the cancel
+                                operation.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2Cancel (
+  IN EFI_DISK_IO2_PROTOCOL  *This
+  );
+
+/**
+  Reads a specified number of bytes from a device.
+
+  The aligned part of the request goes straight to the Block IO2 protocol;
+  partial blocks at either end are read through a bounce buffer. If Token
+  or Token->Event is NULL the request is serviced by DiskIoReadDisk().
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  MediaId               ID of the medium to be read.
+  @param  Offset                The starting byte offset on the logical block I/O device to read from.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+  @param  BufferSize            The size in bytes of Buffer. The number of bytes to read from the device.
+  @param  Buffer                A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was read correctly from the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the read.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_INVALID_PARAMETER The read request contains device addresses that are not valid for the device.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2ReadDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN UINT64                       Offset,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token,
+  IN UINTN                        BufferSize,
+  OUT VOID                        *Buffer
+  );
+
+/**
+  Writes a specified number of bytes to a device.
+
+  Partial blocks at either end need a read modify write, which is done
+  asynchronously through a bounce buffer. Such a request is queued behind
+  any earlier outstanding write to the same blocks, and later writes to
+  those blocks are queued behind it. If Token or Token->Event is NULL the
+  request is serviced by DiskIoWriteDisk().
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  MediaId               ID of the medium to be written.
+  @param  Offset                The starting byte offset on the logical block I/O device to write to.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+  @param  BufferSize            The size in bytes of Buffer. The number of bytes to write to the device.
+  @param  Buffer                A pointer to the buffer containing the data to be written.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was written correctly to the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_WRITE_PROTECTED   The device cannot be written to.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the write operation.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_INVALID_PARAMETER The write request contains device addresses that are not valid for the device.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2WriteDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN UINT64                       Offset,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  );
+
+/**
+  Flushes all modified data to a physical block device.
+
+  The flush is queued behind every outstanding asynchronous request and is
+  issued to the Block IO2 protocol once they have all completed. If Token
+  or Token->Event is NULL this function waits for them before it flushes.
+
+  @param  This                  Indicates a pointer to the calling context.
+  @param  Token                 A pointer to the token associated with the transaction.
+                                If this field is NULL, synchronous/blocking IO is performed.
+
+  @retval EFI_SUCCESS           If Event is NULL (blocking I/O): The data was flushed successfully to the device.
+                                If Event is not NULL (asynchronous I/O): The request was successfully queued for processing.
+                                                                         Event will be signaled upon completion.
+  @retval EFI_WRITE_PROTECTED   The device cannot be written to.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the write operation,
+                                or the earlier requests did not complete in time.
+  @retval EFI_NO_MEDIA          There is no medium in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId is not for the current medium.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+DiskIo2FlushDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL        *This,
+  IN OUT EFI_DISK_IO2_TOKEN       *Token
+  );
+
 //
 // EFI Component Name Functions
 //
@@ -0,0 +1,522 @@
+/** @file
+  Directory reading, name lookup and path resolution of the ext2/ext3/ext4
+  file system driver.
+
+  Hashed (dir_index) directories keep a linear layout readers can scan, so
+  every directory is read linearly. Lookups go through a dentry cache that
+  maps (directory inode, name) to an inode number.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ext4.h"
+
+/**
+  Convert a UTF-8 name to UCS-2. Characters outside the BMP and invalid
+  sequences become '?'.
+
+  @param  Source                The UTF-8 name, not null-terminated.
+  @param  SourceLen             The length of Source in bytes.
+  @param  Destination           Receives the null-terminated name; it must hold
+                                SourceLen + 1 characters.
+
+**/
+VOID
+Ext4Utf8ToUcs2 (
+  IN  CONST CHAR8           *Source,
+  IN  UINTN                 SourceLen,
+  OUT CHAR16                *Destination
+  )
+{
+  CONST UINT8  *Byte;
+  CONST UINT8  *End;
+  UINTN        Trail;
+  UINT32       Char;
+
+  Byte = (CONST UINT8 *) Source;
+  End  = Byte + SourceLen;
+  while (Byte < End) {
+    if (*Byte < 0x80) {
+      *Destination++ = *Byte++;
+      continue;
+    }
+
+    if ((*Byte & 0xE0) == 0xC0) {
+      Trail = 1;
+      Char  = *Byte & 0x1F;
+    } else if ((*Byte & 0xF0) == 0xE0) {
+      Trail = 2;
+      Char  = *Byte & 0x0F;
+    } else {
+      *Destination++ = L'?';
+      Byte++;
+      continue;
+    }
+
+    Byte++;
+    for (; Trail > 0 && Byte < End && (*Byte & 0xC0) == 0x80; Trail--, Byte++) {
+      Char = (Char << 6) | (*Byte & 0x3F);
+    }
+    *Destination++ = (CHAR16) ((Trail == 0) ? Char : L'?');
+  }
+
+  *Destination = L'\0';
+}
+
+/**
+  Convert a UEFI path to a UTF-8 path with '/' separators.
+
+  @param  Source                The null-terminated UCS-2 path.
+
+  @return A pool allocated, null-terminated UTF-8 path, or NULL if memory
+          allocation failed.
+
+**/
+CHAR8 *
+Ext4PathToUtf8 (
+  IN CONST CHAR16           *Source
+  )
+{
+  CHAR8  *Path;
+  CHAR8  *Destination;
+
+  Path = AllocatePool (StrLen (Source) * 3 + 1);
+  if (Path == NULL) {
+    return NULL;
+  }
+
+  for (Destination = Path; *Source != L'\0'; Source++) {
+    if (*Source == L'\\') {
+      *Destination++ = '/';
+    } else if (*Source < 0x80) {
+      *Destination++ = (CHAR8) *Source;
+    } else if (*Source < 0x800) {
+      *Destination++ = (CHAR8) (0xC0 | (*Source >> 6));
+      *Destination++ = (CHAR8) (0x80 | (*Source & 0x3F));
+    } else {
+      *Destination++ = (CHAR8) (0xE0 | (*Source >> 12));
+      *Destination++ = (CHAR8) (0x80 | ((*Source >> 6) & 0x3F));
+      *Destination++ = (CHAR8) (0x80 | (*Source & 0x3F));
+    }
+  }
+
+  *Destination = '\0';
+  return Path;
+}
+
+/**
+  Hash a directory inode and name to a dentry cache bucket.
+
+  @param  Parent                The directory inode.
+  @param  Name                  The name, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+
+  @return The bucket index.
+
+**/
+UINTN
+Ext4DentryHash (
+  IN UINT32                 Parent,
+  IN CONST CHAR8            *Name,
+  IN UINTN                  NameLen
+  )
+{
+  UINTN  Hash;
+
+  Hash = Parent;
+  while (NameLen-- > 0) {
+    Hash = Hash * 31 + (UINT8) *Name++;
+  }
+
+  return Hash & (EXT4_DENTRY_HASH_SIZE - 1);
+}
+
+/**
+  Look a name up in the dentry cache.
+
+  @param  Volume                The volume.
+  @param  Parent                The directory inode the name is in.
+  @param  Name                  The name, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+
+  @return The cache entry, made the most recently used one, or NULL if the
+          name is not cached.
+
+**/
+EXT4_DENTRY *
+Ext4FindDentry (
+  IN EXT4_VOLUME            *Volume,
+  IN UINT32                 Parent,
+  IN CONST CHAR8            *Name,
+  IN UINTN                  NameLen
+  )
+{
+  LIST_ENTRY   *Bucket;
+  LIST_ENTRY   *Link;
+  EXT4_DENTRY  *Dentry;
+
+  Bucket = &Volume->DentryHash[Ext4DentryHash (Parent, Name, NameLen)];
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    Dentry = BASE_CR (Link, EXT4_DENTRY, HashLink);
+    if (Dentry->Parent == Parent && Dentry->NameLen == NameLen && CompareMem (Dentry->Name, Name, NameLen) == 0) {
+      RemoveEntryList (&Dentry->LruLink);
+      InsertHeadList (&Volume->DentryLru, &Dentry->LruLink);
+      return Dentry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Add a name to inode mapping to the dentry cache.
+
+  @param  Volume                The volume.
+  @param  Parent                The directory inode the name is in.
+  @param  Name                  The name, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+  @param  Inode                 The inode the name refers to.
+
+**/
+VOID
+Ext4AddDentry (
+  IN EXT4_VOLUME            *Volume,
+  IN UINT32                 Parent,
+  IN CONST CHAR8            *Name,
+  IN UINTN                  NameLen,
+  IN UINT32                 Inode
+  )
+{
+  EXT4_DENTRY  *Dentry;
+
+  if (NameLen > EXT4_NAME_LEN || Ext4FindDentry (Volume, Parent, Name, NameLen) != NULL) {
+    return;
+  }
+
+  //
+  // Recycle the least recently used entry. Unused entries are in no hash
+  // chain.
+  //
+  Dentry = BASE_CR (GetPreviousNode (&Volume->DentryLru, &Volume->DentryLru), EXT4_DENTRY, LruLink);
+  if (Dentry->Parent != 0) {
+    RemoveEntryList (&Dentry->HashLink);
+  }
+  RemoveEntryList (&Dentry->LruLink);
+
+  Dentry->Parent  = Parent;
+  Dentry->Inode   = Inode;
+  Dentry->NameLen = (UINT8) NameLen;
+  CopyMem (Dentry->Name, Name, NameLen);
+
+  InsertHeadList (&Volume->DentryHash[Ext4DentryHash (Parent, Name, NameLen)], &Dentry->HashLink);
+  InsertHeadList (&Volume->DentryLru, &Dentry->LruLink);
+}
+
+/**
+  Read the next in-use entry of a directory.
+
+  @param  Volume                The volume the directory is on.
+  @param  Dir                   The directory.
+  @param  Position              On input the byte offset to read from, on output
+                                the offset of the entry after the one returned.
+  @param  Entry                 Receives the entry, with NameLen fixed up for
+                                volumes without the filetype feature.
+
+  @retval EFI_SUCCESS           An entry was returned.
+  @retval EFI_NOT_FOUND         There are no more entries.
+  @retval EFI_VOLUME_CORRUPTED  The directory block is inconsistent.
+  @retval Others                The directory could not be read.
+
+**/
+EFI_STATUS
+Ext4ReadDirEntry (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Dir,
+  IN OUT UINT64             *Position,
+  OUT    EXT4_DIR_ENTRY     *Entry
+  )
+{
+  EFI_STATUS      Status;
+  UINT64          BlockOffset;
+  UINT32          InBlock;
+  EXT4_DIR_ENTRY  *Raw;
+
+  //
+  // Inline directories hold no "." and ".." entries, only the parent's
+  // inode number; report it as both entries before the real ones.
+  //
+  if ((Dir->Inode.Flags & EXT4_INLINE_DATA_FL) != 0) {
+    if (Dir->Size > Volume->BlockSize || Dir->Size < EXT4_INLINE_DOTDOT_SIZE) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+    if (*Position < EXT4_INLINE_DOTDOT_SIZE) {
+      ZeroMem (Entry, EXT4_DIR_ENTRY_HEADER_SIZE);
+      Entry->FileType = EXT4_FT_DIR;
+      if (*Position == 0) {
+        Entry->Inode   = Dir->Number;
+        Entry->NameLen = 1;
+        CopyMem (Entry->Name, ".", 1);
+        *Position      = 1;
+      } else {
+        Entry->Inode   = Dir->Inode.Block[0];
+        Entry->NameLen = 2;
+        CopyMem (Entry->Name, "..", 2);
+        *Position      = EXT4_INLINE_DOTDOT_SIZE;
+      }
+      if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_FILETYPE) == 0) {
+        Entry->FileType = EXT4_FT_UNKNOWN;
+      }
+      return EFI_SUCCESS;
+    }
+  }
+
+  while (*Position < Dir->Size) {
+    BlockOffset = MultU64x32 (DivU64x32Remainder (*Position, Volume->BlockSize, &InBlock), Volume->BlockSize);
+
+    if (Volume->BlockBufferInode != Dir->Number || Volume->BlockBufferOffset != BlockOffset) {
+      Volume->BlockBufferInode = 0;
+      Volume->BlockBufferSize  = Volume->BlockSize;
+      Status = Ext4ReadNode (Volume, Dir, BlockOffset, &Volume->BlockBufferSize, Volume->BlockBuffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      Volume->BlockBufferInode  = Dir->Number;
+      Volume->BlockBufferOffset = BlockOffset;
+    }
+
+    Raw = (EXT4_DIR_ENTRY *) (Volume->BlockBuffer + InBlock);
+    if (InBlock + EXT4_DIR_ENTRY_HEADER_SIZE > Volume->BlockBufferSize ||
+        Raw->RecLen < EXT4_DIR_ENTRY_HEADER_SIZE ||
+        (Raw->RecLen & 3) != 0 ||
+        InBlock + Raw->RecLen > Volume->BlockBufferSize ||
+        EXT4_DIR_ENTRY_HEADER_SIZE + (UINTN) Raw->NameLen > Raw->RecLen) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    *Position += Raw->RecLen;
+
+    //
+    // Unused slots, hash tree nodes and checksum tails have inode 0.
+    //
+    if (Raw->Inode == 0) {
+      continue;
+    }
+
+    CopyMem (Entry, Raw, EXT4_DIR_ENTRY_HEADER_SIZE + Raw->NameLen);
+    if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_FILETYPE) == 0) {
+      Entry->FileType = EXT4_FT_UNKNOWN;
+    }
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Find a name in a directory, using the dentry cache.
+
+  @param  Volume                The volume.
+  @param  Dir                   The directory.
+  @param  Name                  The name, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+  @param  Number                Receives the inode the name refers to.
+
+  @retval EFI_SUCCESS           The name was found.
+  @retval EFI_NOT_FOUND         The directory has no entry with that name.
+  @retval Others                The directory could not be read.
+
+**/
+EFI_STATUS
+Ext4LookupName (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Dir,
+  IN     CONST CHAR8        *Name,
+  IN     UINTN              NameLen,
+  OUT    UINT32             *Number
+  )
+{
+  EFI_STATUS      Status;
+  EXT4_DENTRY     *Dentry;
+  EXT4_DIR_ENTRY  Entry;
+  UINT64          Position;
+
+  Dentry = Ext4FindDentry (Volume, Dir->Number, Name, NameLen);
+  if (Dentry != NULL) {
+    *Number = Dentry->Inode;
+    return EFI_SUCCESS;
+  }
+
+  Position = 0;
+  while (TRUE) {
+    Status = Ext4ReadDirEntry (Volume, Dir, &Position, &Entry);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (Entry.NameLen == NameLen && CompareMem (Entry.Name, Name, NameLen) == 0) {
+      Ext4AddDentry (Volume, Dir->Number, Name, NameLen, Entry.Inode);
+      *Number = Entry.Inode;
+      return EFI_SUCCESS;
+    }
+  }
+}
+
+/**
+  Resolve a UEFI path to an inode, following symbolic links.
+
+  @param  Volume                The volume.
+  @param  Start                 The directory relative paths start from.
+  @param  StartName             The name of Start, returned if the path names Start itself.
+  @param  FileName              The path, with '\' separators.
+  @param  Number                Receives the inode number the path resolves to.
+  @param  Name                  Receives the last path component, EXT4_NAME_LEN + 1 bytes.
+
+  @retval EFI_SUCCESS           The path was resolved.
+  @retval EFI_NOT_FOUND         A path component does not exist or is not a directory.
+  @retval EFI_INVALID_PARAMETER A path component is too long.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                A directory could not be read.
+
+**/
+EFI_STATUS
+Ext4ResolvePath (
+  IN  EXT4_VOLUME           *Volume,
+  IN  EXT4_NODE             *Start,
+  IN  CHAR8                 *StartName,
+  IN  CHAR16                *FileName,
+  OUT UINT32                *Number,
+  OUT CHAR8                 *Name
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       *Path;
+  CHAR8       *NewPath;
+  CHAR8       *Cursor;
+  CHAR8       *Component;
+  CHAR8       *Target;
+  UINTN       Length;
+  UINTN       TargetLength;
+  UINTN       Links;
+  UINT32      Current;
+  UINT32      Child;
+  EXT4_NODE   Node;
+
+  Path = Ext4PathToUtf8 (FileName);
+  if (Path == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Current = Start->Number;
+  AsciiStrCpy (Name, StartName);
+  Cursor  = Path;
+  Links   = 0;
+  Status  = EFI_SUCCESS;
+
+  if (*Cursor == '/') {
+    Current = EXT4_ROOT_INODE;
+    Name[0] = '\0';
+  }
+
+  while (TRUE) {
+    while (*Cursor == '/') {
+      Cursor++;
+    }
+    if (*Cursor == '\0') {
+      break;
+    }
+
+    Component = Cursor;
+    while (*Cursor != '\0' && *Cursor != '/') {
+      Cursor++;
+    }
+    Length = Cursor - Component;
+
+    if (Length > EXT4_NAME_LEN) {
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    }
+    if (Length == 1 && Component[0] == '.') {
+      continue;
+    }
+
+    Status = Ext4OpenNode (Volume, Current, &Node);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    if (EXT4_IS_DIR (&Node)) {
+      Status = Ext4LookupName (Volume, &Node, Component, Length, &Child);
+    } else {
+      Status = EFI_NOT_FOUND;
+    }
+    Ext4CloseNode (&Node);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Status = Ext4OpenNode (Volume, Child, &Node);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (!EXT4_IS_SYMLINK (&Node)) {
+      Ext4CloseNode (&Node);
+      Current = Child;
+      if (Child == EXT4_ROOT_INODE) {
+        Name[0] = '\0';
+      } else {
+        CopyMem (Name, Component, Length);
+        Name[Length] = '\0';
+      }
+      continue;
+    }
+
+    //
+    // Splice the link target in front of the rest of the path. Absolute
+    // targets restart from the root; relative ones from the directory the
+    // link is in.
+    //
+    if (++Links > EXT4_MAX_SYMLINK_DEPTH) {
+      Ext4CloseNode (&Node);
+      Status = EFI_NOT_FOUND;
+      break;
+    }
+
+    Status = Ext4ReadSymlink (Volume, &Node, &Target);
+    Ext4CloseNode (&Node);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    TargetLength = AsciiStrLen (Target);
+    NewPath = AllocatePool (TargetLength + 1 + AsciiStrLen (Cursor) + 1);
+    if (NewPath == NULL) {
+      FreePool (Target);
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+    CopyMem (NewPath, Target, TargetLength);
+    NewPath[TargetLength] = '/';
+    AsciiStrCpy (NewPath + TargetLength + 1, Cursor);
+    FreePool (Target);
+    FreePool (Path);
+    Path   = NewPath;
+    Cursor = Path;
+
+    if (*Cursor == '/') {
+      Current = EXT4_ROOT_INODE;
+      Name[0] = '\0';
+    }
+  }
+
+  FreePool (Path);
+  *Number = Current;
+  return Status;
+}
@@ -0,0 +1,308 @@
+/** @file
+  Read-only ext2/ext3/ext4 file system driver. It produces the Simple File
+  System protocol on every Disk I/O device that holds an ext2, ext3 or ext4
+  file system, so that loaders can read kernels straight from a Linux root
+  or boot partition.
+
+  The driver never writes to the media. Journals are not replayed, so data
+  that only lives in the journal of an uncleanly unmounted file system is not
+  visible.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ext4.h"
+
+//
+// Serializes access to all volumes and files; file system requests may come
+// in at up to TPL_CALLBACK.
+//
+EFI_LOCK  gExt4Lock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
+
+/**
+  Test to see if this driver supports ControllerHandle.
+
+  @param  This                Protocol instance pointer.
+  @param  ControllerHandle    Handle of device to test
+  @param  RemainingDevicePath Optional parameter use to pick a specific child
+                              device to start.
+
+  @retval EFI_SUCCESS         This driver supports this device
+  @retval EFI_ALREADY_STARTED This driver is already running on this device
+  @retval other               This driver does not support this device
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4DriverBindingSupported (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   ControllerHandle,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath OPTIONAL
+  )
+{
+  EFI_STATUS            Status;
+  EFI_DISK_IO_PROTOCOL  *DiskIo;
+
+  //
+  // Open the IO Abstraction(s) needed to perform the supported test.
+  //
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiDiskIoProtocolGuid,
+                  (VOID **) &DiskIo,
+                  This->DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  gBS->CloseProtocol (
+         ControllerHandle,
+         &gEfiDiskIoProtocolGuid,
+         This->DriverBindingHandle,
+         ControllerHandle
+         );
+
+  return gBS->OpenProtocol (
+                ControllerHandle,
+                &gEfiBlockIoProtocolGuid,
+                NULL,
+                This->DriverBindingHandle,
+                ControllerHandle,
+                EFI_OPEN_PROTOCOL_TEST_PROTOCOL
+                );
+}
+
+/**
+  Start this driver on ControllerHandle by checking the media for an ext2,
+  ext3 or ext4 file system and installing the Simple File System protocol
+  on it.
+
+  @param  This                 Protocol instance pointer.
+  @param  ControllerHandle     Handle of device to bind driver to
+  @param  RemainingDevicePath  Optional parameter use to pick a specific child
+                               device to start.
+
+  @retval EFI_SUCCESS          This driver is added to ControllerHandle
+  @retval EFI_ALREADY_STARTED  This driver is already running on ControllerHandle
+  @retval other                This driver does not support this device
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4DriverBindingStart (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   ControllerHandle,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath OPTIONAL
+  )
+{
+  EFI_STATUS             Status;
+  EFI_BLOCK_IO_PROTOCOL  *BlockIo;
+  EFI_DISK_IO_PROTOCOL   *DiskIo;
+  EXT4_VOLUME            *Volume;
+
+  Volume = NULL;
+  EfiAcquireLock (&gExt4Lock);
+
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiBlockIoProtocolGuid,
+                  (VOID **) &BlockIo,
+                  This->DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiDiskIoProtocolGuid,
+                  (VOID **) &DiskIo,
+                  This->DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  );
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Volume = AllocateZeroPool (sizeof (EXT4_VOLUME));
+  if (Volume == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ErrorCloseDiskIo;
+  }
+
+  Volume->Signature = EXT4_VOLUME_SIGNATURE;
+  Volume->Handle    = ControllerHandle;
+  Volume->BlockIo   = BlockIo;
+  Volume->DiskIo    = DiskIo;
+  Volume->MediaId   = BlockIo->Media->MediaId;
+  Volume->Valid     = TRUE;
+  Volume->SimpleFileSystem.Revision   = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_REVISION;
+  Volume->SimpleFileSystem.OpenVolume = Ext4OpenVolume;
+
+  Status = Ext4MountVolume (Volume);
+  if (EFI_ERROR (Status)) {
+    goto ErrorFreeVolume;
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &ControllerHandle,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  &Volume->SimpleFileSystem,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorFreeVolume;
+  }
+
+  DEBUG ((EFI_D_INFO, "Ext4: mounted %ld blocks of %d bytes, %d groups\n",
+          Volume->BlockCount, Volume->BlockSize, Volume->GroupCount));
+  goto Exit;
+
+ErrorFreeVolume:
+  Ext4FreeVolume (Volume);
+
+ErrorCloseDiskIo:
+  gBS->CloseProtocol (
+         ControllerHandle,
+         &gEfiDiskIoProtocolGuid,
+         This->DriverBindingHandle,
+         ControllerHandle
+         );
+
+Exit:
+  EfiReleaseLock (&gExt4Lock);
+  return Status;
+}
+
+/**
+  Stop this driver on ControllerHandle by removing the Simple File System
+  protocol. Files that are still open stay valid objects but fail every
+  request; the volume is freed when the last of them is closed.
+
+  @param  This              Protocol instance pointer.
+  @param  ControllerHandle  Handle of device to stop driver on
+  @param  NumberOfChildren  Number of Handles in ChildHandleBuffer. If number of
+                            children is zero stop the entire bus driver.
+  @param  ChildHandleBuffer List of Child Handles to Stop.
+
+  @retval EFI_SUCCESS       This driver is removed ControllerHandle
+  @retval other             This driver was not removed from this device
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4DriverBindingStop (
+  IN  EFI_DRIVER_BINDING_PROTOCOL    *This,
+  IN  EFI_HANDLE                     ControllerHandle,
+  IN  UINTN                          NumberOfChildren,
+  IN  EFI_HANDLE                     *ChildHandleBuffer
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *SimpleFileSystem;
+  EXT4_VOLUME                      *Volume;
+
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  (VOID **) &SimpleFileSystem,
+                  This->DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Volume = EXT4_VOLUME_FROM_THIS (SimpleFileSystem);
+
+  EfiAcquireLock (&gExt4Lock);
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (
+                  ControllerHandle,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  &Volume->SimpleFileSystem,
+                  NULL
+                  );
+  if (!EFI_ERROR (Status)) {
+    gBS->CloseProtocol (
+           ControllerHandle,
+           &gEfiDiskIoProtocolGuid,
+           This->DriverBindingHandle,
+           ControllerHandle
+           );
+
+    Volume->Valid   = FALSE;
+    Volume->DiskIo  = NULL;
+    Volume->BlockIo = NULL;
+    if (Volume->OpenFiles == 0) {
+      Ext4FreeVolume (Volume);
+    }
+  }
+
+  EfiReleaseLock (&gExt4Lock);
+  return Status;
+}
+
+//
+// Driver Binding Protocol Instance
+//
+EFI_DRIVER_BINDING_PROTOCOL gExt4DriverBinding = {
+  Ext4DriverBindingSupported,
+  Ext4DriverBindingStart,
+  Ext4DriverBindingStop,
+  0xa,
+  NULL,
+  NULL
+};
+
+/**
+  The user Entry Point for the ext2/ext3/ext4 file system driver. The user
+  code starts with this function as the real entry point for the image goes
+  into a library that calls this function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeExt4 (
+  IN EFI_HANDLE           ImageHandle,
+  IN EFI_SYSTEM_TABLE     *SystemTable
+  )
+{
+  EFI_STATUS              Status;
+
+  //
+  // Install driver model protocol(s).
+  //
+  Status = EfiLibInstallDriverBindingComponentName2 (
+             ImageHandle,
+             SystemTable,
+             &gExt4DriverBinding,
+             ImageHandle,
+             &gExt4ComponentName,
+             &gExt4ComponentName2
+             );
+  ASSERT_EFI_ERROR (Status);
+
+  return Status;
+}
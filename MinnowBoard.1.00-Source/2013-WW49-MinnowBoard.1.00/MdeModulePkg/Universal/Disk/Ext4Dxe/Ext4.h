@@ -0,0 +1,515 @@
+/** @file
+  Master header file for the read-only ext2/ext3/ext4 file system driver.
+  It includes the module private definitions.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _EXT4_H_
+#define _EXT4_H_
+
+#include <Uefi.h>
+#include <Guid/FileInfo.h>
+#include <Guid/FileSystemInfo.h>
+#include <Guid/FileSystemVolumeLabelInfo.h>
+#include <Protocol/BlockIo.h>
+#include <Protocol/ComponentName.h>
+#include <Protocol/DriverBinding.h>
+#include <Protocol/DiskIo.h>
+#include <Protocol/SimpleFileSystem.h>
+#include <Library/DebugLib.h>
+#include <Library/UefiDriverEntryPoint.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "Ext4Disk.h"
+
+//
+// Number of inodes kept in the per-volume inode cache.
+//
+#define EXT4_INODE_CACHE_SIZE             64
+
+//
+// Number of directory entries kept in the per-volume dentry cache, and the
+// number of hash buckets they are spread over (a power of two).
+//
+#define EXT4_DENTRY_CACHE_SIZE            256
+#define EXT4_DENTRY_HASH_SIZE             64
+
+//
+// Maximum number of symbolic links followed while resolving one path.
+//
+#define EXT4_MAX_SYMLINK_DEPTH            8
+
+typedef struct {
+  LIST_ENTRY              Link;           ///< Position in the LRU list
+  UINT32                  Number;         ///< 0 if the entry is unused
+  EXT4_INODE              Inode;
+} EXT4_INODE_CACHE_ENTRY;
+
+typedef struct {
+  LIST_ENTRY              HashLink;
+  LIST_ENTRY              LruLink;
+  UINT32                  Parent;         ///< 0 if the entry is unused
+  UINT32                  Inode;
+  UINT8                   NameLen;
+  CHAR8                   Name[EXT4_NAME_LEN];
+} EXT4_DENTRY;
+
+#define EXT4_VOLUME_SIGNATURE             SIGNATURE_32 ('e', 'x', 't', '4')
+
+typedef struct {
+  UINTN                           Signature;
+  EFI_HANDLE                      Handle;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL SimpleFileSystem;
+  EFI_BLOCK_IO_PROTOCOL           *BlockIo;
+  EFI_DISK_IO_PROTOCOL            *DiskIo;
+  UINT32                          MediaId;
+
+  //
+  // Stop() clears Valid; the volume is freed once the last file is closed.
+  //
+  BOOLEAN                         Valid;
+  UINTN                           OpenFiles;
+
+  UINT32                          BlockSize;
+  UINT32                          InodeSize;
+  UINT32                          InodesPerGroup;
+  UINT32                          BlocksPerGroup;
+  UINT32                          GroupCount;
+  UINT32                          FeatureIncompat;
+  UINT32                          FeatureRoCompat;
+  UINT64                          BlockCount;
+  UINT64                          FreeBlockCount;
+  UINT64                          *InodeTable;    ///< Inode table block of each group
+  CHAR16                          VolumeLabel[17];
+
+  //
+  // Directory block last read by Ext4ReadDirEntry(); BlockBufferInode is 0
+  // when BlockBuffer holds anything else.
+  //
+  UINT8                           *BlockBuffer;
+  UINT32                          BlockBufferInode;
+  UINT64                          BlockBufferOffset;
+  UINTN                           BlockBufferSize;
+
+  EXT4_INODE_CACHE_ENTRY          *InodeCache;
+  LIST_ENTRY                      InodeLru;
+
+  EXT4_DENTRY                     *DentryCache;
+  LIST_ENTRY                      DentryLru;
+  LIST_ENTRY                      DentryHash[EXT4_DENTRY_HASH_SIZE];
+} EXT4_VOLUME;
+
+#define EXT4_VOLUME_FROM_THIS(a)          CR (a, EXT4_VOLUME, SimpleFileSystem, EXT4_VOLUME_SIGNATURE)
+
+//
+// An inode being read, with the last block run it mapped and the last
+// extent tree or indirect block it read, so sequential access does not
+// walk the block map again for every call.
+//
+typedef struct {
+  UINT32                  Number;
+  EXT4_INODE              Inode;
+  UINT64                  Size;
+
+  UINT32                  RunLblock;
+  UINT32                  RunCount;       ///< 0 if no run is cached
+  UINT64                  RunPblock;      ///< 0 for a hole
+
+  UINT8                   *MapBuffer;
+  UINT64                  MapBufferBlock; ///< 0 if MapBuffer holds nothing
+} EXT4_NODE;
+
+#define EXT4_FILE_SIGNATURE               SIGNATURE_32 ('e', 'x', 't', 'f')
+
+typedef struct {
+  UINTN                   Signature;
+  EFI_FILE_PROTOCOL       Handle;
+  EXT4_VOLUME             *Volume;
+  EXT4_NODE               Node;
+  UINT64                  Position;
+  CHAR8                   Name[EXT4_NAME_LEN + 1];
+} EXT4_FILE;
+
+#define EXT4_FILE_FROM_THIS(a)            CR (a, EXT4_FILE, Handle, EXT4_FILE_SIGNATURE)
+
+#define EXT4_IS_DIR(Node)                 (((Node)->Inode.Mode & EXT4_S_IFMT) == EXT4_S_IFDIR)
+#define EXT4_IS_REG(Node)                 (((Node)->Inode.Mode & EXT4_S_IFMT) == EXT4_S_IFREG)
+#define EXT4_IS_SYMLINK(Node)             (((Node)->Inode.Mode & EXT4_S_IFMT) == EXT4_S_IFLNK)
+
+//
+// Global Variables
+//
+extern EFI_DRIVER_BINDING_PROTOCOL   gExt4DriverBinding;
+extern EFI_COMPONENT_NAME_PROTOCOL   gExt4ComponentName;
+extern EFI_COMPONENT_NAME2_PROTOCOL  gExt4ComponentName2;
+extern EFI_LOCK                      gExt4Lock;
+extern EFI_FILE_PROTOCOL             gExt4FileInterface;
+
+//
+// Superblock.c
+//
+
+/**
+  Read the superblock and the group descriptors of the volume on DiskIo,
+  and set up the inode and dentry caches.
+
+  @param  Volume                The volume with DiskIo, BlockIo and MediaId filled in.
+
+  @retval EFI_SUCCESS           The volume is an ext2/3/4 file system this driver can read.
+  @retval EFI_UNSUPPORTED       The volume is not an ext2/3/4 file system, or uses
+                                incompatible features this driver does not know.
+  @retval EFI_VOLUME_CORRUPTED  The superblock or group descriptors are inconsistent.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4MountVolume (
+  IN OUT EXT4_VOLUME        *Volume
+  );
+
+/**
+  Free a volume and everything Ext4MountVolume() allocated for it.
+
+  @param  Volume                The volume to free.
+
+**/
+VOID
+Ext4FreeVolume (
+  IN EXT4_VOLUME            *Volume
+  );
+
+/**
+  Read bytes from the volume.
+
+  @param  Volume                The volume to read from.
+  @param  Offset                The byte offset on the volume.
+  @param  Size                  The number of bytes to read.
+  @param  Buffer                The buffer that receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_DEVICE_ERROR      The volume has been released by Stop().
+  @retval Others                The error returned by Disk I/O.
+
+**/
+EFI_STATUS
+Ext4ReadDisk (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT64                Offset,
+  IN  UINTN                 Size,
+  OUT VOID                  *Buffer
+  );
+
+//
+// Inode.c
+//
+
+/**
+  Read an inode, going through the inode cache.
+
+  @param  Volume                The volume the inode is on.
+  @param  Number                The inode number.
+  @param  Inode                 Receives the inode.
+
+  @retval EFI_SUCCESS           The inode was read.
+  @retval EFI_VOLUME_CORRUPTED  The inode number is out of range.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadInode (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT32                Number,
+  OUT EXT4_INODE            *Inode
+  );
+
+/**
+  Prepare a node for reading the given inode.
+
+  @param  Volume                The volume the inode is on.
+  @param  Number                The inode number.
+  @param  Node                  The node to set up.
+
+  @retval EFI_SUCCESS           The node is ready. Release it with Ext4CloseNode().
+  @retval Others                The inode could not be read.
+
+**/
+EFI_STATUS
+Ext4OpenNode (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT32                Number,
+  OUT EXT4_NODE             *Node
+  );
+
+/**
+  Release what Ext4OpenNode() and later reads allocated for a node.
+
+  @param  Node                  The node to release.
+
+**/
+VOID
+Ext4CloseNode (
+  IN EXT4_NODE              *Node
+  );
+
+/**
+  Read data of an inode. Block runs that are contiguous on disk are read
+  with a single Disk I/O request straight into Buffer.
+
+  @param  Volume                The volume the inode is on.
+  @param  Node                  The node to read from.
+  @param  Offset                The byte offset in the inode's data.
+  @param  Size                  On input the number of bytes to read, on output
+                                the number of bytes read, which is less only
+                                when the end of the data is reached.
+  @param  Buffer                The buffer that receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_VOLUME_CORRUPTED  The block map of the inode is inconsistent.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadNode (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT64             Offset,
+  IN OUT UINTN              *Size,
+  OUT    VOID               *Buffer
+  );
+
+/**
+  Read the target of a symbolic link.
+
+  @param  Volume                The volume the link is on.
+  @param  Node                  The symbolic link.
+  @param  Target                Receives a pool allocated, null-terminated
+                                copy of the link target.
+
+  @retval EFI_SUCCESS           The target was read.
+  @retval EFI_VOLUME_CORRUPTED  The link is empty or too long.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The target could not be read.
+
+**/
+EFI_STATUS
+Ext4ReadSymlink (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  OUT    CHAR8              **Target
+  );
+
+//
+// Directory.c
+//
+
+/**
+  Read the next in-use entry of a directory.
+
+  @param  Volume                The volume the directory is on.
+  @param  Dir                   The directory.
+  @param  Position              On input the byte offset to read from, on output
+                                the offset of the entry after the one returned.
+  @param  Entry                 Receives the entry, with NameLen fixed up for
+                                volumes without the filetype feature.
+
+  @retval EFI_SUCCESS           An entry was returned.
+  @retval EFI_NOT_FOUND         There are no more entries.
+  @retval EFI_VOLUME_CORRUPTED  The directory block is inconsistent.
+  @retval Others                The directory could not be read.
+
+**/
+EFI_STATUS
+Ext4ReadDirEntry (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Dir,
+  IN OUT UINT64             *Position,
+  OUT    EXT4_DIR_ENTRY     *Entry
+  );
+
+/**
+  Resolve a UEFI path to an inode, following symbolic links.
+
+  @param  Volume                The volume.
+  @param  Start                 The directory relative paths start from.
+  @param  StartName             The name of Start, returned if the path names Start itself.
+  @param  FileName              The path, with '\' separators.
+  @param  Number                Receives the inode number the path resolves to.
+  @param  Name                  Receives the last path component, EXT4_NAME_LEN + 1 bytes.
+
+  @retval EFI_SUCCESS           The path was resolved.
+  @retval EFI_NOT_FOUND         A path component does not exist or is not a directory.
+  @retval EFI_INVALID_PARAMETER A path component is too long.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                A directory could not be read.
+
+**/
+EFI_STATUS
+Ext4ResolvePath (
+  IN  EXT4_VOLUME           *Volume,
+  IN  EXT4_NODE             *Start,
+  IN  CHAR8                 *StartName,
+  IN  CHAR16                *FileName,
+  OUT UINT32                *Number,
+  OUT CHAR8                 *Name
+  );
+
+/**
+  Add a name to inode mapping to the dentry cache.
+
+  @param  Volume                The volume.
+  @param  Parent                The directory inode the name is in.
+  @param  Name                  The name, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+  @param  Inode                 The inode the name refers to.
+
+**/
+VOID
+Ext4AddDentry (
+  IN EXT4_VOLUME            *Volume,
+  IN UINT32                 Parent,
+  IN CONST CHAR8            *Name,
+  IN UINTN                  NameLen,
+  IN UINT32                 Inode
+  );
+
+/**
+  Convert a UTF-8 name to UCS-2. Characters outside the BMP and invalid
+  sequences become '?'.
+
+  @param  Source                The UTF-8 name, not null-terminated.
+  @param  SourceLen             The length of Source in bytes.
+  @param  Destination           Receives the null-terminated name; it must hold
+                                SourceLen + 1 characters.
+
+**/
+VOID
+Ext4Utf8ToUcs2 (
+  IN  CONST CHAR8           *Source,
+  IN  UINTN                 SourceLen,
+  OUT CHAR16                *Destination
+  );
+
+//
+// File.c
+//
+
+EFI_STATUS
+EFIAPI
+Ext4OpenVolume (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL                **File
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Open (
+  IN  EFI_FILE_PROTOCOL     *This,
+  OUT EFI_FILE_PROTOCOL     **NewHandle,
+  IN  CHAR16                *FileName,
+  IN  UINT64                OpenMode,
+  IN  UINT64                Attributes
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Close (
+  IN EFI_FILE_PROTOCOL      *This
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Delete (
+  IN EFI_FILE_PROTOCOL      *This
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Read (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Write (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  IN     VOID               *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4GetPosition (
+  IN  EFI_FILE_PROTOCOL     *This,
+  OUT UINT64                *Position
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4SetPosition (
+  IN EFI_FILE_PROTOCOL      *This,
+  IN UINT64                 Position
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4GetInfo (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN     EFI_GUID           *InformationType,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4SetInfo (
+  IN EFI_FILE_PROTOCOL      *This,
+  IN EFI_GUID               *InformationType,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4Flush (
+  IN EFI_FILE_PROTOCOL      *This
+  );
+
+//
+// ComponentName.c
+//
+
+EFI_STATUS
+EFIAPI
+Ext4ComponentNameGetDriverName (
+  IN  EFI_COMPONENT_NAME_PROTOCOL  *This,
+  IN  CHAR8                        *Language,
+  OUT CHAR16                       **DriverName
+  );
+
+EFI_STATUS
+EFIAPI
+Ext4ComponentNameGetControllerName (
+  IN  EFI_COMPONENT_NAME_PROTOCOL                     *This,
+  IN  EFI_HANDLE                                      ControllerHandle,
+  IN  EFI_HANDLE                                      ChildHandle        OPTIONAL,
+  IN  CHAR8                                           *Language,
+  OUT CHAR16                                          **ControllerName
+  );
+
+#endif
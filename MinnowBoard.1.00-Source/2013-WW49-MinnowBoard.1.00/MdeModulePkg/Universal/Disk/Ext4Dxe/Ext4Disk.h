@@ -0,0 +1,311 @@
+/** @file
+  On-disk structures of the ext2, ext3 and ext4 file systems.
+
+  Only the parts of the on-disk format that a reader needs are described here.
+  All multi-byte fields are little endian.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _EXT4_DISK_H_
+#define _EXT4_DISK_H_
+
+//
+// The superblock always lives 1024 bytes into the volume, whatever the block size.
+//
+#define EXT4_SUPERBLOCK_OFFSET              1024
+#define EXT4_SUPERBLOCK_SIZE                1024
+#define EXT4_SIGNATURE                      0xEF53
+
+#define EXT4_MIN_BLOCK_SIZE                 1024
+#define EXT4_MAX_BLOCK_SIZE                 65536
+#define EXT4_GOOD_OLD_REV                   0
+#define EXT4_GOOD_OLD_INODE_SIZE            128
+#define EXT4_MIN_DESC_SIZE                  32
+#define EXT4_MIN_DESC_SIZE_64BIT            64
+
+#define EXT4_ROOT_INODE                     2
+#define EXT4_NAME_LEN                       255
+#define EXT4_N_BLOCKS                       15
+#define EXT4_NDIR_BLOCKS                    12
+#define EXT4_IND_BLOCK                      12
+#define EXT4_DIND_BLOCK                     13
+#define EXT4_TIND_BLOCK                     14
+
+//
+// Logical block numbers within a file are 32 bits wide.
+//
+#define EXT4_LOGICAL_BLOCK_LIMIT            0x100000000ULL
+
+//
+// s_feature_compat
+//
+#define EXT4_FEATURE_COMPAT_HAS_JOURNAL     0x0004
+
+//
+// s_feature_ro_compat. A reader may ignore these, except for the ones that
+// change how existing fields are interpreted.
+//
+#define EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER 0x0001
+#define EXT4_FEATURE_RO_COMPAT_HUGE_FILE    0x0008
+
+//
+// s_feature_incompat
+//
+#define EXT4_FEATURE_INCOMPAT_COMPRESSION   0x00001
+#define EXT4_FEATURE_INCOMPAT_FILETYPE      0x00002
+#define EXT4_FEATURE_INCOMPAT_RECOVER       0x00004
+#define EXT4_FEATURE_INCOMPAT_JOURNAL_DEV   0x00008
+#define EXT4_FEATURE_INCOMPAT_META_BG       0x00010
+#define EXT4_FEATURE_INCOMPAT_EXTENTS       0x00040
+#define EXT4_FEATURE_INCOMPAT_64BIT         0x00080
+#define EXT4_FEATURE_INCOMPAT_MMP           0x00100
+#define EXT4_FEATURE_INCOMPAT_FLEX_BG       0x00200
+#define EXT4_FEATURE_INCOMPAT_EA_INODE      0x00400
+#define EXT4_FEATURE_INCOMPAT_DIRDATA       0x01000
+#define EXT4_FEATURE_INCOMPAT_CSUM_SEED     0x02000
+#define EXT4_FEATURE_INCOMPAT_LARGEDIR      0x04000
+#define EXT4_FEATURE_INCOMPAT_INLINE_DATA   0x08000
+#define EXT4_FEATURE_INCOMPAT_ENCRYPT       0x10000
+#define EXT4_FEATURE_INCOMPAT_CASEFOLD      0x20000
+
+//
+// Incompatible features that do not change how a reader finds file data.
+// encrypt and casefold are left out: names in such directories are
+// encrypted or looked up case-insensitively, which this driver does not do.
+//
+#define EXT4_FEATURE_INCOMPAT_SUPPORTED     (EXT4_FEATURE_INCOMPAT_FILETYPE    | \
+                                             EXT4_FEATURE_INCOMPAT_RECOVER     | \
+                                             EXT4_FEATURE_INCOMPAT_META_BG     | \
+                                             EXT4_FEATURE_INCOMPAT_EXTENTS     | \
+                                             EXT4_FEATURE_INCOMPAT_64BIT       | \
+                                             EXT4_FEATURE_INCOMPAT_MMP         | \
+                                             EXT4_FEATURE_INCOMPAT_FLEX_BG     | \
+                                             EXT4_FEATURE_INCOMPAT_EA_INODE    | \
+                                             EXT4_FEATURE_INCOMPAT_CSUM_SEED   | \
+                                             EXT4_FEATURE_INCOMPAT_LARGEDIR    | \
+                                             EXT4_FEATURE_INCOMPAT_INLINE_DATA)
+
+#pragma pack(1)
+
+typedef struct {
+  UINT32  InodesCount;
+  UINT32  BlocksCountLo;
+  UINT32  RBlocksCountLo;
+  UINT32  FreeBlocksCountLo;
+  UINT32  FreeInodesCount;
+  UINT32  FirstDataBlock;
+  UINT32  LogBlockSize;
+  UINT32  LogClusterSize;
+  UINT32  BlocksPerGroup;
+  UINT32  ClustersPerGroup;
+  UINT32  InodesPerGroup;
+  UINT32  Mtime;
+  UINT32  Wtime;
+  UINT16  MntCount;
+  UINT16  MaxMntCount;
+  UINT16  Magic;
+  UINT16  State;
+  UINT16  Errors;
+  UINT16  MinorRevLevel;
+  UINT32  LastCheck;
+  UINT32  CheckInterval;
+  UINT32  CreatorOs;
+  UINT32  RevLevel;
+  UINT16  DefResuid;
+  UINT16  DefResgid;
+  UINT32  FirstIno;
+  UINT16  InodeSize;
+  UINT16  BlockGroupNr;
+  UINT32  FeatureCompat;
+  UINT32  FeatureIncompat;
+  UINT32  FeatureRoCompat;
+  UINT8   Uuid[16];
+  CHAR8   VolumeName[16];
+  CHAR8   LastMounted[64];
+  UINT32  AlgorithmUsageBitmap;
+  UINT8   PreallocBlocks;
+  UINT8   PreallocDirBlocks;
+  UINT16  ReservedGdtBlocks;
+  UINT8   JournalUuid[16];
+  UINT32  JournalInum;
+  UINT32  JournalDev;
+  UINT32  LastOrphan;
+  UINT32  HashSeed[4];
+  UINT8   DefHashVersion;
+  UINT8   JnlBackupType;
+  UINT16  DescSize;
+  UINT32  DefaultMountOpts;
+  UINT32  FirstMetaBg;
+  UINT32  MkfsTime;
+  UINT32  JnlBlocks[17];
+  UINT32  BlocksCountHi;
+  UINT32  RBlocksCountHi;
+  UINT32  FreeBlocksCountHi;
+} EXT4_SUPERBLOCK;
+
+//
+// Block group descriptor. The fields after ItableUnused/Checksum are only
+// present when the 64bit feature is set and DescSize is at least 64.
+//
+typedef struct {
+  UINT32  BlockBitmapLo;
+  UINT32  InodeBitmapLo;
+  UINT32  InodeTableLo;
+  UINT16  FreeBlocksCountLo;
+  UINT16  FreeInodesCountLo;
+  UINT16  UsedDirsCountLo;
+  UINT16  Flags;
+  UINT32  ExcludeBitmapLo;
+  UINT16  BlockBitmapCsumLo;
+  UINT16  InodeBitmapCsumLo;
+  UINT16  ItableUnusedLo;
+  UINT16  Checksum;
+  UINT32  BlockBitmapHi;
+  UINT32  InodeBitmapHi;
+  UINT32  InodeTableHi;
+} EXT4_GROUP_DESC;
+
+//
+// i_mode
+//
+#define EXT4_S_IFMT                         0xF000
+#define EXT4_S_IFLNK                        0xA000
+#define EXT4_S_IFREG                        0x8000
+#define EXT4_S_IFDIR                        0x4000
+
+//
+// i_flags
+//
+#define EXT4_ENCRYPT_FL                     0x00000800
+#define EXT4_INDEX_FL                       0x00001000
+#define EXT4_HUGE_FILE_FL                   0x00040000
+#define EXT4_EXTENTS_FL                     0x00080000
+#define EXT4_INLINE_DATA_FL                 0x10000000
+
+//
+// The part of the inode a reader needs. Fields from ExtraIsize on are only
+// valid when the inode is larger than 128 bytes and ExtraIsize covers them.
+//
+typedef struct {
+  UINT16  Mode;
+  UINT16  Uid;
+  UINT32  SizeLo;
+  UINT32  Atime;
+  UINT32  Ctime;
+  UINT32  Mtime;
+  UINT32  Dtime;
+  UINT16  Gid;
+  UINT16  LinksCount;
+  UINT32  BlocksLo;
+  UINT32  Flags;
+  UINT32  Osd1;
+  UINT32  Block[EXT4_N_BLOCKS];
+  UINT32  Generation;
+  UINT32  FileAclLo;
+  UINT32  SizeHigh;
+  UINT32  ObsoFaddr;
+  UINT16  BlocksHigh;
+  UINT16  FileAclHigh;
+  UINT16  UidHigh;
+  UINT16  GidHigh;
+  UINT16  ChecksumLo;
+  UINT16  Reserved;
+  UINT16  ExtraIsize;
+  UINT16  ChecksumHi;
+  UINT32  CtimeExtra;
+  UINT32  MtimeExtra;
+  UINT32  AtimeExtra;
+  UINT32  Crtime;
+  UINT32  CrtimeExtra;
+} EXT4_INODE;
+
+//
+// Extent tree. The root node lives in the 60 bytes of i_block; the other
+// nodes fill a whole block each.
+//
+#define EXT4_EXTENT_MAGIC                   0xF30A
+#define EXT4_EXTENT_MAX_DEPTH               5
+#define EXT4_EXTENT_INIT_MAX_LEN            32768
+
+typedef struct {
+  UINT16  Magic;
+  UINT16  Entries;
+  UINT16  Max;
+  UINT16  Depth;
+  UINT32  Generation;
+} EXT4_EXTENT_HEADER;
+
+typedef struct {
+  UINT32  Block;
+  UINT32  LeafLo;
+  UINT16  LeafHi;
+  UINT16  Unused;
+} EXT4_EXTENT_INDEX;
+
+//
+// Len above EXT4_EXTENT_INIT_MAX_LEN marks an allocated but unwritten
+// extent of (Len - EXT4_EXTENT_INIT_MAX_LEN) blocks, which reads as zeros.
+//
+typedef struct {
+  UINT32  Block;
+  UINT16  Len;
+  UINT16  StartHi;
+  UINT32  StartLo;
+} EXT4_EXTENT;
+
+//
+// Extended attributes kept in the inode, after i_extra_isize. The entries
+// follow the magic number and the list ends with four zero bytes. Value
+// offsets are relative to the first entry. The part of an inline_data file
+// or directory that does not fit in i_block is the value of "system.data".
+//
+#define EXT4_XATTR_MAGIC                    0xEA020000
+#define EXT4_XATTR_INDEX_SYSTEM             7
+#define EXT4_XATTR_ENTRY_SIZE(NameLen)      (((NameLen) + sizeof (EXT4_XATTR_ENTRY) + 3) & ~3)
+
+//
+// Inline directories start with the parent's inode number in place of the
+// "." and ".." entries.
+//
+#define EXT4_INLINE_DOTDOT_SIZE             4
+
+typedef struct {
+  UINT8   NameLen;
+  UINT8   NameIndex;
+  UINT16  ValueOffs;
+  UINT32  ValueInum;
+  UINT32  ValueSize;
+  UINT32  Hash;
+} EXT4_XATTR_ENTRY;
+
+//
+// Directory entry. Without the filetype feature NameLen is 16 bits wide and
+// FileType holds its upper byte.
+//
+#define EXT4_DIR_ENTRY_HEADER_SIZE          8
+
+#define EXT4_FT_UNKNOWN                     0
+#define EXT4_FT_REG_FILE                    1
+#define EXT4_FT_DIR                         2
+#define EXT4_FT_SYMLINK                     7
+
+typedef struct {
+  UINT32  Inode;
+  UINT16  RecLen;
+  UINT8   NameLen;
+  UINT8   FileType;
+  CHAR8   Name[EXT4_NAME_LEN];
+} EXT4_DIR_ENTRY;
+
+#pragma pack()
+
+#endif
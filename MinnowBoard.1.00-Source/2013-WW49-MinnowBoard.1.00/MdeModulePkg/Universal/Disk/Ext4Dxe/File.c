@@ -0,0 +1,693 @@
+/** @file
+  Simple File System and File protocol implementation of the ext2/ext3/ext4
+  file system driver. Volumes are always read only.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ext4.h"
+
+EFI_FILE_PROTOCOL gExt4FileInterface = {
+  EFI_FILE_PROTOCOL_REVISION,
+  Ext4Open,
+  Ext4Close,
+  Ext4Delete,
+  Ext4Read,
+  Ext4Write,
+  Ext4GetPosition,
+  Ext4SetPosition,
+  Ext4GetInfo,
+  Ext4SetInfo,
+  Ext4Flush
+};
+
+/**
+  Convert a time stamp in seconds since 1970-01-01 UTC to an EFI_TIME.
+
+  @param  Seconds               The time stamp.
+  @param  Time                  Receives the time.
+
+**/
+VOID
+Ext4UnixTimeToEfiTime (
+  IN  UINT32                Seconds,
+  OUT EFI_TIME              *Time
+  )
+{
+  UINT32  Days;
+  UINT32  Era;
+  UINT32  DayOfEra;
+  UINT32  YearOfEra;
+  UINT32  DayOfYear;
+  UINT32  MonthIndex;
+
+  ZeroMem (Time, sizeof (EFI_TIME));
+  Days         = Seconds / 86400;
+  Seconds      = Seconds % 86400;
+  Time->Hour   = (UINT8) (Seconds / 3600);
+  Time->Minute = (UINT8) (Seconds / 60 % 60);
+  Time->Second = (UINT8) (Seconds % 60);
+
+  //
+  // Civil date from the day count, with years starting on March 1st so the
+  // leap day is the last day of the year.
+  //
+  Days      += 719468;
+  Era        = Days / 146097;
+  DayOfEra   = Days - Era * 146097;
+  YearOfEra  = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+  DayOfYear  = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+  MonthIndex = (5 * DayOfYear + 2) / 153;
+
+  Time->Day   = (UINT8) (DayOfYear - (153 * MonthIndex + 2) / 5 + 1);
+  Time->Month = (UINT8) ((MonthIndex < 10) ? MonthIndex + 3 : MonthIndex - 9);
+  Time->Year  = (UINT16) (YearOfEra + Era * 400 + ((Time->Month <= 2) ? 1 : 0));
+}
+
+/**
+  Fill in an EFI_FILE_INFO for an inode.
+
+  @param  Volume                The volume the inode is on.
+  @param  Inode                 The inode.
+  @param  Name                  The UTF-8 name of the file, not null-terminated.
+  @param  NameLen               The length of Name in bytes.
+  @param  BufferSize            On input the size of Buffer, on output the size
+                                of the information.
+  @param  Buffer                Receives the EFI_FILE_INFO.
+
+  @retval EFI_SUCCESS           The information was returned.
+  @retval EFI_BUFFER_TOO_SMALL  BufferSize is too small; it has been updated.
+
+**/
+EFI_STATUS
+Ext4GetFileInfo (
+  IN     EXT4_VOLUME        *Volume,
+  IN     EXT4_INODE         *Inode,
+  IN     CONST CHAR8        *Name,
+  IN     UINTN              NameLen,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_FILE_INFO  *Info;
+  CHAR16         FileName[EXT4_NAME_LEN + 1];
+  UINTN          Size;
+  UINT64         Blocks;
+
+  Ext4Utf8ToUcs2 (Name, NameLen, FileName);
+  Size = SIZE_OF_EFI_FILE_INFO + StrSize (FileName);
+  if (*BufferSize < Size) {
+    *BufferSize = Size;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Info = Buffer;
+  ZeroMem (Info, SIZE_OF_EFI_FILE_INFO);
+  Info->Size     = Size;
+  Info->FileSize = Inode->SizeLo | LShiftU64 (Inode->SizeHigh, 32);
+
+  //
+  // i_blocks counts 512-byte sectors, unless huge_file says it counts blocks.
+  //
+  Blocks = Inode->BlocksLo;
+  if ((Volume->FeatureRoCompat & EXT4_FEATURE_RO_COMPAT_HUGE_FILE) != 0) {
+    Blocks |= LShiftU64 (Inode->BlocksHigh, 32);
+    if ((Inode->Flags & EXT4_HUGE_FILE_FL) != 0) {
+      Blocks = MultU64x32 (Blocks, Volume->BlockSize / 512);
+    }
+  }
+  Info->PhysicalSize = MultU64x32 (Blocks, 512);
+
+  Ext4UnixTimeToEfiTime ((Inode->Crtime != 0) ? Inode->Crtime : Inode->Ctime, &Info->CreateTime);
+  Ext4UnixTimeToEfiTime (Inode->Atime, &Info->LastAccessTime);
+  Ext4UnixTimeToEfiTime (Inode->Mtime, &Info->ModificationTime);
+
+  Info->Attribute = EFI_FILE_READ_ONLY;
+  if ((Inode->Mode & EXT4_S_IFMT) == EXT4_S_IFDIR) {
+    Info->Attribute |= EFI_FILE_DIRECTORY;
+  }
+
+  StrCpy (Info->FileName, FileName);
+  *BufferSize = Size;
+  return EFI_SUCCESS;
+}
+
+/**
+  Create a file handle for an inode.
+
+  @param  Volume                The volume the inode is on.
+  @param  Number                The inode number.
+  @param  Name                  The null-terminated UTF-8 name of the file.
+  @param  NewFile               Receives the file.
+
+  @retval EFI_SUCCESS           The file was created.
+  @retval EFI_ACCESS_DENIED     The inode is encrypted, or is neither a regular
+                                file nor a directory.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The inode could not be read.
+
+**/
+EFI_STATUS
+Ext4CreateFile (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT32                Number,
+  IN  CONST CHAR8           *Name,
+  OUT EXT4_FILE             **NewFile
+  )
+{
+  EFI_STATUS  Status;
+  EXT4_FILE   *File;
+
+  File = AllocateZeroPool (sizeof (EXT4_FILE));
+  if (File == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4OpenNode (Volume, Number, &File->Node);
+  if (!EFI_ERROR (Status) &&
+      (((File->Node.Inode.Flags & EXT4_ENCRYPT_FL) != 0) ||
+       (!EXT4_IS_DIR (&File->Node) && !EXT4_IS_REG (&File->Node)))) {
+    Status = EFI_ACCESS_DENIED;
+  }
+  if (EFI_ERROR (Status)) {
+    FreePool (File);
+    return Status;
+  }
+
+  File->Signature = EXT4_FILE_SIGNATURE;
+  File->Volume    = Volume;
+  CopyMem (&File->Handle, &gExt4FileInterface, sizeof (EFI_FILE_PROTOCOL));
+  AsciiStrCpy (File->Name, Name);
+
+  Volume->OpenFiles++;
+  *NewFile = File;
+  return EFI_SUCCESS;
+}
+
+/**
+  Open the root directory on a volume.
+
+  @param  This                  A pointer to the volume to open the root directory.
+  @param  File                  A pointer to the location to return the opened file handle for the
+                                root directory.
+
+  @retval EFI_SUCCESS           The device was opened.
+  @retval EFI_DEVICE_ERROR      The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED  The file system structures are corrupted.
+  @retval EFI_OUT_OF_RESOURCES  The volume was not opened due to lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4OpenVolume (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL                **File
+  )
+{
+  EFI_STATUS   Status;
+  EXT4_VOLUME  *Volume;
+  EXT4_FILE    *Root;
+
+  Volume = EXT4_VOLUME_FROM_THIS (This);
+
+  EfiAcquireLock (&gExt4Lock);
+  Status = Ext4CreateFile (Volume, EXT4_ROOT_INODE, "", &Root);
+  if (!EFI_ERROR (Status)) {
+    if (EXT4_IS_DIR (&Root->Node)) {
+      *File = &Root->Handle;
+    } else {
+      Ext4CloseNode (&Root->Node);
+      Volume->OpenFiles--;
+      FreePool (Root);
+      Status = EFI_VOLUME_CORRUPTED;
+    }
+  }
+  EfiReleaseLock (&gExt4Lock);
+
+  return Status;
+}
+
+/**
+  Opens a new file relative to the source file's location.
+
+  @param  This       A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                     handle to the source location. This would typically be an open
+                     handle to a directory.
+  @param  NewHandle  A pointer to the location to return the opened handle for the new
+                     file.
+  @param  FileName   The Null-terminated string of the name of the file to be opened.
+                     The file name may contain the following path modifiers: "\", ".",
+                     and "..". Symbolic links on the volume are followed.
+  @param  OpenMode   The mode to open the file. Only EFI_FILE_MODE_READ is allowed.
+  @param  Attributes Only valid for EFI_FILE_MODE_CREATE, which is never allowed.
+
+  @retval EFI_SUCCESS          The file was opened.
+  @retval EFI_NOT_FOUND        The specified file could not be found on the device.
+  @retval EFI_WRITE_PROTECTED  OpenMode asks for write access.
+  @retval EFI_ACCESS_DENIED    The file is encrypted or is a special file.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_OUT_OF_RESOURCES Not enough resources were available to open the file.
+  @retval EFI_INVALID_PARAMETER A parameter is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Open (
+  IN  EFI_FILE_PROTOCOL     *This,
+  OUT EFI_FILE_PROTOCOL     **NewHandle,
+  IN  CHAR16                *FileName,
+  IN  UINT64                OpenMode,
+  IN  UINT64                Attributes
+  )
+{
+  EFI_STATUS   Status;
+  EXT4_FILE    *File;
+  EXT4_FILE    *NewFile;
+  EXT4_VOLUME  *Volume;
+  UINT32       Number;
+  CHAR8        Name[EXT4_NAME_LEN + 1];
+
+  if (NewHandle == NULL || FileName == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  switch (OpenMode) {
+  case EFI_FILE_MODE_READ:
+    break;
+
+  case EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE:
+  case EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE:
+    return EFI_WRITE_PROTECTED;
+
+  default:
+    return EFI_INVALID_PARAMETER;
+  }
+
+  File   = EXT4_FILE_FROM_THIS (This);
+  Volume = File->Volume;
+
+  EfiAcquireLock (&gExt4Lock);
+  if (!Volume->Valid) {
+    Status = EFI_DEVICE_ERROR;
+  } else {
+    Status = Ext4ResolvePath (Volume, &File->Node, File->Name, FileName, &Number, Name);
+    if (!EFI_ERROR (Status)) {
+      Status = Ext4CreateFile (Volume, Number, Name, &NewFile);
+    }
+    if (!EFI_ERROR (Status)) {
+      *NewHandle = &NewFile->Handle;
+    }
+  }
+  EfiReleaseLock (&gExt4Lock);
+
+  return Status;
+}
+
+/**
+  Closes a specified file handle.
+
+  @param  This          A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                        handle to close.
+
+  @retval EFI_SUCCESS   The file was closed.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Close (
+  IN EFI_FILE_PROTOCOL      *This
+  )
+{
+  EXT4_FILE    *File;
+  EXT4_VOLUME  *Volume;
+
+  File   = EXT4_FILE_FROM_THIS (This);
+  Volume = File->Volume;
+
+  EfiAcquireLock (&gExt4Lock);
+  Ext4CloseNode (&File->Node);
+  File->Signature = 0;
+  FreePool (File);
+
+  Volume->OpenFiles--;
+  if (!Volume->Valid && Volume->OpenFiles == 0) {
+    Ext4FreeVolume (Volume);
+  }
+  EfiReleaseLock (&gExt4Lock);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Close and delete the file handle. Files cannot be deleted from a read-only
+  volume, so the handle is only closed.
+
+  @param  This                     A pointer to the EFI_FILE_PROTOCOL instance that is the
+                                   handle to the file to delete.
+
+  @retval EFI_WARN_DELETE_FAILURE  The handle was closed, but the file was not deleted.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Delete (
+  IN EFI_FILE_PROTOCOL      *This
+  )
+{
+  Ext4Close (This);
+  return EFI_WARN_DELETE_FAILURE;
+}
+
+/**
+  Read the next directory entry of a directory as an EFI_FILE_INFO.
+
+  @param  File                  The directory.
+  @param  BufferSize            On input the size of Buffer, on output the size
+                                of the entry returned, or 0 at the end of the directory.
+  @param  Buffer                Receives the EFI_FILE_INFO.
+
+  @retval EFI_SUCCESS           An entry, or the end of the directory, was returned.
+  @retval EFI_BUFFER_TOO_SMALL  BufferSize is too small; it has been updated.
+  @retval Others                The directory could not be read.
+
+**/
+EFI_STATUS
+Ext4ReadDirectory (
+  IN OUT EXT4_FILE          *File,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS      Status;
+  EXT4_VOLUME     *Volume;
+  EXT4_DIR_ENTRY  Entry;
+  EXT4_INODE      Inode;
+  UINT64          Position;
+
+  Volume = File->Volume;
+
+  while (TRUE) {
+    Position = File->Position;
+    Status   = Ext4ReadDirEntry (Volume, &File->Node, &Position, &Entry);
+    if (Status == EFI_NOT_FOUND) {
+      *BufferSize = 0;
+      return EFI_SUCCESS;
+    }
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    //
+    // Like FAT, the root directory has no "." and ".." entries.
+    //
+    if (File->Node.Number == EXT4_ROOT_INODE &&
+        ((Entry.NameLen == 1 && Entry.Name[0] == '.') ||
+         (Entry.NameLen == 2 && Entry.Name[0] == '.' && Entry.Name[1] == '.'))) {
+      File->Position = Position;
+      continue;
+    }
+
+    Status = Ext4ReadInode (Volume, Entry.Inode, &Inode);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = Ext4GetFileInfo (Volume, &Inode, Entry.Name, Entry.NameLen, BufferSize, Buffer);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    //
+    // Listing a directory is usually followed by opening some of its entries.
+    //
+    Ext4AddDentry (Volume, File->Node.Number, Entry.Name, Entry.NameLen, Entry.Inode);
+    File->Position = Position;
+    return EFI_SUCCESS;
+  }
+}
+
+/**
+  Reads data from a file.
+
+  @param  This       A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                     handle to read data from.
+  @param  BufferSize On input, the size of the Buffer. On output, the amount of data
+                     returned in Buffer. In both cases, the size is measured in bytes.
+  @param  Buffer     The buffer into which the data is read.
+
+  @retval EFI_SUCCESS          Data was read.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_DEVICE_ERROR     On entry, the current file position is beyond the end of the file.
+  @retval EFI_VOLUME_CORRUPTED The file system structures are corrupted.
+  @retval EFI_BUFFER_TO_SMALL  The BufferSize is too small to read the current directory
+                               entry. BufferSize has been updated with the size
+                               needed to complete the request.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Read (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS   Status;
+  EXT4_FILE    *File;
+  EXT4_VOLUME  *Volume;
+
+  File   = EXT4_FILE_FROM_THIS (This);
+  Volume = File->Volume;
+
+  EfiAcquireLock (&gExt4Lock);
+  if (!Volume->Valid) {
+    Status = EFI_DEVICE_ERROR;
+  } else if (EXT4_IS_DIR (&File->Node)) {
+    Status = Ext4ReadDirectory (File, BufferSize, Buffer);
+  } else if (File->Position > File->Node.Size) {
+    Status = EFI_DEVICE_ERROR;
+  } else {
+    Status = Ext4ReadNode (Volume, &File->Node, File->Position, BufferSize, Buffer);
+    if (!EFI_ERROR (Status)) {
+      File->Position += *BufferSize;
+    }
+  }
+  EfiReleaseLock (&gExt4Lock);
+
+  return Status;
+}
+
+/**
+  Writes data to a file. The volume is read only.
+
+  @param  This                 A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                               handle to write data to.
+  @param  BufferSize           On input, the size of the Buffer. On output, the amount of data
+                               actually written.
+  @param  Buffer               The buffer of data to write.
+
+  @retval EFI_WRITE_PROTECTED  The volume is read only.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Write (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  IN     VOID               *Buffer
+  )
+{
+  *BufferSize = 0;
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+  Returns a file's current position.
+
+  @param  This            A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                          handle to get the current position on.
+  @param  Position        The address to return the file's current position value.
+
+  @retval EFI_SUCCESS      The position was returned.
+  @retval EFI_UNSUPPORTED  The request is not valid on open directories.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4GetPosition (
+  IN  EFI_FILE_PROTOCOL     *This,
+  OUT UINT64                *Position
+  )
+{
+  EXT4_FILE  *File;
+
+  File = EXT4_FILE_FROM_THIS (This);
+  if (EXT4_IS_DIR (&File->Node)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *Position = File->Position;
+  return EFI_SUCCESS;
+}
+
+/**
+  Sets a file's current position.
+
+  @param  This            A pointer to the EFI_FILE_PROTOCOL instance that is the
+                          file handle to set the requested position on.
+  @param  Position        The byte position from the start of the file to set. The
+                          value 0xFFFFFFFFFFFFFFFF sets the position to the end of file.
+
+  @retval EFI_SUCCESS      The position was set.
+  @retval EFI_UNSUPPORTED  The seek request for nonzero is not valid on open
+                           directories.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4SetPosition (
+  IN EFI_FILE_PROTOCOL      *This,
+  IN UINT64                 Position
+  )
+{
+  EXT4_FILE  *File;
+
+  File = EXT4_FILE_FROM_THIS (This);
+  if (EXT4_IS_DIR (&File->Node)) {
+    if (Position != 0) {
+      return EFI_UNSUPPORTED;
+    }
+  } else if (Position == (UINT64) -1) {
+    Position = File->Node.Size;
+  }
+
+  File->Position = Position;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns information about a file.
+
+  @param  This            A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                          handle the requested information is for.
+  @param  InformationType The type identifier for the information being requested.
+  @param  BufferSize      On input, the size of Buffer. On output, the amount of data
+                          returned in Buffer. In both cases, the size is measured in bytes.
+  @param  Buffer          A pointer to the data buffer to return.
+
+  @retval EFI_SUCCESS          The information was returned.
+  @retval EFI_UNSUPPORTED      The InformationType is not known.
+  @retval EFI_DEVICE_ERROR     The device reported an error.
+  @retval EFI_BUFFER_TOO_SMALL The BufferSize is too small to read the current directory entry.
+                               BufferSize has been updated with the size needed to complete
+                               the request.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4GetInfo (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN     EFI_GUID           *InformationType,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS                    Status;
+  EXT4_FILE                     *File;
+  EXT4_VOLUME                   *Volume;
+  EFI_FILE_SYSTEM_INFO          *FileSystemInfo;
+  EFI_FILE_SYSTEM_VOLUME_LABEL  *VolumeLabel;
+  UINTN                         Size;
+
+  File   = EXT4_FILE_FROM_THIS (This);
+  Volume = File->Volume;
+
+  EfiAcquireLock (&gExt4Lock);
+  if (!Volume->Valid) {
+    Status = EFI_DEVICE_ERROR;
+  } else if (CompareGuid (InformationType, &gEfiFileInfoGuid)) {
+    Status = Ext4GetFileInfo (Volume, &File->Node.Inode, File->Name, AsciiStrLen (File->Name), BufferSize, Buffer);
+  } else if (CompareGuid (InformationType, &gEfiFileSystemInfoGuid)) {
+    Size = SIZE_OF_EFI_FILE_SYSTEM_INFO + StrSize (Volume->VolumeLabel);
+    if (*BufferSize < Size) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    } else {
+      FileSystemInfo             = Buffer;
+      FileSystemInfo->Size       = Size;
+      FileSystemInfo->ReadOnly   = TRUE;
+      FileSystemInfo->VolumeSize = MultU64x32 (Volume->BlockCount, Volume->BlockSize);
+      FileSystemInfo->FreeSpace  = MultU64x32 (Volume->FreeBlockCount, Volume->BlockSize);
+      FileSystemInfo->BlockSize  = Volume->BlockSize;
+      StrCpy (FileSystemInfo->VolumeLabel, Volume->VolumeLabel);
+      Status = EFI_SUCCESS;
+    }
+    *BufferSize = Size;
+  } else if (CompareGuid (InformationType, &gEfiFileSystemVolumeLabelInfoIdGuid)) {
+    Size = SIZE_OF_EFI_FILE_SYSTEM_VOLUME_LABEL + StrSize (Volume->VolumeLabel);
+    if (*BufferSize < Size) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    } else {
+      VolumeLabel = Buffer;
+      StrCpy (VolumeLabel->VolumeLabel, Volume->VolumeLabel);
+      Status = EFI_SUCCESS;
+    }
+    *BufferSize = Size;
+  } else {
+    Status = EFI_UNSUPPORTED;
+  }
+  EfiReleaseLock (&gExt4Lock);
+
+  return Status;
+}
+
+/**
+  Sets information about a file. The volume is read only.
+
+  @param  This                 A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                               handle the information is for.
+  @param  InformationType      The type identifier for the information being set.
+  @param  BufferSize           The size, in bytes, of Buffer.
+  @param  Buffer               A pointer to the data buffer to write.
+
+  @retval EFI_WRITE_PROTECTED  The volume is read only.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4SetInfo (
+  IN EFI_FILE_PROTOCOL      *This,
+  IN EFI_GUID               *InformationType,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+  Flushes all modified data associated with a file to a device. The volume
+  is read only.
+
+  @param  This                 A pointer to the EFI_FILE_PROTOCOL instance that is the file
+                               handle to flush.
+
+  @retval EFI_WRITE_PROTECTED  The volume is read only.
+
+**/
+EFI_STATUS
+EFIAPI
+Ext4Flush (
+  IN EFI_FILE_PROTOCOL      *This
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
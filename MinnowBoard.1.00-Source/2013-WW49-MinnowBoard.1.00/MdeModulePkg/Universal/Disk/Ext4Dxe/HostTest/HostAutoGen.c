@@ -0,0 +1,37 @@
+/** @file
+  Stands in for the AutoGen.c that the EDK II build generates for a module:
+  the GUID globals of Ext4Dxe and the libraries it uses.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostTest.h"
+
+#include <Protocol/ComponentName2.h>
+#include <Protocol/DriverConfiguration.h>
+#include <Protocol/DriverConfiguration2.h>
+#include <Guid/GlobalVariable.h>
+
+GUID      gEfiCallerIdGuid   = { 0x0d9a8578, 0x8666, 0x4d8a, { 0x86, 0x95, 0x5e, 0x9c, 0xd7, 0x48, 0x31, 0xb3 }};
+CHAR8     *gEfiCallerBaseName = "HostTest";
+
+EFI_GUID  gEfiDriverBindingProtocolGuid           = EFI_DRIVER_BINDING_PROTOCOL_GUID;
+EFI_GUID  gEfiComponentNameProtocolGuid           = EFI_COMPONENT_NAME_PROTOCOL_GUID;
+EFI_GUID  gEfiComponentName2ProtocolGuid          = EFI_COMPONENT_NAME2_PROTOCOL_GUID;
+EFI_GUID  gEfiDriverConfigurationProtocolGuid     = EFI_DRIVER_CONFIGURATION_PROTOCOL_GUID;
+EFI_GUID  gEfiDriverConfiguration2ProtocolGuid    = EFI_DRIVER_CONFIGURATION2_PROTOCOL_GUID;
+EFI_GUID  gEfiBlockIoProtocolGuid                 = EFI_BLOCK_IO_PROTOCOL_GUID;
+EFI_GUID  gEfiDiskIoProtocolGuid                  = EFI_DISK_IO_PROTOCOL_GUID;
+EFI_GUID  gEfiSimpleFileSystemProtocolGuid        = EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_GUID;
+EFI_GUID  gEfiFileInfoGuid                        = EFI_FILE_INFO_ID;
+EFI_GUID  gEfiFileSystemInfoGuid                  = EFI_FILE_SYSTEM_INFO_ID;
+EFI_GUID  gEfiFileSystemVolumeLabelInfoIdGuid     = EFI_FILE_SYSTEM_VOLUME_LABEL_ID;
+EFI_GUID  gEfiGlobalVariableGuid                  = EFI_GLOBAL_VARIABLE;
@@ -0,0 +1,1028 @@
+/** @file
+  Host tests of the ext2/ext3/ext4 file system driver.
+
+  The program builds a directory tree in its work directory, turns it into
+  file system images with mkfs.ext4 in several layouts, and has e2fsck index
+  the directories of each. It then binds Ext4Dxe to every image through the
+  host Block I/O and Disk I/O of HostDisk.c and checks what it reads
+  through EFI_FILE_PROTOCOL against the tree: a large file with a hole mapped
+  by extents or by indirect blocks, a directory with enough entries to be
+  hashed (htree), small and inline files, nested paths and symbolic links.
+  Copies of an image with a damaged superblock or group descriptor must be
+  refused by the driver's Start() with the right status.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "HostTest.h"
+
+#include <Library/PrintLib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define TEST_SECTOR_SIZE          512
+#define TEST_IMAGE_SIZE           "32M"
+#define TEST_LABEL                "HostTest"
+#define TEST_PATH_LENGTH          512
+#define TEST_INFO_SIZE            (SIZE_OF_EFI_FILE_INFO + (EXT4_NAME_LEN + 1) * sizeof (CHAR16))
+
+//
+// big.bin has a hole between TEST_HOLE_START and TEST_HOLE_END, and does not
+// end on a block boundary. It is read in chunks that are not a multiple of
+// any block size.
+//
+#define TEST_BIG_FILE_SIZE        (3 * SIZE_1MB + 1234)
+#define TEST_HOLE_START           SIZE_1MB
+#define TEST_HOLE_END             (2 * SIZE_1MB)
+#define TEST_CHUNK_SIZE           40000
+#define TEST_SEEK_COUNT           64
+#define TEST_SEEK_SIZE            5000
+
+//
+// Enough entries in dir that its entries fill several blocks, so e2fsck
+// indexes it, in every layout.
+//
+#define TEST_DIR_FILES            400
+#define TEST_SMALL_SIZES          { 0, 1, 59, 60, 61, 150, 4097 }
+
+//
+// The target of slow-link is longer than the 60 bytes a fast symbolic link
+// keeps in the inode.
+//
+#define TEST_LONG_DIR             "a-directory-with-a-name-long-enough-for-a-slow-symlink"
+
+typedef struct {
+  CONST CHAR8             *Name;
+  CONST CHAR8             *MkfsOptions;
+  UINT32                  Incompat;       ///< Incompatible features the volume must have
+  UINT32                  DescSize;       ///< Group descriptor size mkfs chooses
+  UINT32                  BigFileFlags;   ///< Inode flags big.bin must have
+} TEST_LAYOUT;
+
+typedef struct {
+  CONST CHAR8             *Work;
+  CONST TEST_LAYOUT       *Layout;
+  EFI_HANDLE              Disk;
+  EXT4_VOLUME             *Volume;
+  EFI_FILE_PROTOCOL       *Root;
+  UINT8                   *Buffer;
+} TEST_CONTEXT;
+
+typedef
+BOOLEAN
+(*TEST_FUNCTION) (
+  IN OUT TEST_CONTEXT     *Context
+  );
+
+typedef struct {
+  CONST CHAR8             *Name;
+  TEST_FUNCTION           Function;
+} TEST;
+
+/**
+  Damage the image of a corruption test.
+
+  @param  Fd                    The image file.
+  @param  Sb                    The superblock, written back after the call.
+
+**/
+typedef
+VOID
+(*TEST_PATCH) (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  );
+
+typedef struct {
+  CONST CHAR8             *Name;
+  TEST_PATCH              Patch;
+  EFI_STATUS              Expected;
+} TEST_CORRUPTION;
+
+#define TEST_CHECK(Condition) \
+  do { \
+    if (!(Condition)) { \
+      fprintf (stderr, "check failed at line %u: %s\n", (unsigned) __LINE__, #Condition); \
+      return FALSE; \
+    } \
+  } while (FALSE)
+
+CONST TEST_LAYOUT  mLayouts[] = {
+  { "ext4",        "-t ext4 -b 4096 -O 64bit",       EXT4_FEATURE_INCOMPAT_EXTENTS | EXT4_FEATURE_INCOMPAT_64BIT,       64, EXT4_EXTENTS_FL },
+  { "ext4-1k",     "-t ext4 -b 1024 -O ^64bit",      EXT4_FEATURE_INCOMPAT_EXTENTS,                                     32, EXT4_EXTENTS_FL },
+  { "ext4-inline", "-t ext4 -b 4096 -O inline_data", EXT4_FEATURE_INCOMPAT_EXTENTS | EXT4_FEATURE_INCOMPAT_INLINE_DATA, 64, EXT4_EXTENTS_FL },
+  { "ext3",        "-t ext3 -b 1024",                0,                                                                 32, 0 },
+  { "ext2",        "-t ext2 -b 4096",                0,                                                                 32, 0 }
+};
+
+CONST UINT32  mSmallSizes[] = TEST_SMALL_SIZES;
+
+//
+// Creating the images
+//
+
+/**
+  Return the byte big.bin holds at an offset.
+
+**/
+UINT8
+TestBigFileByte (
+  IN UINT64               Offset
+  )
+{
+  if (Offset >= TEST_HOLE_START && Offset < TEST_HOLE_END) {
+    return 0;
+  }
+  return (UINT8) (Offset * 7 + (Offset >> 12) * 13 + 1);
+}
+
+/**
+  Return the byte a small file holds at an offset.
+
+**/
+UINT8
+TestSmallFileByte (
+  IN UINT64               Offset
+  )
+{
+  return (UINT8) ('a' + Offset % 26);
+}
+
+/**
+  Run a shell command.
+
+  @retval TRUE                  The command exited with a status of at most MaxStatus.
+
+**/
+BOOLEAN
+TestRun (
+  IN CONST CHAR8          *Command,
+  IN int                  MaxStatus
+  )
+{
+  int   Status;
+
+  Status = system (Command);
+  if (Status == -1 || !WIFEXITED (Status) || WEXITSTATUS (Status) > MaxStatus) {
+    fprintf (stderr, "command failed: %s\n", Command);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+  Write a file of the source tree. Data is generated by ByteAt, and the range
+  from HoleStart to HoleEnd is left unwritten; a HoleStart of Size or more
+  leaves no hole.
+
+**/
+BOOLEAN
+TestWriteFile (
+  IN CONST CHAR8          *Path,
+  IN UINT64               Size,
+  IN UINT8                (*ByteAt) (UINT64),
+  IN UINT64               HoleStart,
+  IN UINT64               HoleEnd
+  )
+{
+  UINT8     Buffer[4096];
+  UINT64    Offset;
+  UINTN     Length;
+  UINTN     Index;
+  int       Fd;
+  BOOLEAN   Ok;
+
+  Fd = open (Path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (Fd < 0) {
+    return FALSE;
+  }
+
+  Ok = TRUE;
+  for (Offset = 0; Ok && Offset < Size; Offset += Length) {
+    if (Offset == HoleStart) {
+      Length = (UINTN) (HoleEnd - HoleStart);
+      continue;
+    }
+    Length = (UINTN) MIN (sizeof (Buffer), Size - Offset);
+    for (Index = 0; Index < Length; Index++) {
+      Buffer[Index] = ByteAt (Offset + Index);
+    }
+    Ok = pwrite (Fd, Buffer, Length, (off_t) Offset) == (ssize_t) Length;
+  }
+
+  Ok = Ok && ftruncate (Fd, (off_t) Size) == 0;
+  close (Fd);
+  return Ok;
+}
+
+/**
+  Write a file of the source tree that holds a string.
+
+**/
+BOOLEAN
+TestWriteString (
+  IN CONST CHAR8          *Path,
+  IN CONST CHAR8          *String
+  )
+{
+  FILE      *File;
+  BOOLEAN   Ok;
+
+  File = fopen (Path, "w");
+  if (File == NULL) {
+    return FALSE;
+  }
+  Ok = fputs (String, File) >= 0;
+  return (fclose (File) == 0) && Ok;
+}
+
+/**
+  Build the directory tree the images are made from in Work/tree.
+
+**/
+BOOLEAN
+TestMakeTree (
+  IN CONST CHAR8          *Work
+  )
+{
+  CHAR8     Path[TEST_PATH_LENGTH];
+  CHAR8     Content[32];
+  UINTN     Index;
+
+  snprintf (Path, sizeof (Path), "rm -rf %s/tree && mkdir -p %s/tree/dir %s/tree/small %s/tree/a/b/c %s/tree/%s",
+    Work, Work, Work, Work, Work, TEST_LONG_DIR);
+  if (!TestRun (Path, 0)) {
+    return FALSE;
+  }
+
+  snprintf (Path, sizeof (Path), "%s/tree/big.bin", Work);
+  if (!TestWriteFile (Path, TEST_BIG_FILE_SIZE, TestBigFileByte, TEST_HOLE_START, TEST_HOLE_END)) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < TEST_DIR_FILES; Index++) {
+    snprintf (Path, sizeof (Path), "%s/tree/dir/file-%03u", Work, (unsigned) Index);
+    snprintf (Content, sizeof (Content), "file-%03u\n", (unsigned) Index);
+    if (!TestWriteString (Path, Content)) {
+      return FALSE;
+    }
+  }
+
+  for (Index = 0; Index < sizeof (mSmallSizes) / sizeof (mSmallSizes[0]); Index++) {
+    snprintf (Path, sizeof (Path), "%s/tree/small/size-%u", Work, (unsigned) mSmallSizes[Index]);
+    if (!TestWriteFile (Path, mSmallSizes[Index], TestSmallFileByte, mSmallSizes[Index], mSmallSizes[Index])) {
+      return FALSE;
+    }
+  }
+
+  snprintf (Path, sizeof (Path), "%s/tree/a/b/c/deep.txt", Work);
+  if (!TestWriteString (Path, "deep\n")) {
+    return FALSE;
+  }
+  snprintf (Path, sizeof (Path), "%s/tree/%s/target.txt", Work, TEST_LONG_DIR);
+  if (!TestWriteString (Path, "target\n")) {
+    return FALSE;
+  }
+
+  snprintf (Path, sizeof (Path), "%s/tree/fast-link", Work);
+  if (symlink ("dir/file-007", Path) != 0) {
+    return FALSE;
+  }
+  snprintf (Path, sizeof (Path), "%s/tree/slow-link", Work);
+  if (symlink (TEST_LONG_DIR "/target.txt", Path) != 0) {
+    return FALSE;
+  }
+  snprintf (Path, sizeof (Path), "%s/tree/a/b/up-link", Work);
+  if (symlink ("../../a/b/c", Path) != 0) {
+    return FALSE;
+  }
+  snprintf (Path, sizeof (Path), "%s/tree/abs-link", Work);
+  return symlink ("/a/b/c/deep.txt", Path) == 0;
+}
+
+/**
+  Make the image of a layout from the tree, and index its directories.
+
+**/
+BOOLEAN
+TestMakeImage (
+  IN CONST CHAR8          *Work,
+  IN CONST TEST_LAYOUT    *Layout
+  )
+{
+  CHAR8   Command[TEST_PATH_LENGTH];
+
+  snprintf (Command, sizeof (Command), "mkfs.ext4 -q -F -L %s %s -d %s/tree %s/%s.img %s >/dev/null",
+    TEST_LABEL, Layout->MkfsOptions, Work, Work, Layout->Name, TEST_IMAGE_SIZE);
+  if (!TestRun (Command, 0)) {
+    return FALSE;
+  }
+
+  //
+  // e2fsck exits with 1 when it has changed the file system, which -D does.
+  //
+  snprintf (Command, sizeof (Command), "e2fsck -f -y -D %s/%s.img >/dev/null 2>&1", Work, Layout->Name);
+  return TestRun (Command, 1);
+}
+
+//
+// Mounting an image
+//
+
+/**
+  Bind the driver to an image and open its root directory.
+
+  @return The status of the driver's Start(), or of OpenVolume().
+
+**/
+EFI_STATUS
+TestMount (
+  IN OUT TEST_CONTEXT     *Context,
+  IN     CONST CHAR8      *Image
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+
+  Context->Root   = NULL;
+  Context->Volume = NULL;
+  Status = HostOpenDisk (Image, TEST_SECTOR_SIZE, TRUE, &Context->Disk);
+  if (EFI_ERROR (Status)) {
+    fprintf (stderr, "cannot open %s\n", Image);
+    return Status;
+  }
+
+  Status = gExt4DriverBinding.Supported (&gExt4DriverBinding, Context->Disk, NULL);
+  if (!EFI_ERROR (Status)) {
+    Status = gExt4DriverBinding.Start (&gExt4DriverBinding, Context->Disk, NULL);
+  }
+  if (EFI_ERROR (Status)) {
+    if (!EFI_ERROR (HostHandleProtocol (Context->Disk, &gEfiSimpleFileSystemProtocolGuid, NULL))) {
+      fprintf (stderr, "Start() failed but left a file system behind\n");
+      Status = EFI_ABORTED;
+    }
+    HostCloseDisk (Context->Disk);
+    return Status;
+  }
+
+  Status = HostHandleProtocol (Context->Disk, &gEfiSimpleFileSystemProtocolGuid, (VOID **) &FileSystem);
+  if (!EFI_ERROR (Status)) {
+    Context->Volume = EXT4_VOLUME_FROM_THIS (FileSystem);
+    Status = FileSystem->OpenVolume (FileSystem, &Context->Root);
+  }
+  return Status;
+}
+
+/**
+  Close the root directory and unbind the driver.
+
+**/
+EFI_STATUS
+TestUnmount (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Context->Root != NULL) {
+    Context->Root->Close (Context->Root);
+  }
+  Status = gExt4DriverBinding.Stop (&gExt4DriverBinding, Context->Disk, 0, NULL);
+  HostCloseDisk (Context->Disk);
+  return Status;
+}
+
+/**
+  Open a file for reading.
+
+**/
+EFI_STATUS
+TestOpen (
+  IN  EFI_FILE_PROTOCOL   *Directory,
+  IN  CONST CHAR8         *Path,
+  OUT EFI_FILE_PROTOCOL   **File
+  )
+{
+  CHAR16  Name[TEST_PATH_LENGTH];
+
+  AsciiStrToUnicodeStr (Path, Name);
+  return Directory->Open (Directory, File, Name, EFI_FILE_MODE_READ, 0);
+}
+
+/**
+  Check that a file holds exactly the bytes given.
+
+**/
+BOOLEAN
+TestCheckContent (
+  IN EFI_FILE_PROTOCOL    *Directory,
+  IN CONST CHAR8          *Path,
+  IN CONST VOID           *Expected,
+  IN UINTN                Size
+  )
+{
+  EFI_FILE_PROTOCOL   *File;
+  UINT8               Buffer[64];
+  UINTN               Length;
+  EFI_STATUS          Status;
+
+  TEST_CHECK (Size < sizeof (Buffer));
+  TEST_CHECK (!EFI_ERROR (TestOpen (Directory, Path, &File)));
+  Length = sizeof (Buffer);
+  Status = File->Read (File, &Length, Buffer);
+  File->Close (File);
+  TEST_CHECK (!EFI_ERROR (Status));
+  TEST_CHECK (Length == Size);
+  TEST_CHECK (CompareMem (Buffer, Expected, Size) == 0);
+  return TRUE;
+}
+
+/**
+  Return the inode a file handle is open on.
+
+**/
+EXT4_INODE *
+TestInode (
+  IN EFI_FILE_PROTOCOL    *File
+  )
+{
+  EXT4_FILE   *Ext4File;
+
+  Ext4File = EXT4_FILE_FROM_THIS (File);
+  return &Ext4File->Node.Inode;
+}
+
+//
+// Tests run on every layout
+//
+
+/**
+  The volume reports the features of the layout and its label.
+
+**/
+BOOLEAN
+TestVolume (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_SYSTEM_INFO  *Info;
+  UINTN                 Size;
+  UINT32                DescSize;
+
+  TEST_CHECK ((Context->Volume->FeatureIncompat & Context->Layout->Incompat) == Context->Layout->Incompat);
+  DescSize = EXT4_MIN_DESC_SIZE;
+  if ((Context->Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_64BIT) != 0) {
+    DescSize = EXT4_MIN_DESC_SIZE_64BIT;
+  }
+  TEST_CHECK (DescSize == Context->Layout->DescSize);
+
+  Info = (EFI_FILE_SYSTEM_INFO *) Context->Buffer;
+  Size = TEST_CHUNK_SIZE;
+  TEST_CHECK (!EFI_ERROR (Context->Root->GetInfo (Context->Root, &gEfiFileSystemInfoGuid, &Size, Info)));
+  TEST_CHECK (Info->ReadOnly);
+  TEST_CHECK (Info->BlockSize == Context->Volume->BlockSize);
+  TEST_CHECK (Info->VolumeSize == SIZE_32MB);
+  TEST_CHECK (StrCmp (Info->VolumeLabel, L"" TEST_LABEL) == 0);
+  return TRUE;
+}
+
+/**
+  big.bin reads back in chunks that straddle blocks, with its hole as zeros.
+
+**/
+BOOLEAN
+TestBigFile (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *File;
+  EFI_FILE_INFO       *Info;
+  UINT64              Offset;
+  UINTN               Length;
+  UINTN               Index;
+  UINT8               Byte;
+
+  TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, "big.bin", &File)));
+  TEST_CHECK ((TestInode (File)->Flags & EXT4_EXTENTS_FL) == Context->Layout->BigFileFlags);
+
+  Info   = (EFI_FILE_INFO *) Context->Buffer;
+  Length = TEST_CHUNK_SIZE;
+  TEST_CHECK (!EFI_ERROR (File->GetInfo (File, &gEfiFileInfoGuid, &Length, Info)));
+  TEST_CHECK (Info->FileSize == TEST_BIG_FILE_SIZE);
+  TEST_CHECK ((Info->Attribute & EFI_FILE_DIRECTORY) == 0);
+
+  for (Offset = 0; Offset < TEST_BIG_FILE_SIZE; Offset += Length) {
+    Length = TEST_CHUNK_SIZE;
+    TEST_CHECK (!EFI_ERROR (File->Read (File, &Length, Context->Buffer)));
+    TEST_CHECK (Length == MIN (TEST_CHUNK_SIZE, TEST_BIG_FILE_SIZE - Offset));
+    for (Index = 0; Index < Length; Index++) {
+      Byte = TestBigFileByte (Offset + Index);
+      if (Context->Buffer[Index] != Byte) {
+        fprintf (stderr, "big.bin differs at offset %llu\n", (unsigned long long) (Offset + Index));
+        File->Close (File);
+        return FALSE;
+      }
+    }
+  }
+
+  //
+  // At the end of the file a read returns nothing
+  //
+  Length = TEST_CHUNK_SIZE;
+  TEST_CHECK (!EFI_ERROR (File->Read (File, &Length, Context->Buffer)));
+  TEST_CHECK (Length == 0);
+  File->Close (File);
+  return TRUE;
+}
+
+/**
+  Reads at scattered positions of big.bin, which defeat the cached block run.
+
+**/
+BOOLEAN
+TestSeek (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *File;
+  UINT64              Offset;
+  UINT64              Position;
+  UINTN               Length;
+  UINTN               Round;
+  UINTN               Index;
+
+  TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, "big.bin", &File)));
+  for (Round = 0; Round < TEST_SEEK_COUNT; Round++) {
+    Offset = (Round * 2654435761U) % TEST_BIG_FILE_SIZE;
+    TEST_CHECK (!EFI_ERROR (File->SetPosition (File, Offset)));
+    Length = TEST_SEEK_SIZE;
+    TEST_CHECK (!EFI_ERROR (File->Read (File, &Length, Context->Buffer)));
+    TEST_CHECK (Length == MIN (TEST_SEEK_SIZE, TEST_BIG_FILE_SIZE - Offset));
+    for (Index = 0; Index < Length; Index++) {
+      TEST_CHECK (Context->Buffer[Index] == TestBigFileByte (Offset + Index));
+    }
+    TEST_CHECK (!EFI_ERROR (File->GetPosition (File, &Position)));
+    TEST_CHECK (Position == Offset + Length);
+  }
+  File->Close (File);
+  return TRUE;
+}
+
+/**
+  Every name in the hashed directory is found, from the directory and from
+  the root, and a missing one is not.
+
+**/
+BOOLEAN
+TestHtreeLookup (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *Directory;
+  EFI_FILE_PROTOCOL   *File;
+  CHAR8               Path[32];
+  CHAR8               Content[32];
+  UINTN               Index;
+
+  TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, "dir", &Directory)));
+  TEST_CHECK ((TestInode (Directory)->Flags & EXT4_INDEX_FL) != 0);
+
+  for (Index = 0; Index < TEST_DIR_FILES; Index++) {
+    snprintf (Content, sizeof (Content), "file-%03u\n", (unsigned) Index);
+    snprintf (Path, sizeof (Path), "file-%03u", (unsigned) Index);
+    TEST_CHECK (TestCheckContent (Directory, Path, Content, AsciiStrLen (Content)));
+    snprintf (Path, sizeof (Path), "\\dir\\file-%03u", (unsigned) (TEST_DIR_FILES - 1 - Index));
+    snprintf (Content, sizeof (Content), "file-%03u\n", (unsigned) (TEST_DIR_FILES - 1 - Index));
+    TEST_CHECK (TestCheckContent (Directory, Path, Content, AsciiStrLen (Content)));
+  }
+
+  TEST_CHECK (TestOpen (Directory, "file-999", &File) == EFI_NOT_FOUND);
+  TEST_CHECK (TestOpen (Directory, "file-0000", &File) == EFI_NOT_FOUND);
+  Directory->Close (Directory);
+  return TRUE;
+}
+
+/**
+  Listing the hashed directory returns every entry once, with "." and "..".
+
+**/
+BOOLEAN
+TestHtreeList (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *Directory;
+  EFI_FILE_INFO       *Info;
+  BOOLEAN             Seen[TEST_DIR_FILES];
+  UINTN               Length;
+  UINTN               Files;
+  UINTN               Dots;
+  UINTN               Index;
+  CHAR16              Name[16];
+
+  ZeroMem (Seen, sizeof (Seen));
+  Files = 0;
+  Dots  = 0;
+  Info  = (EFI_FILE_INFO *) Context->Buffer;
+
+  TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, "dir", &Directory)));
+  while (TRUE) {
+    Length = TEST_INFO_SIZE;
+    TEST_CHECK (!EFI_ERROR (Directory->Read (Directory, &Length, Info)));
+    if (Length == 0) {
+      break;
+    }
+    if (StrCmp (Info->FileName, L".") == 0 || StrCmp (Info->FileName, L"..") == 0) {
+      TEST_CHECK ((Info->Attribute & EFI_FILE_DIRECTORY) != 0);
+      Dots++;
+      continue;
+    }
+
+    for (Index = 0; Index < TEST_DIR_FILES; Index++) {
+      UnicodeSPrint (Name, sizeof (Name), L"file-%03d", Index);
+      if (StrCmp (Info->FileName, Name) == 0) {
+        break;
+      }
+    }
+    TEST_CHECK (Index < TEST_DIR_FILES);
+    TEST_CHECK (!Seen[Index]);
+    TEST_CHECK (Info->FileSize == 9);
+    Seen[Index] = TRUE;
+    Files++;
+  }
+
+  Directory->Close (Directory);
+  TEST_CHECK (Files == TEST_DIR_FILES);
+  TEST_CHECK (Dots == 2);
+  return TRUE;
+}
+
+/**
+  Small files read back whole, whether their data is in blocks or inline.
+
+**/
+BOOLEAN
+TestSmallFiles (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *File;
+  CHAR8               Path[32];
+  UINTN               Length;
+  UINTN               Index;
+  UINTN               Offset;
+  BOOLEAN             Inline;
+
+  Inline = FALSE;
+  for (Index = 0; Index < sizeof (mSmallSizes) / sizeof (mSmallSizes[0]); Index++) {
+    snprintf (Path, sizeof (Path), "small\\size-%u", (unsigned) mSmallSizes[Index]);
+    TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, Path, &File)));
+    if ((TestInode (File)->Flags & EXT4_INLINE_DATA_FL) != 0) {
+      Inline = TRUE;
+    }
+
+    Length = TEST_CHUNK_SIZE;
+    TEST_CHECK (!EFI_ERROR (File->Read (File, &Length, Context->Buffer)));
+    File->Close (File);
+    TEST_CHECK (Length == mSmallSizes[Index]);
+    for (Offset = 0; Offset < Length; Offset++) {
+      TEST_CHECK (Context->Buffer[Offset] == TestSmallFileByte (Offset));
+    }
+  }
+
+  TEST_CHECK (Inline == ((Context->Layout->Incompat & EXT4_FEATURE_INCOMPAT_INLINE_DATA) != 0));
+  return TRUE;
+}
+
+/**
+  Nested, absolute and dotted paths, and fast, slow, relative and absolute
+  symbolic links resolve.
+
+**/
+BOOLEAN
+TestPaths (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *Directory;
+
+  TEST_CHECK (TestCheckContent (Context->Root, "a\\b\\c\\deep.txt", "deep\n", 5));
+  TEST_CHECK (TestCheckContent (Context->Root, "\\a\\b\\c\\deep.txt", "deep\n", 5));
+  TEST_CHECK (TestCheckContent (Context->Root, "a\\.\\b\\..\\b\\c\\deep.txt", "deep\n", 5));
+  TEST_CHECK (TestCheckContent (Context->Root, "fast-link", "file-007\n", 9));
+  TEST_CHECK (TestCheckContent (Context->Root, "slow-link", "target\n", 7));
+  TEST_CHECK (TestCheckContent (Context->Root, "a\\b\\up-link\\deep.txt", "deep\n", 5));
+  TEST_CHECK (TestCheckContent (Context->Root, "abs-link", "deep\n", 5));
+
+  TEST_CHECK (!EFI_ERROR (TestOpen (Context->Root, "a\\b", &Directory)));
+  TEST_CHECK (TestCheckContent (Directory, "c\\deep.txt", "deep\n", 5));
+  TEST_CHECK (TestCheckContent (Directory, "\\fast-link", "file-007\n", 9));
+  Directory->Close (Directory);
+
+  TEST_CHECK (TestOpen (Context->Root, "a\\b\\c\\deep.txt\\x", &Directory) == EFI_NOT_FOUND);
+  TEST_CHECK (TestOpen (Context->Root, "a\\missing\\deep.txt", &Directory) == EFI_NOT_FOUND);
+  return TRUE;
+}
+
+/**
+  Nothing the driver did reached the media as a write.
+
+**/
+BOOLEAN
+TestReadOnly (
+  IN OUT TEST_CONTEXT     *Context
+  )
+{
+  EFI_FILE_PROTOCOL   *File;
+  CHAR16              Name[] = L"new.txt";
+
+  TEST_CHECK (
+    Context->Root->Open (Context->Root, &File, Name, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0) ==
+    EFI_WRITE_PROTECTED
+    );
+  TEST_CHECK (gHostDiskCounters.Writes == 0);
+  return TRUE;
+}
+
+TEST  mTests[] = {
+  { "volume",       TestVolume      },
+  { "big-file",     TestBigFile     },
+  { "seek",         TestSeek        },
+  { "htree-lookup", TestHtreeLookup },
+  { "htree-list",   TestHtreeList   },
+  { "small-files",  TestSmallFiles  },
+  { "paths",        TestPaths       },
+  { "read-only",    TestReadOnly    }
+};
+
+//
+// Damaged images. The first layout's image has 4 KB blocks and 64 byte group
+// descriptors, the first of which is in block 1.
+//
+
+VOID
+TestPatchMagic (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->Magic = 0xEF52;
+}
+
+VOID
+TestPatchBlockSize (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->LogBlockSize = 7;
+}
+
+VOID
+TestPatchCasefold (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->FeatureIncompat |= EXT4_FEATURE_INCOMPAT_CASEFOLD;
+}
+
+VOID
+TestPatchEncrypt (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->FeatureIncompat |= EXT4_FEATURE_INCOMPAT_ENCRYPT;
+}
+
+VOID
+TestPatchUnknownFeature (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->FeatureIncompat |= BIT31;
+}
+
+VOID
+TestPatchInodeSize (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->InodeSize = 200;
+}
+
+VOID
+TestPatchDescSize (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->DescSize = 48;
+}
+
+VOID
+TestPatchBlockCount (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->BlocksCountHi = 1;
+}
+
+VOID
+TestPatchTruncate (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  if (ftruncate (Fd, SIZE_16MB) != 0) {
+    fprintf (stderr, "cannot truncate the image\n");
+  }
+}
+
+VOID
+TestPatchBlocksPerGroup (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->BlocksPerGroup = 0;
+}
+
+VOID
+TestPatchInodesPerGroup (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->InodesPerGroup = (1 << (Sb->LogBlockSize + 10)) * 8 + 1;
+}
+
+VOID
+TestPatchInodeCount (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  Sb->InodesCount = 0xFFFFFFFF;
+}
+
+VOID
+TestPatchInodeTable (
+  IN     int              Fd,
+  IN OUT EXT4_SUPERBLOCK  *Sb
+  )
+{
+  UINT32  InodeTableHi;
+
+  InodeTableHi = 1;
+  if (pwrite (Fd, &InodeTableHi, sizeof (InodeTableHi), SIZE_4KB + OFFSET_OF (EXT4_GROUP_DESC, InodeTableHi)) != sizeof (InodeTableHi)) {
+    fprintf (stderr, "cannot patch the group descriptor\n");
+  }
+}
+
+CONST TEST_CORRUPTION  mCorruptions[] = {
+  { "bad-magic",          TestPatchMagic,          EFI_UNSUPPORTED      },
+  { "bad-block-size",     TestPatchBlockSize,      EFI_UNSUPPORTED      },
+  { "casefold",           TestPatchCasefold,       EFI_UNSUPPORTED      },
+  { "encrypt",            TestPatchEncrypt,        EFI_UNSUPPORTED      },
+  { "unknown-feature",    TestPatchUnknownFeature, EFI_UNSUPPORTED      },
+  { "bad-inode-size",     TestPatchInodeSize,      EFI_VOLUME_CORRUPTED },
+  { "bad-desc-size",      TestPatchDescSize,       EFI_VOLUME_CORRUPTED },
+  { "blocks-past-media",  TestPatchBlockCount,     EFI_VOLUME_CORRUPTED },
+  { "truncated",          TestPatchTruncate,       EFI_VOLUME_CORRUPTED },
+  { "no-blocks-per-group", TestPatchBlocksPerGroup, EFI_VOLUME_CORRUPTED },
+  { "inodes-per-group",   TestPatchInodesPerGroup, EFI_VOLUME_CORRUPTED },
+  { "inode-count",        TestPatchInodeCount,     EFI_VOLUME_CORRUPTED },
+  { "inode-table",        TestPatchInodeTable,     EFI_VOLUME_CORRUPTED }
+};
+
+/**
+  Damage a copy of the first layout's image and check that Start() refuses it.
+
+**/
+BOOLEAN
+TestCorruption (
+  IN OUT TEST_CONTEXT           *Context,
+  IN     CONST TEST_CORRUPTION  *Corruption
+  )
+{
+  CHAR8             Image[TEST_PATH_LENGTH];
+  CHAR8             Command[3 * TEST_PATH_LENGTH];
+  EXT4_SUPERBLOCK   Sb;
+  EFI_STATUS        Status;
+  int               Fd;
+
+  snprintf (Image, sizeof (Image), "%s/corrupt.img", Context->Work);
+  snprintf (Command, sizeof (Command), "cp %s/%s.img %s", Context->Work, mLayouts[0].Name, Image);
+  TEST_CHECK (TestRun (Command, 0));
+
+  Fd = open (Image, O_RDWR);
+  TEST_CHECK (Fd >= 0);
+  TEST_CHECK (pread (Fd, &Sb, sizeof (Sb), EXT4_SUPERBLOCK_OFFSET) == sizeof (Sb));
+  Corruption->Patch (Fd, &Sb);
+  TEST_CHECK (pwrite (Fd, &Sb, sizeof (Sb), EXT4_SUPERBLOCK_OFFSET) == sizeof (Sb));
+  close (Fd);
+
+  Status = TestMount (Context, Image);
+  if (!EFI_ERROR (Status)) {
+    TestUnmount (Context);
+  }
+  if (Status != Corruption->Expected) {
+    fprintf (stderr, "Start() returned 0x%llx, expected 0x%llx\n",
+      (unsigned long long) Status, (unsigned long long) Corruption->Expected);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+int
+main (
+  int     Argc,
+  char    **Argv
+  )
+{
+  TEST_CONTEXT        Context;
+  CHAR8               Image[TEST_PATH_LENGTH];
+  CHAR8               Name[64];
+  UINTN               Layout;
+  UINTN               Index;
+  UINTN               Failed;
+  UINTN               Total;
+  BOOLEAN             Passed;
+
+  if (Argc != 2) {
+    fprintf (stderr, "Usage: HostTest WorkDirectory\n");
+    return 2;
+  }
+
+  ZeroMem (&Context, sizeof (Context));
+  Context.Work   = Argv[1];
+  Context.Buffer = AllocatePool (TEST_CHUNK_SIZE);
+  if (Context.Buffer == NULL || !TestMakeTree (Context.Work)) {
+    fprintf (stderr, "cannot create the source tree in %s\n", Context.Work);
+    return 1;
+  }
+
+  HostInitializeServices ();
+  InitializeExt4 (NULL, gST);
+
+  Failed = 0;
+  Total  = 0;
+  for (Layout = 0; Layout < sizeof (mLayouts) / sizeof (mLayouts[0]); Layout++) {
+    Context.Layout = &mLayouts[Layout];
+    snprintf (Image, sizeof (Image), "%s/%s.img", Context.Work, mLayouts[Layout].Name);
+    if (!TestMakeImage (Context.Work, &mLayouts[Layout]) || EFI_ERROR (TestMount (&Context, Image))) {
+      printf ("%-32s FAILED\n", mLayouts[Layout].Name);
+      Failed++;
+      Total++;
+      continue;
+    }
+
+    for (Index = 0; Index < sizeof (mTests) / sizeof (mTests[0]); Index++) {
+      Passed = mTests[Index].Function (&Context);
+      snprintf (Name, sizeof (Name), "%s/%s", mLayouts[Layout].Name, mTests[Index].Name);
+      printf ("%-32s %s\n", Name, Passed ? "passed" : "FAILED");
+      if (!Passed) {
+        Failed++;
+      }
+      Total++;
+    }
+
+    if (EFI_ERROR (TestUnmount (&Context))) {
+      printf ("%-32s FAILED\n", mLayouts[Layout].Name);
+      Failed++;
+    }
+  }
+
+  for (Index = 0; Index < sizeof (mCorruptions) / sizeof (mCorruptions[0]); Index++) {
+    Passed = TestCorruption (&Context, &mCorruptions[Index]);
+    snprintf (Name, sizeof (Name), "corrupt/%s", mCorruptions[Index].Name);
+    printf ("%-32s %s\n", Name, Passed ? "passed" : "FAILED");
+    if (!Passed) {
+      Failed++;
+    }
+    Total++;
+  }
+
+  FreePool (Context.Buffer);
+  printf ("%u of %u tests failed\n", (unsigned) Failed, (unsigned) Total);
+  return (Failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+/** @file
+  Declarations of the host tests of Ext4Dxe, which run over the host
+  services of MdeModulePkg/Test/HostSupport.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include "Ext4.h"
+#include "HostSupport.h"
+
+//
+// Entry point of the driver linked into the program
+//
+EFI_STATUS
+EFIAPI
+InitializeExt4 (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  );
+
+#endif
@@ -0,0 +1,726 @@
+/** @file
+  Inode reading and block mapping of the ext2/ext3/ext4 file system driver.
+
+  File data is located either through the ext4 extent tree or through the
+  classic direct/indirect block map of ext2 and ext3. Both are turned into
+  runs of contiguous blocks, and each run is read with one Disk I/O request
+  straight into the caller's buffer.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ext4.h"
+
+/**
+  Read an inode, going through the inode cache.
+
+  @param  Volume                The volume the inode is on.
+  @param  Number                The inode number.
+  @param  Inode                 Receives the inode.
+
+  @retval EFI_SUCCESS           The inode was read.
+  @retval EFI_VOLUME_CORRUPTED  The inode number is out of range.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadInode (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT32                Number,
+  OUT EXT4_INODE            *Inode
+  )
+{
+  EFI_STATUS              Status;
+  LIST_ENTRY              *Link;
+  EXT4_INODE_CACHE_ENTRY  *Entry;
+  UINT32                  Group;
+  UINT32                  Index;
+  UINTN                   ValidSize;
+
+  Group = (Number - 1) / Volume->InodesPerGroup;
+  Index = (Number - 1) % Volume->InodesPerGroup;
+  if (Number == 0 || Group >= Volume->GroupCount) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  for (Link = GetFirstNode (&Volume->InodeLru); !IsNull (&Volume->InodeLru, Link); Link = GetNextNode (&Volume->InodeLru, Link)) {
+    Entry = BASE_CR (Link, EXT4_INODE_CACHE_ENTRY, Link);
+    if (Entry->Number == Number) {
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&Volume->InodeLru, &Entry->Link);
+      CopyMem (Inode, &Entry->Inode, sizeof (EXT4_INODE));
+      return EFI_SUCCESS;
+    }
+  }
+
+  ValidSize = MIN (Volume->InodeSize, sizeof (EXT4_INODE));
+  ZeroMem (Inode, sizeof (EXT4_INODE));
+  Status = Ext4ReadDisk (
+             Volume,
+             MultU64x32 (Volume->InodeTable[Group], Volume->BlockSize) + MultU64x32 (Index, Volume->InodeSize),
+             ValidSize,
+             Inode
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Fields past i_extra_isize are not part of this inode's layout.
+  //
+  if (ValidSize > EXT4_GOOD_OLD_INODE_SIZE && EXT4_GOOD_OLD_INODE_SIZE + (UINTN) Inode->ExtraIsize < ValidSize) {
+    ZeroMem (
+      (UINT8 *) Inode + EXT4_GOOD_OLD_INODE_SIZE + Inode->ExtraIsize,
+      ValidSize - EXT4_GOOD_OLD_INODE_SIZE - Inode->ExtraIsize
+      );
+  }
+
+  Entry = BASE_CR (GetPreviousNode (&Volume->InodeLru, &Volume->InodeLru), EXT4_INODE_CACHE_ENTRY, Link);
+  Entry->Number = Number;
+  CopyMem (&Entry->Inode, Inode, sizeof (EXT4_INODE));
+  RemoveEntryList (&Entry->Link);
+  InsertHeadList (&Volume->InodeLru, &Entry->Link);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Prepare a node for reading the given inode.
+
+  @param  Volume                The volume the inode is on.
+  @param  Number                The inode number.
+  @param  Node                  The node to set up.
+
+  @retval EFI_SUCCESS           The node is ready. Release it with Ext4CloseNode().
+  @retval Others                The inode could not be read.
+
+**/
+EFI_STATUS
+Ext4OpenNode (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT32                Number,
+  OUT EXT4_NODE             *Node
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (Node, sizeof (EXT4_NODE));
+  Status = Ext4ReadInode (Volume, Number, &Node->Inode);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Node->Number = Number;
+  Node->Size   = Node->Inode.SizeLo | LShiftU64 (Node->Inode.SizeHigh, 32);
+  return EFI_SUCCESS;
+}
+
+/**
+  Release what Ext4OpenNode() and later reads allocated for a node.
+
+  @param  Node                  The node to release.
+
+**/
+VOID
+Ext4CloseNode (
+  IN EXT4_NODE              *Node
+  )
+{
+  if (Node->MapBuffer != NULL) {
+    FreePool (Node->MapBuffer);
+    Node->MapBuffer = NULL;
+  }
+  Node->MapBufferBlock = 0;
+  Node->RunCount       = 0;
+}
+
+/**
+  Read an extent tree or indirect block into the node's map buffer, unless
+  it is already there.
+
+  @param  Volume                The volume.
+  @param  Node                  The node the block map belongs to.
+  @param  Block                 The block to read.
+
+  @retval EFI_SUCCESS           Node->MapBuffer holds the block.
+  @retval EFI_VOLUME_CORRUPTED  The block number is outside the volume.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadMapBlock (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT64             Block
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Block == 0 || Block >= Volume->BlockCount) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (Node->MapBufferBlock == Block) {
+    return EFI_SUCCESS;
+  }
+
+  if (Node->MapBuffer == NULL) {
+    Node->MapBuffer = AllocatePool (Volume->BlockSize);
+    if (Node->MapBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  Node->MapBufferBlock = 0;
+  Status = Ext4ReadDisk (Volume, MultU64x32 (Block, Volume->BlockSize), Volume->BlockSize, Node->MapBuffer);
+  if (!EFI_ERROR (Status)) {
+    Node->MapBufferBlock = Block;
+  }
+
+  return Status;
+}
+
+/**
+  Map a logical block through the extent tree of a node.
+
+  @param  Volume                The volume.
+  @param  Node                  The node, which uses extents.
+  @param  Lblock                The logical block to map.
+  @param  Pblock                Receives the physical block, or 0 for a hole
+                                or an unwritten extent.
+  @param  Count                 Receives the number of blocks from Lblock on
+                                that map the same way.
+
+  @retval EFI_SUCCESS           The block was mapped.
+  @retval EFI_VOLUME_CORRUPTED  The extent tree is inconsistent.
+  @retval Others                An extent tree block could not be read.
+
+**/
+EFI_STATUS
+Ext4MapExtent (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT32             Lblock,
+  OUT    UINT64             *Pblock,
+  OUT    UINT64             *Count
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_EXTENT_HEADER  *Header;
+  EXT4_EXTENT_INDEX   *Index;
+  EXT4_EXTENT         *Extent;
+  UINTN               NodeSize;
+  UINT64              Boundary;
+  UINTN               Level;
+  UINT16              Depth;
+  UINTN               Low;
+  UINTN               High;
+  UINTN               Middle;
+  UINT32              Length;
+  BOOLEAN             Unwritten;
+
+  Header   = (EXT4_EXTENT_HEADER *) Node->Inode.Block;
+  NodeSize = sizeof (Node->Inode.Block);
+  Depth    = Header->Depth;
+
+  //
+  // Boundary is the first logical block past Lblock that the tree maps,
+  // which bounds a hole.
+  //
+  Boundary = EXT4_LOGICAL_BLOCK_LIMIT;
+
+  for (Level = 0; ; Level++) {
+    if (Level > EXT4_EXTENT_MAX_DEPTH ||
+        Header->Magic != EXT4_EXTENT_MAGIC ||
+        Header->Depth != Depth ||
+        Header->Entries > Header->Max ||
+        sizeof (EXT4_EXTENT_HEADER) + Header->Max * sizeof (EXT4_EXTENT) > NodeSize) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    //
+    // Both node kinds are sorted by their first logical block; find the
+    // number of entries that start at or before Lblock.
+    //
+    Index  = (EXT4_EXTENT_INDEX *) (Header + 1);
+    Extent = (EXT4_EXTENT *) (Header + 1);
+    Low    = 0;
+    High   = Header->Entries;
+    while (Low < High) {
+      Middle = (Low + High) / 2;
+      if (Extent[Middle].Block <= Lblock) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if (Low < Header->Entries && Extent[Low].Block < Boundary) {
+      Boundary = Extent[Low].Block;
+    }
+
+    if (Low == 0) {
+      break;
+    }
+
+    if (Header->Depth == 0) {
+      Extent    = &Extent[Low - 1];
+      Length    = Extent->Len;
+      Unwritten = (BOOLEAN) (Length > EXT4_EXTENT_INIT_MAX_LEN);
+      if (Unwritten) {
+        Length -= EXT4_EXTENT_INIT_MAX_LEN;
+      }
+
+      if ((UINT64) Extent->Block + Length <= Lblock) {
+        break;
+      }
+
+      *Count  = (UINT64) Extent->Block + Length - Lblock;
+      *Pblock = 0;
+      if (!Unwritten) {
+        *Pblock = (Extent->StartLo | LShiftU64 (Extent->StartHi, 32)) + (Lblock - Extent->Block);
+      }
+      return EFI_SUCCESS;
+    }
+
+    //
+    // Reading the child may overwrite the node Header points to.
+    //
+    Depth  = Header->Depth - 1;
+    Status = Ext4ReadMapBlock (Volume, Node, Index[Low - 1].LeafLo | LShiftU64 (Index[Low - 1].LeafHi, 32));
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Header   = (EXT4_EXTENT_HEADER *) Node->MapBuffer;
+    NodeSize = Volume->BlockSize;
+  }
+
+  //
+  // Lblock is in a hole.
+  //
+  *Pblock = 0;
+  *Count  = Boundary - Lblock;
+  return EFI_SUCCESS;
+}
+
+/**
+  Map a logical block through the direct and indirect blocks of a node.
+
+  @param  Volume                The volume.
+  @param  Node                  The node, which uses the ext2/ext3 block map.
+  @param  Lblock                The logical block to map.
+  @param  Pblock                Receives the physical block, or 0 for a hole.
+  @param  Count                 Receives the number of blocks from Lblock on
+                                that map the same way.
+
+  @retval EFI_SUCCESS           The block was mapped.
+  @retval EFI_VOLUME_CORRUPTED  Lblock is beyond what the block map can address.
+  @retval Others                An indirect block could not be read.
+
+**/
+EFI_STATUS
+Ext4MapIndirect (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT32             Lblock,
+  OUT    UINT64             *Pblock,
+  OUT    UINT64             *Count
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      PerBlock;
+  UINT64      Offset;
+  UINT64      Span;
+  UINT32      Pointer;
+  UINT32      *Table;
+  UINTN       Entries;
+  UINTN       Slot;
+  UINTN       Levels;
+  UINTN       Run;
+
+  PerBlock = Volume->BlockSize / sizeof (UINT32);
+
+  if (Lblock < EXT4_NDIR_BLOCKS) {
+    Table   = Node->Inode.Block;
+    Entries = EXT4_NDIR_BLOCKS;
+    Slot    = Lblock;
+  } else {
+    Offset = Lblock - EXT4_NDIR_BLOCKS;
+    Span   = PerBlock;
+    for (Levels = 1; Offset >= Span; Levels++) {
+      Offset -= Span;
+      Span    = MultU64x32 (Span, PerBlock);
+      if (Levels == 3) {
+        return EFI_VOLUME_CORRUPTED;
+      }
+    }
+    Pointer = Node->Inode.Block[EXT4_IND_BLOCK + Levels - 1];
+
+    //
+    // Walk down; Span is the number of blocks below Pointer and Offset is
+    // Lblock's position among them.
+    //
+    while (TRUE) {
+      if (Pointer == 0) {
+        *Pblock = 0;
+        *Count  = Span - Offset;
+        return EFI_SUCCESS;
+      }
+
+      Status = Ext4ReadMapBlock (Volume, Node, Pointer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      Span  = DivU64x32 (Span, PerBlock);
+      Table = (UINT32 *) Node->MapBuffer;
+      Slot  = (UINTN) DivU64x32 (Offset, (UINT32) Span);
+      if (Span == 1) {
+        Entries = PerBlock;
+        break;
+      }
+      Offset -= MultU64x32 (Span, (UINT32) Slot);
+      Pointer = Table[Slot];
+    }
+  }
+
+  //
+  // Count the following entries of this table that continue the run.
+  //
+  for (Run = 1; Slot + Run < Entries; Run++) {
+    if (Table[Slot] == 0 ? Table[Slot + Run] != 0 : Table[Slot + Run] != Table[Slot] + Run) {
+      break;
+    }
+  }
+
+  *Pblock = Table[Slot];
+  *Count  = Run;
+  return EFI_SUCCESS;
+}
+
+/**
+  Map a logical block of a node to a run of physical blocks.
+
+  @param  Volume                The volume.
+  @param  Node                  The node.
+  @param  Lblock                The logical block to map.
+  @param  Pblock                Receives the physical block, or 0 for a hole.
+  @param  Count                 Receives the number of blocks from Lblock on
+                                that map the same way.
+
+  @retval EFI_SUCCESS           The block was mapped.
+  @retval EFI_VOLUME_CORRUPTED  The block map is inconsistent.
+  @retval Others                A block map block could not be read.
+
+**/
+EFI_STATUS
+Ext4MapBlock (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT32             Lblock,
+  OUT    UINT64             *Pblock,
+  OUT    UINT64             *Count
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Delta;
+
+  if (Node->RunCount != 0 && Lblock >= Node->RunLblock && Lblock - Node->RunLblock < Node->RunCount) {
+    Delta   = Lblock - Node->RunLblock;
+    *Pblock = (Node->RunPblock == 0) ? 0 : Node->RunPblock + Delta;
+    *Count  = Node->RunCount - Delta;
+    return EFI_SUCCESS;
+  }
+
+  if ((Node->Inode.Flags & EXT4_EXTENTS_FL) != 0) {
+    Status = Ext4MapExtent (Volume, Node, Lblock, Pblock, Count);
+  } else {
+    Status = Ext4MapIndirect (Volume, Node, Lblock, Pblock, Count);
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (*Count == 0 || (*Pblock != 0 && (*Pblock >= Volume->BlockCount || *Count > Volume->BlockCount - *Pblock))) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Node->RunLblock = Lblock;
+  Node->RunCount  = (UINT32) MIN (*Count, 0xFFFFFFFF);
+  Node->RunPblock = *Pblock;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read data of an inline_data inode that continues past i_block into the
+  "system.data" extended attribute in the inode body.
+
+  @param  Volume                The volume the inode is on.
+  @param  Node                  The node to read from.
+  @param  Offset                The byte offset in the inode's data.
+  @param  Size                  The number of bytes to read, within the file size.
+  @param  Buffer                The buffer that receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_VOLUME_CORRUPTED  The attribute is missing or too short.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The device reported an error.
+
+**/
+STATIC
+EFI_STATUS
+Ext4ReadInlineData (
+  IN  EXT4_VOLUME           *Volume,
+  IN  EXT4_NODE             *Node,
+  IN  UINTN                 Offset,
+  IN  UINTN                 Size,
+  OUT UINT8                 *Buffer
+  )
+{
+  EFI_STATUS        Status;
+  UINT8             *Raw;
+  UINT32            Group;
+  UINT32            Index;
+  UINTN             First;
+  UINTN             Cursor;
+  UINTN             InValue;
+  EXT4_XATTR_ENTRY  *Xattr;
+
+  if (Volume->InodeSize <= EXT4_GOOD_OLD_INODE_SIZE) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Raw = AllocatePool (Volume->InodeSize);
+  if (Raw == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Group  = (Node->Number - 1) / Volume->InodesPerGroup;
+  Index  = (Node->Number - 1) % Volume->InodesPerGroup;
+  Status = Ext4ReadDisk (
+             Volume,
+             MultU64x32 (Volume->InodeTable[Group], Volume->BlockSize) + MultU64x32 (Index, Volume->InodeSize),
+             Volume->InodeSize,
+             Raw
+             );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = EFI_VOLUME_CORRUPTED;
+  First  = EXT4_GOOD_OLD_INODE_SIZE + Node->Inode.ExtraIsize + sizeof (UINT32);
+  if (First + sizeof (UINT32) > Volume->InodeSize || ReadUnaligned32 ((UINT32 *) (Raw + First - sizeof (UINT32))) != EXT4_XATTR_MAGIC) {
+    goto Done;
+  }
+
+  for (Cursor = First; Cursor + sizeof (UINT32) <= Volume->InodeSize && ReadUnaligned32 ((UINT32 *) (Raw + Cursor)) != 0; ) {
+    Xattr = (EXT4_XATTR_ENTRY *) (Raw + Cursor);
+    if (Cursor + EXT4_XATTR_ENTRY_SIZE (Xattr->NameLen) > Volume->InodeSize) {
+      break;
+    }
+
+    if (Xattr->NameIndex == EXT4_XATTR_INDEX_SYSTEM && Xattr->NameLen == 4 &&
+        CompareMem (Xattr + 1, "data", 4) == 0) {
+      if (Xattr->ValueInum != 0 ||
+          First + Xattr->ValueOffs + (UINTN) Xattr->ValueSize > Volume->InodeSize ||
+          sizeof (Node->Inode.Block) + (UINTN) Xattr->ValueSize < Offset + Size) {
+        break;
+      }
+
+      //
+      // The data is i_block followed by the attribute value.
+      //
+      if (Offset < sizeof (Node->Inode.Block)) {
+        CopyMem (Buffer, (UINT8 *) Node->Inode.Block + Offset, sizeof (Node->Inode.Block) - Offset);
+        Buffer += sizeof (Node->Inode.Block) - Offset;
+        Size   -= sizeof (Node->Inode.Block) - Offset;
+        Offset  = sizeof (Node->Inode.Block);
+      }
+      InValue = Offset - sizeof (Node->Inode.Block);
+      CopyMem (Buffer, Raw + First + Xattr->ValueOffs + InValue, Size);
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    Cursor += EXT4_XATTR_ENTRY_SIZE (Xattr->NameLen);
+  }
+
+Done:
+  FreePool (Raw);
+  return Status;
+}
+
+/**
+  Read data of an inode. Block runs that are contiguous on disk are read
+  with a single Disk I/O request straight into Buffer.
+
+  @param  Volume                The volume the inode is on.
+  @param  Node                  The node to read from.
+  @param  Offset                The byte offset in the inode's data.
+  @param  Size                  On input the number of bytes to read, on output
+                                the number of bytes read, which is less only
+                                when the end of the data is reached.
+  @param  Buffer                The buffer that receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_VOLUME_CORRUPTED  The block map of the inode is inconsistent.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadNode (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  IN     UINT64             Offset,
+  IN OUT UINTN              *Size,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Destination;
+  UINTN       Remaining;
+  UINTN       Length;
+  UINT64      Lblock;
+  UINT32      InBlock;
+  UINT64      Pblock;
+  UINT64      Count;
+  UINT64      NextPblock;
+  UINT64      NextCount;
+
+  if (Offset >= Node->Size) {
+    *Size = 0;
+    return EFI_SUCCESS;
+  }
+  if (*Size > Node->Size - Offset) {
+    *Size = (UINTN) (Node->Size - Offset);
+  }
+
+  Destination = Buffer;
+  Remaining   = *Size;
+
+  if ((Node->Inode.Flags & EXT4_INLINE_DATA_FL) != 0) {
+    if (Offset + Remaining <= sizeof (Node->Inode.Block)) {
+      CopyMem (Destination, (UINT8 *) Node->Inode.Block + (UINTN) Offset, Remaining);
+      return EFI_SUCCESS;
+    }
+    return Ext4ReadInlineData (Volume, Node, (UINTN) Offset, Remaining, Destination);
+  }
+
+  while (Remaining > 0) {
+    Lblock = DivU64x32Remainder (Offset, Volume->BlockSize, &InBlock);
+    if (RShiftU64 (Lblock, 32) != 0) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = Ext4MapBlock (Volume, Node, (UINT32) Lblock, &Pblock, &Count);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (Pblock != 0) {
+      //
+      // Extend the run over following runs that continue it on disk, so a
+      // large sequential read becomes a single Disk I/O request.
+      //
+      while (MultU64x32 (Count, Volume->BlockSize) - InBlock < Remaining && Lblock + Count < EXT4_LOGICAL_BLOCK_LIMIT) {
+        Status = Ext4MapBlock (Volume, Node, (UINT32) (Lblock + Count), &NextPblock, &NextCount);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+        if (NextPblock != Pblock + Count) {
+          break;
+        }
+        Count += NextCount;
+      }
+    }
+
+    Length = Remaining;
+    if (MultU64x32 (Count, Volume->BlockSize) - InBlock < Length) {
+      Length = (UINTN) (MultU64x32 (Count, Volume->BlockSize) - InBlock);
+    }
+
+    if (Pblock == 0) {
+      ZeroMem (Destination, Length);
+    } else {
+      Status = Ext4ReadDisk (Volume, MultU64x32 (Pblock, Volume->BlockSize) + InBlock, Length, Destination);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    Destination += Length;
+    Offset      += Length;
+    Remaining   -= Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the target of a symbolic link.
+
+  @param  Volume                The volume the link is on.
+  @param  Node                  The symbolic link.
+  @param  Target                Receives a pool allocated, null-terminated
+                                copy of the link target.
+
+  @retval EFI_SUCCESS           The target was read.
+  @retval EFI_VOLUME_CORRUPTED  The link is empty or too long.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The target could not be read.
+
+**/
+EFI_STATUS
+Ext4ReadSymlink (
+  IN     EXT4_VOLUME        *Volume,
+  IN OUT EXT4_NODE          *Node,
+  OUT    CHAR8              **Target
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+  UINT32      EaBlocks;
+
+  if (Node->Size == 0 || Node->Size >= Volume->BlockSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Size    = (UINTN) Node->Size;
+  *Target = AllocatePool (Size + 1);
+  if (*Target == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Short targets are kept in i_block itself. Such "fast" links own no data
+  // blocks beyond a possible extended attribute block.
+  //
+  EaBlocks = (Node->Inode.FileAclLo != 0) ? Volume->BlockSize / 512 : 0;
+  if (Size < sizeof (Node->Inode.Block) &&
+      (Node->Inode.Flags & (EXT4_EXTENTS_FL | EXT4_INLINE_DATA_FL)) == 0 &&
+      Node->Inode.BlocksLo == EaBlocks) {
+    CopyMem (*Target, Node->Inode.Block, Size);
+    Status = EFI_SUCCESS;
+  } else {
+    Status = Ext4ReadNode (Volume, Node, 0, &Size, *Target);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (*Target);
+    *Target = NULL;
+    return Status;
+  }
+
+  (*Target)[Size] = '\0';
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,381 @@
+/** @file
+  Superblock and block group descriptor handling of the ext2/ext3/ext4
+  file system driver.
+
+Copyright (c) 2013, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ext4.h"
+
+/**
+  Read bytes from the volume.
+
+  @param  Volume                The volume to read from.
+  @param  Offset                The byte offset on the volume.
+  @param  Size                  The number of bytes to read.
+  @param  Buffer                The buffer that receives the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval EFI_DEVICE_ERROR      The volume has been released by Stop().
+  @retval Others                The error returned by Disk I/O.
+
+**/
+EFI_STATUS
+Ext4ReadDisk (
+  IN  EXT4_VOLUME           *Volume,
+  IN  UINT64                Offset,
+  IN  UINTN                 Size,
+  OUT VOID                  *Buffer
+  )
+{
+  if (!Volume->Valid) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return Volume->DiskIo->ReadDisk (Volume->DiskIo, Volume->MediaId, Offset, Size, Buffer);
+}
+
+/**
+  Check whether a block group holds a copy of the superblock and, without
+  meta_bg, of the group descriptors.
+
+  @param  Volume                The volume.
+  @param  Group                 The block group number.
+
+  @retval TRUE                  The group starts with a superblock copy.
+  @retval FALSE                 The group holds no superblock copy.
+
+**/
+BOOLEAN
+Ext4GroupHasSuper (
+  IN EXT4_VOLUME            *Volume,
+  IN UINT32                 Group
+  )
+{
+  UINT32  Base;
+  UINT32  Power;
+
+  if (Group <= 1 || (Volume->FeatureRoCompat & EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER) == 0) {
+    return TRUE;
+  }
+
+  //
+  // With sparse_super only groups 0, 1 and the powers of 3, 5 and 7 have one.
+  //
+  for (Base = 3; Base <= 7; Base += 2) {
+    for (Power = Base; Power < Group; Power *= Base) {
+      if (Power > 0xFFFFFFFF / Base) {
+        break;
+      }
+    }
+    if (Power == Group) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Read the block group descriptors and remember where each group's inode
+  table is.
+
+  @param  Volume                The volume, with the superblock fields set.
+  @param  FirstMetaBg           s_first_meta_bg of the superblock.
+  @param  FirstDataBlock        s_first_data_block of the superblock.
+  @param  DescSize              The size of one group descriptor.
+
+  @retval EFI_SUCCESS           Volume->InodeTable is filled in.
+  @retval EFI_VOLUME_CORRUPTED  The group count is too large, or a descriptor
+                                points outside the volume.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4ReadGroupDescriptors (
+  IN OUT EXT4_VOLUME        *Volume,
+  IN     UINT32             FirstMetaBg,
+  IN     UINT32             FirstDataBlock,
+  IN     UINT32             DescSize
+  )
+{
+  EFI_STATUS       Status;
+  UINT32           DescPerBlock;
+  UINT32           DescBlocks;
+  UINT32           Index;
+  UINT32           Group;
+  UINT32           Slot;
+  UINT64           Location;
+  EXT4_GROUP_DESC  *Desc;
+
+  if (Volume->GroupCount > MAX_ADDRESS / sizeof (UINT64)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Volume->InodeTable = AllocatePool (Volume->GroupCount * sizeof (UINT64));
+  if (Volume->InodeTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DescPerBlock = Volume->BlockSize / DescSize;
+  DescBlocks   = (Volume->GroupCount + DescPerBlock - 1) / DescPerBlock;
+
+  for (Index = 0; Index < DescBlocks; Index++) {
+    Group = Index * DescPerBlock;
+    if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_META_BG) == 0 || Index < FirstMetaBg) {
+      //
+      // Classic layout: all descriptor blocks follow the superblock.
+      //
+      Location = (UINT64) FirstDataBlock + 1 + Index;
+    } else {
+      //
+      // meta_bg: each descriptor block lives in the first group it describes.
+      //
+      Location = (UINT64) FirstDataBlock + MultU64x32 (Group, Volume->BlocksPerGroup);
+      if (Ext4GroupHasSuper (Volume, Group)) {
+        Location++;
+      }
+    }
+
+    if (Location >= Volume->BlockCount) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = Ext4ReadDisk (
+               Volume,
+               MultU64x32 (Location, Volume->BlockSize),
+               Volume->BlockSize,
+               Volume->BlockBuffer
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    for (Slot = 0; Slot < DescPerBlock && Group < Volume->GroupCount; Slot++, Group++) {
+      Desc = (EXT4_GROUP_DESC *) (Volume->BlockBuffer + Slot * DescSize);
+      Volume->InodeTable[Group] = Desc->InodeTableLo;
+      if (DescSize >= EXT4_MIN_DESC_SIZE_64BIT) {
+        Volume->InodeTable[Group] |= LShiftU64 (Desc->InodeTableHi, 32);
+      }
+
+      if (Volume->InodeTable[Group] == 0 || Volume->InodeTable[Group] >= Volume->BlockCount) {
+        DEBUG ((EFI_D_ERROR, "Ext4: group %d has a bad inode table %lx\n", Group, Volume->InodeTable[Group]));
+        return EFI_VOLUME_CORRUPTED;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate the inode and dentry caches of a volume.
+
+  @param  Volume                The volume.
+
+  @retval EFI_SUCCESS           The caches are set up and empty.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+**/
+EFI_STATUS
+Ext4InitCaches (
+  IN OUT EXT4_VOLUME        *Volume
+  )
+{
+  UINTN  Index;
+
+  Volume->InodeCache  = AllocateZeroPool (EXT4_INODE_CACHE_SIZE * sizeof (EXT4_INODE_CACHE_ENTRY));
+  Volume->DentryCache = AllocateZeroPool (EXT4_DENTRY_CACHE_SIZE * sizeof (EXT4_DENTRY));
+  if (Volume->InodeCache == NULL || Volume->DentryCache == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  InitializeListHead (&Volume->InodeLru);
+  for (Index = 0; Index < EXT4_INODE_CACHE_SIZE; Index++) {
+    InsertTailList (&Volume->InodeLru, &Volume->InodeCache[Index].Link);
+  }
+
+  InitializeListHead (&Volume->DentryLru);
+  for (Index = 0; Index < EXT4_DENTRY_HASH_SIZE; Index++) {
+    InitializeListHead (&Volume->DentryHash[Index]);
+  }
+  for (Index = 0; Index < EXT4_DENTRY_CACHE_SIZE; Index++) {
+    InitializeListHead (&Volume->DentryCache[Index].HashLink);
+    InsertTailList (&Volume->DentryLru, &Volume->DentryCache[Index].LruLink);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the superblock and the group descriptors of the volume on DiskIo,
+  and set up the inode and dentry caches.
+
+  @param  Volume                The volume with DiskIo, BlockIo and MediaId filled in.
+
+  @retval EFI_SUCCESS           The volume is an ext2/3/4 file system this driver can read.
+  @retval EFI_UNSUPPORTED       The volume is not an ext2/3/4 file system, or uses
+                                incompatible features this driver does not know.
+  @retval EFI_VOLUME_CORRUPTED  The superblock or group descriptors are inconsistent.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval Others                The device reported an error.
+
+**/
+EFI_STATUS
+Ext4MountVolume (
+  IN OUT EXT4_VOLUME        *Volume
+  )
+{
+  EFI_STATUS          Status;
+  EXT4_SUPERBLOCK     Sb;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  UINT32              DescSize;
+  UINT32              Remainder;
+  UINT64              GroupCount;
+  UINT64              MediaBlocks;
+  UINTN               LabelLen;
+
+  Status = Ext4ReadDisk (Volume, EXT4_SUPERBLOCK_OFFSET, sizeof (Sb), &Sb);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Sb.Magic != EXT4_SIGNATURE || Sb.LogBlockSize > 6) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Volume->BlockSize = EXT4_MIN_BLOCK_SIZE << Sb.LogBlockSize;
+  if (Sb.RevLevel == EXT4_GOOD_OLD_REV) {
+    Volume->InodeSize       = EXT4_GOOD_OLD_INODE_SIZE;
+    Volume->FeatureIncompat = 0;
+    Volume->FeatureRoCompat = 0;
+  } else {
+    Volume->InodeSize       = Sb.InodeSize;
+    Volume->FeatureIncompat = Sb.FeatureIncompat;
+    Volume->FeatureRoCompat = Sb.FeatureRoCompat;
+  }
+
+  if ((Volume->FeatureIncompat & ~EXT4_FEATURE_INCOMPAT_SUPPORTED) != 0) {
+    DEBUG ((EFI_D_INFO, "Ext4: unsupported incompatible features %x\n",
+            Volume->FeatureIncompat & ~EXT4_FEATURE_INCOMPAT_SUPPORTED));
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_RECOVER) != 0) {
+    DEBUG ((EFI_D_WARN, "Ext4: journal needs recovery, recent changes may not be visible\n"));
+  }
+
+  if (Volume->InodeSize < EXT4_GOOD_OLD_INODE_SIZE ||
+      Volume->InodeSize > Volume->BlockSize ||
+      (Volume->InodeSize & (Volume->InodeSize - 1)) != 0) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  DescSize = EXT4_MIN_DESC_SIZE;
+  if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_64BIT) != 0) {
+    DescSize = Sb.DescSize;
+    if (DescSize < EXT4_MIN_DESC_SIZE_64BIT ||
+        DescSize > Volume->BlockSize ||
+        (DescSize & (DescSize - 1)) != 0) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+  }
+
+  Volume->BlockCount     = Sb.BlocksCountLo;
+  Volume->FreeBlockCount = Sb.FreeBlocksCountLo;
+  if ((Volume->FeatureIncompat & EXT4_FEATURE_INCOMPAT_64BIT) != 0) {
+    Volume->BlockCount     |= LShiftU64 (Sb.BlocksCountHi, 32);
+    Volume->FreeBlockCount |= LShiftU64 (Sb.FreeBlocksCountHi, 32);
+  }
+
+  //
+  // The file system must fit on the media, so that a corrupted block count
+  // does not let descriptors and inode tables point past its end.
+  //
+  Media       = Volume->BlockIo->Media;
+  MediaBlocks = DivU64x32 (MultU64x32 (Media->LastBlock + 1, Media->BlockSize), Volume->BlockSize);
+  if (Volume->BlockCount > MediaBlocks) {
+    DEBUG ((EFI_D_ERROR, "Ext4: %ld blocks do not fit on the media\n", Volume->BlockCount));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Volume->BlocksPerGroup = Sb.BlocksPerGroup;
+  Volume->InodesPerGroup = Sb.InodesPerGroup;
+  if (Volume->BlocksPerGroup == 0 ||
+      Volume->InodesPerGroup == 0 ||
+      Volume->InodesPerGroup > Volume->BlockSize * 8 ||
+      Sb.FirstDataBlock >= Volume->BlockCount) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  GroupCount = DivU64x32Remainder (
+                 Volume->BlockCount - Sb.FirstDataBlock,
+                 Volume->BlocksPerGroup,
+                 &Remainder
+                 );
+  if (Remainder != 0) {
+    GroupCount++;
+  }
+  if (GroupCount == 0 || RShiftU64 (GroupCount, 32) != 0 ||
+      MultU64x32 (GroupCount, Volume->InodesPerGroup) < Sb.InodesCount) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+  Volume->GroupCount = (UINT32) GroupCount;
+
+  //
+  // The volume name is a UTF-8 string that is only null-terminated when it
+  // is shorter than the field.
+  //
+  for (LabelLen = 0; LabelLen < sizeof (Sb.VolumeName) && Sb.VolumeName[LabelLen] != 0; LabelLen++) {
+  }
+  Ext4Utf8ToUcs2 (Sb.VolumeName, LabelLen, Volume->VolumeLabel);
+
+  Volume->BlockBuffer = AllocatePool (Volume->BlockSize);
+  if (Volume->BlockBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Ext4ReadGroupDescriptors (Volume, Sb.FirstMetaBg, Sb.FirstDataBlock, DescSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Ext4InitCaches (Volume);
+}
+
+/**
+  Free a volume and everything Ext4MountVolume() allocated for it.
+
+  @param  Volume                The volume to free.
+
+**/
+VOID
+Ext4FreeVolume (
+  IN EXT4_VOLUME            *Volume
+  )
+{
+  if (Volume->InodeTable != NULL) {
+    FreePool (Volume->InodeTable);
+  }
+  if (Volume->BlockBuffer != NULL) {
+    FreePool (Volume->BlockBuffer);
+  }
+  if (Volume->InodeCache != NULL) {
+    FreePool (Volume->InodeCache);
+  }
+  if (Volume->DentryCache != NULL) {
+    FreePool (Volume->DentryCache);
+  }
+
+  Volume->Signature = 0;
+  FreePool (Volume);
+}
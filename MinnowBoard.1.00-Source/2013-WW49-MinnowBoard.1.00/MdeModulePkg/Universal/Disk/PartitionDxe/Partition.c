@@ -200,6 +200,7 @@ PartitionDriverBindingStart (
   EFI_BLOCK_IO_PROTOCOL     *BlockIo;
   EFI_BLOCK_IO2_PROTOCOL    *BlockIo2;
   EFI_DISK_IO_PROTOCOL      *DiskIo;
+  EFI_DISK_IO2_PROTOCOL     *DiskIo2;
   EFI_DEVICE_PATH_PROTOCOL  *ParentDevicePath;
   PARTITION_DETECT_ROUTINE  *Routine;
   BOOLEAN                   MediaPresent;
@@ -223,7 +224,8 @@ PartitionDriverBindingStart (
 
   //
   // Try to open BlockIO and BlockIO2. If BlockIO would be opened, continue,
-  // otherwise, return error.
+  // otherwise, return error. BlockIO2 is opened BY_DRIVER by the Disk IO
+  // driver, so it is only looked up here.
   //
   Status = gBS->OpenProtocol (
                   ControllerHandle,
@@ -243,8 +245,11 @@ PartitionDriverBindingStart (
                   (VOID **) &BlockIo2,
                   This->DriverBindingHandle,
                   ControllerHandle,
-                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
                   );
+  if (EFI_ERROR (Status)) {
+    BlockIo2 = NULL;
+  }
 
   //
   // Get the Device Path Protocol on ControllerHandle's handle.
@@ -281,6 +286,19 @@ PartitionDriverBindingStart (
 
   OpenStatus = Status;
 
+  //
+  // Try to open DiskIO2. The child BlockIO2 uses it for the requests the
+  // parent BlockIO2 can not take directly.
+  //
+  gBS->OpenProtocol (
+         ControllerHandle,
+         &gEfiDiskIo2ProtocolGuid,
+         (VOID **) &DiskIo2,
+         This->DriverBindingHandle,
+         ControllerHandle,
+         EFI_OPEN_PROTOCOL_BY_DRIVER
+         );
+
   //
   // Try to read blocks when there's media or it is removable physical partition.
   //
@@ -332,11 +350,11 @@ PartitionDriverBindingStart (
           ControllerHandle
           );
     //
-    // Close Parent BlockIO2 if has.
-    //    
+    // Close Parent DiskIO2 if has.
+    //
     gBS->CloseProtocol (
            ControllerHandle,
-           &gEfiBlockIo2ProtocolGuid,
+           &gEfiDiskIo2ProtocolGuid,
            This->DriverBindingHandle,
            ControllerHandle
            );
@@ -384,6 +402,7 @@ PartitionDriverBindingStop (
   BOOLEAN                 AllChildrenStopped;
   PARTITION_PRIVATE_DATA  *Private;
   EFI_DISK_IO_PROTOCOL    *DiskIo;
+  EFI_DISK_IO2_PROTOCOL   *DiskIo2;
 
   BlockIo  = NULL;
   BlockIo2 = NULL;
@@ -400,11 +419,11 @@ PartitionDriverBindingStop (
           ControllerHandle
           );
     //
-    // Close Parent BlockIO2 if has.
-    //    
+    // Close Parent DiskIO2 if has.
+    //
     gBS->CloseProtocol (
            ControllerHandle,
-           &gEfiBlockIo2ProtocolGuid,
+           &gEfiDiskIo2ProtocolGuid,
            This->DriverBindingHandle,
            ControllerHandle
            );
@@ -420,6 +439,7 @@ PartitionDriverBindingStop (
 
   AllChildrenStopped = TRUE;
   for (Index = 0; Index < NumberOfChildren; Index++) {
+    BlockIo2 = NULL;
     gBS->OpenProtocol (
            ChildHandleBuffer[Index],
            &gEfiBlockIoProtocolGuid,
@@ -449,6 +469,14 @@ PartitionDriverBindingStop (
                     This->DriverBindingHandle,
                     ChildHandleBuffer[Index]
                     );
+    if (Private->DiskIo2 != NULL) {
+      gBS->CloseProtocol (
+             ControllerHandle,
+             &gEfiDiskIo2ProtocolGuid,
+             This->DriverBindingHandle,
+             ChildHandleBuffer[Index]
+             );
+    }
     //
     // All Software protocols have be freed from the handle so remove it.
     // Remove the BlockIo Protocol if has.
@@ -492,6 +520,16 @@ PartitionDriverBindingStop (
              ChildHandleBuffer[Index],
              EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
              );
+      if (Private->DiskIo2 != NULL) {
+        gBS->OpenProtocol (
+               ControllerHandle,
+               &gEfiDiskIo2ProtocolGuid,
+               (VOID **) &DiskIo2,
+               This->DriverBindingHandle,
+               ChildHandleBuffer[Index],
+               EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
+               );
+      }
     } else {
       FreePool (Private->DevicePath);
       FreePool (Private);
@@ -826,21 +864,16 @@ PartitionReadBlocksEx (
   }
 
   //
-  // Since the BlockIO2 call Parent BlockIO2 directly, so here the offset must
-  // be multiple of BlockSize. If the Spec will be updated the DiskIO to support
-  // BlockIO2, this limitation will be removed and call DiskIO here.
+  // The parent BlockIO2 can only be called directly when the offset is a
+  // multiple of BlockSize and the partition has the same block size as its
+  // parent. Otherwise the parent DiskIO2 handles the partial blocks.
   //
   Lba = DivU64x32Remainder (Offset, Private->BlockSize, &UnderRun);
-  if (UnderRun != 0) {
-    return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
-  }
-
-  //
-  // Because some partitions have different block size from their parent
-  // device, in that case the Block I/O2 couldn't be called.
-  //
-  if (Private->BlockSize != Private->ParentBlockIo->Media->BlockSize) {
-    return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
+  if ((UnderRun != 0) || (Private->BlockSize != Private->ParentBlockIo->Media->BlockSize)) {
+    if (Private->DiskIo2 == NULL) {
+      return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
+    }
+    return Private->DiskIo2->ReadDiskEx (Private->DiskIo2, MediaId, Offset, (EFI_DISK_IO2_TOKEN *) Token, BufferSize, Buffer);
   }
 
   return Private->ParentBlockIo2->ReadBlocksEx (Private->ParentBlockIo2, MediaId, Lba, Token, BufferSize, Buffer);
@@ -908,21 +941,16 @@ PartitionWriteBlocksEx (
   }
 
   //
-  // Since the BlockIO2 call Parent BlockIO2 directly, so here the offset must
-  // be multiple of BlockSize. If the Spec will be updated the DiskIO to support
-  // BlockIO2, this limitation will be removed and call DiskIO here.
+  // The parent BlockIO2 can only be called directly when the offset is a
+  // multiple of BlockSize and the partition has the same block size as its
+  // parent. Otherwise the parent DiskIO2 handles the partial blocks.
   //
   Lba = DivU64x32Remainder (Offset, Private->BlockSize, &UnderRun);
-  if (UnderRun != 0) {
-    return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
-  }
-
-  //
-  // Because some kinds of partition have different block size from their parent,
-  // in that case it couldn't call parent Block I/O2. 
-  //
-  if (Private->BlockSize != Private->ParentBlockIo->Media->BlockSize) {
-    return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
+  if ((UnderRun != 0) || (Private->BlockSize != Private->ParentBlockIo->Media->BlockSize)) {
+    if (Private->DiskIo2 == NULL) {
+      return ProbeMediaStatusEx (Private->ParentBlockIo2, MediaId, EFI_UNSUPPORTED);
+    }
+    return Private->DiskIo2->WriteDiskEx (Private->DiskIo2, MediaId, Offset, (EFI_DISK_IO2_TOKEN *) Token, BufferSize, Buffer);
   }
 
   return Private->ParentBlockIo2->WriteBlocksEx (Private->ParentBlockIo2, MediaId, Lba, Token, BufferSize, Buffer);
@@ -963,10 +991,13 @@ PartitionFlushBlocksEx (
 
   //
   // Because some kinds of partition have different block size from their parent,
-  // in that case it couldn't call parent Block I/O2. 
+  // in that case it couldn't call parent Block I/O2 and flushes through DiskIO2.
   //
   if (Private->BlockSize != Private->ParentBlockIo->Media->BlockSize) {
-    return EFI_UNSUPPORTED;
+    if (Private->DiskIo2 == NULL) {
+      return EFI_UNSUPPORTED;
+    }
+    return Private->DiskIo2->FlushDiskEx (Private->DiskIo2, (EFI_DISK_IO2_TOKEN *) Token);
   }
 
   return Private->ParentBlockIo2->FlushBlocksEx (Private->ParentBlockIo2, Token);
@@ -1027,6 +1058,22 @@ PartitionInstallChildHandle (
   Private->ParentBlockIo2   = ParentBlockIo2;
   Private->DiskIo           = ParentDiskIo;
 
+  //
+  // The parent DiskIO2 is optional. It lets the child BlockIO2 serve
+  // requests that do not map onto whole parent blocks.
+  //
+  Status = gBS->OpenProtocol (
+                  ParentHandle,
+                  &gEfiDiskIo2ProtocolGuid,
+                  (VOID **) &Private->DiskIo2,
+                  This->DriverBindingHandle,
+                  ParentHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    Private->DiskIo2 = NULL;
+  }
+
   //
   // Set the BlockIO into Private Data.
   //
@@ -1106,15 +1153,13 @@ PartitionInstallChildHandle (
   //
   // Create the new handle. 
   // BlockIO2 will be installed on the condition that the blocksize of parent BlockIO 
-  // is same with the child BlockIO's. Instead of calling the DiskIO, the child BlockIO2 
-  // directly call the parent BlockIO and doesn't handle the different block size issue.
-  // If SPEC will update the DiskIO to support the Non-Blocking model, the BlockIO2 will call
-  // DiskIO to handle the blocksize unequal issue and the limitation will be remove from
-  // here.
+  // is same with the child BlockIO's, or that the parent provides DiskIO2. The child
+  // BlockIO2 calls the parent BlockIO2 directly for requests on whole parent blocks
+  // and uses the parent DiskIO2 to handle the blocksize unequal issue.
   //
   Private->Handle = NULL;
   if ((Private->ParentBlockIo2 != NULL) &&
-      (Private->ParentBlockIo2->Media->BlockSize == BlockSize)
+      ((Private->ParentBlockIo2->Media->BlockSize == BlockSize) || (Private->DiskIo2 != NULL))
      ) {
     Status = gBS->InstallMultipleProtocolInterfaces (
                     &Private->Handle,
@@ -1153,6 +1198,16 @@ PartitionInstallChildHandle (
                     Private->Handle,
                     EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
                     );
+    if (!EFI_ERROR (Status) && Private->DiskIo2 != NULL) {
+      Status = gBS->OpenProtocol (
+                      ParentHandle,
+                      &gEfiDiskIo2ProtocolGuid,
+                      (VOID **) &Private->DiskIo2,
+                      This->DriverBindingHandle,
+                      Private->Handle,
+                      EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
+                      );
+    }
   } else {
     FreePool (Private->DevicePath);
     FreePool (Private);
@@ -26,6 +26,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/DevicePath.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/DiskIo.h>
+#include <Protocol/DiskIo2.h>
 #include <Library/DebugLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/BaseLib.h>
@@ -54,6 +55,7 @@ typedef struct {
   EFI_BLOCK_IO_MEDIA        Media2;//For BlockIO2
 
   EFI_DISK_IO_PROTOCOL      *DiskIo;
+  EFI_DISK_IO2_PROTOCOL     *DiskIo2;
   EFI_BLOCK_IO_PROTOCOL     *ParentBlockIo;
   EFI_BLOCK_IO2_PROTOCOL    *ParentBlockIo2;
   UINT64                    Start;
@@ -98,9 +98,14 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Reclaim keeps every variable ahead of the first deleted one in place, so
+  only the blocks from the first byte that differs from the current content
+  of the variable storage space onwards are written, as one FTW record.
+
   @param  VariableBase   Base address of variable to write
   @param  Buffer         Point to the data buffer.
   @param  BufferSize     The number of bytes of the data Buffer.
+  @param  BytesWritten   Returns the number of bytes written to the storage space.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -111,7 +116,8 @@ EFI_STATUS
 FtwVariableSpace (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
   IN UINT8                  *Buffer,
-  IN UINTN                  BufferSize
+  IN UINTN                  BufferSize,
+  OUT UINTN                 *BytesWritten
   )
 {
   EFI_STATUS                         Status;
@@ -120,8 +126,12 @@ FtwVariableSpace (
   UINTN                              VarOffset;
   UINT8                              *FtwBuffer;
   UINTN                              FtwBufferSize;
+  UINTN                              WriteOffset;
+  UINT8                              *VariableStore;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
 
+  *BytesWritten = 0;
+
   //
   // Locate fault tolerant write protocol.
   //
@@ -155,18 +165,55 @@ FtwVariableSpace (
   SetMem (FtwBuffer, FtwBufferSize, (UINT8) 0xff);
   CopyMem (FtwBuffer, Buffer, BufferSize);
 
+  //
+  // Skip the part of the storage space that already holds the new content.
+  //
+  VariableStore = (UINT8 *) (UINTN) VariableBase;
+  for (WriteOffset = 0; WriteOffset < FtwBufferSize; WriteOffset++) {
+    if (FtwBuffer[WriteOffset] != VariableStore[WriteOffset]) {
+      break;
+    }
+  }
+  if (WriteOffset == FtwBufferSize) {
+    FreePool (FtwBuffer);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Start writing at the beginning of the block holding the first changed byte,
+  // unless that is the block the storage space starts in.
+  //
+  if (WriteOffset != 0) {
+    Status = GetLbaAndOffsetByAddress (VariableBase + WriteOffset, &VarLba, &VarOffset);
+    if (EFI_ERROR (Status)) {
+      FreePool (FtwBuffer);
+      return EFI_ABORTED;
+    }
+    if (VarOffset <= WriteOffset) {
+      WriteOffset -= VarOffset;
+      VarOffset    = 0;
+    } else {
+      WriteOffset = 0;
+      Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+      ASSERT_EFI_ERROR (Status);
+    }
+  }
+
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,         // LBA
-                          VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
-                          NULL,           // PrivateData NULL
-                          FvbHandle,      // Fvb Handle
-                          FtwBuffer       // write buffer
+                          VarLba,                       // LBA
+                          VarOffset,                    // Offset
+                          FtwBufferSize - WriteOffset,  // NumBytes
+                          NULL,                         // PrivateData NULL
+                          FvbHandle,                    // Fvb Handle
+                          FtwBuffer + WriteOffset       // write buffer
                           );
+  if (!EFI_ERROR (Status)) {
+    *BytesWritten = FtwBufferSize - WriteOffset;
+  }
 
   FreePool (FtwBuffer);
   return Status;
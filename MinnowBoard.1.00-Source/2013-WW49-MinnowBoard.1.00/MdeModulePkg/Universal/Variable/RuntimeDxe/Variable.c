@@ -496,6 +496,308 @@ GetEndPointer (
 }
 
 
+/**
+  Compute the bucket of the variable index that a variable name and vendor GUID
+  hash to.
+
+  @param VariableName    Pointer to the variable name.
+  @param NameSize        Size of VariableName in bytes, including the terminator.
+  @param VendorGuid      Pointer to the vendor GUID.
+
+  @return The bucket number.
+
+**/
+UINTN
+VariableIndexHash (
+  IN  CHAR16                   *VariableName,
+  IN  UINTN                    NameSize,
+  IN  EFI_GUID                 *VendorGuid
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  Hash = ReadUnaligned32 ((UINT32 *) VendorGuid) ^
+         ReadUnaligned32 ((UINT32 *) VendorGuid + 1) ^
+         ReadUnaligned32 ((UINT32 *) VendorGuid + 2) ^
+         ReadUnaligned32 ((UINT32 *) VendorGuid + 3);
+  for (Index = 0; (Index < NameSize / sizeof (CHAR16)) && (VariableName[Index] != 0); Index++) {
+    Hash = Hash * 31 + VariableName[Index];
+  }
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (VARIABLE_INDEX_BUCKETS - 1);
+}
+
+/**
+  Add a variable to the index of the store that holds it.
+
+  If the index is full it is marked invalid, so lookups walk the store until
+  the next rebuild.
+
+  @param Index                   Pointer to the variable index.
+  @param VariableStoreHeader     Pointer to the store that holds the variable.
+  @param Variable                Pointer to the variable header.
+
+**/
+VOID
+VariableIndexInsert (
+  IN OUT VARIABLE_INDEX          *Index,
+  IN     VARIABLE_STORE_HEADER   *VariableStoreHeader,
+  IN     VARIABLE_HEADER         *Variable
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Entry;
+  UINTN                 Bucket;
+
+  if (!Index->Valid) {
+    return;
+  }
+
+  if (Index->Count == Index->Capacity) {
+    Index->Valid = FALSE;
+    return;
+  }
+
+  Bucket = VariableIndexHash (GetVariableNamePtr (Variable), NameSizeOfVariable (Variable), &Variable->VendorGuid);
+
+  Entry         = &Index->Entries[Index->Count];
+  Entry->Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+  Entry->Next   = Index->Buckets[Bucket];
+  Index->Buckets[Bucket] = Index->Count;
+  Index->Count++;
+}
+
+/**
+  Rebuild the index of a variable store from the variables it holds.
+
+  @param Index                   Pointer to the variable index.
+  @param VariableStoreHeader     Pointer to the variable store, or NULL if there is none.
+
+**/
+VOID
+VariableIndexBuild (
+  IN OUT VARIABLE_INDEX          *Index,
+  IN     VARIABLE_STORE_HEADER   *VariableStoreHeader
+  )
+{
+  VARIABLE_HEADER       *Variable;
+
+  SetMem (Index->Buckets, sizeof (Index->Buckets), 0xff);
+  Index->Count = 0;
+  Index->Valid = (BOOLEAN) ((Index->Entries != NULL) && (VariableStoreHeader != NULL));
+  if (!Index->Valid) {
+    return;
+  }
+
+  for ( Variable = GetStartPointer (VariableStoreHeader)
+      ; (Variable < GetEndPointer (VariableStoreHeader)) && IsValidVariableHeader (Variable)
+      ; Variable = GetNextVariablePtr (Variable)
+      ) {
+    if (Variable->State == VAR_ADDED || 
+        Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)
+       ) {
+      VariableIndexInsert (Index, VariableStoreHeader, Variable);
+    }
+  }
+}
+
+/**
+  Allocate the index of a variable store and fill it from the store.
+
+  The index is sized for the largest number of variables the store can hold,
+  so it never has to grow at runtime.  Failing to allocate it is not fatal;
+  lookups in this store then walk the store.
+
+  @param Index                   Pointer to the variable index.
+  @param VariableStoreHeader     Pointer to the variable store, or NULL if there is none.
+
+**/
+VOID
+VariableIndexInitialize (
+  OUT VARIABLE_INDEX             *Index,
+  IN  VARIABLE_STORE_HEADER      *VariableStoreHeader
+  )
+{
+  Index->Entries  = NULL;
+  Index->Capacity = 0;
+  if (VariableStoreHeader != NULL) {
+    Index->Capacity = (UINT32) ((VariableStoreHeader->Size - sizeof (VARIABLE_STORE_HEADER)) / VARIABLE_INDEX_MIN_SIZE);
+    Index->Entries  = AllocateRuntimePool (Index->Capacity * sizeof (VARIABLE_INDEX_ENTRY));
+    if (Index->Entries == NULL) {
+      DEBUG ((EFI_D_WARN, "Variable driver: no memory for the variable index, lookups will walk the store.\n"));
+    }
+  }
+
+  VariableIndexBuild (Index, VariableStoreHeader);
+}
+
+/**
+  Check whether an indexed variable is the one being looked up.
+
+  @param Variable                Pointer to the variable header.
+  @param VariableName            Name of the variable to be found.
+  @param NameSize                Size of VariableName in bytes, including the terminator.
+  @param VendorGuid              Vendor GUID to be found.
+  @param IgnoreRtCheck           Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                 check at runtime when searching variable.
+
+  @retval TRUE                   The variable matches.
+  @retval FALSE                  The variable does not match.
+
+**/
+BOOLEAN
+VariableIndexMatch (
+  IN  VARIABLE_HEADER            *Variable,
+  IN  CHAR16                     *VariableName,
+  IN  UINTN                      NameSize,
+  IN  EFI_GUID                   *VendorGuid,
+  IN  BOOLEAN                    IgnoreRtCheck
+  )
+{
+  if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN) (CompareGuid (VendorGuid, &Variable->VendorGuid) &&
+                    (NameSizeOfVariable (Variable) == NameSize) &&
+                    (CompareMem (VariableName, GetVariableNamePtr (Variable), NameSize) == 0));
+}
+
+/**
+  Return the index of the variable store that starts at the given variable.
+
+  @param StartPtr                Pointer to the first variable of the store.
+  @param VariableStoreHeader     Returns the store the index belongs to.
+
+  @return The variable index, or NULL if the store is not indexed or its index is not usable.
+
+**/
+VARIABLE_INDEX *
+GetVariableIndex (
+  IN  VARIABLE_HEADER            *StartPtr,
+  OUT VARIABLE_STORE_HEADER      **VariableStoreHeader
+  )
+{
+  VARIABLE_STORE_HEADER   *StoreHeader[VariableStoreTypeMax];
+  VARIABLE_STORE_TYPE     Type;
+
+  StoreHeader[VariableStoreTypeVolatile] = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  StoreHeader[VariableStoreTypeHob]      = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+  StoreHeader[VariableStoreTypeNv]       = mNvVariableCache;
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    if ((StoreHeader[Type] != NULL) && (StartPtr == GetStartPointer (StoreHeader[Type]))) {
+      if (!mVariableModuleGlobal->VariableIndex[Type].Valid) {
+        return NULL;
+      }
+      *VariableStoreHeader = StoreHeader[Type];
+      return &mVariableModuleGlobal->VariableIndex[Type];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Find a variable through the index of its store.
+
+  This returns the same variable FindVariableEx () finds by walking the store:
+  the first ADDED variable, together with the IN_DELETED_TRANSITION one that
+  precedes it, or else the last IN_DELETED_TRANSITION variable.  Entries of
+  variables that have been deleted since they were indexed are unlinked.
+
+  @param Index                   Pointer to the variable index.
+  @param VariableStoreHeader     Pointer to the variable store.
+  @param VariableName            Name of the variable to be found, not empty.
+  @param VendorGuid              Vendor GUID to be found.
+  @param IgnoreRtCheck           Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                 check at runtime when searching variable.
+  @param PtrTrack                Variable Track Pointer structure that contains Variable Information.
+
+  @retval  EFI_SUCCESS           Variable found successfully
+  @retval  EFI_NOT_FOUND         Variable not found
+
+**/
+EFI_STATUS
+FindVariableInIndex (
+  IN OUT VARIABLE_INDEX          *Index,
+  IN     VARIABLE_STORE_HEADER   *VariableStoreHeader,
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Entry;
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *AddedVariable;
+  VARIABLE_HEADER       *InDeletedVariable;
+  UINT32                *Link;
+  UINTN                 NameSize;
+  UINTN                 Bucket;
+
+  NameSize = StrSize (VariableName);
+  Bucket   = VariableIndexHash (VariableName, NameSize, VendorGuid);
+
+  AddedVariable     = NULL;
+  InDeletedVariable = NULL;
+  for (Link = &Index->Buckets[Bucket]; *Link != VARIABLE_INDEX_END; ) {
+    Entry    = &Index->Entries[*Link];
+    Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry->Offset);
+    if (!IsValidVariableHeader (Variable) ||
+        (Variable->State != VAR_ADDED && Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))
+       ) {
+      //
+      // The variable has been deleted; states only ever move towards DELETED,
+      // so the entry can be dropped for good.
+      //
+      *Link = Entry->Next;
+      continue;
+    }
+    Link = &Entry->Next;
+
+    if (!VariableIndexMatch (Variable, VariableName, NameSize, VendorGuid, IgnoreRtCheck)) {
+      continue;
+    }
+    if (Variable->State == VAR_ADDED) {
+      if (AddedVariable == NULL || Variable < AddedVariable) {
+        AddedVariable = Variable;
+      }
+    } else if (InDeletedVariable == NULL || Variable > InDeletedVariable) {
+      InDeletedVariable = Variable;
+    }
+  }
+
+  if (AddedVariable == NULL) {
+    PtrTrack->CurrPtr                = InDeletedVariable;
+    PtrTrack->InDeletedTransitionPtr = NULL;
+    return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+  }
+
+  if (InDeletedVariable != NULL && InDeletedVariable > AddedVariable) {
+    //
+    // Only an IN_DELETED_TRANSITION variable ahead of the ADDED one pairs with it.
+    //
+    InDeletedVariable = NULL;
+    for (Link = &Index->Buckets[Bucket]; *Link != VARIABLE_INDEX_END; Link = &Entry->Next) {
+      Entry    = &Index->Entries[*Link];
+      Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry->Offset);
+      if (Variable < AddedVariable &&
+          Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED) &&
+          VariableIndexMatch (Variable, VariableName, NameSize, VendorGuid, IgnoreRtCheck) &&
+          (InDeletedVariable == NULL || Variable > InDeletedVariable)
+         ) {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  PtrTrack->CurrPtr                = AddedVariable;
+  PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+  return EFI_SUCCESS;
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
@@ -543,7 +845,15 @@ Reclaim (
   UINTN                 HwErrVariableTotalSize;
   BOOLEAN               NeedDoReclaim;
   VARIABLE_HEADER       *UpdatingVariable;
-
+  UINT64                StartTicks;
+  UINT64                Ticks;
+  UINT64                CounterStart;
+  UINT64                CounterEnd;
+  UINTN                 BytesWritten;
+  VARIABLE_RECLAIM_STATISTICS *Statistics;
+
+  StartTicks       = GetPerformanceCounter ();
+  BytesWritten     = 0;
   UpdatingVariable = NULL;
   if (UpdatingPtrTrack != NULL) {
     UpdatingVariable = UpdatingPtrTrack->CurrPtr;
@@ -707,6 +1017,7 @@ Reclaim (
     //
     SetMem ((UINT8 *) (UINTN) VariableBase, VariableStoreHeader->Size, 0xff);
     CopyMem ((UINT8 *) (UINTN) VariableBase, ValidBuffer, (UINTN) (CurrPtr - (UINT8 *) ValidBuffer));
+    BytesWritten = (UINTN) (CurrPtr - (UINT8 *) ValidBuffer);
     Status  = EFI_SUCCESS;
   } else {
     //
@@ -715,10 +1026,20 @@ Reclaim (
     Status = FtwVariableSpace (
               VariableBase,
               ValidBuffer,
-              (UINTN) (CurrPtr - (UINT8 *) ValidBuffer)
+              (UINTN) (CurrPtr - (UINT8 *) ValidBuffer),
+              &BytesWritten
               );
     CopyMem (mNvVariableCache, (CHAR8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
   }
+
+  //
+  // Every variable may have moved, rebuild the index of the store.
+  //
+  if (IsVolatile) {
+    VariableIndexBuild (&mVariableModuleGlobal->VariableIndex[VariableStoreTypeVolatile], VariableStoreHeader);
+  } else {
+    VariableIndexBuild (&mVariableModuleGlobal->VariableIndex[VariableStoreTypeNv], mNvVariableCache);
+  }
   if (!EFI_ERROR (Status)) {
     *LastVariableOffset = (UINTN) (CurrPtr - (UINT8 *) ValidBuffer);
     if (!IsVolatile) {
@@ -742,6 +1063,30 @@ Reclaim (
 
   FreePool (ValidBuffer);
 
+  //
+  // Record how long the reclaim took and how much of the store it rewrote.
+  //
+  Ticks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    Ticks = StartTicks - Ticks;
+  } else {
+    Ticks = Ticks - StartTicks;
+  }
+  Statistics = &mVariableModuleGlobal->ReclaimStatistics[IsVolatile ? VariableStoreTypeVolatile : VariableStoreTypeNv];
+  Statistics->Count++;
+  Statistics->BytesWritten = BytesWritten;
+  Statistics->Time         = GetTimeInNanoSecond (Ticks);
+  DEBUG ((
+    EFI_D_INFO,
+    "Variable driver: reclaimed %a variable store, %ld of %ld bytes written in %ld us, %r\n",
+    IsVolatile ? "volatile" : "non-volatile",
+    (UINT64) BytesWritten,
+    (UINT64) VariableStoreHeader->Size,
+    DivU64x32 (Statistics->Time, 1000),
+    Status
+    ));
+
   return Status;
 }
 
@@ -767,9 +1112,21 @@ FindVariableEx (
 {
   VARIABLE_HEADER                *InDeletedVariable;
   VOID                           *Point;
+  VARIABLE_INDEX                 *Index;
+  VARIABLE_STORE_HEADER          *VariableStoreHeader;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
+  //
+  // Look a named variable up through the index of its store when there is one.
+  //
+  if (VariableName[0] != 0) {
+    Index = GetVariableIndex (PtrTrack->StartPtr, &VariableStoreHeader);
+    if (Index != NULL) {
+      return FindVariableInIndex (Index, VariableStoreHeader, VariableName, VendorGuid, IgnoreRtCheck, PtrTrack);
+    }
+  }
+
   //
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
@@ -1754,6 +2111,11 @@ UpdateVariable (
     // update the memory copy of Flash region.
     //
     CopyMem ((UINT8 *)mNvVariableCache + CacheOffset, (UINT8 *)NextVariable, VarSize);
+    VariableIndexInsert (
+      &mVariableModuleGlobal->VariableIndex[VariableStoreTypeNv],
+      mNvVariableCache,
+      (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + CacheOffset)
+      );
   } else {
     //
     // Create a volatile variable.
@@ -1800,6 +2162,11 @@ UpdateVariable (
       goto Done;
     }
 
+    VariableIndexInsert (
+      &mVariableModuleGlobal->VariableIndex[VariableStoreTypeVolatile],
+      (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase,
+      (VARIABLE_HEADER *) ((UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase + mVariableModuleGlobal->VolatileLastVariableOffset)
+      );
     mVariableModuleGlobal->VolatileLastVariableOffset += HEADER_ALIGN (VarSize);
   }
 
@@ -2466,7 +2833,8 @@ VariableServiceQueryVariableInfo (
 
 
 /**
-  This function reclaims variable storage if free size is below the threshold.
+  This function reclaims variable storage if free size is below the threshold,
+  or if the store is filled beyond PcdVariableReclaimFillPercent.
   
 **/
 VOID
@@ -2478,6 +2846,7 @@ ReclaimForOS(
   UINTN                          CommonVariableSpace;
   UINTN                          RemainingCommonVariableSpace;
   UINTN                          RemainingHwErrVariableSpace;
+  UINT32                         FillPercent;
 
   Status  = EFI_SUCCESS; 
 
@@ -2486,12 +2855,18 @@ ReclaimForOS(
   RemainingCommonVariableSpace = CommonVariableSpace - mVariableModuleGlobal->CommonVariableTotalSize;
 
   RemainingHwErrVariableSpace = PcdGet32 (PcdHwErrStorageSize) - mVariableModuleGlobal->HwErrVariableTotalSize;
+
+  FillPercent = PcdGet32 (PcdVariableReclaimFillPercent);
   //
-  // Check if the free area is blow a threshold.
+  // Check if the free area is blow a threshold, or the store is filled beyond
+  // the configured level. Reclaiming here at ReadyToBoot spares SetVariable ()
+  // from reclaiming a full store later on.
   //
   if ((RemainingCommonVariableSpace < PcdGet32 (PcdMaxVariableSize))
     || ((PcdGet32 (PcdHwErrStorageSize) != 0) && 
-       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize)))){
+       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize)))
+    || ((FillPercent != 0) &&
+       (MultU64x32 (mVariableModuleGlobal->CommonVariableTotalSize, 100) >= MultU64x32 (CommonVariableSpace, FillPercent)))){
     Status = Reclaim (
             mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
             &mVariableModuleGlobal->NonVolatileLastVariableOffset,
@@ -2585,8 +2960,13 @@ FlushHobVariableToFlash (
       // All HOB variables have been flushed in flash.
       //
       DEBUG ((EFI_D_INFO, "Variable driver: all HOB variables have been flushed in flash.\n"));
+      mVariableModuleGlobal->VariableIndex[VariableStoreTypeHob].Valid = FALSE;
       if (!AtRuntime ()) {
         FreePool ((VOID *) VariableStoreHeader);
+        if (mVariableModuleGlobal->VariableIndex[VariableStoreTypeHob].Entries != NULL) {
+          FreePool (mVariableModuleGlobal->VariableIndex[VariableStoreTypeHob].Entries);
+          mVariableModuleGlobal->VariableIndex[VariableStoreTypeHob].Entries = NULL;
+        }
       }
     }
   }
@@ -2792,6 +3172,16 @@ VariableCommonInitialize (
     goto Done;
   }
   CopyMem (mNvVariableCache, (CHAR8 *)(UINTN)VariableStoreBase, (UINTN)VariableStoreLength);
+
+  //
+  // Index the name and GUID of every variable in each store so lookups don't walk them.
+  //
+  VariableIndexInitialize (&mVariableModuleGlobal->VariableIndex[VariableStoreTypeVolatile], VolatileVariableStore);
+  VariableIndexInitialize (
+    &mVariableModuleGlobal->VariableIndex[VariableStoreTypeHob],
+    (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase
+    );
+  VariableIndexInitialize (&mVariableModuleGlobal->VariableIndex[VariableStoreTypeNv], mNvVariableCache);
   Status = EFI_SUCCESS;
 
 Done:
@@ -34,6 +34,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseLib.h>
 #include <Library/SynchronizationLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/EventGroup.h>
 #include <Guid/VariableFormat.h>
@@ -68,6 +69,42 @@ typedef struct {
   BOOLEAN         Volatile;
 } VARIABLE_POINTER_TRACK;
 
+///
+/// Number of hash buckets in the name/GUID index of each variable store.
+///
+#define VARIABLE_INDEX_BUCKETS  128
+
+///
+/// Terminates a bucket chain of the variable index.
+///
+#define VARIABLE_INDEX_END      0xFFFFFFFF
+
+///
+/// The smallest variable a store can hold: a one character name and one byte of data.
+///
+#define VARIABLE_INDEX_MIN_SIZE HEADER_ALIGN (sizeof (VARIABLE_HEADER) + 2 * sizeof (CHAR16) + 1)
+
+typedef struct {
+  UINT32          Offset;     ///< Offset of the variable header from the variable store header.
+  UINT32          Next;       ///< Next entry in the same bucket, or VARIABLE_INDEX_END.
+} VARIABLE_INDEX_ENTRY;
+
+///
+/// Hash index over the variables of one store, keyed by name and vendor GUID.
+/// Entries are appended as variables are written and are never removed one
+/// by one; a lookup drops entries whose variable has since been deleted, and
+/// the whole index is rebuilt whenever the store is reclaimed.  If the index
+/// could not be allocated or overflows, Valid is FALSE and lookups fall back
+/// to walking the store.
+///
+typedef struct {
+  VARIABLE_INDEX_ENTRY  *Entries;
+  UINT32                Count;
+  UINT32                Capacity;
+  BOOLEAN               Valid;
+  UINT32                Buckets[VARIABLE_INDEX_BUCKETS];
+} VARIABLE_INDEX;
+
 typedef struct {
   EFI_PHYSICAL_ADDRESS  HobVariableBase;
   EFI_PHYSICAL_ADDRESS  VolatileVariableBase;
@@ -76,6 +113,15 @@ typedef struct {
   UINT32                ReentrantState;
 } VARIABLE_GLOBAL;
 
+///
+/// Statistics of the reclaim operations on one variable store.
+///
+typedef struct {
+  UINTN           Count;
+  UINTN           BytesWritten;          ///< Bytes written to the store by the last reclaim.
+  UINT64          Time;                  ///< Duration of the last reclaim in nanoseconds.
+} VARIABLE_RECLAIM_STATISTICS;
+
 typedef struct {
   VARIABLE_GLOBAL VariableGlobal;
   UINTN           VolatileLastVariableOffset;
@@ -87,6 +133,12 @@ typedef struct {
   CHAR8           *PlatformLang;
   CHAR8           Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
+  VARIABLE_INDEX  VariableIndex[VariableStoreTypeMax];
+  //
+  // Statistics of the reclaim operations, indexed by VARIABLE_STORE_TYPE.
+  // Only the volatile and the non-volatile stores are reclaimed.
+  //
+  VARIABLE_RECLAIM_STATISTICS ReclaimStatistics[VariableStoreTypeMax];
 } VARIABLE_MODULE_GLOBAL;
 
 typedef struct {
@@ -117,9 +169,13 @@ FlushHobVariableToFlash (
   volume block device. The destination is specified by the parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Only the blocks from the first byte that differs from the current content
+  of the variable storage space onwards are written.
+
   @param  VariableBase   Base address of the variable to write.
   @param  Buffer         Point to the data buffer.
   @param  BufferSize     The number of bytes of the data Buffer.
+  @param  BytesWritten   Returns the number of bytes written to the storage space.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -130,7 +186,8 @@ EFI_STATUS
 FtwVariableSpace (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
   IN UINT8                  *Buffer,
-  IN UINTN                  BufferSize
+  IN UINTN                  BufferSize,
+  OUT UINTN                 *BytesWritten
   );
 
 
@@ -545,6 +545,13 @@ typedef union {
 #define ATA_CMD_WRITE_DMA             0xca   ///< defined from ATA-1
 #define ATA_CMD_WRITE_DMA_WITH_RETRY  0xcb   ///< defined from ATA-1, obsoleted from ATA-
 #define ATA_CMD_WRITE_DMA_EXT         0x35   ///< defined from ATA-6
+#define ATA_CMD_READ_FPDMA_QUEUED     0x60   ///< defined from ATA8-ACS
+#define ATA_CMD_WRITE_FPDMA_QUEUED    0x61   ///< defined from ATA8-ACS
+
+//
+// Log Command
+//
+#define ATA_CMD_READ_LOG_EXT          0x2f   ///< defined from ATA-6
         
 ///
 /// Default content of device control register, disable INT,
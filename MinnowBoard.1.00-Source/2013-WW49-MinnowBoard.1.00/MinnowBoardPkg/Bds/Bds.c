@@ -1762,6 +1762,17 @@ BdsEntry (
   EfiConnectDevicePaths (gConOutDevices);
   EfiConnectDevicePaths (gConInDevices);
   EfiConnectDevicePaths (gErrOutDevices);
+
+  //
+  // A console behind a bus that enumerates in continuations, like a USB
+  // keyboard, only appears once they are done. Wait for them so that it is
+  // there for the hotkeys and the UI, and finish connecting it.
+  //
+  if (!EFI_ERROR (BdsWaitForDeferredStart ())) {
+    EfiConnectDevicePaths (gConOutDevices);
+    EfiConnectDevicePaths (gConInDevices);
+    EfiConnectDevicePaths (gErrOutDevices);
+  }
   BdsSetgST();
   //
   // The EFI System table must contain valid console infomration at this point.
@@ -18,6 +18,12 @@
 
 #define  BDS_MAX_STRING_LENTH                  100
 
+//
+// Longest wait, in 100ns units, for the deferred parts of driver Start()
+// functions to finish during connect all or the console connect
+//
+#define  BDS_DEFERRED_START_TIMEOUT            (5 * 10000000)
+
 BOOLEAN   mConnectAll = FALSE;
 
 extern EFI_BOOT_MODE                 gBootMode;
@@ -636,9 +642,13 @@ EfiBootManagerBootOption (
   Status = EfiBootManagerLoadImage (BootOption, &ImageHandle, TRUE);
 }
 
+/**
+  Connect all the drivers to all the controllers, once.
+
+**/
 VOID
-EfiBootManagerConnectAll (
-  IN  BOOLEAN   OnlyOncePerBoot
+BdsConnectAllHandles (
+  VOID
   )
 {
   EFI_STATUS  Status;
@@ -646,11 +656,6 @@ EfiBootManagerConnectAll (
   EFI_HANDLE  *HandleBuffer;
   UINTN       Index;
 
-  if (OnlyOncePerBoot && mConnectAll) {
-    return;
-  }
-  mConnectAll = TRUE;
-
   Status = gBS->LocateHandleBuffer (
                   AllHandles,
                   NULL,
@@ -662,14 +667,58 @@ EfiBootManagerConnectAll (
     return;
   }
 
-
-
   for (Index = 0; Index < HandleCount; Index++) {
     Status = gBS->ConnectController (HandleBuffer[Index], NULL, NULL, TRUE);
   }
 
   FreePool (HandleBuffer);
-  return;
+}
+
+/**
+  Wait for the parts of driver Start() functions that were left to timer
+  continuations, so that the hardware waits of all controllers overlap.
+  The controllers they produced can be connected afterwards.
+
+  @retval EFI_SUCCESS     The continuations finished, or the wait timed out.
+  @retval EFI_NOT_FOUND   No driver start can be deferred.
+
+**/
+EFI_STATUS
+BdsWaitForDeferredStart (
+  VOID
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_DEFERRED_START_PROTOCOL  *DeferredStart;
+
+  Status = gBS->LocateProtocol (&gEfiDeferredStartProtocolGuid, NULL, (VOID **) &DeferredStart);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = DeferredStart->WaitForContinuations (DeferredStart, BDS_DEFERRED_START_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Deferred driver start not finished - %r\n", Status));
+  }
+
+  return EFI_SUCCESS;
+}
+
+VOID
+EfiBootManagerConnectAll (
+  IN  BOOLEAN   OnlyOncePerBoot
+  )
+{
+  if (OnlyOncePerBoot && mConnectAll) {
+    return;
+  }
+  mConnectAll = TRUE;
+
+  BdsConnectAllHandles ();
+
+  if (!EFI_ERROR (BdsWaitForDeferredStart ())) {
+    BdsConnectAllHandles ();
+  }
 }
 
 EFI_STATUS
@@ -132,6 +132,11 @@ EfiBootManagerLoadImage (
   IN  BOOLEAN                         RemovableMediaSupport
   );
 
+EFI_STATUS
+BdsWaitForDeferredStart (
+  VOID
+  );
+
 VOID 
 EfiBootManagerConnectAll (
   IN  BOOLEAN   OnlyOncePerBoot
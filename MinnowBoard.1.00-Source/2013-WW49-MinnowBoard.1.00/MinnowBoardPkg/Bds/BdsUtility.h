@@ -33,6 +33,7 @@
 #include <Protocol/SimpleNetwork.h>
 #include <Protocol/DebugPort.h>
 #include <Protocol/UsbIo.h>
+#include <Protocol/DeferredStart.h>
 
 #include <Guid/GlobalVariable.h>
 #include <Guid/FileInfo.h>